@@ -0,0 +1,320 @@
+/**
+ * @file subscription_manager_benchmark.c
+ * @brief Host benchmark comparing the topic trie against the previous
+ * subscription list, which called MQTT_MatchTopic() for every subscription.
+ *
+ * This file is not part of the firmware build. Build it on the host together
+ * with the subscription manager and the coreMQTT sources used by the firmware:
+ *
+ *     gcc -O2 -DMQTT_DO_NOT_USE_CUSTOM_CONFIG \
+ *         -I<logging include dir> -I<coreMQTT>/source/include \
+ *         -I<coreMQTT>/source/interface -I.. \
+ *         subscription_manager_benchmark.c ../mqtt_subscription_manager.c \
+ *         <coreMQTT>/source/core_mqtt.c <coreMQTT>/source/core_mqtt_state.c \
+ *         <coreMQTT>/source/core_mqtt_serializer.c -o subscription_manager_benchmark
+ *
+ *     ./subscription_manager_benchmark [iterations]
+ *
+ * The subscriptions are the ones the application holds while an OTA update is
+ * running (OTA job and stream topics, device shadow topics and the device
+ * registration response), so SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS entries
+ * are in use. For every topic name the number of callbacks invoked by both
+ * implementations is compared before the timings are printed, and the program
+ * exits with 1 when they differ.
+ */
+
+/* Standard includes. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Subscription manager header include. */
+#include "mqtt_subscription_manager.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Default number of dispatches timed for each topic name.
+ */
+#define BENCHMARK_DEFAULT_ITERATIONS    ( 1000000UL )
+
+/**
+ * @brief Thing name used to build the topic filters and topic names.
+ */
+#define BENCHMARK_THING_NAME            "benchmark-thing-0123456789"
+
+/**
+ * @brief Prefix of the topics reserved by AWS IoT for the thing.
+ */
+#define BENCHMARK_THING_PREFIX          "$aws/things/" BENCHMARK_THING_NAME
+
+/**
+ * @brief An element of the list based subscription manager used before the
+ * topic trie.
+ */
+typedef struct benchmarkListElement
+{
+    IncomingPubCallback_t pxIncomingPublishCallback;
+    void * pvIncomingPublishCallbackContext;
+    uint16_t usFilterStringLength;
+    const char * pcSubscriptionFilterString;
+} BenchmarkListElement_t;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Topic filters subscribed by the application during an OTA update.
+ */
+static const char * const pcTopicFilters[] =
+{
+    BENCHMARK_THING_PREFIX "/jobs/notify-next",
+    "$aws/things/+/streams/#",
+    BENCHMARK_THING_PREFIX "/jobs/$next/get/+",
+    BENCHMARK_THING_PREFIX "/jobs/+/update/+",
+    BENCHMARK_THING_PREFIX "/shadow/update/delta",
+    BENCHMARK_THING_PREFIX "/shadow/update/accepted",
+    BENCHMARK_THING_PREFIX "/shadow/update/rejected",
+    BENCHMARK_THING_PREFIX "/shadow/get/accepted",
+    BENCHMARK_THING_PREFIX "/shadow/get/rejected",
+    "device/register/" BENCHMARK_THING_NAME "/res"
+};
+
+/**
+ * @brief Topic names of the incoming publishes that are timed.
+ *
+ * The stream data topic is the one received for every block of an OTA image.
+ */
+static const char * const pcTopicNames[] =
+{
+    BENCHMARK_THING_PREFIX "/streams/AFR_OTA-0123456789abcdef/data/cbor",
+    BENCHMARK_THING_PREFIX "/jobs/notify-next",
+    BENCHMARK_THING_PREFIX "/jobs/AFR_OTA-job/update/accepted",
+    BENCHMARK_THING_PREFIX "/shadow/update/delta",
+    "device/register/" BENCHMARK_THING_NAME "/res",
+    "dt/" BENCHMARK_THING_NAME "/unsubscribed"
+};
+
+#define BENCHMARK_TOPIC_FILTER_NUM    ( sizeof( pcTopicFilters ) / sizeof( pcTopicFilters[ 0 ] ) )
+#define BENCHMARK_TOPIC_NAME_NUM      ( sizeof( pcTopicNames ) / sizeof( pcTopicNames[ 0 ] ) )
+
+/**
+ * @brief Subscription manager using the topic trie.
+ */
+static SubscriptionManager_t xSubscriptionManager;
+
+/**
+ * @brief Subscription list used by the previous implementation.
+ */
+static BenchmarkListElement_t xSubscriptionList[ SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS ];
+
+/**
+ * @brief Number of callbacks invoked, read back so that the dispatches are
+ * not optimised away.
+ */
+static volatile uint32_t ulCallbackCount = 0U;
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Callback registered for every topic filter.
+ *
+ * @param[in] pvContext Unused.
+ * @param[in] pxPublishInfo Unused.
+ */
+static void prvCountingCallback( void * pvContext,
+                                 MQTTPublishInfo_t * pxPublishInfo );
+
+/**
+ * @brief Dispatch an incoming publish the way the previous list based
+ * implementation did.
+ *
+ * @param[in] pxSubscriptionList The subscription list.
+ * @param[in] pxPublishInfo Info of incoming publish.
+ *
+ * @return `true` if an application callback could be invoked;
+ *  `false` otherwise.
+ */
+static bool prvListHandleIncomingPublishes( BenchmarkListElement_t * pxSubscriptionList,
+                                            MQTTPublishInfo_t * pxPublishInfo );
+
+/**
+ * @brief Get a monotonic timestamp.
+ *
+ * @return Nanoseconds from an arbitrary origin.
+ */
+static uint64_t prvGetTimeNs( void );
+
+/**
+ * @brief Count the callbacks invoked by a single dispatch with each
+ * implementation.
+ *
+ * @param[in] pxPublishInfo Info of incoming publish.
+ * @param[out] pulTrieCallbacks Callbacks invoked by the topic trie.
+ * @param[out] pulListCallbacks Callbacks invoked by the subscription list.
+ */
+static void prvCountCallbacks( MQTTPublishInfo_t * pxPublishInfo,
+                               uint32_t * pulTrieCallbacks,
+                               uint32_t * pulListCallbacks );
+
+/*-----------------------------------------------------------*/
+
+static void prvCountingCallback( void * pvContext,
+                                 MQTTPublishInfo_t * pxPublishInfo )
+{
+    ( void ) pvContext;
+    ( void ) pxPublishInfo;
+
+    ulCallbackCount++;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvListHandleIncomingPublishes( BenchmarkListElement_t * pxSubscriptionList,
+                                            MQTTPublishInfo_t * pxPublishInfo )
+{
+    uint32_t ulIndex = 0U;
+    bool isMatched = false, publishHandled = false;
+
+    for( ulIndex = 0U; ulIndex < SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS; ulIndex++ )
+    {
+        if( pxSubscriptionList[ ulIndex ].usFilterStringLength > 0 )
+        {
+            MQTT_MatchTopic( pxPublishInfo->pTopicName,
+                             pxPublishInfo->topicNameLength,
+                             pxSubscriptionList[ ulIndex ].pcSubscriptionFilterString,
+                             pxSubscriptionList[ ulIndex ].usFilterStringLength,
+                             &isMatched );
+
+            if( isMatched == true )
+            {
+                pxSubscriptionList[ ulIndex ].pxIncomingPublishCallback( pxSubscriptionList[ ulIndex ].pvIncomingPublishCallbackContext,
+                                                                        pxPublishInfo );
+
+                publishHandled = true;
+            }
+        }
+    }
+
+    return publishHandled;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint64_t prvGetTimeNs( void )
+{
+    struct timespec xNow;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( ( uint64_t ) xNow.tv_sec * 1000000000ULL ) + ( uint64_t ) xNow.tv_nsec;
+}
+
+/*-----------------------------------------------------------*/
+
+static void prvCountCallbacks( MQTTPublishInfo_t * pxPublishInfo,
+                               uint32_t * pulTrieCallbacks,
+                               uint32_t * pulListCallbacks )
+{
+    ulCallbackCount = 0U;
+    ( void ) SubscriptionManager_HandleIncomingPublishes( &xSubscriptionManager, pxPublishInfo );
+    *pulTrieCallbacks = ulCallbackCount;
+
+    ulCallbackCount = 0U;
+    ( void ) prvListHandleIncomingPublishes( xSubscriptionList, pxPublishInfo );
+    *pulListCallbacks = ulCallbackCount;
+}
+
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    unsigned long ulIterations = BENCHMARK_DEFAULT_ITERATIONS;
+    unsigned long ulLoop = 0UL;
+    size_t uxIndex = 0U;
+    uint32_t ulTrieCallbacks = 0U, ulListCallbacks = 0U;
+    uint64_t ullStart = 0ULL, ullTrieNs = 0ULL, ullListNs = 0ULL;
+    MQTTPublishInfo_t xPublishInfo;
+    int lStatus = 0;
+
+    if( argc > 1 )
+    {
+        ulIterations = strtoul( argv[ 1 ], NULL, 10 );
+
+        if( ulIterations == 0UL )
+        {
+            ulIterations = BENCHMARK_DEFAULT_ITERATIONS;
+        }
+    }
+
+    SubscriptionManager_Init( &xSubscriptionManager );
+    memset( xSubscriptionList, 0x00, sizeof( xSubscriptionList ) );
+
+    for( uxIndex = 0U; uxIndex < BENCHMARK_TOPIC_FILTER_NUM; uxIndex++ )
+    {
+        if( SubscriptionManager_AddSubscription( &xSubscriptionManager,
+                                                 pcTopicFilters[ uxIndex ],
+                                                 ( uint16_t ) strlen( pcTopicFilters[ uxIndex ] ),
+                                                 prvCountingCallback,
+                                                 NULL ) == false )
+        {
+            printf( "Failed to add %s to the topic trie.\n", pcTopicFilters[ uxIndex ] );
+            return 1;
+        }
+
+        xSubscriptionList[ uxIndex ].pcSubscriptionFilterString = pcTopicFilters[ uxIndex ];
+        xSubscriptionList[ uxIndex ].usFilterStringLength = ( uint16_t ) strlen( pcTopicFilters[ uxIndex ] );
+        xSubscriptionList[ uxIndex ].pxIncomingPublishCallback = prvCountingCallback;
+        xSubscriptionList[ uxIndex ].pvIncomingPublishCallbackContext = NULL;
+    }
+
+    printf( "%lu dispatches per topic, %u subscriptions\n",
+            ulIterations, ( unsigned int ) BENCHMARK_TOPIC_FILTER_NUM );
+    printf( "%10s %10s %9s  %s\n", "trie ns", "list ns", "callbacks", "topic" );
+
+    for( uxIndex = 0U; uxIndex < BENCHMARK_TOPIC_NAME_NUM; uxIndex++ )
+    {
+        memset( &xPublishInfo, 0x00, sizeof( xPublishInfo ) );
+        xPublishInfo.pTopicName = pcTopicNames[ uxIndex ];
+        xPublishInfo.topicNameLength = ( uint16_t ) strlen( pcTopicNames[ uxIndex ] );
+
+        prvCountCallbacks( &xPublishInfo, &ulTrieCallbacks, &ulListCallbacks );
+
+        if( ulTrieCallbacks != ulListCallbacks )
+        {
+            printf( "Mismatch for %s: trie invoked %u callbacks, list invoked %u.\n",
+                    pcTopicNames[ uxIndex ],
+                    ( unsigned int ) ulTrieCallbacks,
+                    ( unsigned int ) ulListCallbacks );
+            lStatus = 1;
+            continue;
+        }
+
+        ullStart = prvGetTimeNs();
+
+        for( ulLoop = 0UL; ulLoop < ulIterations; ulLoop++ )
+        {
+            ( void ) SubscriptionManager_HandleIncomingPublishes( &xSubscriptionManager, &xPublishInfo );
+        }
+
+        ullTrieNs = prvGetTimeNs() - ullStart;
+
+        ullStart = prvGetTimeNs();
+
+        for( ulLoop = 0UL; ulLoop < ulIterations; ulLoop++ )
+        {
+            ( void ) prvListHandleIncomingPublishes( xSubscriptionList, &xPublishInfo );
+        }
+
+        ullListNs = prvGetTimeNs() - ullStart;
+
+        printf( "%10.1f %10.1f %9u  %s\n",
+                ( double ) ullTrieNs / ( double ) ulIterations,
+                ( double ) ullListNs / ( double ) ulIterations,
+                ( unsigned int ) ulTrieCallbacks,
+                pcTopicNames[ uxIndex ] );
+    }
+
+    return lStatus;
+}
@@ -36,59 +36,662 @@
 #include "mqtt_subscription_manager.h"
 
 
-bool SubscriptionManager_AddSubscription( SubscriptionElement_t * pxSubscriptionList,
+/**
+ * @brief Index of the root node of the topic trie.
+ */
+#define ROOT_NODE_INDEX    ( 0U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Find the end of the topic level starting at @p ulLevelStart.
+ *
+ * @param[in] pcString Topic name or topic filter.
+ * @param[in] ulStringLength Length of @p pcString.
+ * @param[in] ulLevelStart Offset of the first character of the level.
+ *
+ * @return Offset of the '/' terminating the level, or @p ulStringLength.
+ */
+static uint32_t prvFindLevelEnd( const char * pcString,
+                                 uint32_t ulStringLength,
+                                 uint32_t ulLevelStart );
+
+/**
+ * @brief Check that the wildcards of a topic filter are well formed.
+ *
+ * @param[in] pcTopicFilterString Topic filter.
+ * @param[in] usTopicFilterLength Length of topic filter.
+ *
+ * @return `true` if the topic filter can be stored in the trie.
+ */
+static bool prvIsValidTopicFilter( const char * pcTopicFilterString,
+                                   uint16_t usTopicFilterLength );
+
+/**
+ * @brief Find the literal child of a node that matches a topic level.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] usParent Parent node.
+ * @param[in] pcLevel Topic level to look for.
+ * @param[in] ulLevelLength Length of @p pcLevel.
+ *
+ * @return Index of the child node, or SUBSCRIPTION_MANAGER_INVALID_INDEX.
+ */
+static uint16_t prvFindLiteralChild( const SubscriptionManager_t * pxSubscriptionManager,
+                                     uint16_t usParent,
+                                     const char * pcLevel,
+                                     uint32_t ulLevelLength );
+
+/**
+ * @brief Find the child of a node for a topic filter level.
+ *
+ * The wildcard levels "+" and "#" are looked up without string comparison.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] usParent Parent node.
+ * @param[in] pcLevel Topic filter level to look for.
+ * @param[in] ulLevelLength Length of @p pcLevel.
+ *
+ * @return Index of the child node, or SUBSCRIPTION_MANAGER_INVALID_INDEX.
+ */
+static uint16_t prvFindFilterChild( const SubscriptionManager_t * pxSubscriptionManager,
+                                    uint16_t usParent,
+                                    const char * pcLevel,
+                                    uint32_t ulLevelLength );
+
+/**
+ * @brief Take a node from the arena and link it below @p usParent.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] usParent Parent node.
+ * @param[in] usOwner Subscription whose filter string holds the level.
+ * @param[in] ulLevelStart Offset of the level in the filter string.
+ * @param[in] ulLevelLength Length of the level.
+ *
+ * @return Index of the new node, or SUBSCRIPTION_MANAGER_INVALID_INDEX if
+ * the arena is exhausted.
+ */
+static uint16_t prvAddChild( SubscriptionManager_t * pxSubscriptionManager,
+                             uint16_t usParent,
+                             uint16_t usOwner,
+                             uint32_t ulLevelStart,
+                             uint32_t ulLevelLength );
+
+/**
+ * @brief Return the nodes that no longer lead to a subscription to the arena,
+ * starting at @p usNode and walking up towards the root.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] usNode Deepest node to check.
+ *
+ * @return The deepest node that is still in use.
+ */
+static uint16_t prvPruneNodes( SubscriptionManager_t * pxSubscriptionManager,
+                               uint16_t usNode );
+
+/**
+ * @brief Invoke every callback registered on a node.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] usNode Node whose subscriptions are invoked.
+ * @param[in] pxPublishInfo Info of incoming publish.
+ *
+ * @return `true` if at least one callback was invoked.
+ */
+static bool prvInvokeCallbacks( SubscriptionManager_t * pxSubscriptionManager,
+                                uint16_t usNode,
+                                MQTTPublishInfo_t * pxPublishInfo );
+
+/**
+ * @brief Match the remaining levels of a topic name below @p usNode.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] usNode Node matched by the previous topic level.
+ * @param[in] ulLevelStart Offset of the next topic level. A value greater than
+ * the topic name length means that every level has been matched.
+ * @param[in] pxPublishInfo Info of incoming publish.
+ *
+ * @return `true` if at least one callback was invoked.
+ */
+static bool prvDispatchLevel( SubscriptionManager_t * pxSubscriptionManager,
+                              uint16_t usNode,
+                              uint32_t ulLevelStart,
+                              MQTTPublishInfo_t * pxPublishInfo );
+
+/**
+ * @brief Find the first subscription matching the remaining levels of a topic
+ * name below @p usNode, in the order used by prvDispatchLevel().
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] usNode Node matched by the previous topic level.
+ * @param[in] ulLevelStart Offset of the next topic level. A value greater than
+ * the topic name length means that every level has been matched.
+ * @param[in] pcTopicName Topic name.
+ * @param[in] ulTopicNameLength Length of @p pcTopicName.
+ *
+ * @return Index of the subscription, or SUBSCRIPTION_MANAGER_INVALID_INDEX.
+ */
+static uint16_t prvFindLevel( const SubscriptionManager_t * pxSubscriptionManager,
+                              uint16_t usNode,
+                              uint32_t ulLevelStart,
+                              const char * pcTopicName,
+                              uint32_t ulTopicNameLength );
+
+/*-----------------------------------------------------------*/
+
+static uint32_t prvFindLevelEnd( const char * pcString,
+                                 uint32_t ulStringLength,
+                                 uint32_t ulLevelStart )
+{
+    uint32_t ulLevelEnd = ulLevelStart;
+
+    while( ( ulLevelEnd < ulStringLength ) && ( pcString[ ulLevelEnd ] != '/' ) )
+    {
+        ulLevelEnd++;
+    }
+
+    return ulLevelEnd;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvIsValidTopicFilter( const char * pcTopicFilterString,
+                                   uint16_t usTopicFilterLength )
+{
+    uint32_t ulLevelStart = 0U, ulLevelEnd = 0U, ulIndex = 0U;
+    bool xIsValid = true;
+
+    do
+    {
+        ulLevelEnd = prvFindLevelEnd( pcTopicFilterString, usTopicFilterLength, ulLevelStart );
+
+        for( ulIndex = ulLevelStart; ( ulIndex < ulLevelEnd ) && ( xIsValid == true ); ulIndex++ )
+        {
+            if( ( pcTopicFilterString[ ulIndex ] == '+' ) || ( pcTopicFilterString[ ulIndex ] == '#' ) )
+            {
+                /* A wildcard must occupy an entire level, and "#" must be the last level. */
+                if( ( ( ulLevelEnd - ulLevelStart ) != 1U ) ||
+                    ( ( pcTopicFilterString[ ulIndex ] == '#' ) && ( ulLevelEnd != usTopicFilterLength ) ) )
+                {
+                    xIsValid = false;
+                }
+            }
+        }
+
+        ulLevelStart = ulLevelEnd + 1U;
+    } while( ( xIsValid == true ) && ( ulLevelEnd < usTopicFilterLength ) );
+
+    return xIsValid;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint16_t prvFindLiteralChild( const SubscriptionManager_t * pxSubscriptionManager,
+                                     uint16_t usParent,
+                                     const char * pcLevel,
+                                     uint32_t ulLevelLength )
+{
+    const SubscriptionTrieNode_t * pxChild = NULL;
+    const char * pcChildLevel = NULL;
+    uint16_t usChild = pxSubscriptionManager->xNodes[ usParent ].usFirstChild;
+
+    while( usChild != SUBSCRIPTION_MANAGER_INVALID_INDEX )
+    {
+        pxChild = &( pxSubscriptionManager->xNodes[ usChild ] );
+
+        if( pxChild->usLevelLength == ulLevelLength )
+        {
+            pcChildLevel = &( pxSubscriptionManager->xSubscriptions[ pxChild->usOwner ].pcSubscriptionFilterString[ pxChild->usLevelOffset ] );
+
+            if( strncmp( pcChildLevel, pcLevel, ( size_t ) ulLevelLength ) == 0 )
+            {
+                break;
+            }
+        }
+
+        usChild = pxChild->usNextSibling;
+    }
+
+    return usChild;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint16_t prvFindFilterChild( const SubscriptionManager_t * pxSubscriptionManager,
+                                    uint16_t usParent,
+                                    const char * pcLevel,
+                                    uint32_t ulLevelLength )
+{
+    uint16_t usChild = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+
+    if( ( ulLevelLength == 1U ) && ( pcLevel[ 0 ] == '+' ) )
+    {
+        usChild = pxSubscriptionManager->xNodes[ usParent ].usPlusChild;
+    }
+    else if( ( ulLevelLength == 1U ) && ( pcLevel[ 0 ] == '#' ) )
+    {
+        usChild = pxSubscriptionManager->xNodes[ usParent ].usHashChild;
+    }
+    else
+    {
+        usChild = prvFindLiteralChild( pxSubscriptionManager, usParent, pcLevel, ulLevelLength );
+    }
+
+    return usChild;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint16_t prvAddChild( SubscriptionManager_t * pxSubscriptionManager,
+                             uint16_t usParent,
+                             uint16_t usOwner,
+                             uint32_t ulLevelStart,
+                             uint32_t ulLevelLength )
+{
+    SubscriptionTrieNode_t * pxParent = &( pxSubscriptionManager->xNodes[ usParent ] );
+    SubscriptionTrieNode_t * pxChild = NULL;
+    const char * pcLevel = &( pxSubscriptionManager->xSubscriptions[ usOwner ].pcSubscriptionFilterString[ ulLevelStart ] );
+    uint16_t usChild = pxSubscriptionManager->usFreeNode;
+
+    if( usChild == SUBSCRIPTION_MANAGER_INVALID_INDEX )
+    {
+        LogError( ( "Topic trie node arena exhausted. Increase SUBSCRIPTION_MANAGER_MAX_TRIE_NODES." ) );
+    }
+    else
+    {
+        pxChild = &( pxSubscriptionManager->xNodes[ usChild ] );
+        pxSubscriptionManager->usFreeNode = pxChild->usNextSibling;
+
+        pxChild->usOwner = usOwner;
+        pxChild->usLevelOffset = ( uint16_t ) ulLevelStart;
+        pxChild->usLevelLength = ( uint16_t ) ulLevelLength;
+        pxChild->usParent = usParent;
+        pxChild->usFirstChild = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+        pxChild->usNextSibling = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+        pxChild->usPlusChild = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+        pxChild->usHashChild = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+        pxChild->usFirstSubscription = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+
+        if( ( ulLevelLength == 1U ) && ( pcLevel[ 0 ] == '+' ) )
+        {
+            pxParent->usPlusChild = usChild;
+        }
+        else if( ( ulLevelLength == 1U ) && ( pcLevel[ 0 ] == '#' ) )
+        {
+            pxParent->usHashChild = usChild;
+        }
+        else
+        {
+            pxChild->usNextSibling = pxParent->usFirstChild;
+            pxParent->usFirstChild = usChild;
+        }
+    }
+
+    return usChild;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint16_t prvPruneNodes( SubscriptionManager_t * pxSubscriptionManager,
+                               uint16_t usNode )
+{
+    SubscriptionTrieNode_t * pxNode = NULL;
+    SubscriptionTrieNode_t * pxParent = NULL;
+    uint16_t usSibling = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+
+    while( usNode != ROOT_NODE_INDEX )
+    {
+        pxNode = &( pxSubscriptionManager->xNodes[ usNode ] );
+
+        if( ( pxNode->usFirstSubscription != SUBSCRIPTION_MANAGER_INVALID_INDEX ) ||
+            ( pxNode->usFirstChild != SUBSCRIPTION_MANAGER_INVALID_INDEX ) ||
+            ( pxNode->usPlusChild != SUBSCRIPTION_MANAGER_INVALID_INDEX ) ||
+            ( pxNode->usHashChild != SUBSCRIPTION_MANAGER_INVALID_INDEX ) )
+        {
+            break;
+        }
+
+        /* Unlink the node from its parent. */
+        pxParent = &( pxSubscriptionManager->xNodes[ pxNode->usParent ] );
+
+        if( pxParent->usPlusChild == usNode )
+        {
+            pxParent->usPlusChild = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+        }
+        else if( pxParent->usHashChild == usNode )
+        {
+            pxParent->usHashChild = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+        }
+        else if( pxParent->usFirstChild == usNode )
+        {
+            pxParent->usFirstChild = pxNode->usNextSibling;
+        }
+        else
+        {
+            usSibling = pxParent->usFirstChild;
+
+            while( pxSubscriptionManager->xNodes[ usSibling ].usNextSibling != usNode )
+            {
+                usSibling = pxSubscriptionManager->xNodes[ usSibling ].usNextSibling;
+            }
+
+            pxSubscriptionManager->xNodes[ usSibling ].usNextSibling = pxNode->usNextSibling;
+        }
+
+        /* Return the node to the arena. */
+        usSibling = pxNode->usParent;
+        memset( pxNode, 0x00, sizeof( SubscriptionTrieNode_t ) );
+        pxNode->usNextSibling = pxSubscriptionManager->usFreeNode;
+        pxSubscriptionManager->usFreeNode = usNode;
+
+        usNode = usSibling;
+    }
+
+    return usNode;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvInvokeCallbacks( SubscriptionManager_t * pxSubscriptionManager,
+                                uint16_t usNode,
+                                MQTTPublishInfo_t * pxPublishInfo )
+{
+    SubscriptionElement_t * pxElement = NULL;
+    uint16_t usElement = pxSubscriptionManager->xNodes[ usNode ].usFirstSubscription;
+    bool publishHandled = false;
+
+    while( usElement != SUBSCRIPTION_MANAGER_INVALID_INDEX )
+    {
+        pxElement = &( pxSubscriptionManager->xSubscriptions[ usElement ] );
+        pxElement->pxIncomingPublishCallback( pxElement->pvIncomingPublishCallbackContext,
+                                              pxPublishInfo );
+        publishHandled = true;
+
+        usElement = pxElement->usNextElement;
+    }
+
+    return publishHandled;
+}
+
+/*-----------------------------------------------------------*/
+
+static bool prvDispatchLevel( SubscriptionManager_t * pxSubscriptionManager,
+                              uint16_t usNode,
+                              uint32_t ulLevelStart,
+                              MQTTPublishInfo_t * pxPublishInfo )
+{
+    const SubscriptionTrieNode_t * pxNode = &( pxSubscriptionManager->xNodes[ usNode ] );
+    const char * pcTopic = pxPublishInfo->pTopicName;
+    uint32_t ulTopicLength = pxPublishInfo->topicNameLength;
+    uint32_t ulLevelEnd = 0U;
+    uint16_t usChild = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+    bool publishHandled = false, xWildcardAllowed = true;
+
+    /* Topic names starting with "$" are not matched by a wildcard in the first level. */
+    if( ( usNode == ROOT_NODE_INDEX ) && ( pcTopic[ 0 ] == '$' ) )
+    {
+        xWildcardAllowed = false;
+    }
+
+    /* "#" matches every remaining level, including none of them. */
+    if( ( xWildcardAllowed == true ) && ( pxNode->usHashChild != SUBSCRIPTION_MANAGER_INVALID_INDEX ) )
+    {
+        if( prvInvokeCallbacks( pxSubscriptionManager, pxNode->usHashChild, pxPublishInfo ) == true )
+        {
+            publishHandled = true;
+        }
+    }
+
+    if( ulLevelStart > ulTopicLength )
+    {
+        /* Every level of the topic name has been matched. */
+        if( prvInvokeCallbacks( pxSubscriptionManager, usNode, pxPublishInfo ) == true )
+        {
+            publishHandled = true;
+        }
+    }
+    else
+    {
+        ulLevelEnd = prvFindLevelEnd( pcTopic, ulTopicLength, ulLevelStart );
+
+        usChild = prvFindLiteralChild( pxSubscriptionManager,
+                                       usNode,
+                                       &( pcTopic[ ulLevelStart ] ),
+                                       ulLevelEnd - ulLevelStart );
+
+        if( usChild != SUBSCRIPTION_MANAGER_INVALID_INDEX )
+        {
+            if( prvDispatchLevel( pxSubscriptionManager, usChild, ulLevelEnd + 1U, pxPublishInfo ) == true )
+            {
+                publishHandled = true;
+            }
+        }
+
+        if( ( xWildcardAllowed == true ) && ( pxNode->usPlusChild != SUBSCRIPTION_MANAGER_INVALID_INDEX ) )
+        {
+            if( prvDispatchLevel( pxSubscriptionManager, pxNode->usPlusChild, ulLevelEnd + 1U, pxPublishInfo ) == true )
+            {
+                publishHandled = true;
+            }
+        }
+    }
+
+    return publishHandled;
+}
+
+/*-----------------------------------------------------------*/
+
+static uint16_t prvFindLevel( const SubscriptionManager_t * pxSubscriptionManager,
+                              uint16_t usNode,
+                              uint32_t ulLevelStart,
+                              const char * pcTopicName,
+                              uint32_t ulTopicNameLength )
+{
+    const SubscriptionTrieNode_t * pxNode = &( pxSubscriptionManager->xNodes[ usNode ] );
+    uint32_t ulLevelEnd = 0U;
+    uint16_t usChild = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+    uint16_t usElement = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+    bool xWildcardAllowed = true;
+
+    /* Topic names starting with "$" are not matched by a wildcard in the first level. */
+    if( ( usNode == ROOT_NODE_INDEX ) && ( pcTopicName[ 0 ] == '$' ) )
+    {
+        xWildcardAllowed = false;
+    }
+
+    /* "#" matches every remaining level, including none of them. */
+    if( ( xWildcardAllowed == true ) && ( pxNode->usHashChild != SUBSCRIPTION_MANAGER_INVALID_INDEX ) )
+    {
+        usElement = pxSubscriptionManager->xNodes[ pxNode->usHashChild ].usFirstSubscription;
+    }
+
+    if( usElement != SUBSCRIPTION_MANAGER_INVALID_INDEX )
+    {
+        /* Found below the "#" child. */
+    }
+    else if( ulLevelStart > ulTopicNameLength )
+    {
+        /* Every level of the topic name has been matched. */
+        usElement = pxNode->usFirstSubscription;
+    }
+    else
+    {
+        ulLevelEnd = prvFindLevelEnd( pcTopicName, ulTopicNameLength, ulLevelStart );
+
+        usChild = prvFindLiteralChild( pxSubscriptionManager,
+                                       usNode,
+                                       &( pcTopicName[ ulLevelStart ] ),
+                                       ulLevelEnd - ulLevelStart );
+
+        if( usChild != SUBSCRIPTION_MANAGER_INVALID_INDEX )
+        {
+            usElement = prvFindLevel( pxSubscriptionManager, usChild, ulLevelEnd + 1U, pcTopicName, ulTopicNameLength );
+        }
+
+        if( ( usElement == SUBSCRIPTION_MANAGER_INVALID_INDEX ) &&
+            ( xWildcardAllowed == true ) &&
+            ( pxNode->usPlusChild != SUBSCRIPTION_MANAGER_INVALID_INDEX ) )
+        {
+            usElement = prvFindLevel( pxSubscriptionManager, pxNode->usPlusChild, ulLevelEnd + 1U, pcTopicName, ulTopicNameLength );
+        }
+    }
+
+    return usElement;
+}
+
+/*-----------------------------------------------------------*/
+
+void SubscriptionManager_Init( SubscriptionManager_t * pxSubscriptionManager )
+{
+    uint16_t usIndex = 0U;
+    SubscriptionTrieNode_t * pxRoot = NULL;
+
+    if( pxSubscriptionManager == NULL )
+    {
+        LogError( ( "Invalid parameter. pxSubscriptionManager=%p.",
+                    pxSubscriptionManager ) );
+    }
+    else
+    {
+        memset( pxSubscriptionManager, 0x00, sizeof( SubscriptionManager_t ) );
+
+        /* Chain every subscription element into the free list. */
+        for( usIndex = 0U; usIndex < SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS; usIndex++ )
+        {
+            pxSubscriptionManager->xSubscriptions[ usIndex ].usNextElement = usIndex + 1U;
+        }
+
+        pxSubscriptionManager->xSubscriptions[ SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS - 1U ].usNextElement = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+        pxSubscriptionManager->usFreeSubscription = 0U;
+
+        /* Chain every node except the root into the free list. */
+        for( usIndex = ROOT_NODE_INDEX + 1U; usIndex < SUBSCRIPTION_MANAGER_MAX_TRIE_NODES; usIndex++ )
+        {
+            pxSubscriptionManager->xNodes[ usIndex ].usNextSibling = usIndex + 1U;
+        }
+
+        pxSubscriptionManager->xNodes[ SUBSCRIPTION_MANAGER_MAX_TRIE_NODES - 1U ].usNextSibling = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+        pxSubscriptionManager->usFreeNode = ROOT_NODE_INDEX + 1U;
+
+        pxRoot = &( pxSubscriptionManager->xNodes[ ROOT_NODE_INDEX ] );
+        pxRoot->usOwner = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+        pxRoot->usParent = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+        pxRoot->usFirstChild = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+        pxRoot->usNextSibling = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+        pxRoot->usPlusChild = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+        pxRoot->usHashChild = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+        pxRoot->usFirstSubscription = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+    }
+}
+
+/*-----------------------------------------------------------*/
+
+bool SubscriptionManager_AddSubscription( SubscriptionManager_t * pxSubscriptionManager,
                                           const char * pcTopicFilterString,
                                           uint16_t usTopicFilterLength,
                                           IncomingPubCallback_t pxIncomingPublishCallback,
                                           void * pvIncomingPublishCallbackContext )
 {
-    int32_t lIndex = 0;
-    size_t xAvailableIndex = SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS;
+    SubscriptionElement_t * pxElement = NULL;
+    uint32_t ulLevelStart = 0U, ulLevelEnd = 0U;
+    uint16_t usNode = ROOT_NODE_INDEX, usChild = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+    uint16_t usAvailableIndex = SUBSCRIPTION_MANAGER_INVALID_INDEX, usElement = SUBSCRIPTION_MANAGER_INVALID_INDEX;
     bool xReturnStatus = false;
 
-    if( ( pxSubscriptionList == NULL ) ||
+    if( ( pxSubscriptionManager == NULL ) ||
         ( pcTopicFilterString == NULL ) ||
         ( usTopicFilterLength == 0U ) ||
         ( pxIncomingPublishCallback == NULL ) )
     {
-        LogError( ( "Invalid parameter. pxSubscriptionList=%p, pcTopicFilterString=%p,"
+        LogError( ( "Invalid parameter. pxSubscriptionManager=%p, pcTopicFilterString=%p,"
                     " usTopicFilterLength=%u, pxIncomingPublishCallback=%p.",
-                    pxSubscriptionList,
+                    pxSubscriptionManager,
                     pcTopicFilterString,
                     ( unsigned int ) usTopicFilterLength,
                     pxIncomingPublishCallback ) );
     }
+    else if( prvIsValidTopicFilter( pcTopicFilterString, usTopicFilterLength ) == false )
+    {
+        LogError( ( "Invalid topic filter. pcTopicFilterString=%.*s.",
+                    ( int ) usTopicFilterLength,
+                    pcTopicFilterString ) );
+    }
+    else if( pxSubscriptionManager->usFreeSubscription == SUBSCRIPTION_MANAGER_INVALID_INDEX )
+    {
+        LogError( ( "Subscription list is full. Increase SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS." ) );
+    }
     else
     {
-        /* Start at end of array, so that we will insert at the first available index.
-         * Scans backwards to find duplicates. */
-        for( lIndex = ( int32_t ) SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS - 1; lIndex >= 0; lIndex-- )
+        /* Reserve the element first, so that new nodes can refer to its filter string. */
+        usAvailableIndex = pxSubscriptionManager->usFreeSubscription;
+        pxElement = &( pxSubscriptionManager->xSubscriptions[ usAvailableIndex ] );
+        pxElement->pcSubscriptionFilterString = pcTopicFilterString;
+
+        /* Walk down the trie one level at a time, adding missing levels. */
+        do
         {
-            if( pxSubscriptionList[ lIndex ].usFilterStringLength == 0 )
+            ulLevelEnd = prvFindLevelEnd( pcTopicFilterString, usTopicFilterLength, ulLevelStart );
+            usChild = prvFindFilterChild( pxSubscriptionManager,
+                                          usNode,
+                                          &( pcTopicFilterString[ ulLevelStart ] ),
+                                          ulLevelEnd - ulLevelStart );
+
+            if( usChild == SUBSCRIPTION_MANAGER_INVALID_INDEX )
             {
-                xAvailableIndex = lIndex;
+                usChild = prvAddChild( pxSubscriptionManager,
+                                       usNode,
+                                       usAvailableIndex,
+                                       ulLevelStart,
+                                       ulLevelEnd - ulLevelStart );
             }
-            else if( ( pxSubscriptionList[ lIndex ].usFilterStringLength == usTopicFilterLength ) &&
-                     ( strncmp( pcTopicFilterString, pxSubscriptionList[ lIndex ].pcSubscriptionFilterString, ( size_t ) usTopicFilterLength ) == 0 ) )
+
+            if( usChild != SUBSCRIPTION_MANAGER_INVALID_INDEX )
             {
-                /* If a subscription already exists, don't do anything. */
-                if( ( pxSubscriptionList[ lIndex ].pxIncomingPublishCallback == pxIncomingPublishCallback ) &&
-                    ( pxSubscriptionList[ lIndex ].pvIncomingPublishCallbackContext == pvIncomingPublishCallbackContext ) )
+                usNode = usChild;
+            }
+
+            ulLevelStart = ulLevelEnd + 1U;
+        } while( ( usChild != SUBSCRIPTION_MANAGER_INVALID_INDEX ) && ( ulLevelEnd < usTopicFilterLength ) );
+
+        if( usChild == SUBSCRIPTION_MANAGER_INVALID_INDEX )
+        {
+            /* Release the levels that were added for this subscription. */
+            ( void ) prvPruneNodes( pxSubscriptionManager, usNode );
+            pxElement->pcSubscriptionFilterString = NULL;
+        }
+        else
+        {
+            /* If a subscription already exists, don't do anything. */
+            usElement = pxSubscriptionManager->xNodes[ usNode ].usFirstSubscription;
+
+            while( usElement != SUBSCRIPTION_MANAGER_INVALID_INDEX )
+            {
+                if( ( pxSubscriptionManager->xSubscriptions[ usElement ].pxIncomingPublishCallback == pxIncomingPublishCallback ) &&
+                    ( pxSubscriptionManager->xSubscriptions[ usElement ].pvIncomingPublishCallbackContext == pvIncomingPublishCallbackContext ) )
                 {
                     LogWarn( ( "Subscription already exists.\n" ) );
-                    xAvailableIndex = SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS;
-                    xReturnStatus = true;
                     break;
                 }
+
+                usElement = pxSubscriptionManager->xSubscriptions[ usElement ].usNextElement;
+            }
+
+            if( usElement == SUBSCRIPTION_MANAGER_INVALID_INDEX )
+            {
+                pxSubscriptionManager->usFreeSubscription = pxElement->usNextElement;
+
+                pxElement->usFilterStringLength = usTopicFilterLength;
+                pxElement->pxIncomingPublishCallback = pxIncomingPublishCallback;
+                pxElement->pvIncomingPublishCallbackContext = pvIncomingPublishCallbackContext;
+                pxElement->usTrieNode = usNode;
+                pxElement->usNextElement = pxSubscriptionManager->xNodes[ usNode ].usFirstSubscription;
+                pxSubscriptionManager->xNodes[ usNode ].usFirstSubscription = usAvailableIndex;
+            }
+            else
+            {
+                pxElement->pcSubscriptionFilterString = NULL;
             }
-        }
 
-        if( xAvailableIndex < SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS )
-        {
-            pxSubscriptionList[ xAvailableIndex ].pcSubscriptionFilterString = pcTopicFilterString;
-            pxSubscriptionList[ xAvailableIndex ].usFilterStringLength = usTopicFilterLength;
-            pxSubscriptionList[ xAvailableIndex ].pxIncomingPublishCallback = pxIncomingPublishCallback;
-            pxSubscriptionList[ xAvailableIndex ].pvIncomingPublishCallbackContext = pvIncomingPublishCallbackContext;
             xReturnStatus = true;
         }
     }
@@ -98,31 +701,91 @@ bool SubscriptionManager_AddSubscription( SubscriptionElement_t * pxSubscription
 
 /*-----------------------------------------------------------*/
 
-void SubscriptionManager_RemoveSubscription( SubscriptionElement_t * pxSubscriptionList,
+void SubscriptionManager_RemoveSubscription( SubscriptionManager_t * pxSubscriptionManager,
                                              const char * pcTopicFilterString,
                                              uint16_t usTopicFilterLength )
 {
-    int32_t lIndex = 0;
+    SubscriptionElement_t * pxElement = NULL;
+    SubscriptionTrieNode_t * pxNode = NULL;
+    uint32_t ulLevelStart = 0U, ulLevelEnd = 0U;
+    uint16_t usNode = ROOT_NODE_INDEX, usElement = SUBSCRIPTION_MANAGER_INVALID_INDEX, usOwner = SUBSCRIPTION_MANAGER_INVALID_INDEX;
 
-    if( ( pxSubscriptionList == NULL ) ||
+    if( ( pxSubscriptionManager == NULL ) ||
         ( pcTopicFilterString == NULL ) ||
         ( usTopicFilterLength == 0U ) )
     {
-        LogError( ( "Invalid parameter. pxSubscriptionList=%p, pcTopicFilterString=%p,"
+        LogError( ( "Invalid parameter. pxSubscriptionManager=%p, pcTopicFilterString=%p,"
                     " usTopicFilterLength=%u.",
-                    pxSubscriptionList,
+                    pxSubscriptionManager,
                     pcTopicFilterString,
                     ( unsigned int ) usTopicFilterLength ) );
     }
     else
     {
-        for( lIndex = 0; lIndex < SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS; lIndex++ )
+        /* Find the node of the last level of the topic filter. */
+        do
+        {
+            ulLevelEnd = prvFindLevelEnd( pcTopicFilterString, usTopicFilterLength, ulLevelStart );
+            usNode = prvFindFilterChild( pxSubscriptionManager,
+                                         usNode,
+                                         &( pcTopicFilterString[ ulLevelStart ] ),
+                                         ulLevelEnd - ulLevelStart );
+            ulLevelStart = ulLevelEnd + 1U;
+        } while( ( usNode != SUBSCRIPTION_MANAGER_INVALID_INDEX ) && ( ulLevelEnd < usTopicFilterLength ) );
+
+        if( usNode != SUBSCRIPTION_MANAGER_INVALID_INDEX )
         {
-            if( pxSubscriptionList[ lIndex ].usFilterStringLength == usTopicFilterLength )
+            /* Return every subscription of the node to the free list. */
+            usElement = pxSubscriptionManager->xNodes[ usNode ].usFirstSubscription;
+            pxSubscriptionManager->xNodes[ usNode ].usFirstSubscription = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+
+            while( usElement != SUBSCRIPTION_MANAGER_INVALID_INDEX )
+            {
+                pxElement = &( pxSubscriptionManager->xSubscriptions[ usElement ] );
+                usOwner = pxElement->usNextElement;
+                memset( pxElement, 0x00, sizeof( SubscriptionElement_t ) );
+                pxElement->usNextElement = pxSubscriptionManager->usFreeSubscription;
+                pxSubscriptionManager->usFreeSubscription = usElement;
+                usElement = usOwner;
+            }
+
+            usNode = prvPruneNodes( pxSubscriptionManager, usNode );
+
+            if( usNode != ROOT_NODE_INDEX )
             {
-                if( strncmp( pxSubscriptionList[ lIndex ].pcSubscriptionFilterString, pcTopicFilterString, usTopicFilterLength ) == 0 )
+                /* The remaining levels may still refer to a removed filter string.
+                 * Any subscription below the deepest remaining node shares its
+                 * levels, so hand the levels over to one of them. */
+                pxNode = &( pxSubscriptionManager->xNodes[ usNode ] );
+
+                while( pxNode->usFirstSubscription == SUBSCRIPTION_MANAGER_INVALID_INDEX )
                 {
-                    memset( &( pxSubscriptionList[ lIndex ] ), 0x00, sizeof( SubscriptionElement_t ) );
+                    if( pxNode->usFirstChild != SUBSCRIPTION_MANAGER_INVALID_INDEX )
+                    {
+                        pxNode = &( pxSubscriptionManager->xNodes[ pxNode->usFirstChild ] );
+                    }
+                    else if( pxNode->usPlusChild != SUBSCRIPTION_MANAGER_INVALID_INDEX )
+                    {
+                        pxNode = &( pxSubscriptionManager->xNodes[ pxNode->usPlusChild ] );
+                    }
+                    else
+                    {
+                        pxNode = &( pxSubscriptionManager->xNodes[ pxNode->usHashChild ] );
+                    }
+                }
+
+                usOwner = pxNode->usFirstSubscription;
+
+                while( usNode != ROOT_NODE_INDEX )
+                {
+                    pxNode = &( pxSubscriptionManager->xNodes[ usNode ] );
+
+                    if( pxSubscriptionManager->xSubscriptions[ pxNode->usOwner ].usFilterStringLength == 0U )
+                    {
+                        pxNode->usOwner = usOwner;
+                    }
+
+                    usNode = pxNode->usParent;
                 }
             }
         }
@@ -131,41 +794,76 @@ void SubscriptionManager_RemoveSubscription( SubscriptionElement_t * pxSubscript
 
 /*-----------------------------------------------------------*/
 
-bool SubscriptionManager_HandleIncomingPublishes( SubscriptionElement_t * pxSubscriptionList,
+bool SubscriptionManager_HandleIncomingPublishes( SubscriptionManager_t * pxSubscriptionManager,
                                                   MQTTPublishInfo_t * pxPublishInfo )
 {
-    int32_t lIndex = 0;
-    bool isMatched = false, publishHandled = false;
+    bool publishHandled = false;
 
-    if( ( pxSubscriptionList == NULL ) ||
-        ( pxPublishInfo == NULL ) )
+    if( ( pxSubscriptionManager == NULL ) ||
+        ( pxPublishInfo == NULL ) ||
+        ( pxPublishInfo->pTopicName == NULL ) ||
+        ( pxPublishInfo->topicNameLength == 0U ) )
     {
-        LogError( ( "Invalid parameter. pxSubscriptionList=%p, pxPublishInfo=%p,",
-                    pxSubscriptionList,
+        LogError( ( "Invalid parameter. pxSubscriptionManager=%p, pxPublishInfo=%p,",
+                    pxSubscriptionManager,
                     pxPublishInfo ) );
     }
     else
     {
-        for( lIndex = 0; lIndex < SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS; lIndex++ )
-        {
-            if( pxSubscriptionList[ lIndex ].usFilterStringLength > 0 )
-            {
-                MQTT_MatchTopic( pxPublishInfo->pTopicName,
-                                 pxPublishInfo->topicNameLength,
-                                 pxSubscriptionList[ lIndex ].pcSubscriptionFilterString,
-                                 pxSubscriptionList[ lIndex ].usFilterStringLength,
-                                 &isMatched );
+        publishHandled = prvDispatchLevel( pxSubscriptionManager,
+                                           ROOT_NODE_INDEX,
+                                           0U,
+                                           pxPublishInfo );
+    }
 
-                if( isMatched == true )
-                {
-                    pxSubscriptionList[ lIndex ].pxIncomingPublishCallback( pxSubscriptionList[ lIndex ].pvIncomingPublishCallbackContext,
-                                                                            pxPublishInfo );
+    return publishHandled;
+}
 
-                    publishHandled = true;
-                }
+/*-----------------------------------------------------------*/
+
+bool SubscriptionManager_FindSubscription( const SubscriptionManager_t * pxSubscriptionManager,
+                                           const char * pcTopicName,
+                                           uint16_t usTopicNameLength,
+                                           IncomingPubCallback_t * ppxIncomingPublishCallback,
+                                           void ** ppvIncomingPublishCallbackContext )
+{
+    const SubscriptionElement_t * pxElement = NULL;
+    uint16_t usElement = SUBSCRIPTION_MANAGER_INVALID_INDEX;
+    bool subscriptionFound = false;
+
+    if( ( pxSubscriptionManager == NULL ) ||
+        ( pcTopicName == NULL ) ||
+        ( usTopicNameLength == 0U ) ||
+        ( ppxIncomingPublishCallback == NULL ) )
+    {
+        LogError( ( "Invalid parameter. pxSubscriptionManager=%p, pcTopicName=%p, usTopicNameLength=%u,"
+                    " ppxIncomingPublishCallback=%p.",
+                    pxSubscriptionManager,
+                    pcTopicName,
+                    ( unsigned int ) usTopicNameLength,
+                    ppxIncomingPublishCallback ) );
+    }
+    else
+    {
+        usElement = prvFindLevel( pxSubscriptionManager,
+                                  ROOT_NODE_INDEX,
+                                  0U,
+                                  pcTopicName,
+                                  usTopicNameLength );
+
+        if( usElement != SUBSCRIPTION_MANAGER_INVALID_INDEX )
+        {
+            pxElement = &( pxSubscriptionManager->xSubscriptions[ usElement ] );
+            *ppxIncomingPublishCallback = pxElement->pxIncomingPublishCallback;
+
+            if( ppvIncomingPublishCallbackContext != NULL )
+            {
+                *ppvIncomingPublishCallbackContext = pxElement->pvIncomingPublishCallbackContext;
             }
+
+            subscriptionFound = true;
         }
     }
 
-    return publishHandled;
+    return subscriptionFound;
 }
@@ -65,6 +65,21 @@
     #define SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS    10U
 #endif
 
+/**
+ * @brief Number of nodes in the topic trie arena, including the root node.
+ *
+ * Every `/` separated level of a topic filter occupies one node, but levels
+ * shared between filters (e.g. "$aws/things/<ThingName>") are stored only once.
+ */
+#ifndef SUBSCRIPTION_MANAGER_MAX_TRIE_NODES
+    #define SUBSCRIPTION_MANAGER_MAX_TRIE_NODES    ( ( SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS * 4U ) + 1U )
+#endif
+
+/**
+ * @brief Index used to terminate the node and subscription chains.
+ */
+#define SUBSCRIPTION_MANAGER_INVALID_INDEX    ( 0xFFFFU )
+
 /**
  * @brief Callback function called when receiving a publish.
  *
@@ -77,11 +92,8 @@ typedef void (* IncomingPubCallback_t )( void * pvIncomingPublishCallbackContext
 /**
  * @brief An element in the list of subscriptions.
  *
- * This subscription manager implementation expects that the array of the
- * subscription elements used for storing subscriptions to be initialized to 0.
- *
  * @note This implementation allows multiple tasks to subscribe to the same topic.
- * In this case, another element is added to the subscription list, differing
+ * In this case, another element is chained to the same trie node, differing
  * in the intended publish callback. Also note that the topic filters are not
  * copied in the subscription manager and hence the topic filter strings need to
  * stay in scope until unsubscribed.
@@ -92,40 +104,83 @@ typedef struct subscriptionElement
     void * pvIncomingPublishCallbackContext;
     uint16_t usFilterStringLength;
     const char * pcSubscriptionFilterString;
+    uint16_t usTrieNode;       /**< Trie node of the last level of the filter. */
+    uint16_t usNextElement;    /**< Next subscription of the same node, or next free element. */
 } SubscriptionElement_t;
 
 /**
- * @brief Add a subscription to the subscription list.
+ * @brief A node of the topic trie. One node represents one topic level.
+ *
+ * The level string is not copied. It is read from the filter string of
+ * the subscription `usOwner` at `usLevelOffset`, which is the same for every
+ * filter sharing this node.
+ */
+typedef struct subscriptionTrieNode
+{
+    uint16_t usOwner;              /**< Subscription whose filter string holds the level. */
+    uint16_t usLevelOffset;        /**< Offset of the level in the filter string. */
+    uint16_t usLevelLength;        /**< Length of the level. */
+    uint16_t usParent;             /**< Parent node. */
+    uint16_t usFirstChild;         /**< First child of the literal levels. */
+    uint16_t usNextSibling;        /**< Next sibling, or next free node. */
+    uint16_t usPlusChild;          /**< Child of the single level wildcard "+". */
+    uint16_t usHashChild;          /**< Child of the multi level wildcard "#". */
+    uint16_t usFirstSubscription;  /**< Subscriptions whose filter ends at this node. */
+} SubscriptionTrieNode_t;
+
+/**
+ * @brief Subscriptions and the topic trie used to route incoming publishes.
+ *
+ * Must be initialized with SubscriptionManager_Init() before use.
+ */
+typedef struct subscriptionManager
+{
+    SubscriptionElement_t xSubscriptions[ SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS ];
+    SubscriptionTrieNode_t xNodes[ SUBSCRIPTION_MANAGER_MAX_TRIE_NODES ];
+    uint16_t usFreeSubscription;
+    uint16_t usFreeNode;
+} SubscriptionManager_t;
+
+/**
+ * @brief Initialize the subscription manager, removing every subscription.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager to initialize.
+ */
+void SubscriptionManager_Init( SubscriptionManager_t * pxSubscriptionManager );
+
+/**
+ * @brief Add a subscription to the subscription manager.
  *
  * @note Multiple tasks can be subscribed to the same topic with different
  * context-callback pairs. However, a single context-callback pair may only be
  * associated to the same topic filter once.
  *
- * @param[in] pxSubscriptionList  The pointer to the subscription list array.
+ * @param[in] pxSubscriptionManager The subscription manager.
  * @param[in] pcTopicFilterString Topic filter string of subscription.
  * @param[in] usTopicFilterLength Length of topic filter string.
  * @param[in] pxIncomingPublishCallback Callback function for the subscription.
  * @param[in] pvIncomingPublishCallbackContext Context for the subscription callback.
  *
- * @return `true` if subscription added or exists, `false` if insufficient memory.
+ * @return `true` if subscription added or exists, `false` if insufficient memory
+ * or the topic filter is malformed.
  */
-bool SubscriptionManager_AddSubscription( SubscriptionElement_t * pxSubscriptionList,
+bool SubscriptionManager_AddSubscription( SubscriptionManager_t * pxSubscriptionManager,
                                           const char * pcTopicFilterString,
                                           uint16_t usTopicFilterLength,
                                           IncomingPubCallback_t pxIncomingPublishCallback,
                                           void * pvIncomingPublishCallbackContext );
 
 /**
- * @brief Remove a subscription from the subscription list.
+ * @brief Remove a subscription from the subscription manager.
  *
- * @note If the topic filter exists multiple times in the subscription list,
+ * @note If the topic filter is registered with multiple callbacks,
  * then every instance of the subscription will be removed.
  *
- * @param[in] pxSubscriptionList  The pointer to the subscription list array.
+ * @param[in] pxSubscriptionManager The subscription manager.
  * @param[in] pcTopicFilterString Topic filter of subscription.
  * @param[in] usTopicFilterLength Length of topic filter.
  */
-void SubscriptionManager_RemoveSubscription( SubscriptionElement_t * pxSubscriptionList,
+void SubscriptionManager_RemoveSubscription( SubscriptionManager_t * pxSubscriptionManager,
                                              const char * pcTopicFilterString,
                                              uint16_t usTopicFilterLength );
 
@@ -133,13 +188,39 @@ void SubscriptionManager_RemoveSubscription( SubscriptionElement_t * pxSubscript
  * @brief Handle incoming publishes by invoking the callbacks registered
  * for the incoming publish's topic filter.
  *
- * @param[in] pxSubscriptionList  The pointer to the subscription list array.
+ * The topic is matched by walking the trie one level at a time, so the cost
+ * depends on the number of topic levels and not on the number of subscriptions.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
  * @param[in] pxPublishInfo Info of incoming publish.
  *
  * @return `true` if an application callback could be invoked;
  *  `false` otherwise.
  */
-bool SubscriptionManager_HandleIncomingPublishes( SubscriptionElement_t * pxSubscriptionList,
+bool SubscriptionManager_HandleIncomingPublishes( SubscriptionManager_t * pxSubscriptionManager,
                                                   MQTTPublishInfo_t * pxPublishInfo );
 
+/**
+ * @brief Find the subscription that an incoming publish on a topic name would
+ * be routed to, without invoking any callback.
+ *
+ * The trie is walked in the same order as
+ * SubscriptionManager_HandleIncomingPublishes(), and the first subscription
+ * whose callback would be invoked is returned.
+ *
+ * @param[in] pxSubscriptionManager The subscription manager.
+ * @param[in] pcTopicName Topic name to look up.
+ * @param[in] usTopicNameLength Length of topic name.
+ * @param[out] ppxIncomingPublishCallback Callback function of the subscription.
+ * @param[out] ppvIncomingPublishCallbackContext Context of the subscription callback.
+ * Can be NULL if the context is not needed.
+ *
+ * @return `true` if a subscription matches the topic name; `false` otherwise.
+ */
+bool SubscriptionManager_FindSubscription( const SubscriptionManager_t * pxSubscriptionManager,
+                                           const char * pcTopicName,
+                                           uint16_t usTopicNameLength,
+                                           IncomingPubCallback_t * ppxIncomingPublishCallback,
+                                           void ** ppvIncomingPublishCallbackContext );
+
 #endif /* MQTT_SUBSCRIPTION_MANAGER_H */
@@ -0,0 +1,133 @@
+/**
+ * @file se_bus_lock.h
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ *
+ * @details
+ * ECC608(I2C2)へのアクセスを排他する。atcab_*を呼ぶ前にロックを取得し、呼び終えたら解放する。
+ * ロックを使わないcryptoauthlibの利用者が転送中の場合は、I2Cの転送完了割り込みで起床して待つ
+ */
+#ifndef SE_BUS_LOCK_H_
+#define SE_BUS_LOCK_H_
+
+#ifdef __cplusplus // Provide Cplusplus Compatibility
+
+extern "C"
+{
+#endif /* end Provide Cplusplus Compatibility */
+
+// --------------------------------------------------
+// ###   システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+// --------------------------------------------------
+// ユーザ作成ヘッダの取り込み
+// --------------------------------------------------
+#include "common/include/application_define.h"
+
+    // --------------------------------------------------
+    // #defineマクロ
+    // --------------------------------------------------
+
+/**
+ * @brief ロックの取得とI2Cバスの解放を待つ時間の既定値
+ */
+#define SE_BUS_LOCK_DEFAULT_TIMEOUT_MS (5U * 1000U)
+
+/**
+ * @brief I2Cの転送完了割り込みを1回で待つ最大時間
+ *
+ * @details
+ * 割り込みの通知を受けられなかった場合も、この間隔でI2Cバスのビジー状態を確認し直す
+ */
+#define SE_BUS_LOCK_BUSY_WAIT_SLICE_MS (2U)
+
+/**
+ * @brief 失敗したアクセスをリトライするまでの最初の待機時間
+ *
+ * @details
+ * リトライするごとに2倍にし、#SE_BUS_RETRY_BACKOFF_MAX_MS で頭打ちにする
+ */
+#define SE_BUS_RETRY_BACKOFF_MIN_MS (2U)
+
+/**
+ * @brief 失敗したアクセスをリトライするまでの最大の待機時間
+ */
+#define SE_BUS_RETRY_BACKOFF_MAX_MS (100U)
+
+    // --------------------------------------------------
+    // #define関数マクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // typedef定義
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // enumタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // struct/unionタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // extern変数宣言
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // 関数プロトタイプ宣言
+    // --------------------------------------------------
+
+    /**
+     * @brief ロック用のセマフォを作成し、I2C2の転送完了コールバックを登録する。作成済みの場合は何もしない
+     *
+     * @details
+     * #bSEBusLock も初回の呼び出しで作成するため、呼ばなくてもよい。起動時に作成しておくと、失敗を早く検出できる
+     *
+     * @retval true  成功
+     * @retval false セマフォを作成できない
+     */
+    bool bSEBusLockInit(void);
+
+    /**
+     * @brief ロックを取得し、I2Cバスがビジー状態でなくなるまで待つ
+     *
+     * @param[in] ulTimeoutMs ロックの取得とI2Cバスの解放を待つ時間の合計
+     *
+     * @retval true  成功。使い終わったら #vSEBusUnlock を呼ぶこと
+     * @retval false タイムアウト、またはロック用のセマフォを作成できない
+     */
+    bool bSEBusLock(const uint32_t ulTimeoutMs);
+
+    /**
+     * @brief ロックを解放する
+     */
+    void vSEBusUnlock(void);
+
+    /**
+     * @brief 失敗したアクセスをリトライする前に待つ。ロックを解放してから呼ぶこと
+     *
+     * @param[in] uxRetryCount 何回目のリトライか。0から数える
+     */
+    void vSEBusBackoff(const uint8_t uxRetryCount);
+
+    /**
+     * @brief ロックの取得回数、待ち時間、リトライ回数をログに出力する
+     */
+    void vSEBusPrintStats(void);
+
+    // --------------------------------------------------
+    // インライン関数
+    // --------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end SE_BUS_LOCK_H_ */
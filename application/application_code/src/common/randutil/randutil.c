@@ -19,6 +19,7 @@
 // --------------------------------------------------
 // ユーザ作成ヘッダの取り込み
 // --------------------------------------------------
+#include "common/include/se_bus_lock.h"
 #include "include/randutil.h"
 
 // --------------------------------------------------
@@ -64,6 +65,12 @@
 size_t xGetRandomBytes(uint8_t *puxBuf, size_t xBytes)
 {
 #ifdef USE_ECC608_RANDOM
+    // FlashTaskのセキュアエレメントへのアクセスと排他する
+    if (bSEBusLock(SE_BUS_LOCK_DEFAULT_TIMEOUT_MS) == false)
+    {
+        return 0;
+    }
+
     // Initialize atcab
     ATCADevice xDevice = atcab_get_device();
 #    if 0
@@ -78,7 +85,8 @@ size_t xGetRandomBytes(uint8_t *puxBuf, size_t xBytes)
 
     uint8_t uxRandomValue[ECC608_GENERATE_RANDOM_BYTE] = {0};
     uint32_t i = 0;
-    while (1)
+    // 要求されたバイト数を書き込んだら終了する。生成に失敗した場合は書き込めたバイト数を返す
+    while (i < xBytes)
     {
         if (i % ECC608_GENERATE_RANDOM_BYTE == 0)
         {
@@ -87,9 +95,8 @@ size_t xGetRandomBytes(uint8_t *puxBuf, size_t xBytes)
         }
         puxBuf[i] = uxRandomValue[i % ECC608_GENERATE_RANDOM_BYTE];
         i++;
-        if (i > xBytes)
-            break;
     }
+    vSEBusUnlock();
     return i;
 #else
     for (int i = 0; i < xBytes; i++)
@@ -0,0 +1,271 @@
+/**
+ * @file se_bus_lock.c
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+
+// --------------------------------------------------
+// システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "definitions.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+// --------------------------------------------------
+// ユーザ作成ヘッダの取り込み
+// --------------------------------------------------
+#include "common/include/application_define.h"
+#include "include/se_bus_lock.h"
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#defineマクロ
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#define関数マクロ
+// --------------------------------------------------
+
+/**
+ * @brief ミリ秒をTickに変換する。1Tickに満たない場合は1Tickにする
+ */
+#define SE_BUS_MS_TO_TICKS(ms) ((pdMS_TO_TICKS(ms) > 0) ? pdMS_TO_TICKS(ms) : 1)
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するtypedef定義
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するenumタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するstruct/unionタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+/**
+ * @brief ロックの統計
+ */
+typedef struct
+{
+    uint32_t ulLockCount;      /**< ロックを取得した回数 */
+    uint32_t ulContendedCount; /**< ロックの取得またはI2Cバスの解放を待った回数 */
+    uint32_t ulBusBusyCount;   /**< ロックを取得した後にI2Cバスの解放を待った回数 */
+    uint32_t ulWaitTotalMs;    /**< 待った時間の合計 */
+    uint32_t ulWaitMaxMs;      /**< 待った時間の最大 */
+    uint32_t ulRetryCount;     /**< 失敗したアクセスをリトライした回数 */
+    uint32_t ulTimeoutCount;   /**< タイムアウトした回数 */
+} SEBusLockStats_t;
+
+// --------------------------------------------------
+// ファイル内で共有するstatic変数宣言
+// --------------------------------------------------
+
+/**
+ * @brief ECC608へのアクセスを排他するミューテックス
+ */
+static SemaphoreHandle_t gxBusMutex = NULL;
+
+/**
+ * @brief I2C2の転送完了を通知するセマフォ
+ */
+static SemaphoreHandle_t gxTransferDoneSemaphore = NULL;
+
+/**
+ * @brief ロックの統計
+ */
+static SEBusLockStats_t gxStats;
+
+// --------------------------------------------------
+// static関数プロトタイプ宣言
+// --------------------------------------------------
+
+/**
+ * @brief I2C2の転送が完了したときに割り込みから呼ばれるコールバック関数
+ *
+ * @param[in] xContext 使用しない
+ */
+static void vprvI2CTransferCallback(uintptr_t xContext);
+
+/**
+ * @brief ロック用のセマフォを作成し、I2C2の転送完了コールバックを登録する
+ *
+ * @details
+ * スケジューラを停止した状態で呼ぶこと。ログは出力しない。
+ * 途中で作成に失敗した場合は、作成済みのセマフォを削除して作成前の状態に戻す
+ *
+ * @retval true  成功、または作成済み
+ * @retval false セマフォを作成できない
+ */
+static bool bprvCreateLock(void);
+
+// --------------------------------------------------
+// 変数定義（staticを除く）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 関数定義（staticを除く）
+// --------------------------------------------------
+
+bool bSEBusLockInit(void)
+{
+    // 既に作成済み
+    if (gxBusMutex != NULL)
+    {
+        return true;
+    }
+
+    // 最初のロックの取得で作成する場合もあるため、複数のタスクが同時に作成しないようスケジューラを止める
+    vTaskSuspendAll();
+    const bool bResult = bprvCreateLock();
+    (void)xTaskResumeAll();
+
+    if (bResult == false)
+    {
+        APP_PRINTFError("Failed to create SE bus lock semaphore.");
+    }
+    return bResult;
+}
+
+bool bSEBusLock(const uint32_t ulTimeoutMs)
+{
+    // 初期化前に呼ばれた場合は、ここでロックを作成する
+    if (bSEBusLockInit() == false)
+    {
+        return false;
+    }
+
+    TickType_t xStartTick = xTaskGetTickCount();
+    TickType_t xTimeoutTicks = pdMS_TO_TICKS(ulTimeoutMs);
+
+    if (xSemaphoreTake(gxBusMutex, xTimeoutTicks) != pdTRUE)
+    {
+        gxStats.ulTimeoutCount++;
+        APP_PRINTFError("SE bus lock timed out. TIMEOUT = %ums", ulTimeoutMs);
+        return false;
+    }
+
+    // ロックを使わないcryptoauthlibの利用者が転送中の場合は、転送完了の割り込みで起床して確認し直す
+    bool bIsBusBusy = false;
+    (void)xSemaphoreTake(gxTransferDoneSemaphore, 0);
+    while (I2C2_IsBusy() == true)
+    {
+        bIsBusBusy = true;
+        if ((xTaskGetTickCount() - xStartTick) >= xTimeoutTicks)
+        {
+            gxStats.ulTimeoutCount++;
+            xSemaphoreGive(gxBusMutex);
+            APP_PRINTFError("The I2C bus remained busy and timed out. TIMEOUT = %ums", ulTimeoutMs);
+            return false;
+        }
+
+        (void)xSemaphoreTake(gxTransferDoneSemaphore, SE_BUS_MS_TO_TICKS(SE_BUS_LOCK_BUSY_WAIT_SLICE_MS));
+    }
+
+    // ロックを保持している間に統計を更新する
+    uint32_t ulWaitMs = (uint32_t)(xTaskGetTickCount() - xStartTick) * portTICK_PERIOD_MS;
+    gxStats.ulLockCount++;
+    if ((ulWaitMs > 0) || (bIsBusBusy == true))
+    {
+        gxStats.ulContendedCount++;
+        APP_PRINTFDebug("Waited %u ms for the SE bus. Bus busy: %d", ulWaitMs, bIsBusBusy);
+    }
+    if (bIsBusBusy == true)
+    {
+        gxStats.ulBusBusyCount++;
+    }
+    gxStats.ulWaitTotalMs += ulWaitMs;
+    if (ulWaitMs > gxStats.ulWaitMaxMs)
+    {
+        gxStats.ulWaitMaxMs = ulWaitMs;
+    }
+
+    return true;
+}
+
+void vSEBusUnlock(void)
+{
+    xSemaphoreGive(gxBusMutex);
+}
+
+void vSEBusBackoff(const uint8_t uxRetryCount)
+{
+    uint32_t ulDelayMs = SE_BUS_RETRY_BACKOFF_MAX_MS;
+    if (uxRetryCount < 16U)
+    {
+        ulDelayMs = SE_BUS_RETRY_BACKOFF_MIN_MS << uxRetryCount;
+        if (ulDelayMs > SE_BUS_RETRY_BACKOFF_MAX_MS)
+        {
+            ulDelayMs = SE_BUS_RETRY_BACKOFF_MAX_MS;
+        }
+    }
+
+    gxStats.ulRetryCount++;
+    vTaskDelay(SE_BUS_MS_TO_TICKS(ulDelayMs));
+}
+
+void vSEBusPrintStats(void)
+{
+    APP_PRINTFInfo("SE bus: %u locks, %u contended (%u bus busy), wait total %u ms, max %u ms, %u retries, %u timeouts.",
+                   gxStats.ulLockCount,
+                   gxStats.ulContendedCount,
+                   gxStats.ulBusBusyCount,
+                   gxStats.ulWaitTotalMs,
+                   gxStats.ulWaitMaxMs,
+                   gxStats.ulRetryCount,
+                   gxStats.ulTimeoutCount);
+}
+
+// --------------------------------------------------
+// static関数定義
+// --------------------------------------------------
+
+static bool bprvCreateLock(void)
+{
+    // スケジューラを止める前に別のタスクが作成した
+    if (gxBusMutex != NULL)
+    {
+        return true;
+    }
+
+    gxTransferDoneSemaphore = xSemaphoreCreateBinary();
+    if (gxTransferDoneSemaphore == NULL)
+    {
+        return false;
+    }
+
+    // ロックを待つタスクの優先度を引き継がせるため、ミューテックスを使う
+    SemaphoreHandle_t xBusMutex = xSemaphoreCreateMutex();
+    if (xBusMutex == NULL)
+    {
+        vSemaphoreDelete(gxTransferDoneSemaphore);
+        gxTransferDoneSemaphore = NULL;
+        return false;
+    }
+
+    memset(&gxStats, 0x00, sizeof(gxStats));
+    I2C2_CallbackRegister(vprvI2CTransferCallback, (uintptr_t)NULL);
+
+    // 作成済みかの判定に使うため、全ての準備が済んでから公開する
+    gxBusMutex = xBusMutex;
+    return true;
+}
+
+static void vprvI2CTransferCallback(uintptr_t xContext)
+{
+    (void)xContext;
+
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    (void)xSemaphoreGiveFromISR(gxTransferDoneSemaphore, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+// --------------------------------------------------
+// Unit Test用関数定義(関数のプロトタイプ宣言は「自身のファイル名+ "_test.h"」で宣言されていること)
+// --------------------------------------------------
+#if (BUILD_MODE_TEST == 1) /* BUILD_MODE_TESTが定義されているとき */
+#endif                     /* end  BUILD_MODE_TEST */
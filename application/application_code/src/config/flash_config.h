@@ -64,6 +64,39 @@ extern "C"
  */
 #define FLASH_RESPONSE_TIMEOUT_MS (5U * 1000U)
 
+/**
+ * @brief 1回の書き込みの依頼でまとめて書き込める情報の最大数
+ *
+ * @details
+ * 書き込む情報は依頼ごとにタイプ別の領域へコピーするため、書き込める情報のタイプの数より大きくする必要はない
+ */
+#define FLASH_TASK_WRITE_ENTRY_MAX_NUM (4U)
+
+/**
+ * @brief Wi-Fi情報をRAMにキャッシュするか
+ *
+ * @details
+ * Wi-Fiのパスワードを含むため、既定ではキャッシュしない。
+ * 1にした場合も、書き込み時にキャッシュを無効化するとともに0x00でクリアする
+ */
+#define FLASH_CACHE_WIFI_INFO_ENABLE (0)
+
+/**
+ * @brief キャッシュの読み出しを、シーケンス番号で更新中の読み出しを検出する方式にするか
+ *
+ * @details
+ * 1の場合、読み出し中に書き換えられたときは読み直す。0の場合、クリティカルセクション内でコピーする
+ */
+#define FLASH_CACHE_SEQUENCE_ENABLE (1)
+
+/**
+ * @brief キャッシュの読み出し中に書き換えられた場合に読み直す回数
+ *
+ * @details
+ * 読み直しても揃わない場合は、FlashTaskに読み込みを依頼する
+ */
+#define FLASH_CACHE_READ_RETRY_NUM (3U)
+
 #ifdef __cplusplus
 }
 #endif
@@ -67,6 +67,14 @@ extern "C"
  */
 #define MQTT_MAX_SUBSCRIBE_NUM (10U)
 
+/**
+ * @brief Subscribe済みトピック一覧に保持するトピックの最大長
+ *
+ * @details
+ * トピックは一覧にコピーして保持し、SubscriptionManagerにもコピーを登録する。これより長いトピックは振り分けを登録しない
+ */
+#define MQTT_SUBSCRIBE_TOPIC_MAX_LENGTH (128U)
+
 /**
  * @brief MQTTPub/Sub時のタイムアウト時間
  *
@@ -80,6 +88,271 @@ extern "C"
  */
 #define AWS_IOT_MQTT_PORT (8883U)
 
+/**
+ * @brief MQTTの永続セッションを使用するか
+ *
+ * @details
+ * 1の場合、cleanSession = false で接続する。
+ * ブローカーにセッションが残っていた場合(Session Present)は、保持しているSubscription一覧から受信Publishの振り分けを復元し、
+ * 同じトピックへのSubscribeをブローカーへ送信せずに完了させる。また、切断中にブローカーが保持したQoS1のPublishも再接続後に受信される。
+ *
+ * @note AWS IoTのセッション保持期間を過ぎている場合はSession Presentとならず、通常通りSubscribeが行われる。
+ */
+#define MQTT_PERSISTENT_SESSION_ENABLE (0)
+
+/**
+ * @brief 通信断からの自動再接続で、1回目の再接続を待機する時間の上限
+ *
+ * @details
+ * 再接続に失敗するたびに上限を2倍にし、0から上限までの乱数時間(Full Jitter)待機してから再接続する。
+ * ブローカー側の障害復旧時に、多数のデバイスの再接続が同時に集中することを防ぐ。
+ */
+#define MQTT_RECONNECT_BACKOFF_BASE_MS (500U)
+
+/**
+ * @brief 通信断からの自動再接続で、再接続を待機する時間の上限の最大値
+ */
+#define MQTT_RECONNECT_BACKOFF_MAX_MS (60U * 1000U)
+
+/**
+ * @brief MQTTの再接続中にPub/Subを行う場合に、接続の回復を待機する時間
+ */
+#define MQTT_CONNECTION_WAIT_TIMEOUT_MS (10U * 1000U)
+
+/**
+ * @brief 同時に送信中(PUBACK待ち)にできるQoS1 Publishの最大数
+ *
+ * @details
+ * 送信ストアはこの数だけ確保される。上限に達している場合、QoS1のPublishは空きが出るまで待機する。
+ */
+#define MQTT_QOS1_INFLIGHT_WINDOW (2U)
+
+/**
+ * @brief QoS1 Publishの送信ストアに保存できるトピックの最大長
+ */
+#define MQTT_QOS1_STORE_TOPIC_MAX_LENGTH (128U)
+
+/**
+ * @brief QoS1 Publishの送信ストアに保存できるペイロードの最大長
+ *
+ * @details
+ * Device Shadowの更新ペイロード(UPDATE_DEVICE_SHADOW_PAYLOAD_BUFFER_SIZE)が収まるサイズにする
+ */
+#define MQTT_QOS1_STORE_PAYLOAD_MAX_LENGTH (1024U)
+
+/**
+ * @brief 一括系のコマンドが待っている間に、対話系のコマンドを続けて処理できる最大回数
+ *
+ * @details
+ * 対話系のコマンドが途切れない場合でも、この回数ごとに一括系のコマンドを1つ処理し、一括系が処理されなくなることを防ぐ
+ */
+#define MQTT_AGENT_BULK_STARVATION_LIMIT (4U)
+
+/**
+ * @brief 一括系のコマンドを発行するタスクとして登録できる最大数
+ */
+#define MQTT_BULK_TASK_MAX_NUM (2U)
+
+/**
+ * @brief MQTT Agentのコマンドキューの待ち時間を計測するか
+ *
+ * @details
+ * 1の場合、優先度ごとにエンキューからMQTT Taskが取り出すまでの待ち時間を計測し、MQTT Task終了時に出力する。
+ * OTA中の鍵状態の報告の遅延を確認する際に使用する。
+ */
+#define MQTT_AGENT_ENABLE_QUEUE_STATS (0)
+
+/**
+ * @brief 受信したPublishのコールバック関数を、MQTT Taskとは別のDispatch Taskで実行できるようにするか
+ *
+ * @details
+ * 1の場合、#MQTT_DISPATCH_MODE_WORKER でSubscribeしたトピックは、受信したPublishをバッファプールにコピーしてDispatch Taskで実行する。
+ * 0の場合、すべてのコールバック関数をMQTT Taskで実行する。
+ */
+#define MQTT_DISPATCH_WORKER_ENABLE (1)
+
+/**
+ * @brief Dispatch Taskに渡すPublishのバッファ数
+ *
+ * @details
+ * 1つあたり #MQTT_BUFFER_SIZE のRAMを使用する。空きがない場合、受信したPublishは破棄される。
+ * Dispatch Taskで実行するコールバック関数が処理する間に続けて届くPublishの数以上にすること。
+ */
+#define MQTT_DISPATCH_BUFFER_POOL_NUM (2U)
+
+/**
+ * @brief Dispatch Taskで実行するコールバック関数と引数の組み合わせの最大数
+ */
+#define MQTT_DISPATCH_SUBSCRIBER_MAX_NUM (4U)
+
+/**
+ * @brief eMQTTCommunicationInit()で使用するトランスポート層
+ *
+ * @details
+ * 通常はTLS(#MQTT_TRANSPORT_TYPE_TLS)を使用する。
+ * 性能計測時は、平文のMQTT(#MQTT_TRANSPORT_TYPE_PLAINTEXT)やメモリ上のパイプ(#MQTT_TRANSPORT_TYPE_PIPE)に切り替えることで、
+ * TLSやネットワークの影響を除いてMQTT処理の性能を計測できる。
+ *
+ * @warning 平文のMQTTは計測用のローカルブローカーとの接続にのみ使用すること
+ */
+#define MQTT_DEFAULT_TRANSPORT_TYPE (MQTT_TRANSPORT_TYPE_TLS)
+
+/**
+ * @brief 平文のMQTTで接続するブローカーのホスト名
+ *
+ * @details
+ * #MQTT_TRANSPORT_TYPE_PLAINTEXT を選択した場合に使用する。計測用のローカルブローカーのアドレスを設定すること。
+ * 空の場合は平文のMQTTで接続しない。#MQTT_DEFAULT_TRANSPORT_TYPE に平文のMQTTを選択した場合はビルドエラーにする
+ */
+#define MQTT_PLAINTEXT_BROKER_HOST_NAME ""
+
+/**
+ * @brief 平文のMQTTで接続するブローカーのポート番号
+ */
+#define MQTT_PLAINTEXT_BROKER_PORT (1883U)
+
+/**
+ * @brief パイプトランスポートの片方向あたりのバッファサイズ
+ *
+ * @details
+ * #MQTT_TRANSPORT_TYPE_PIPE を選択した場合に、送信/受信それぞれでこのサイズのRAMを使用する
+ */
+#define MQTT_PIPE_TRANSPORT_BUFFER_SIZE (MQTT_BUFFER_SIZE)
+
+/**
+ * @brief 受信したPublishのペイロードを、MQTT通信バッファに格納せずにチャンク単位で受け取れるようにするか
+ *
+ * @details
+ * 1の場合、#eMQTTRegisterStreamReceive で登録したトピックのPublishは、トランスポート層から読み込んだペイロードを
+ * #MQTT_STREAM_CHUNK_SIZE ずつ登録したコールバック関数に渡す。
+ * ペイロードが #MQTT_BUFFER_SIZE を超えるPublishも受信できる。
+ */
+#define MQTT_STREAM_RECEIVE_ENABLE (1)
+
+/**
+ * @brief ストリーム受信でコールバック関数に渡す1回あたりの最大サイズ
+ */
+#define MQTT_STREAM_CHUNK_SIZE (512U)
+
+/**
+ * @brief ストリーム受信を登録できるトピックフィルタの最大数
+ */
+#define MQTT_STREAM_SUBSCRIBER_MAX_NUM (2U)
+
+/**
+ * @brief ストリーム受信の対象にできるトピックの最大長
+ *
+ * @details
+ * これより長いトピックのPublishは、ストリーム受信を登録していても通常の受信となる
+ */
+#define MQTT_STREAM_TOPIC_MAX_LENGTH (128U)
+
+/**
+ * @brief Publishの送信レートをトピックの種類ごとに制限するか
+ *
+ * @details
+ * 1の場合、トピックの種類(Device Shadow / OTA(Jobs, Streams) / その他)ごとのトークンバケットで送信レートを制限する。
+ * 上限を超えたPublishは失敗にせず、トークンが補充されるまで待機してから送信する。
+ * AWS IoTの接続あたりのPublishレート制限による切断と、それに伴うTLSの再接続を防ぐ。
+ */
+#define MQTT_PUBLISH_RATE_LIMIT_ENABLE (1)
+
+/**
+ * @brief Device ShadowのPublishの1秒あたりの送信数の上限
+ *
+ * @details
+ * 各種類の1秒あたりの送信数と連続して送信できる最大数は1以上にすること
+ */
+#define MQTT_RATE_LIMIT_SHADOW_PUBLISH_PER_SECOND (5U)
+
+/**
+ * @brief Device ShadowのPublishを連続して送信できる最大数
+ */
+#define MQTT_RATE_LIMIT_SHADOW_BURST (5U)
+
+/**
+ * @brief OTA(Jobs, Streams)のPublishの1秒あたりの送信数の上限
+ */
+#define MQTT_RATE_LIMIT_OTA_PUBLISH_PER_SECOND (10U)
+
+/**
+ * @brief OTA(Jobs, Streams)のPublishを連続して送信できる最大数
+ */
+#define MQTT_RATE_LIMIT_OTA_BURST (10U)
+
+/**
+ * @brief その他のPublishの1秒あたりの送信数の上限
+ */
+#define MQTT_RATE_LIMIT_DEFAULT_PUBLISH_PER_SECOND (10U)
+
+/**
+ * @brief その他のPublishを連続して送信できる最大数
+ */
+#define MQTT_RATE_LIMIT_DEFAULT_BURST (10U)
+
+/**
+ * @brief 送信待ちの間に同じトピックへの新しいPublishで上書きできる(Coalesce)Publishの最大数
+ *
+ * @details
+ * #eMQTTPublishCoalescable で送信レートの上限を超えたPublishを保持する領域の数。
+ * 1つあたり #MQTT_RATE_LIMIT_COALESCE_TOPIC_MAX_LENGTH + #MQTT_RATE_LIMIT_COALESCE_PAYLOAD_MAX_LENGTH のRAMを使用する
+ */
+#define MQTT_RATE_LIMIT_COALESCE_SLOT_NUM (2U)
+
+/**
+ * @brief 送信待ちのPublishを上書きできる場合に保持できるトピックの最大長
+ */
+#define MQTT_RATE_LIMIT_COALESCE_TOPIC_MAX_LENGTH (128U)
+
+/**
+ * @brief 送信待ちのPublishを上書きできる場合に保持できるペイロードの最大長
+ */
+#define MQTT_RATE_LIMIT_COALESCE_PAYLOAD_MAX_LENGTH (512U)
+
+/**
+ * @brief MQTT通信の統計情報(メトリクス)を収集するか
+ *
+ * @details
+ * 1の場合、以下を収集する。
+ * - Publish/Subscribe/Unsubscribeごとの、MQTT Agentへのエンキューから完了までの時間のヒストグラム
+ * - MQTT Agentのコマンドキューの滞留数
+ * - 送信/受信したバイト数
+ * - 再接続の試行回数/成功回数
+ * - KeepAlive(PINGREQ→PINGRESP)の往復時間
+ *
+ * 収集した内容は #vMQTTPrintMetrics でデバッグ出力に表示でき、#MQTT_METRICS_PUBLISH_INTERVAL_MS ごとに診断用トピックへPublishする。
+ *
+ * @note 診断用トピック(#MQTT_METRICS_TOPIC_FORMAT)へのPublishはIoTポリシーで許可されていないため、
+ *       有効にする場合はIoTポリシーに当該トピックへのiot:Publishを追加するか、#MQTT_METRICS_PUBLISH_INTERVAL_MS を0にすること
+ */
+#define MQTT_METRICS_ENABLE (0)
+
+/**
+ * @brief メトリクスを診断用トピックへPublishする間隔
+ *
+ * @details
+ * 0の場合、定期的なPublishは行わない
+ */
+#define MQTT_METRICS_PUBLISH_INTERVAL_MS (5U * 60U * 1000U)
+
+/**
+ * @brief メトリクスをPublishする診断用トピックのフォーマット
+ *
+ * @details
+ * %sにはThing名が入る
+ */
+#define MQTT_METRICS_TOPIC_FORMAT "dt/%s/mqtt-metrics"
+
+/**
+ * @brief メトリクスをPublishする診断用トピックの最大長
+ */
+#define MQTT_METRICS_TOPIC_MAX_LENGTH (64U)
+
+/**
+ * @brief メトリクスをJSONに変換する際のバッファサイズ
+ */
+#define MQTT_METRICS_SNAPSHOT_BUFFER_SIZE (384U)
+
 #ifdef __cplusplus
 }
 #endif
@@ -53,6 +53,132 @@ extern "C"
  */
 #define OTA_APP_SHUTDOWN_TIMEOUT_MS    (10000U)
 
+/**
+ * @brief HTTPでデータブロックを取得する場合に保持できるURLの最大バイト数
+ *
+ * @details
+ * ジョブドキュメントで指定される署名付きURLはクエリ文字列を含めて1000バイトを超えることがある
+ */
+#define OTA_APP_HTTP_URL_MAX_SIZE (1536U)
+
+/**
+ * @brief HTTPでデータブロックを取得する場合に保持できるホスト名の最大バイト数
+ */
+#define OTA_APP_HTTP_HOST_MAX_SIZE (128U)
+
+/**
+ * @brief HTTPのリクエストヘッダを作成するバッファのサイズ
+ *
+ * @details
+ * リクエストヘッダにはURLのパスとクエリ文字列がそのまま入るため、#OTA_APP_HTTP_URL_MAX_SIZE より大きくする
+ */
+#define OTA_APP_HTTP_REQUEST_BUFFER_SIZE (OTA_APP_HTTP_URL_MAX_SIZE + 256U)
+
+/**
+ * @brief HTTPのレスポンスヘッダを格納するために、レスポンスのバッファに追加で確保するサイズ
+ *
+ * @details
+ * レスポンスのバッファは、このサイズに1回のリクエストで取得するデータブロックの合計サイズを加えたサイズになる
+ */
+#define OTA_APP_HTTP_RESPONSE_HEADER_SIZE (1024U)
+
+/**
+ * @brief HTTPでデータブロックを取得する場合のソケット送信/受信時のタイムアウト
+ */
+#define OTA_APP_HTTP_SEND_RECV_TIMEOUT_MS (5000U)
+
+/**
+ * @brief 受信中のイメージを書き込むバンクの先頭アドレス
+ *
+ * @details
+ * 消去済みかの確認で書き込み直後のデータを読むため、キャッシュを経由しないKSEG1のアドレスを指定する
+ */
+#define OTA_APP_STAGING_IMAGE_ADDRESS (0xB0080000U)
+
+/**
+ * @brief データブロックの書き込み先のページの消去が進むのを待つ時間(ms)
+ *
+ * @details
+ * 消去が1ページも進まずにこの時間が経過した場合は、書き込みを失敗とする
+ */
+#define OTA_APP_STAGING_ERASE_WAIT_TIMEOUT_MS (1000U)
+
+/**
+ * @brief FWのダウンロードを再起動後に続きから再開するか
+ *
+ * @details
+ * 1の場合、受信済みのデータブロックのビットマップを #OTA_APP_RESUME_CHECKPOINT_INTERVAL_BLOCKS ごとに内部フラッシュに記録する。
+ * 再起動後に同じイメージのジョブを受信したときは、記録したビットマップを復元し、受信していないデータブロックのみ要求する。
+ *
+ * @note 記録には #OTA_APP_RESUME_CHECKPOINT_ADDRESS のページを使用する。
+ *       有効にする場合は、アプリケーションのイメージがこのページに配置されないようリンカスクリプトで予約すること
+ */
+#define OTA_APP_RESUME_ENABLE (0)
+
+/**
+ * @brief 受信済みのデータブロックを内部フラッシュに記録する間隔(データブロック数)
+ *
+ * @details
+ * 小さくすると再起動時に受信し直すデータブロックが減るが、内部フラッシュの書き込み回数が増える
+ */
+#define OTA_APP_RESUME_CHECKPOINT_INTERVAL_BLOCKS (16U)
+
+/**
+ * @brief 受信済みのデータブロックを記録する内部フラッシュのページの先頭アドレス
+ *
+ * @details
+ * 実行中のバンクの最終ページを使用する。アプリケーションのイメージがこのページに配置されないようにリンカスクリプトで予約すること
+ */
+#define OTA_APP_RESUME_CHECKPOINT_ADDRESS (0xB007F000U)
+
+/**
+ * @brief 受信中のイメージを書き込むバンクのサイズ
+ *
+ * @details
+ * ジョブを受け付けたときに、受信するイメージのサイズ分を優先度の低いタスクで消去しておく。
+ * 続きから受信する場合は、バンクを切り替えた後に記録のページとなる最終ページを書き込み先から除く
+ */
+#if (OTA_APP_RESUME_ENABLE == 1)
+#    define OTA_APP_STAGING_IMAGE_SIZE (0x0007F000U)
+#else
+#    define OTA_APP_STAGING_IMAGE_SIZE (0x00080000U)
+#endif
+
+/**
+ * @brief ユーザー操作に応答する処理の間、データブロックの要求を止めるか
+ *
+ * @details
+ * 1の場合、解施錠やShadowの送受信の間はデータブロックを要求せず、終わってから #OTA_APP_DOWNLOAD_SCHEDULER_RESUME_DELAY_MS 後に再開する。
+ * また、ブローカーとの往復時間(RTT)が最小値より伸びた分に応じて、データブロックの要求の間隔を空ける
+ */
+#define OTA_APP_DOWNLOAD_SCHEDULER_ENABLE (1)
+
+/**
+ * @brief ユーザー操作に応答する処理が終わってから、データブロックの要求を再開するまでの時間(ms)
+ *
+ * @details
+ * 解施錠の後に続くShadowの更新など、連続する処理の間で再開しないようにする
+ */
+#define OTA_APP_DOWNLOAD_SCHEDULER_RESUME_DELAY_MS (300U)
+
+/**
+ * @brief データブロックの要求を止める最大時間(ms)
+ *
+ * @details
+ * 処理の終了が通知されない場合でもダウンロードが止まり続けないよう、この時間が経過したら要求する
+ */
+#define OTA_APP_DOWNLOAD_SCHEDULER_MAX_PAUSE_MS (10000U)
+
+/**
+ * @brief RTTが最小値より伸びた分に掛けて、データブロックの要求の間隔にする係数
+ */
+#define OTA_APP_DOWNLOAD_SCHEDULER_RTT_GAIN (2U)
+
+/**
+ * @brief データブロックの要求の間隔の最大値(ms)
+ */
+#define OTA_APP_DOWNLOAD_SCHEDULER_MAX_INTERVAL_MS (2000U)
+
     // --------------------------------------------------
     // #define関数マクロ
     // --------------------------------------------------
@@ -15,9 +15,12 @@ extern "C"
 //! DeviceModeSwitchキューのサイズ
 #define DEVICE_MODE_SWITCH_QUEUE_LENGTH (5U)
 
-//! MQTT Communication Task内で使用するMQTT Agentが受け取るコマンドの最大数
+//! MQTT Communication Task内で使用するMQTT Agentが受け取る対話系(Shadow、鍵状態の報告等)コマンドの最大数
 #define MQTT_AGENT_COMMAND_QUEUE_LENGTH (5U)
 
+//! MQTT Communication Task内で使用するMQTT Agentが受け取る一括系(OTA等)コマンドの最大数
+#define MQTT_AGENT_BULK_COMMAND_QUEUE_LENGTH (5U)
+
 //! Flashタスクが同時に受付できるコマンドの最大数
 #define FLASH_TASK_COMMAND_QUEUE_LENGTH (5U)
 
@@ -59,6 +59,20 @@ extern "C"
  */
 #define MQTT_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
 
+/**
+ * @brief MQTT Dispatch Taskのスタックサイズ
+ *
+ * @details
+ * Subscribeしたトピックのコールバック関数(JSONの解析等)を実行するため、MQTTTaskより大きくする
+ */
+#define MQTT_DISPATCH_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE * 2)
+
+/**
+ * @brief MQTT Dispatch Taskの優先度
+ *
+ */
+#define MQTT_DISPATCH_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+
 /**
  * @brief FlashTaskのタスクサイズ
  *
@@ -137,6 +151,23 @@ extern "C"
  */
 #define OTA_AGENT_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
 
+/**
+ * @brief OTAStagingEraserTaskのスタックサイズ
+ *
+ * @details
+ * 消去の完了を待つ間にNVMの割り込みとセマフォを使用し、失敗時はAPP_PRINTFでログを出力するため、OTAAgentTaskと同じくログ出力の分を見込む
+ */
+#define OTA_STAGING_ERASER_TASK_SIZE (configMINIMAL_STACK_SIZE * 2)
+
+/**
+ * @brief OTAStagingEraserTaskの優先度
+ *
+ * @details
+ * 消去はデータブロックの書き込みより先に進んでいればよいため、OTAAgentTaskとLockTaskより低くする。
+ * 書き込みが消去に追いついた場合は、OTAAgentTaskが待つ間に消去が進む
+ */
+#define OTA_STAGING_ERASER_TASK_PRIORITY (tskIDLE_PRIORITY)
+
 #ifdef __cplusplus
 }
 #endif
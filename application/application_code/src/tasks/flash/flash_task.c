@@ -13,6 +13,7 @@
 
 #include "FreeRTOS.h"
 #include "queue.h"
+#include "semphr.h"
 
 // --------------------------------------------------
 // ユーザ作成ヘッダの取り込み
@@ -30,6 +31,11 @@
 // 自ファイル内でのみ使用する#defineマクロ
 // --------------------------------------------------
 
+/**
+ * @brief キャッシュのシーケンス番号とデータの読み書きの順序を、コンパイラに入れ替えさせないためのバリア
+ */
+#define FLASH_CACHE_BARRIER() __asm__ volatile("" ::: "memory")
+
 // --------------------------------------------------
 // 自ファイル内でのみ使用する#define関数マクロ
 // --------------------------------------------------
@@ -42,6 +48,30 @@
 // 自ファイル内でのみ使用するenumタグ定義（typedefを同時に行う）
 // --------------------------------------------------
 
+/**
+ * @brief キャッシュするレコード
+ */
+typedef enum
+{
+    FLASH_CACHE_RECORD_WIFI_INFO = 0,      /**< Wi-Fi情報 */
+    FLASH_CACHE_RECORD_AWS_IOT_ENDPOINT,   /**< AWS IoT Endpoint */
+    FLASH_CACHE_RECORD_PROVISIONING_FLAG,  /**< プロビジョニングフラグ */
+    FLASH_CACHE_RECORD_FACTORY_THING_NAME, /**< 工場出荷ThingName */
+    FLASH_CACHE_RECORD_USUAL_THING_NAME,   /**< 普段使い用のThingName */
+    FLASH_CACHE_RECORD_NUM,                /**< レコードの数 */
+} FlashCacheRecord_t;
+
+/**
+ * @brief FlashTaskへの依頼の状態
+ */
+typedef enum
+{
+    FLASH_REQUEST_STATE_FREE = 0,  /**< 未使用 */
+    FLASH_REQUEST_STATE_PENDING,   /**< 依頼の作成中、FlashTaskの処理待ち、または処理中 */
+    FLASH_REQUEST_STATE_DONE,      /**< 処理済みで、待機しているタスクが結果を取り出すのを待っている */
+    FLASH_REQUEST_STATE_ABANDONED, /**< 待機しているタスクがタイムアウトした。処理前なら反映せず、処理中なら処理した後に結果を破棄する */
+} FlashRequestState_t;
+
 // --------------------------------------------------
 // 自ファイル内でのみ使用するstruct/unionタグ定義（typedefを同時に行う）
 // --------------------------------------------------
@@ -52,14 +82,14 @@
 typedef struct
 {
     /**
-     * @brief WriteType
+     * @brief まとめて書き込む情報
      */
-    WriteFlashType_t xWriteType;
+    const FlashWriteEntry_t *pxEntries;
 
     /**
-     * @brief 書き込みたいデータ
+     * @brief pxEntriesの要素数
      */
-    void *pvData;
+    uint8_t uxEntryNum;
 } FlashWriteParameters_t;
 
 typedef struct
@@ -81,60 +111,106 @@ typedef struct
 } FlashReadParameters_t;
 
 /**
- * @brief ThingNameをキャッシュするための構造体
+ * @brief レコードごとのキャッシュの定義
+ */
+typedef struct
+{
+    ReadFlashType_t eReadType;   /**< キャッシュから読み出す情報のタイプ */
+    WriteFlashType_t eWriteType; /**< キャッシュを無効化する書き込みのタイプ。書き込まないレコードは0 */
+    void *pvCache;               /**< キャッシュするバッファ */
+    uint32_t uxSize;             /**< キャッシュするバッファのサイズ */
+    bool bIsEnabled;             /**< キャッシュするか */
+} FlashCacheRecordDef_t;
+
+/**
+ * @brief レコードごとのキャッシュの状態
+ *
+ * @details
+ * FlashTaskのみが書き換え、読み出しは任意のタスクから行う
  */
 typedef struct
 {
     /**
-     * @brief キャッシュを持っているか
+     * @brief シーケンス番号。書き換え中は奇数
      */
-    bool bHasCache;
+    volatile uint32_t ulSequence;
 
     /**
-     * @brief キャッシュするThingName
+     * @brief キャッシュを持っているか
      */
-    ThingName_t xThingName;
+    volatile bool bIsValid;
+} FlashCacheState_t;
 
-} ThingNameCache_t;
+/**
+ * @brief 依頼ごとに読み書きする情報を保持する領域
+ *
+ * @details
+ * 情報のタイプごとに領域を持つ。依頼したタスクのバッファをFlashTaskから参照しないよう、書き込む情報はここにコピーし、
+ * 読み込んだ情報はここから依頼したタスクのバッファにコピーする
+ */
+typedef struct
+{
+    WiFiInfo_t xWiFiInfo;                 /**< Wi-Fi情報 */
+    AWSIoTEndpoint_t xIoTEndpoint;        /**< AWS IoT Endpoint */
+    ProvisioningFlag_t xProvisioningFlag; /**< プロビジョニングフラグ */
+    FactoryThingName_t xFactoryThingName; /**< 工場出荷ThingName */
+    ThingName_t xUsualThingName;          /**< 普段使い用のThingName */
+} FlashRequestData_t;
 
 /**
- * @brief Flash Taskのキューに渡すためのパラメータ
+ * @brief FlashTaskへの依頼
+ *
+ * @details
+ * 依頼はgxRequestPoolから確保し、キューにはポインタを渡す。
+ * 同期の依頼は待機しているタスクが結果を取り出した後に、非同期の依頼はFlashTaskが完了を通知した後に解放する
  */
 typedef struct
 {
+    /**
+     * @brief 依頼の状態
+     */
+    volatile FlashRequestState_t eState;
+
     /**
      * @brief Flashに対する書き込みか。falseの場合は読み込み。
      */
     bool bIsWrite;
 
     /**
-     * @brief 書き込み/読み込みの完了を待機しているタスクのハンドル
+     * @brief 読み込む情報のタイプ。bIsWriteがfalseの場合のみ使用する
      */
-    TaskHandle_t xTaskNotifyHandle;
+    ReadFlashType_t eReadFlashType;
 
     /**
-     * @brief bIsWriteがtrueの場合はFlashWriteParameters_tが入り、falseの場合はFlashReadParameters_tが入る
-     *
+     * @brief 書き込む情報。pvWriteDataはxDataの領域を指す。bIsWriteがtrueの場合のみ使用する
      */
-    union
-    {
-        /**
-         * @brief FlashのWriteに必要なパラメータ
-         */
-        FlashWriteParameters_t *pxWriteParam;
+    FlashWriteEntry_t xEntries[FLASH_TASK_WRITE_ENTRY_MAX_NUM];
 
-        /**
-         * @brief FlashのReadに必要なパラメータ
-         */
-        FlashReadParameters_t *pxReadParam;
-    } u;
+    /**
+     * @brief xEntriesの要素数
+     */
+    uint8_t uxEntryNum;
 
     /**
-     * @brief Flashに対する読み書き結果
+     * @brief 読み書きする情報
+     */
+    FlashRequestData_t xData;
+
+    /**
+     * @brief 完了を待機しているタスクのハンドル。非同期の依頼の場合はNULL
      */
-    FlashTaskResult_t xResult;
+    TaskHandle_t xWaitingTaskHandle;
 
-} FlashTaskAddQueueParameters_t;
+    /**
+     * @brief 非同期の依頼の完了を通知する方法
+     */
+    FlashTaskCompletion_t xCompletion;
+
+    /**
+     * @brief Flashに対する読み書き結果
+     */
+    FlashTaskResult_t eResult;
+} FlashRequest_t;
 
 // --------------------------------------------------
 // ファイル内で共有するstatic変数宣言
@@ -151,9 +227,85 @@ static TaskHandle_t gxTaskHandle = NULL;
 static QueueHandle_t gxQueueHandle = NULL;
 
 /**
- * @brief ThingNameのキャッシュに使用するバッファ
+ * @brief FlashTaskへの依頼を保持する領域
  */
-static ThingNameCache_t gxThingNameCache = {0x00};
+static FlashRequest_t gxRequestPool[FLASH_TASK_COMMAND_QUEUE_LENGTH];
+
+/**
+ * @brief gxRequestPoolの未使用の依頼の数を数えるセマフォ
+ */
+static SemaphoreHandle_t gxRequestPoolSemaphore = NULL;
+
+/**
+ * @brief Wi-Fi情報のキャッシュ
+ */
+static WiFiInfo_t gxWiFiInfoCache;
+
+/**
+ * @brief AWS IoT Endpointのキャッシュ
+ */
+static AWSIoTEndpoint_t gxIoTEndpointCache;
+
+/**
+ * @brief プロビジョニングフラグのキャッシュ
+ */
+static ProvisioningFlag_t gxProvisioningFlagCache;
+
+/**
+ * @brief 工場出荷ThingNameのキャッシュ
+ */
+static FactoryThingName_t gxFactoryThingNameCache;
+
+/**
+ * @brief 普段使い用のThingNameのキャッシュ
+ */
+static ThingName_t gxUsualThingNameCache;
+
+/**
+ * @brief レコードごとのキャッシュの定義
+ */
+static const FlashCacheRecordDef_t gxFlashCacheRecordDefs[FLASH_CACHE_RECORD_NUM] = {
+    [FLASH_CACHE_RECORD_WIFI_INFO] = {
+        .eReadType = READ_FLASH_TYPE_WIFI_INFO,
+        .eWriteType = WRITE_FLASH_TYPE_WIFI_INFO,
+        .pvCache = &gxWiFiInfoCache,
+        .uxSize = sizeof(gxWiFiInfoCache),
+        .bIsEnabled = (FLASH_CACHE_WIFI_INFO_ENABLE == 1),
+    },
+    [FLASH_CACHE_RECORD_AWS_IOT_ENDPOINT] = {
+        .eReadType = READ_FLASH_TYPE_AWS_IOT_ENDPOINT,
+        .eWriteType = WRITE_FLASH_TYPE_AWS_IOT_ENDPOINT,
+        .pvCache = &gxIoTEndpointCache,
+        .uxSize = sizeof(gxIoTEndpointCache),
+        .bIsEnabled = true,
+    },
+    [FLASH_CACHE_RECORD_PROVISIONING_FLAG] = {
+        .eReadType = READ_FLASH_TYPE_PROVISIONING_FLAG,
+        .eWriteType = WRITE_FLASH_TYPE_PROVISIONING_FLAG,
+        .pvCache = &gxProvisioningFlagCache,
+        .uxSize = sizeof(gxProvisioningFlagCache),
+        .bIsEnabled = true,
+    },
+    [FLASH_CACHE_RECORD_FACTORY_THING_NAME] = {
+        .eReadType = READ_FLASH_TYPE_FACTORY_THING_NAME,
+        .eWriteType = (WriteFlashType_t)0,
+        .pvCache = &gxFactoryThingNameCache,
+        .uxSize = sizeof(gxFactoryThingNameCache),
+        .bIsEnabled = true,
+    },
+    [FLASH_CACHE_RECORD_USUAL_THING_NAME] = {
+        .eReadType = READ_FLASH_TYPE_USUAL_THING_NAME,
+        .eWriteType = WRITE_FLASH_TYPE_USUAL_THING_NAME,
+        .pvCache = &gxUsualThingNameCache,
+        .uxSize = sizeof(gxUsualThingNameCache),
+        .bIsEnabled = true,
+    },
+};
+
+/**
+ * @brief レコードごとのキャッシュの状態
+ */
+static FlashCacheState_t gxFlashCacheStates[FLASH_CACHE_RECORD_NUM];
 
 // --------------------------------------------------
 // static関数プロトタイプ宣言
@@ -169,6 +321,9 @@ static void vprvFlashTask(void *pvParam);
 /**
  * @brief FlashにWriteする
  *
+ * @details
+ * 全ての情報を書き込む内容に反映してから、変更のある部分のみまとめて書き込む
+ *
  * @param[in] pxFlashWriteParams Writeに必要なパラメータ
  *
  * @retval true  成功
@@ -176,9 +331,22 @@ static void vprvFlashTask(void *pvParam);
  */
 static bool bprvFlashWriteProcess(const FlashWriteParameters_t *pxFlashWriteParams);
 
+/**
+ * @brief 1つの情報を書き込む内容に反映する
+ *
+ * @param[in] pxEntry 書き込みたい情報
+ *
+ * @retval true  成功
+ * @retval false 失敗
+ */
+static bool bprvStageWriteEntry(const FlashWriteEntry_t *pxEntry);
+
 /**
  * @brief FlashからReadする
  *
+ * @details
+ * キャッシュを持っている場合はキャッシュから読み出し、持っていない場合はセキュアエレメントから読み込んでキャッシュする
+ *
  * @param[in] pxFlashReadParams Readに必要なパラメータ
  *
  * @retval true  成功
@@ -187,37 +355,184 @@ static bool bprvFlashWriteProcess(const FlashWriteParameters_t *pxFlashWritePara
 static bool bprvFlashReadProcess(const FlashReadParameters_t *pxFlashReadParams);
 
 /**
- * @brief 受け取ったQueueの中身をバリデートする
+ * @brief セキュアエレメントからReadする
+ *
+ * @param[in] pxFlashReadParams Readに必要なパラメータ
+ *
+ * @retval true  成功
+ * @retval false 失敗
+ */
+static bool bprvFlashReadFromSE(const FlashReadParameters_t *pxFlashReadParams);
+
+/**
+ * @brief 受け取った依頼の中身をバリデートする
  *
- * @param[in] pxParam 受け取ったQueueのデータ
+ * @param[in] pxRequest 受け取った依頼
  *
  * @retval true  バリデート成功
  * @retval false バリデート失敗
  */
-static bool bprvValidateQueueParam(const FlashTaskAddQueueParameters_t *pxParam);
+static bool bprvValidateRequest(FlashRequest_t *pxRequest);
+
+/**
+ * @brief 読み込みの依頼を作成する
+ *
+ * @param[in]  eReadFlashType 取得したい情報のタイプ
+ * @param[out] ppxRequest     作成した依頼
+ *
+ * @retval FLASH_TASK_RESULT_SUCCESS    成功
+ * @retval FLASH_TASK_RESULT_BAD_RESULT 読み込めない情報のタイプ
+ * @retval FLASH_TASK_RESULT_TIMEOUT    依頼を保持する領域が空かない
+ */
+static FlashTaskResult_t eprvCreateReadRequest(const ReadFlashType_t eReadFlashType, FlashRequest_t **ppxRequest);
+
+/**
+ * @brief 書き込みの依頼を作成し、書き込む情報を依頼の領域にコピーする
+ *
+ * @param[in]  pxEntries  書き込みたい情報の配列
+ * @param[in]  uxEntryNum pxEntriesの要素数
+ * @param[out] ppxRequest 作成した依頼
+ *
+ * @retval FLASH_TASK_RESULT_SUCCESS    成功
+ * @retval FLASH_TASK_RESULT_BAD_RESULT パラメータエラー
+ * @retval FLASH_TASK_RESULT_TIMEOUT    依頼を保持する領域が空かない
+ */
+static FlashTaskResult_t eprvCreateWriteRequest(const FlashWriteEntry_t *pxEntries, const uint8_t uxEntryNum, FlashRequest_t **ppxRequest);
+
+/**
+ * @brief gxRequestPoolから依頼を確保する。空いていない場合は #FLASH_RESPONSE_TIMEOUT_MS まで待つ
+ *
+ * @param[out] ppxRequest 確保した依頼
+ *
+ * @retval true  成功
+ * @retval false 依頼を保持する領域が空かない
+ */
+static bool bprvAllocateRequest(FlashRequest_t **ppxRequest);
+
+/**
+ * @brief 依頼を解放する。読み書きした情報は0x00でクリアする
+ *
+ * @param[in] pxRequest 解放する依頼
+ */
+static void vprvReleaseRequest(FlashRequest_t *pxRequest);
+
+/**
+ * @brief 依頼をFlashTaskのキューに送る
+ *
+ * @param[in] pxRequest 送る依頼
+ *
+ * @retval true  成功
+ * @retval false 失敗
+ */
+static bool bprvSubmitRequest(FlashRequest_t *pxRequest);
 
 /**
- * @brief キャッシュに普段使用用のThingNameがある場合は取得する
+ * @brief 依頼をFlashTaskのキューに送り、完了を待つ
  *
- * @param[out] pxThingName 格納するバッファ
+ * @details
+ * タイムアウトした場合は依頼を手放し、FlashTaskが処理した後に結果を破棄させる。
+ * タイムアウト以外の場合は本関数内で依頼を解放する
+ *
+ * @param[in]  pxRequest    送る依頼
+ * @param[out] pvBuffer     読み込んだ情報を格納するバッファ。書き込みの場合はNULL
+ * @param[in]  uxBufferSize バッファのサイズ
+ *
+ * @return Flashに対する読み書き結果
+ */
+static FlashTaskResult_t eprvSubmitAndWait(FlashRequest_t *pxRequest, void *pvBuffer, const uint32_t uxBufferSize);
+
+/**
+ * @brief FlashTaskで処理した依頼の結果を、依頼したタスクに渡す。FlashTaskからのみ呼ぶ
+ *
+ * @param[in] pxRequest 処理した依頼
+ * @param[in] eResult   Flashに対する読み書き結果
+ */
+static void vprvCompleteRequest(FlashRequest_t *pxRequest, const FlashTaskResult_t eResult);
+
+/**
+ * @brief 非同期の依頼の完了を通知する
+ *
+ * @param[in] pxCompletion 完了を通知する方法
+ * @param[in] eResult      Flashに対する読み書き結果
+ * @param[in] pvData       読み込んだ情報。書き込みの場合や失敗した場合はNULL
+ * @param[in] uxDataSize   pvDataのサイズ
+ */
+static void vprvNotifyCompletion(const FlashTaskCompletion_t *pxCompletion, const FlashTaskResult_t eResult, const void *pvData, const uint32_t uxDataSize);
+
+/**
+ * @brief 読み込む情報のタイプに対応する、依頼の領域を取得する
+ *
+ * @param[in]  pxData         依頼の領域
+ * @param[in]  eReadFlashType 取得したい情報のタイプ
+ * @param[out] puxDataSize    領域のサイズ
+ *
+ * @return 依頼の領域。読み込めない情報のタイプの場合はNULL
+ */
+static void *pvprvGetReadData(FlashRequestData_t *pxData, const ReadFlashType_t eReadFlashType, uint32_t *puxDataSize);
+
+/**
+ * @brief 書き込む情報のタイプに対応する、依頼の領域を取得する
+ *
+ * @param[in]  pxData          依頼の領域
+ * @param[in]  eWriteFlashType 書き込みたい情報のタイプ
+ * @param[out] puxDataSize     領域のサイズ
+ *
+ * @return 依頼の領域。書き込めない情報のタイプの場合はNULL
+ */
+static void *pvprvGetWriteData(FlashRequestData_t *pxData, const WriteFlashType_t eWriteFlashType, uint32_t *puxDataSize);
+
+/**
+ * @brief 最適化で省略されないよう、volatile経由でバッファを0x00でクリアする
+ *
+ * @param[out] pvBuffer バッファ
+ * @param[in]  uxSize   バッファのサイズ
+ */
+static void vprvZeroize(void *pvBuffer, const uint32_t uxSize);
+
+/**
+ * @brief 情報のタイプに対応するキャッシュのレコードを探す
+ *
+ * @param[in]  eReadFlashType 取得したい情報のタイプ
+ * @param[out] peRecord       キャッシュのレコード
+ *
+ * @retval true  キャッシュするレコードがある
+ * @retval false キャッシュしない情報のタイプ
+ */
+static bool bprvFindCacheRecord(const ReadFlashType_t eReadFlashType, FlashCacheRecord_t *peRecord);
+
+/**
+ * @brief キャッシュを持っている場合は取得する。任意のタスクから呼べる
+ *
+ * @param[in]  eReadFlashType 取得したい情報のタイプ
+ * @param[out] pvBuffer       格納するバッファ
+ * @param[in]  uxBufferSize   バッファのサイズ
  *
  * @retval true  キャッシュからの読み取り成功
- * @retval false キャッシュが空であり読み取り失敗
+ * @retval false キャッシュが空、書き換え中、またはバッファのサイズが一致しない
+ */
+static bool bprvGetCache(const ReadFlashType_t eReadFlashType, void *pvBuffer, const uint32_t uxBufferSize);
+
+/**
+ * @brief キャッシュをセットする。FlashTaskからのみ呼ぶ
+ *
+ * @param[in] eReadFlashType 取得した情報のタイプ
+ * @param[in] pvData         セキュアエレメントから取得した情報
  */
-static bool bprvGetUsualThingNameCache(ThingName_t *pxThingName);
+static void vprvSetCache(const ReadFlashType_t eReadFlashType, const void *pvData);
 
 /**
- * @brief 普段使い用のThingNameのキャッシュをクリアする
+ * @brief キャッシュを無効化し、バッファを0x00でクリアする。FlashTaskからのみ呼ぶ
  *
+ * @param[in] eRecord キャッシュのレコード
  */
-static void vprvClearUsualThingNameCache(void);
+static void vprvInvalidateCache(const FlashCacheRecord_t eRecord);
 
 /**
- * @brief キャッシュに普段使い用のキャッシュをセットする
+ * @brief 書き込む情報のタイプに対応するキャッシュを無効化する。FlashTaskからのみ呼ぶ
  *
- * @param[in] pxThingName セキュアエレメントから取得したThingName
+ * @param[in] eWriteFlashType 書き込む情報のタイプ
  */
-static void vprvSetUsualThingNameCache(const ThingName_t *pxThingName);
+static void vprvInvalidateCacheForWrite(const WriteFlashType_t eWriteFlashType);
 
 // --------------------------------------------------
 // 変数定義（staticを除く）
@@ -232,10 +547,22 @@ FlashTaskResult_t eFlashTaskInit(void)
 
     APP_PRINTFDebug("Flash Task Init started.");
 
-    // Queueの作成
+    // 依頼を保持する領域の空きを数えるセマフォの作成
+    if (gxRequestPoolSemaphore == NULL)
+    {
+        gxRequestPoolSemaphore = xSemaphoreCreateCounting(FLASH_TASK_COMMAND_QUEUE_LENGTH, FLASH_TASK_COMMAND_QUEUE_LENGTH);
+
+        if (gxRequestPoolSemaphore == NULL)
+        {
+            APP_PRINTFError("Flash task create semaphore failed.");
+            return FLASH_TASK_RESULT_FAILED;
+        }
+    }
+
+    // Queueの作成。依頼はgxRequestPoolに保持するため、送信で待つことはない
     if (gxQueueHandle == NULL)
     {
-        gxQueueHandle = xQueueCreate(FLASH_TASK_COMMAND_QUEUE_LENGTH, sizeof(FlashTaskAddQueueParameters_t *));
+        gxQueueHandle = xQueueCreate(FLASH_TASK_COMMAND_QUEUE_LENGTH, sizeof(FlashRequest_t *));
 
         if (gxQueueHandle == NULL)
         {
@@ -269,8 +596,11 @@ FlashTaskResult_t eFlashTaskInit(void)
         return FLASH_TASK_RESULT_FAILED;
     }
 
-    // 普段使い用のThingNameのキャッシュをクリア
-    vprvClearUsualThingNameCache();
+    // キャッシュをクリア
+    for (uint8_t i = 0; i < FLASH_CACHE_RECORD_NUM; i++)
+    {
+        vprvInvalidateCache((FlashCacheRecord_t)i);
+    }
 
     return FLASH_TASK_RESULT_SUCCESS;
 }
@@ -285,86 +615,135 @@ FlashTaskResult_t eReadFlashInfo(const ReadFlashType_t eReadFlashType,
         return FLASH_TASK_RESULT_BAD_RESULT;
     }
 
-    // ---- Queueに送るパラメータを決定
-    FlashTaskAddQueueParameters_t xQParams = {0x00};
-    FlashTaskAddQueueParameters_t *pxQParams = NULL;
-    FlashReadParameters_t xReadParams = {0x00};
-
-    xReadParams.pvBuffer = pvBuffer;
-    xReadParams.xReadType = eReadFlashType;
-    xReadParams.uxBufferSize = uxBufferSize;
-
-    xQParams.bIsWrite = false;
-    xQParams.u.pxReadParam = &xReadParams;
-    xQParams.xResult = FLASH_TASK_RESULT_FAILED;
-    xQParams.xTaskNotifyHandle = xTaskGetCurrentTaskHandle();
-    pxQParams = &xQParams;
+    // キャッシュを持っている場合は、FlashTaskを介さずに取得
+    if (bprvGetCache(eReadFlashType, pvBuffer, uxBufferSize) == true)
+    {
+        APP_PRINTFDebug("Flash read served from cache. Type: 0x%X", eReadFlashType);
+        return FLASH_TASK_RESULT_SUCCESS;
+    }
 
-    // QueueにSend
-    if (xQueueSend(gxQueueHandle, &pxQParams, pdMS_TO_TICKS(FLASH_RESPONSE_TIMEOUT_MS)) != pdTRUE)
+    // ---- FlashTaskへの依頼を作成
+    FlashRequest_t *pxRequest = NULL;
+    FlashTaskResult_t eResult = eprvCreateReadRequest(eReadFlashType, &pxRequest);
+    if (eResult != FLASH_TASK_RESULT_SUCCESS)
     {
-        APP_PRINTFError("Flash read command failed. Timeout.");
-        return FLASH_TASK_RESULT_TIMEOUT;
+        APP_PRINTFError("Flash read command failed. Reason: %d", eResult);
+        return eResult;
     }
 
-    // Queueに送信したコマンドが処理されるまで待機
-    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(FLASH_RESPONSE_TIMEOUT_MS)) != pdTRUE)
+    uint32_t uxDataSize = 0;
+    (void)pvprvGetReadData(&pxRequest->xData, eReadFlashType, &uxDataSize);
+    if (uxBufferSize != uxDataSize)
     {
-        APP_PRINTFError("Flash read command waiting timeout.");
-        return FLASH_TASK_RESULT_TIMEOUT;
+        APP_PRINTFError("BufferSize size is not match.");
+        vprvReleaseRequest(pxRequest);
+        return FLASH_TASK_RESULT_BAD_RESULT;
     }
 
-    if (xQParams.xResult == FLASH_TASK_RESULT_SUCCESS)
+    // FlashTaskに依頼し、処理されるまで待機
+    eResult = eprvSubmitAndWait(pxRequest, pvBuffer, uxBufferSize);
+    if (eResult == FLASH_TASK_RESULT_SUCCESS)
     {
         APP_PRINTFDebug("Flash read success.");
     }
 
-    return xQParams.xResult;
+    return eResult;
 }
 
 FlashTaskResult_t eWriteFlashInfo(const WriteFlashType_t eWriteFlashType,
                                   const void *pvWriteData)
 {
-    if (pvWriteData == NULL)
+    FlashWriteEntry_t xEntry = {
+        .eWriteFlashType = eWriteFlashType,
+        .pvWriteData = pvWriteData,
+    };
+    return eWriteFlashInfoBatch(&xEntry, 1);
+}
+
+FlashTaskResult_t eWriteFlashInfoBatch(const FlashWriteEntry_t *pxEntries,
+                                       const uint8_t uxEntryNum)
+{
+    // ---- FlashTaskへの依頼を作成
+    FlashRequest_t *pxRequest = NULL;
+    FlashTaskResult_t eResult = eprvCreateWriteRequest(pxEntries, uxEntryNum, &pxRequest);
+    if (eResult != FLASH_TASK_RESULT_SUCCESS)
     {
-        APP_PRINTFError("Buffer is null");
-        return FLASH_TASK_RESULT_BAD_RESULT;
+        APP_PRINTFError("Flash write command failed. Reason: %d", eResult);
+        return eResult;
     }
 
-    // ---- Queueに送るパラメータを決定
-    FlashWriteParameters_t xWriteParm = {0x00};
-    FlashTaskAddQueueParameters_t xQParams = {0x00};
-    FlashTaskAddQueueParameters_t *pxQParams;
+    // FlashTaskに依頼し、処理されるまで待機
+    eResult = eprvSubmitAndWait(pxRequest, NULL, 0);
+    if (eResult == FLASH_TASK_RESULT_SUCCESS)
+    {
+        APP_PRINTFDebug("Flash write success.");
+    }
 
-    xWriteParm.pvData = (void *)pvWriteData;
-    xWriteParm.xWriteType = eWriteFlashType;
+    return eResult;
+}
 
-    xQParams.bIsWrite = true;
-    xQParams.u.pxWriteParam = &xWriteParm;
-    xQParams.xResult = FLASH_TASK_RESULT_FAILED;
-    xQParams.xTaskNotifyHandle = xTaskGetCurrentTaskHandle();
-    pxQParams = &xQParams;
+FlashTaskResult_t eReadFlashInfoAsync(const ReadFlashType_t eReadFlashType,
+                                      const FlashTaskCompletion_t *pxCompletion)
+{
+    // ---- FlashTaskへの依頼を作成
+    FlashRequest_t *pxRequest = NULL;
+    FlashTaskResult_t eResult = eprvCreateReadRequest(eReadFlashType, &pxRequest);
+    if (eResult != FLASH_TASK_RESULT_SUCCESS)
+    {
+        APP_PRINTFError("Flash read request failed. Reason: %d", eResult);
+        return eResult;
+    }
 
-    // QueueにSend
-    if (xQueueSend(gxQueueHandle, &pxQParams, pdMS_TO_TICKS(FLASH_RESPONSE_TIMEOUT_MS)) != pdTRUE)
+    if (pxCompletion != NULL)
     {
-        APP_PRINTFError("Flash write command failed. Timeout.");
-        return FLASH_TASK_RESULT_TIMEOUT;
+        pxRequest->xCompletion = *pxCompletion;
     }
 
-    // Queueに送信したコマンドが処理されるまで待機
-    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(FLASH_RESPONSE_TIMEOUT_MS)) != pdTRUE)
+    // キャッシュを持っている場合は、FlashTaskを介さずに完了させる
+    uint32_t uxDataSize = 0;
+    void *pvData = pvprvGetReadData(&pxRequest->xData, eReadFlashType, &uxDataSize);
+    if (bprvGetCache(eReadFlashType, pvData, uxDataSize) == true)
     {
-        APP_PRINTFError("Flash write command waiting timeout.");
-        return FLASH_TASK_RESULT_TIMEOUT;
+        APP_PRINTFDebug("Flash read served from cache. Type: 0x%X", eReadFlashType);
+        vprvNotifyCompletion(&pxRequest->xCompletion, FLASH_TASK_RESULT_SUCCESS, pvData, uxDataSize);
+        vprvReleaseRequest(pxRequest);
+        return FLASH_TASK_RESULT_SUCCESS;
     }
 
-    if (xQParams.xResult == FLASH_TASK_RESULT_SUCCESS)
+    if (bprvSubmitRequest(pxRequest) == false)
     {
-        APP_PRINTFDebug("Flash write success.");
+        vprvReleaseRequest(pxRequest);
+        return FLASH_TASK_RESULT_FAILED;
+    }
+
+    return FLASH_TASK_RESULT_SUCCESS;
+}
+
+FlashTaskResult_t eWriteFlashInfoBatchAsync(const FlashWriteEntry_t *pxEntries,
+                                            const uint8_t uxEntryNum,
+                                            const FlashTaskCompletion_t *pxCompletion)
+{
+    // ---- FlashTaskへの依頼を作成
+    FlashRequest_t *pxRequest = NULL;
+    FlashTaskResult_t eResult = eprvCreateWriteRequest(pxEntries, uxEntryNum, &pxRequest);
+    if (eResult != FLASH_TASK_RESULT_SUCCESS)
+    {
+        APP_PRINTFError("Flash write request failed. Reason: %d", eResult);
+        return eResult;
+    }
+
+    if (pxCompletion != NULL)
+    {
+        pxRequest->xCompletion = *pxCompletion;
     }
 
-    return xQParams.xResult;
+    if (bprvSubmitRequest(pxRequest) == false)
+    {
+        vprvReleaseRequest(pxRequest);
+        return FLASH_TASK_RESULT_FAILED;
+    }
+
+    return FLASH_TASK_RESULT_SUCCESS;
 }
 
 // --------------------------------------------------
@@ -380,68 +759,83 @@ static void vprvFlashTask(void *pvParam)
     }
 
     QueueHandle_t xQHandle = (QueueHandle_t)pvParam; // Queueのハンドル
-    FlashTaskAddQueueParameters_t *pxQParams;        // Queueから受け取るパラメータのバッファ
+    FlashRequest_t *pxRequest;                       // Queueから受け取る依頼
     bool bIsFlashProcessingSuccess = false;          // Flashに対して読み書きした結果を格納するバッファ
 
     while (true)
     {
-        if (xQueueReceive(xQHandle, &pxQParams, portMAX_DELAY))
+        if (xQueueReceive(xQHandle, &pxRequest, portMAX_DELAY))
         {
-            // Queueの中身をバリデート
-            if (bprvValidateQueueParam(pxQParams) == false)
+            if (pxRequest == NULL)
+            {
+                APP_PRINTFError("Queue data is null.");
+                continue;
+            }
+
+            // 待機しているタスクが既にタイムアウトした依頼は、呼び出し元に失敗として扱われているため反映せずに破棄する
+            if (pxRequest->eState == FLASH_REQUEST_STATE_ABANDONED)
+            {
+                vprvCompleteRequest(pxRequest, FLASH_TASK_RESULT_FAILED);
+                continue;
+            }
+
+            // 依頼の中身をバリデート
+            if (bprvValidateRequest(pxRequest) == false)
             {
+                vprvCompleteRequest(pxRequest, FLASH_TASK_RESULT_FAILED);
                 continue;
             }
 
             // WriteかReadを判定する
-            if (pxQParams->bIsWrite == true)
+            if (pxRequest->bIsWrite == true)
             {
                 // Flashに対する書き込みをお行う
-                bIsFlashProcessingSuccess = bprvFlashWriteProcess(pxQParams->u.pxWriteParam);
+                FlashWriteParameters_t xWriteParams = {
+                    .pxEntries = pxRequest->xEntries,
+                    .uxEntryNum = pxRequest->uxEntryNum,
+                };
+                bIsFlashProcessingSuccess = bprvFlashWriteProcess(&xWriteParams);
             }
             else
             {
                 // Flashに対して読み込みを行う
-                bIsFlashProcessingSuccess = bprvFlashReadProcess(pxQParams->u.pxReadParam);
+                FlashReadParameters_t xReadParams = {0x00};
+                xReadParams.xReadType = pxRequest->eReadFlashType;
+                xReadParams.pvBuffer = pvprvGetReadData(&pxRequest->xData, pxRequest->eReadFlashType, &xReadParams.uxBufferSize);
+                bIsFlashProcessingSuccess = bprvFlashReadProcess(&xReadParams);
             }
 
-            // 結果を格納して待機しているタスクに通知を発信する
-            pxQParams->xResult = bIsFlashProcessingSuccess == true
-                                     ? FLASH_TASK_RESULT_SUCCESS
-                                     : FLASH_TASK_RESULT_FAILED;
-            xTaskNotifyGive(pxQParams->xTaskNotifyHandle);
+            // 結果を依頼したタスクに渡す
+            vprvCompleteRequest(pxRequest,
+                                bIsFlashProcessingSuccess == true
+                                    ? FLASH_TASK_RESULT_SUCCESS
+                                    : FLASH_TASK_RESULT_FAILED);
         }
 
         PRINT_TASK_REMAINING_STACK_SIZE();
     }
 }
 
-static bool bprvValidateQueueParam(const FlashTaskAddQueueParameters_t *pxParam)
+static bool bprvValidateRequest(FlashRequest_t *pxRequest)
 {
-    if (pxParam == NULL)
+    if (pxRequest->eState != FLASH_REQUEST_STATE_PENDING)
     {
-        APP_PRINTFError("Queue data is null.");
+        APP_PRINTFError("Request state is invalid. State: %d", pxRequest->eState);
         return false;
     }
 
-    if (pxParam->xTaskNotifyHandle == NULL)
+    if (pxRequest->bIsWrite == true)
     {
-        APP_PRINTFError("Task notify handle is null.");
-        return false;
-    }
-
-    if (pxParam->bIsWrite == true)
-    {
-        if (pxParam->u.pxWriteParam == NULL || pxParam->u.pxWriteParam->pvData == NULL)
+        if (pxRequest->uxEntryNum == 0 || pxRequest->uxEntryNum > FLASH_TASK_WRITE_ENTRY_MAX_NUM)
         {
-
             APP_PRINTFError("Write param is invalid.");
             return false;
         }
     }
     else
     {
-        if (pxParam->u.pxReadParam == NULL || pxParam->u.pxReadParam->pvBuffer == NULL || pxParam->u.pxReadParam->uxBufferSize == 0)
+        uint32_t uxDataSize = 0;
+        if (pvprvGetReadData(&pxRequest->xData, pxRequest->eReadFlashType, &uxDataSize) == NULL)
         {
             APP_PRINTFError("Read param is invalid.");
             return false;
@@ -451,16 +845,345 @@ static bool bprvValidateQueueParam(const FlashTaskAddQueueParameters_t *pxParam)
     return true;
 }
 
+static FlashTaskResult_t eprvCreateReadRequest(const ReadFlashType_t eReadFlashType, FlashRequest_t **ppxRequest)
+{
+    FlashRequest_t *pxRequest = NULL;
+    if (bprvAllocateRequest(&pxRequest) == false)
+    {
+        return FLASH_TASK_RESULT_TIMEOUT;
+    }
+
+    // 読み込めるタイプかは領域の有無で判定する
+    uint32_t uxDataSize = 0;
+    if (pvprvGetReadData(&pxRequest->xData, eReadFlashType, &uxDataSize) == NULL)
+    {
+        APP_PRINTFError("Unkown read type.");
+        vprvReleaseRequest(pxRequest);
+        return FLASH_TASK_RESULT_BAD_RESULT;
+    }
+
+    pxRequest->bIsWrite = false;
+    pxRequest->eReadFlashType = eReadFlashType;
+    *ppxRequest = pxRequest;
+    return FLASH_TASK_RESULT_SUCCESS;
+}
+
+static FlashTaskResult_t eprvCreateWriteRequest(const FlashWriteEntry_t *pxEntries, const uint8_t uxEntryNum, FlashRequest_t **ppxRequest)
+{
+    if ((pxEntries == NULL) || (uxEntryNum == 0))
+    {
+        APP_PRINTFError("Buffer is null");
+        return FLASH_TASK_RESULT_BAD_RESULT;
+    }
+    if (uxEntryNum > FLASH_TASK_WRITE_ENTRY_MAX_NUM)
+    {
+        APP_PRINTFError("Too many write entries. Num: %d", uxEntryNum);
+        return FLASH_TASK_RESULT_BAD_RESULT;
+    }
+    for (uint8_t i = 0; i < uxEntryNum; i++)
+    {
+        if (pxEntries[i].pvWriteData == NULL)
+        {
+            APP_PRINTFError("Buffer is null");
+            return FLASH_TASK_RESULT_BAD_RESULT;
+        }
+    }
+
+    FlashRequest_t *pxRequest = NULL;
+    if (bprvAllocateRequest(&pxRequest) == false)
+    {
+        return FLASH_TASK_RESULT_TIMEOUT;
+    }
+
+    // 書き込む情報を依頼の領域にコピーし、FlashTaskから呼び出し元のバッファを参照しないようにする
+    for (uint8_t i = 0; i < uxEntryNum; i++)
+    {
+        uint32_t uxDataSize = 0;
+        void *pvData = pvprvGetWriteData(&pxRequest->xData, pxEntries[i].eWriteFlashType, &uxDataSize);
+        if (pvData == NULL)
+        {
+            APP_PRINTFError("Unkown Wite type.");
+            vprvReleaseRequest(pxRequest);
+            return FLASH_TASK_RESULT_BAD_RESULT;
+        }
+
+        memcpy(pvData, pxEntries[i].pvWriteData, uxDataSize);
+        pxRequest->xEntries[i].eWriteFlashType = pxEntries[i].eWriteFlashType;
+        pxRequest->xEntries[i].pvWriteData = pvData;
+    }
+
+    pxRequest->bIsWrite = true;
+    pxRequest->uxEntryNum = uxEntryNum;
+    *ppxRequest = pxRequest;
+    return FLASH_TASK_RESULT_SUCCESS;
+}
+
+static bool bprvAllocateRequest(FlashRequest_t **ppxRequest)
+{
+    if (gxRequestPoolSemaphore == NULL)
+    {
+        APP_PRINTFError("Flash task is not initialized.");
+        return false;
+    }
+
+    if (xSemaphoreTake(gxRequestPoolSemaphore, pdMS_TO_TICKS(FLASH_RESPONSE_TIMEOUT_MS)) != pdTRUE)
+    {
+        APP_PRINTFError("No free flash request. Timeout.");
+        return false;
+    }
+
+    FlashRequest_t *pxRequest = NULL;
+    taskENTER_CRITICAL();
+    for (uint8_t i = 0; i < FLASH_TASK_COMMAND_QUEUE_LENGTH; i++)
+    {
+        if (gxRequestPool[i].eState == FLASH_REQUEST_STATE_FREE)
+        {
+            pxRequest = &gxRequestPool[i];
+            pxRequest->eState = FLASH_REQUEST_STATE_PENDING;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    // セマフォの数と未使用の依頼の数は一致するため、通常は見つからないことはない
+    if (pxRequest == NULL)
+    {
+        APP_PRINTFError("Flash request pool is inconsistent.");
+        (void)xSemaphoreGive(gxRequestPoolSemaphore);
+        return false;
+    }
+
+    // xDataは解放時にクリア済み
+    pxRequest->bIsWrite = false;
+    pxRequest->uxEntryNum = 0;
+    pxRequest->xWaitingTaskHandle = NULL;
+    memset(&pxRequest->xCompletion, 0x00, sizeof(pxRequest->xCompletion));
+    pxRequest->eResult = FLASH_TASK_RESULT_FAILED;
+
+    *ppxRequest = pxRequest;
+    return true;
+}
+
+static void vprvReleaseRequest(FlashRequest_t *pxRequest)
+{
+    // Wi-Fiのパスワードなどを残さないようクリアする
+    vprvZeroize(&pxRequest->xData, sizeof(pxRequest->xData));
+    memset(pxRequest->xEntries, 0x00, sizeof(pxRequest->xEntries));
+
+    pxRequest->eState = FLASH_REQUEST_STATE_FREE;
+    (void)xSemaphoreGive(gxRequestPoolSemaphore);
+}
+
+static bool bprvSubmitRequest(FlashRequest_t *pxRequest)
+{
+    // キューの長さと依頼を保持する領域の数は一致するため、待たずに送る
+    if (xQueueSend(gxQueueHandle, &pxRequest, 0) != pdTRUE)
+    {
+        APP_PRINTFError("Flash command send failed.");
+        return false;
+    }
+
+    return true;
+}
+
+static FlashTaskResult_t eprvSubmitAndWait(FlashRequest_t *pxRequest, void *pvBuffer, const uint32_t uxBufferSize)
+{
+    pxRequest->xWaitingTaskHandle = xTaskGetCurrentTaskHandle();
+
+    if (bprvSubmitRequest(pxRequest) == false)
+    {
+        vprvReleaseRequest(pxRequest);
+        return FLASH_TASK_RESULT_FAILED;
+    }
+
+    // Queueに送信したコマンドが処理されるまで待機
+    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(FLASH_RESPONSE_TIMEOUT_MS)) != pdTRUE)
+    {
+        // FlashTaskが完了させる処理と入れ替わらないよう、スケジューラを止めて状態を確認する
+        bool bIsDone = false;
+        vTaskSuspendAll();
+        bIsDone = (pxRequest->eState == FLASH_REQUEST_STATE_DONE);
+        if (bIsDone == false)
+        {
+            pxRequest->eState = FLASH_REQUEST_STATE_ABANDONED;
+        }
+        (void)xTaskResumeAll();
+
+        if (bIsDone == false)
+        {
+            // 依頼は手放し、FlashTaskが処理した後に解放させる
+            APP_PRINTFError("Flash command waiting timeout. The result will be discarded.");
+            return FLASH_TASK_RESULT_TIMEOUT;
+        }
+
+        // タイムアウトと同時に完了した場合は、次の待機で誤って起きないよう通知を受け取っておく
+        (void)ulTaskNotifyTake(pdTRUE, 0);
+    }
+
+    FlashTaskResult_t eResult = pxRequest->eResult;
+    if ((eResult == FLASH_TASK_RESULT_SUCCESS) && (pvBuffer != NULL))
+    {
+        uint32_t uxDataSize = 0;
+        const void *pvData = pvprvGetReadData(&pxRequest->xData, pxRequest->eReadFlashType, &uxDataSize);
+        memcpy(pvBuffer, pvData, uxBufferSize);
+    }
+
+    vprvReleaseRequest(pxRequest);
+    return eResult;
+}
+
+static void vprvCompleteRequest(FlashRequest_t *pxRequest, const FlashTaskResult_t eResult)
+{
+    pxRequest->eResult = eResult;
+
+    // 非同期の依頼は、完了を通知した後に解放する
+    if (pxRequest->xWaitingTaskHandle == NULL)
+    {
+        const void *pvData = NULL;
+        uint32_t uxDataSize = 0;
+        if ((pxRequest->bIsWrite == false) && (eResult == FLASH_TASK_RESULT_SUCCESS))
+        {
+            pvData = pvprvGetReadData(&pxRequest->xData, pxRequest->eReadFlashType, &uxDataSize);
+        }
+
+        vprvNotifyCompletion(&pxRequest->xCompletion, eResult, pvData, uxDataSize);
+        vprvReleaseRequest(pxRequest);
+        return;
+    }
+
+    // 待機しているタスクがタイムアウトを処理する間に状態を変えないよう、スケジューラを止めて通知する
+    bool bIsAbandoned = false;
+    vTaskSuspendAll();
+    bIsAbandoned = (pxRequest->eState == FLASH_REQUEST_STATE_ABANDONED);
+    if (bIsAbandoned == false)
+    {
+        pxRequest->eState = FLASH_REQUEST_STATE_DONE;
+        xTaskNotifyGive(pxRequest->xWaitingTaskHandle);
+    }
+    (void)xTaskResumeAll();
+
+    // 待機しているタスクがタイムアウトした場合は、結果を破棄する
+    if (bIsAbandoned == true)
+    {
+        APP_PRINTFWarn("Discarded the result of a flash command whose caller timed out. Result: %d", eResult);
+        vprvReleaseRequest(pxRequest);
+    }
+}
+
+static void vprvNotifyCompletion(const FlashTaskCompletion_t *pxCompletion, const FlashTaskResult_t eResult, const void *pvData, const uint32_t uxDataSize)
+{
+    if (pxCompletion->xCallback != NULL)
+    {
+        pxCompletion->xCallback(pxCompletion->pvContext, eResult, pvData, uxDataSize);
+    }
+
+    if (pxCompletion->xEventGroup != NULL)
+    {
+        EventBits_t xBits = (eResult == FLASH_TASK_RESULT_SUCCESS) ? pxCompletion->xSuccessBits : pxCompletion->xFailureBits;
+        if (xBits != 0)
+        {
+            (void)xEventGroupSetBits(pxCompletion->xEventGroup, xBits);
+        }
+    }
+}
+
+static void *pvprvGetReadData(FlashRequestData_t *pxData, const ReadFlashType_t eReadFlashType, uint32_t *puxDataSize)
+{
+    switch (eReadFlashType)
+    {
+    case READ_FLASH_TYPE_WIFI_INFO:
+        *puxDataSize = sizeof(pxData->xWiFiInfo);
+        return &pxData->xWiFiInfo;
+    case READ_FLASH_TYPE_AWS_IOT_ENDPOINT:
+        *puxDataSize = sizeof(pxData->xIoTEndpoint);
+        return &pxData->xIoTEndpoint;
+    case READ_FLASH_TYPE_PROVISIONING_FLAG:
+        *puxDataSize = sizeof(pxData->xProvisioningFlag);
+        return &pxData->xProvisioningFlag;
+    case READ_FLASH_TYPE_FACTORY_THING_NAME:
+        *puxDataSize = sizeof(pxData->xFactoryThingName);
+        return &pxData->xFactoryThingName;
+    case READ_FLASH_TYPE_USUAL_THING_NAME:
+        *puxDataSize = sizeof(pxData->xUsualThingName);
+        return &pxData->xUsualThingName;
+    default:
+        *puxDataSize = 0;
+        return NULL;
+    }
+}
+
+static void *pvprvGetWriteData(FlashRequestData_t *pxData, const WriteFlashType_t eWriteFlashType, uint32_t *puxDataSize)
+{
+    switch (eWriteFlashType)
+    {
+    case WRITE_FLASH_TYPE_WIFI_INFO:
+        *puxDataSize = sizeof(pxData->xWiFiInfo);
+        return &pxData->xWiFiInfo;
+    case WRITE_FLASH_TYPE_PROVISIONING_FLAG:
+        *puxDataSize = sizeof(pxData->xProvisioningFlag);
+        return &pxData->xProvisioningFlag;
+    case WRITE_FLASH_TYPE_AWS_IOT_ENDPOINT:
+        *puxDataSize = sizeof(pxData->xIoTEndpoint);
+        return &pxData->xIoTEndpoint;
+    case WRITE_FLASH_TYPE_USUAL_THING_NAME:
+        *puxDataSize = sizeof(pxData->xUsualThingName);
+        return &pxData->xUsualThingName;
+    default:
+        *puxDataSize = 0;
+        return NULL;
+    }
+}
+
+static void vprvZeroize(void *pvBuffer, const uint32_t uxSize)
+{
+    volatile uint8_t *pucBuffer = (volatile uint8_t *)pvBuffer;
+    for (uint32_t i = 0; i < uxSize; i++)
+    {
+        pucBuffer[i] = 0x00;
+    }
+}
+
 static bool bprvFlashWriteProcess(const FlashWriteParameters_t *pxFlashWriteParams)
+{
+    // 書き込みに失敗した場合もセキュアエレメントと一致しない可能性があるため、書き込む前に無効化する
+    for (uint8_t i = 0; i < pxFlashWriteParams->uxEntryNum; i++)
+    {
+        vprvInvalidateCacheForWrite(pxFlashWriteParams->pxEntries[i].eWriteFlashType);
+    }
+
+    if (eSEOperationBeginWrite() != SE_OPERATION_RESULT_SUCCESS)
+    {
+        return false;
+    }
+
+    // 全ての情報を反映できた場合のみ書き込む
+    for (uint8_t i = 0; i < pxFlashWriteParams->uxEntryNum; i++)
+    {
+        if (bprvStageWriteEntry(&pxFlashWriteParams->pxEntries[i]) == false)
+        {
+            vSEOperationAbortWrite();
+            return false;
+        }
+    }
+
+    if (eSEOperationCommitWrite() != SE_OPERATION_RESULT_SUCCESS)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+static bool bprvStageWriteEntry(const FlashWriteEntry_t *pxEntry)
 {
     // Write Typeによって何を書き込むのか決定する
-    switch (pxFlashWriteParams->xWriteType)
+    switch (pxEntry->eWriteFlashType)
     {
     case WRITE_FLASH_TYPE_WIFI_INFO:
         APP_PRINTFDebug("Set WRITE_FLASH_TYPE_WIFI_INFO");
 
-        // セキュアエレメントへWi-Fi情報を書き込み
-        WiFiInfo_t *pxWiFiInfo = (WiFiInfo_t *)pxFlashWriteParams->pvData;
+        // Wi-Fi情報を書き込む内容に反映
+        const WiFiInfo_t *pxWiFiInfo = (const WiFiInfo_t *)pxEntry->pvWriteData;
         if (eSetWiFiInfoToSE(pxWiFiInfo) != SE_OPERATION_RESULT_SUCCESS)
         {
             return false;
@@ -470,8 +1193,8 @@ static bool bprvFlashWriteProcess(const FlashWriteParameters_t *pxFlashWritePara
     case WRITE_FLASH_TYPE_PROVISIONING_FLAG:
         APP_PRINTFDebug("Set WRITE_FLASH_TYPE_PROVISIONING_FLAG");
 
-        // セキュアエレメントへプロビジョニングフラグ情報を書き込み
-        ProvisioningFlag_t *pxProvisioningFlag = (ProvisioningFlag_t *)pxFlashWriteParams->pvData;
+        // プロビジョニングフラグ情報を書き込む内容に反映
+        const ProvisioningFlag_t *pxProvisioningFlag = (const ProvisioningFlag_t *)pxEntry->pvWriteData;
         if (eSetProvisioningFlag(*pxProvisioningFlag) != SE_OPERATION_RESULT_SUCCESS)
         {
             return false;
@@ -481,8 +1204,8 @@ static bool bprvFlashWriteProcess(const FlashWriteParameters_t *pxFlashWritePara
     case WRITE_FLASH_TYPE_AWS_IOT_ENDPOINT:
         APP_PRINTFDebug("Set WRITE_FLASH_TYPE_AWS_IOT_ENDPOINT");
 
-        // セキュアエレメントへIoTEndpointの書き込み
-        AWSIoTEndpoint_t *pxIoTEndpoint = (AWSIoTEndpoint_t *)pxFlashWriteParams->pvData;
+        // IoTEndpointを書き込む内容に反映
+        const AWSIoTEndpoint_t *pxIoTEndpoint = (const AWSIoTEndpoint_t *)pxEntry->pvWriteData;
         if (eSetIoTEndpoint(pxIoTEndpoint) != SE_OPERATION_RESULT_SUCCESS)
         {
             return false;
@@ -491,17 +1214,13 @@ static bool bprvFlashWriteProcess(const FlashWriteParameters_t *pxFlashWritePara
     case WRITE_FLASH_TYPE_USUAL_THING_NAME:
         APP_PRINTFDebug("Set WRITE_FLASH_TYPE_USUAL_THING_NAME");
 
-        // セキュアエレメントへ普段使い用のThingNameを書き込み
-        ThingName_t *pxThingName = (ThingName_t *)pxFlashWriteParams->pvData;
+        // 普段使い用のThingNameを書き込む内容に反映
+        const ThingName_t *pxThingName = (const ThingName_t *)pxEntry->pvWriteData;
         if (eSetThingName(pxThingName) != SE_OPERATION_RESULT_SUCCESS)
         {
             return false;
         }
 
-        // 書き込みが成功したらキャッシュをクリア
-        APP_PRINTFDebug("Clear the cache because the ThingName was successfully written.");
-        vprvClearUsualThingNameCache();
-
         return true;
     default:
         APP_PRINTFError("Unkown Wite type.");
@@ -510,7 +1229,27 @@ static bool bprvFlashWriteProcess(const FlashWriteParameters_t *pxFlashWritePara
 
     return true;
 }
+
 static bool bprvFlashReadProcess(const FlashReadParameters_t *pxFlashReadParams)
+{
+    // 待機中に他のタスクの読み込みでキャッシュされている場合は、キャッシュから取得
+    if (bprvGetCache(pxFlashReadParams->xReadType, pxFlashReadParams->pvBuffer, pxFlashReadParams->uxBufferSize) == true)
+    {
+        APP_PRINTFDebug("Loaded from cache. Type: 0x%X", pxFlashReadParams->xReadType);
+        return true;
+    }
+
+    if (bprvFlashReadFromSE(pxFlashReadParams) == false)
+    {
+        return false;
+    }
+
+    // キャッシュをセット
+    vprvSetCache(pxFlashReadParams->xReadType, pxFlashReadParams->pvBuffer);
+    return true;
+}
+
+static bool bprvFlashReadFromSE(const FlashReadParameters_t *pxFlashReadParams)
 {
     // Read Typeによって読み込む情報を決定する
     switch (pxFlashReadParams->xReadType)
@@ -597,23 +1336,12 @@ static bool bprvFlashReadProcess(const FlashReadParameters_t *pxFlashReadParams)
         // メモリクリア
         memset(pxThingName, 0x00, sizeof(ThingName_t));
 
-        // キャッシュを持っている場合は、キャッシュから取得
-        if (bprvGetUsualThingNameCache(pxThingName) == true)
-        {
-            APP_PRINTFDebug("Loaded ThingName from cache.");
-            return true;
-        }
-
         // セキュアエレメントから普段使い用のThingNameを読み込み
         if (eGetThingName(pxThingName) != SE_OPERATION_RESULT_SUCCESS)
         {
             return false;
         }
 
-        // キャッシュをセット
-        APP_PRINTFDebug("ThingName is successfully read and set in cache.");
-        vprvSetUsualThingNameCache(pxThingName);
-
         return true;
     default:
         APP_PRINTFError("Unkown read type.");
@@ -623,37 +1351,121 @@ static bool bprvFlashReadProcess(const FlashReadParameters_t *pxFlashReadParams)
     return true;
 }
 
-static bool bprvGetUsualThingNameCache(ThingName_t *pxThingName)
+static bool bprvFindCacheRecord(const ReadFlashType_t eReadFlashType, FlashCacheRecord_t *peRecord)
 {
-    // キャッシュを持っていなかったら何もしない
-    if (gxThingNameCache.bHasCache == false)
+    for (uint8_t i = 0; i < FLASH_CACHE_RECORD_NUM; i++)
+    {
+        if ((gxFlashCacheRecordDefs[i].eReadType == eReadFlashType) && (gxFlashCacheRecordDefs[i].bIsEnabled == true))
+        {
+            *peRecord = (FlashCacheRecord_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool bprvGetCache(const ReadFlashType_t eReadFlashType, void *pvBuffer, const uint32_t uxBufferSize)
+{
+    FlashCacheRecord_t eRecord;
+    if (bprvFindCacheRecord(eReadFlashType, &eRecord) == false)
     {
         return false;
     }
 
-    // キャッシュを持っている場合はコピーを行う
-    memcpy(pxThingName, &gxThingNameCache.xThingName, sizeof(ThingName_t));
+    // サイズが一致しない場合はFlashTaskでエラーにする
+    const FlashCacheRecordDef_t *pxDef = &gxFlashCacheRecordDefs[eRecord];
+    FlashCacheState_t *pxState = &gxFlashCacheStates[eRecord];
+    if (uxBufferSize != pxDef->uxSize)
+    {
+        return false;
+    }
 
-    return true;
+#if (FLASH_CACHE_SEQUENCE_ENABLE == 1)
+    // コピーの前後でシーケンス番号が変わっていなければ、書き換えの途中のデータではない
+    for (uint8_t uxRetry = 0; uxRetry < FLASH_CACHE_READ_RETRY_NUM; uxRetry++)
+    {
+        uint32_t ulSequence = pxState->ulSequence;
+        FLASH_CACHE_BARRIER();
+        if ((ulSequence & 1U) != 0)
+        {
+            continue;
+        }
+        if (pxState->bIsValid == false)
+        {
+            return false;
+        }
+
+        memcpy(pvBuffer, pxDef->pvCache, pxDef->uxSize);
+
+        FLASH_CACHE_BARRIER();
+        if (pxState->ulSequence == ulSequence)
+        {
+            return true;
+        }
+    }
+    return false;
+#else
+    bool bIsValid = false;
+    taskENTER_CRITICAL();
+    if (pxState->bIsValid == true)
+    {
+        memcpy(pvBuffer, pxDef->pvCache, pxDef->uxSize);
+        bIsValid = true;
+    }
+    taskEXIT_CRITICAL();
+    return bIsValid;
+#endif
 }
 
-static void vprvClearUsualThingNameCache(void)
+static void vprvSetCache(const ReadFlashType_t eReadFlashType, const void *pvData)
 {
-    // キャッシュのフラグを折る
-    gxThingNameCache.bHasCache = false;
+    FlashCacheRecord_t eRecord;
+    if (bprvFindCacheRecord(eReadFlashType, &eRecord) == false)
+    {
+        return;
+    }
 
-    // ThingName構造体の全部を0x00でクリア
-    memset(&gxThingNameCache.xThingName, 0x00, sizeof(ThingName_t));
+    const FlashCacheRecordDef_t *pxDef = &gxFlashCacheRecordDefs[eRecord];
+    FlashCacheState_t *pxState = &gxFlashCacheStates[eRecord];
+
+    // 書き換え中は無効にしておき、シーケンス番号を使わない場合も書き換えの途中のデータを読み出させない
+    pxState->ulSequence++;
+    pxState->bIsValid = false;
+    FLASH_CACHE_BARRIER();
+    memcpy(pxDef->pvCache, pvData, pxDef->uxSize);
+    FLASH_CACHE_BARRIER();
+    pxState->bIsValid = true;
+    pxState->ulSequence++;
 }
 
-static void vprvSetUsualThingNameCache(const ThingName_t *pxThingName)
+static void vprvInvalidateCache(const FlashCacheRecord_t eRecord)
 {
-    // キャッシュフラグを立てる
-    gxThingNameCache.bHasCache = true;
+    const FlashCacheRecordDef_t *pxDef = &gxFlashCacheRecordDefs[eRecord];
+    FlashCacheState_t *pxState = &gxFlashCacheStates[eRecord];
 
-    // キャッシュをセット
-    memcpy(&gxThingNameCache.xThingName, pxThingName, sizeof(ThingName_t));
+    pxState->ulSequence++;
+    FLASH_CACHE_BARRIER();
+    pxState->bIsValid = false;
+
+    // Wi-Fiのパスワードなどを残さないようクリアする
+    vprvZeroize(pxDef->pvCache, pxDef->uxSize);
+
+    FLASH_CACHE_BARRIER();
+    pxState->ulSequence++;
 }
+
+static void vprvInvalidateCacheForWrite(const WriteFlashType_t eWriteFlashType)
+{
+    for (uint8_t i = 0; i < FLASH_CACHE_RECORD_NUM; i++)
+    {
+        if (gxFlashCacheRecordDefs[i].eWriteType == eWriteFlashType)
+        {
+            APP_PRINTFDebug("Invalidate cache before write. Type: 0x%X", eWriteFlashType);
+            vprvInvalidateCache((FlashCacheRecord_t)i);
+        }
+    }
+}
+
 // --------------------------------------------------
 // Unit Test用関数定義(関数のプロトタイプ宣言は「自身のファイル名+ "_test.h"」で宣言されていること)
 // --------------------------------------------------
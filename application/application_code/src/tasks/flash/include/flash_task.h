@@ -20,6 +20,7 @@ extern "C"
 #include <stdbool.h>
 
 #include "FreeRTOS.h"
+#include "event_groups.h"
 
 // --------------------------------------------------
 // ユーザ作成ヘッダの取り込み
@@ -176,6 +177,51 @@ typedef enum
 // struct/unionタグ定義（typedefを同時に行う）
 // --------------------------------------------------
 
+/**
+ * @brief eWriteFlashInfoBatchでまとめて書き込む情報
+ */
+typedef struct
+{
+    /**
+     * @brief 書き込みたい情報のタイプ @ref WriteFlashType_t
+     */
+    WriteFlashType_t eWriteFlashType;
+
+    /**
+     * @brief 書き込みたい情報のデータ。書き込みたい情報のタイプに対応する flash_data.h のデータ型
+     */
+    const void *pvWriteData;
+} FlashWriteEntry_t;
+
+/**
+ * @brief 非同期の読み書きが完了したときに呼ばれるコールバック関数
+ *
+ * @note FlashTaskのコンテキストで実行される。FlashTaskのAPIの完了を待つ処理など、ブロックする処理は行わないこと
+ *
+ * @param[in] pvContext  #FlashTaskCompletion_t で指定したコンテキスト
+ * @param[in] eResult    読み書きの結果
+ * @param[in] pvData     読み込んだ情報。読み込みに成功した場合のみ有効で、コールバック関数から戻った後は使用できない。書き込みの場合はNULL
+ * @param[in] uxDataSize pvDataのサイズ
+ */
+typedef void (*FlashTaskCallback_t)(void *pvContext, FlashTaskResult_t eResult, const void *pvData, uint32_t uxDataSize);
+
+/**
+ * @brief 非同期の読み書きの完了を通知する方法
+ *
+ * @details
+ * コールバック関数とイベントグループはどちらか一方、または両方を指定できる。
+ * 両方を指定した場合は、コールバック関数から戻った後にイベントビットをセットする。
+ * どちらも指定しない場合は、完了を通知しない(読み込んだ情報のキャッシュのみ行う)
+ */
+typedef struct
+{
+    FlashTaskCallback_t xCallback;  /**< 完了時に呼ぶコールバック関数。不要な場合はNULL */
+    void *pvContext;                /**< コールバック関数に渡すコンテキスト */
+    EventGroupHandle_t xEventGroup; /**< 完了時にイベントビットをセットするイベントグループ。不要な場合はNULL */
+    EventBits_t xSuccessBits;       /**< 成功した場合にセットするイベントビット */
+    EventBits_t xFailureBits;       /**< 失敗した場合にセットするイベントビット */
+} FlashTaskCompletion_t;
+
 // --------------------------------------------------
 // extern変数宣言
 // --------------------------------------------------
@@ -198,6 +244,10 @@ FlashTaskResult_t eFlashTaskInit(void);
 /**
  * @brief Flashから情報を取得する
  *
+ * @details
+ * 完了を待つ間、依頼はFlashTaskが持つ領域に保持する。タイムアウトした場合、FlashTaskは後で完了した結果を破棄し、
+ * pvBufferには書き込まない
+ *
  * @note
  * 本ライブラリはスレッドセーフである
  *
@@ -217,6 +267,9 @@ FlashTaskResult_t eReadFlashInfo(const ReadFlashType_t eReadFlashType,
 /**
  * @brief Flashへ情報を書き込む
  *
+ * @details
+ * タイムアウトした場合の扱いは #eWriteFlashInfoBatch と同じ
+ *
  * @note
  * 本ライブラリはスレッドセーフである
  *
@@ -231,6 +284,75 @@ FlashTaskResult_t eReadFlashInfo(const ReadFlashType_t eReadFlashType,
 FlashTaskResult_t eWriteFlashInfo(const WriteFlashType_t eWriteFlashType,
                                   const void *pvWriteData);
 
+/**
+ * @brief 複数の情報をまとめてFlashへ書き込む
+ *
+ * @details
+ * 1回のFlashTaskへの依頼で、全ての情報を反映した後に変更のある部分のみ書き込む。
+ * 書き込み済みの内容と同じ情報は書き込まない。1回に書き込める数は #FLASH_TASK_WRITE_ENTRY_MAX_NUM まで。
+ * タイムアウトした場合、FlashTaskがまだ処理を始めていない書き込みは反映せずに破棄する。
+ * 処理中だった書き込みは完了させるため、タイムアウト後に書き込まれている場合がある
+ *
+ * @note
+ * 本ライブラリはスレッドセーフである
+ *
+ * @param[in] pxEntries  書き込みたい情報の配列
+ * @param[in] uxEntryNum pxEntriesの要素数
+ *
+ * @retval FLASH_TASK_RESULT_SUCCESS    成功
+ * @retval FLASH_TASK_RESULT_BAD_RESULT パラメータエラー
+ * @retval FLASH_TASK_RESULT_TIMEOUT    タイムアウト。頻発するなら #FLASH_RESPONSE_TIMEOUT_MS の時間を延ばす。
+ * @retval FLASH_TASK_RESULT_FAILED     その他エラー。いずれかの情報を反映できない場合は何も書き込まない
+ */
+FlashTaskResult_t eWriteFlashInfoBatch(const FlashWriteEntry_t *pxEntries,
+                                       const uint8_t uxEntryNum);
+
+/**
+ * @brief Flashから情報を取得するよう依頼し、完了を待たずに戻る
+ *
+ * @details
+ * 依頼はFlashTaskが持つ領域に保持し、読み込んだ情報はコールバック関数に渡す。
+ * キャッシュを持っている場合は、本API内でコールバック関数を呼び、イベントビットをセットする。
+ * 同時に依頼できる数は #FLASH_TASK_COMMAND_QUEUE_LENGTH まで
+ *
+ * @note
+ * 本ライブラリはスレッドセーフである
+ *
+ * @param[in] eReadFlashType 取得したい情報のタイプ @ref ReadFlashType_t
+ * @param[in] pxCompletion   完了を通知する方法。NULLの場合は通知しない
+ *
+ * @retval FLASH_TASK_RESULT_SUCCESS    依頼の受付に成功
+ * @retval FLASH_TASK_RESULT_BAD_RESULT パラメータエラー
+ * @retval FLASH_TASK_RESULT_TIMEOUT    依頼を保持する領域が空かない
+ * @retval FLASH_TASK_RESULT_FAILED     その他エラー
+ */
+FlashTaskResult_t eReadFlashInfoAsync(const ReadFlashType_t eReadFlashType,
+                                      const FlashTaskCompletion_t *pxCompletion);
+
+/**
+ * @brief 複数の情報をまとめてFlashへ書き込むよう依頼し、完了を待たずに戻る
+ *
+ * @details
+ * 書き込む情報は本API内でFlashTaskが持つ領域にコピーするため、戻った後にpxEntriesを破棄してよい。
+ * 同じタイプの情報を複数指定した場合は、後の情報を書き込む。
+ * 1回に書き込める数は #FLASH_TASK_WRITE_ENTRY_MAX_NUM まで
+ *
+ * @note
+ * 本ライブラリはスレッドセーフである
+ *
+ * @param[in] pxEntries    書き込みたい情報の配列
+ * @param[in] uxEntryNum   pxEntriesの要素数
+ * @param[in] pxCompletion 完了を通知する方法。NULLの場合は通知しない
+ *
+ * @retval FLASH_TASK_RESULT_SUCCESS    依頼の受付に成功
+ * @retval FLASH_TASK_RESULT_BAD_RESULT パラメータエラー
+ * @retval FLASH_TASK_RESULT_TIMEOUT    依頼を保持する領域が空かない
+ * @retval FLASH_TASK_RESULT_FAILED     その他エラー
+ */
+FlashTaskResult_t eWriteFlashInfoBatchAsync(const FlashWriteEntry_t *pxEntries,
+                                            const uint8_t uxEntryNum,
+                                            const FlashTaskCompletion_t *pxCompletion);
+
 // --------------------------------------------------
 // インライン関数
 // --------------------------------------------------
@@ -111,6 +111,14 @@ extern "C"
  */
 #define SE_THING_NAME_LENGTH 128U
 
+/**
+ * @brief 一括で読み込むSAVE_SLOT_IDの範囲の長さ
+ *
+ * @details
+ * プロビジョニングフラグからThingNameまでの全ての項目を含む
+ */
+#define SE_SLOT_IMAGE_LENGTH (SE_THING_NAME_START_ADDRESS + SE_THING_NAME_LENGTH)
+
 /**
  * @brief DeviceIDなどを保存するECC608のスロットID
  *
@@ -136,10 +144,7 @@ extern "C"
 #define PROVISIONING_FLAG_ALREADY_FINISHED 0x00000001
 
 /**
- * @brief I2Cがビジー状態から回復するまで待機する時間
- *
- * @warning
- * 1秒刻みで宣言する
+ * @brief I2Cバスのロックの取得と、I2Cがビジー状態から回復するまで待機する時間
  *
  */
 #define SE_OPERATION_FLASH_RW_TIMEOUT_MS (5U * 1000U)
@@ -147,6 +152,8 @@ extern "C"
 /**
  * @brief FlashにR/Wするまでのリトライ回数
  *
+ * @details
+ * リトライの間隔は #SE_BUS_RETRY_BACKOFF_MIN_MS から倍々に伸ばす
  */
 #define SE_OPERATION_FLASH_RETRY_COUNT (10U)
 
@@ -193,6 +200,9 @@ extern "C"
     /**
      * @brief このライブラリを初期化する
      *
+     * @details
+     * SAVE_SLOT_IDの内容は初期化時には読み込まず、最初の取得時に一括で読み込んでRAMに保持する
+     *
      *  @retval #SE_OPERATION_RESULT_SUCCESS 成功
      *  @retval #SE_OPERATION_RESULT_FAILURE 失敗
      */
@@ -262,7 +272,34 @@ extern "C"
      */
 
     /**
-     * @brief WiFiの情報セキュリティタイプを書き込む
+     * @brief セキュアエレメントへの書き込みを開始する
+     *
+     * @details
+     * 以降のeSetXXXは書き込む内容に反映するのみで、eSEOperationCommitWriteでまとめて書き込む
+     *
+     * @retval #SE_OPERATION_RESULT_SUCCESS 成功
+     * @retval #SE_OPERATION_RESULT_FAILURE 書き込み中、または差分を取るための読み込みに失敗した
+     */
+    SEOperation_t eSEOperationBeginWrite(void);
+
+    /**
+     * @brief eSetXXXで反映した内容のうち、変更のあるブロックのみセキュアエレメントへ書き込む
+     *
+     * @details
+     * 連続して変更のあるブロックは1回で書き込む。プロビジョニングフラグを含む先頭ブロックは最後に書き込む
+     *
+     * @retval #SE_OPERATION_RESULT_SUCCESS 成功
+     * @retval #SE_OPERATION_RESULT_FAILURE 書き込みを開始していない、または書き込みに失敗した
+     */
+    SEOperation_t eSEOperationCommitWrite(void);
+
+    /**
+     * @brief 書き込まずに終了する
+     */
+    void vSEOperationAbortWrite(void);
+
+    /**
+     * @brief WiFiの情報セキュリティタイプを書き込む内容に反映する
      *
      * @param[in] pxWiFiInfo WiFi情報
      *
@@ -272,7 +309,7 @@ extern "C"
     SEOperation_t eSetWiFiInfoToSE(const WiFiInfo_t *pxWiFiInfo);
 
     /**
-     * @brief プロビジョニングをセキュアエレメントへ書き込む
+     * @brief プロビジョニングを書き込む内容に反映する
      *
      * @param[in] xProvisioningFlag セットしたいプロビジョニングフラグデータ
      *
@@ -282,7 +319,7 @@ extern "C"
     SEOperation_t eSetProvisioningFlag(const ProvisioningFlag_t xProvisioningFlag);
 
     /**
-     * @brief IoT Endpointをセキュアエレメントへ書き込む
+     * @brief IoT Endpointを書き込む内容に反映する
      *
      * @param[in] pxEndpoint 格納したいendpointのデータ
      *
@@ -292,7 +329,7 @@ extern "C"
     SEOperation_t eSetIoTEndpoint(const AWSIoTEndpoint_t *pxEndpoint);
 
     /**
-     * @brief ThingName(普段使い用)をセキュアエレメントへ書き込む
+     * @brief ThingName(普段使い用)を書き込む内容に反映する
      *
      * @param[in] pxName 格納したいThingNameのデータ
      *
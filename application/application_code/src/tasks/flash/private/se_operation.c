@@ -22,6 +22,7 @@
 // --------------------------------------------------
 #include "common/include/device_state.h"
 #include "common/include/application_define.h"
+#include "common/include/se_bus_lock.h"
 
 #include "tasks/flash/private/include/se_operation.h"
 
@@ -37,6 +38,24 @@
  */
 #define ECC608_SERIAL_NUMBER_BINARY_SIZE (9U)
 
+/**
+ * @brief スロットの内容を保持する場合に、Wi-Fiのパスワードを保持するか
+ *
+ * @details
+ * Wi-Fi情報をキャッシュしない設定の場合は、パスワードをRAMに残さないよう一括読み込みの後にクリアし、取得のたびに読み込む
+ */
+#define SE_SLOT_IMAGE_KEEP_PASSWORD (FLASH_CACHE_WIFI_INFO_ENABLE)
+
+/**
+ * @brief ECC608のデータ領域に1回のコマンドで書き込めるブロックのサイズ
+ */
+#define SE_DATA_BLOCK_SIZE (32U)
+
+/**
+ * @brief 一括で読み込む範囲のブロック数
+ */
+#define SE_SLOT_IMAGE_BLOCK_NUM ((SE_SLOT_IMAGE_LENGTH + SE_DATA_BLOCK_SIZE - 1U) / SE_DATA_BLOCK_SIZE)
+
 // --------------------------------------------------
 // 自ファイル内でのみ使用するtypedef定義
 // --------------------------------------------------
@@ -53,6 +72,31 @@
 // ファイル内で共有するstatic変数宣言
 // --------------------------------------------------
 
+/**
+ * @brief SAVE_SLOT_IDから一括で読み込んだ内容
+ */
+static uint8_t gucSlotImage[SE_SLOT_IMAGE_LENGTH];
+
+/**
+ * @brief gucSlotImageが有効か
+ */
+static bool gbIsSlotImageValid = false;
+
+/**
+ * @brief gucSlotImageから取得したため、読み込まずに済んだ項目の数。一括で読み込んだときにログに出力する
+ */
+static uint32_t gulSlotImageHitCount = 0;
+
+/**
+ * @brief 書き込み中の内容。eSEOperationCommitWriteでgucSlotImageとの差分を書き込む
+ */
+static uint8_t gucStagingImage[SE_SLOT_IMAGE_LENGTH];
+
+/**
+ * @brief eSEOperationBeginWriteで書き込みを開始しているか
+ */
+static bool gbIsWriteActive = false;
+
 // --------------------------------------------------
 // static関数プロトタイプ宣言
 // --------------------------------------------------
@@ -110,12 +154,20 @@ static bool bprvConvertSecurityTypeSEToEnum(const uint32_t xSecTypeFromSE, WIFIS
 static bool bprvConvertSecurityTypeEnumToSE(const WIFISecurity_t xSecurity, uint32_t *pxSecTypeFromSE);
 
 /**
- * @brief I2CバスがReady状態になるまで待機する
+ * @brief SAVE_SLOT_IDの内容をgucSlotImageに一括で読み込む。読み込み済みの場合は何もしない
+ *
+ * @retval true  成功
+ * @retval false 読み込みに失敗した
+ */
+static bool bprvLoadSlotImage(void);
+
+/**
+ * @brief 書き込みを終了し、書き込み内容をクリアする
  *
- * @return true  成功
- * @return false タイムアウト、またはその他エラー
+ * @details
+ * パスワードをRAMに保持しない設定の場合は、差分を取るために読み込んだパスワードもクリアする
  */
-static bool bprvWaitI2CBusReady(void);
+static void vprvEndWrite(void);
 
 // --------------------------------------------------
 // 変数定義（staticを除く）
@@ -141,6 +193,17 @@ SEOperation_t eSEOperationInit(void)
     ATCAIfaceCfg *ifacecfg = &atecc608_0_init_data;
     ATCA_STATUS eStatus;
 
+    // randutilと共用するI2Cバスのロックの初期化
+    if (bSEBusLockInit() == false)
+    {
+        return SE_OPERATION_RESULT_FAILURE;
+    }
+
+    if (bSEBusLock(SE_OPERATION_FLASH_RW_TIMEOUT_MS) == false)
+    {
+        return SE_OPERATION_RESULT_FAILURE;
+    }
+
     // ECC608コンフィグレーションのリリース
     ATCADevice xDevice = atcab_get_device();
     if (xDevice != NULL)
@@ -148,6 +211,7 @@ SEOperation_t eSEOperationInit(void)
         eStatus = atcab_release();
         if (eStatus != ATCA_SUCCESS)
         {
+            vSEBusUnlock();
             APP_PRINTFError("atcab release failed: 0x%02X", eStatus);
             return SE_OPERATION_RESULT_FAILURE;
         }
@@ -155,12 +219,16 @@ SEOperation_t eSEOperationInit(void)
 
     // ECC608の初期化
     eStatus = atcab_init(ifacecfg);
+    vSEBusUnlock();
     if (eStatus != ATCA_SUCCESS)
     {
         APP_PRINTFError("atcab init failed: 0x%02X", eStatus);
         return SE_OPERATION_RESULT_FAILURE;
     }
 
+    // スロットの内容は最初の取得時にFlashTaskで読み込む
+    gbIsSlotImageValid = false;
+
     APP_PRINTFDebug("SE operation init success.");
 
     return SE_OPERATION_RESULT_SUCCESS;
@@ -175,7 +243,6 @@ SEOperation_t eSEOperationInit(void)
 SEOperation_t eGetWiFiInfoFromSE(WiFiInfo_t *pxWiFiInfo)
 {
 
-    ATCA_STATUS eResult;
     uint32_t uxSecType = 0xFFFFFFFF;
 
     // バリデート
@@ -186,41 +253,31 @@ SEOperation_t eGetWiFiInfoFromSE(WiFiInfo_t *pxWiFiInfo)
     }
     memset(pxWiFiInfo, 0x00, sizeof(WiFiInfo_t));
 
-    // SSID、PW、セキュリティタイプの取得
-    const uint8_t uxStatementNum = 3;
-    for (uint8_t uxCount = 0; uxCount < uxStatementNum; uxCount++)
+    // SSID、セキュリティタイプはスロットの内容から取得
+    if (bprvLoadSlotImage() == false)
     {
-        switch (uxCount)
-        {
-        case 0:
-            eResult = eReadECC608Flash(ATCA_ZONE_DATA,
-                                       SAVE_SLOT_ID,
-                                       SE_SSID_START_ADDRESS,
-                                       pxWiFiInfo->cWifiSSID,
-                                       SE_SSID_LENGTH);
-            break;
-        case 1:
-            eResult = eReadECC608Flash(ATCA_ZONE_DATA,
-                                       SAVE_SLOT_ID,
-                                       SE_PASSWORD_START_ADDRESS,
-                                       pxWiFiInfo->cWiFiPassword,
-                                       SE_PASSWORD_LENGTH);
-            break;
-        case 2:
-            eResult = eReadECC608Flash(ATCA_ZONE_DATA,
-                                       SAVE_SLOT_ID,
-                                       SE_SECURITY_TYPE_START_ADDRESS,
-                                       (uint8_t *)&uxSecType,
-                                       SE_SECURITY_TYPE_LENGTH);
-            break;
-        }
+        return SE_OPERATION_RESULT_FAILURE;
+    }
+    memcpy(pxWiFiInfo->cWifiSSID, &gucSlotImage[SE_SSID_START_ADDRESS], SE_SSID_LENGTH);
+    memcpy(&uxSecType, &gucSlotImage[SE_SECURITY_TYPE_START_ADDRESS], SE_SECURITY_TYPE_LENGTH);
+    gulSlotImageHitCount += 2U;
 
-        if (eResult != ATCA_SUCCESS)
-        {
-            APP_PRINTFError("Flash read error from SE.StatementNum: %d Reason: 0x%02X", uxCount, eResult);
-            return SE_OPERATION_RESULT_FAILURE;
-        }
+#if (SE_SLOT_IMAGE_KEEP_PASSWORD == 1)
+    memcpy(pxWiFiInfo->cWiFiPassword, &gucSlotImage[SE_PASSWORD_START_ADDRESS], SE_PASSWORD_LENGTH);
+    gulSlotImageHitCount++;
+#else
+    // パスワードはRAMに保持していないため、SEから読み込む
+    ATCA_STATUS eResult = eReadECC608Flash(ATCA_ZONE_DATA,
+                                           SAVE_SLOT_ID,
+                                           SE_PASSWORD_START_ADDRESS,
+                                           pxWiFiInfo->cWiFiPassword,
+                                           SE_PASSWORD_LENGTH);
+    if (eResult != ATCA_SUCCESS)
+    {
+        APP_PRINTFError("Flash read error from SE. Reason: 0x%02X", eResult);
+        return SE_OPERATION_RESULT_FAILURE;
     }
+#endif
 
     // SEから取得したセキュリティタイプとWIFISecurity_tの変換を行う
     if (bprvConvertSecurityTypeSEToEnum(uxSecType, &(pxWiFiInfo->xWiFiSecurity)) == false)
@@ -243,18 +300,14 @@ SEOperation_t eGetProvisioningFlag(ProvisioningFlag_t *pxProvisioningFlag)
         return SE_OPERATION_RESULT_FAILURE;
     }
 
-    // SEから読み込み
-    uint32_t xProvisioningFlagSE = 0x00;
-    ATCA_STATUS eResult = eReadECC608Flash(ATCA_ZONE_DATA,
-                                           SAVE_SLOT_ID,
-                                           SE_PROVISIONING_FLAG_START_ADDRESS,
-                                           (uint8_t *)&xProvisioningFlagSE,
-                                           SE_PROVISIONING_FLAG_LENGTH);
-    if (eResult != ATCA_SUCCESS)
+    // スロットの内容から取得
+    if (bprvLoadSlotImage() == false)
     {
-        APP_PRINTFError("Flash read error from SE. Reason: 0x%02X", eResult);
         return SE_OPERATION_RESULT_FAILURE;
     }
+    uint32_t xProvisioningFlagSE = 0x00;
+    memcpy(&xProvisioningFlagSE, &gucSlotImage[SE_PROVISIONING_FLAG_START_ADDRESS], SE_PROVISIONING_FLAG_LENGTH);
+    gulSlotImageHitCount++;
 
     // SEから読み込んだプロビジョニングフラグを変換
     if (xProvisioningFlagSE == PROVISIONING_FLAG_NOT_IMPLEMENTED)
@@ -283,18 +336,13 @@ SEOperation_t eGetIoTEndpoint(AWSIoTEndpoint_t *pxEndpoint)
         return SE_OPERATION_RESULT_FAILURE;
     }
 
-    // SEから読み込み
-    ATCA_STATUS eResult = eReadECC608Flash(ATCA_ZONE_DATA,
-                                           SAVE_SLOT_ID,
-                                           SE_IOT_ENDPOINT_START_ADDRESS,
-                                           pxEndpoint->ucEndpoint,
-                                           SE_IOT_ENDPOINT_LENGTH);
-
-    if (eResult != ATCA_SUCCESS)
+    // スロットの内容から取得
+    if (bprvLoadSlotImage() == false)
     {
-        APP_PRINTFError("Flash read error from SE. Reason: 0x%02X", eResult);
         return SE_OPERATION_RESULT_FAILURE;
     }
+    memcpy(pxEndpoint->ucEndpoint, &gucSlotImage[SE_IOT_ENDPOINT_START_ADDRESS], SE_IOT_ENDPOINT_LENGTH);
+    gulSlotImageHitCount++;
 
     return SE_OPERATION_RESULT_SUCCESS;
 }
@@ -308,23 +356,15 @@ SEOperation_t eGetThingName(ThingName_t *pxName)
         return SE_OPERATION_RESULT_FAILURE;
     }
 
-    // SE内のThingName領域は128ByteでThingName本来のサイズは36Byte（文字）であるため、一端バッファにコピーした後pxNameにさらにコピーする
-    uint8_t uxThingNameSE[SE_THING_NAME_LENGTH] = {0x00};
-
-    // SEから読み込み
-    ATCA_STATUS eResult = eReadECC608Flash(ATCA_ZONE_DATA,
-                                           SAVE_SLOT_ID,
-                                           SE_THING_NAME_START_ADDRESS,
-                                           uxThingNameSE,
-                                           SE_THING_NAME_LENGTH);
-
-    if (eResult != ATCA_SUCCESS)
+    // スロットの内容から取得
+    if (bprvLoadSlotImage() == false)
     {
-        APP_PRINTFError("Flash read error from SE. Reason: 0x%02X", eResult);
         return SE_OPERATION_RESULT_FAILURE;
     }
 
-    strncpy((char *)pxName->ucName, (const char *)uxThingNameSE, THING_NAME_LENGTH);
+    // SE内のThingName領域は128ByteでThingName本来のサイズは36Byte（文字）であるため、先頭のみコピーする
+    strncpy((char *)pxName->ucName, (const char *)&gucSlotImage[SE_THING_NAME_START_ADDRESS], THING_NAME_LENGTH);
+    gulSlotImageHitCount++;
 
     return SE_OPERATION_RESULT_SUCCESS;
 }
@@ -337,13 +377,14 @@ SEOperation_t eGetFactoryThingName(FactoryThingName_t *pxName)
         return SE_OPERATION_RESULT_FAILURE;
     }
 
-    if (bprvWaitI2CBusReady() == false)
+    if (bSEBusLock(SE_OPERATION_FLASH_RW_TIMEOUT_MS) == false)
     {
         return SE_OPERATION_RESULT_FAILURE;
     }
 
     uint8_t xSerialNumberBinary[ECC608_SERIAL_NUMBER_BINARY_SIZE] = {0x00};
     ATCA_STATUS eResult = atcab_read_serial_number(xSerialNumberBinary);
+    vSEBusUnlock();
 
     if (eResult != ATCA_SUCCESS)
     {
@@ -372,66 +413,159 @@ SEOperation_t eGetFactoryThingName(FactoryThingName_t *pxName)
  * ##################################
  */
 
-SEOperation_t eSetWiFiInfoToSE(const WiFiInfo_t *pxWiFiInfo)
+SEOperation_t eSEOperationBeginWrite(void)
 {
-    ATCA_STATUS eResult;
-    uint32_t uxSecType = 0xFFFFFFFF;
+    if (gbIsWriteActive == true)
+    {
+        APP_PRINTFError("SE write transaction already active.");
+        return SE_OPERATION_RESULT_FAILURE;
+    }
 
-    // バリデート
-    if (pxWiFiInfo == NULL)
+    // 差分を取るため、書き込み前の内容を読み込んでおく
+    if (bprvLoadSlotImage() == false)
     {
-        APP_PRINTFError("Buffer provided is NULL");
         return SE_OPERATION_RESULT_FAILURE;
     }
 
-    // WIFISecurity_tからSEに保存するセキュリティタイプに変換
-    if (bprvConvertSecurityTypeEnumToSE(pxWiFiInfo->xWiFiSecurity, &uxSecType) == false)
+#if (SE_SLOT_IMAGE_KEEP_PASSWORD == 0)
+    // パスワードはRAMに保持していないため、パスワードと同じブロックを書き込んでも消さないよう書き込みが終わるまで一時的に読み込む
+    ATCA_STATUS eResult = eReadECC608Flash(ATCA_ZONE_DATA,
+                                           SAVE_SLOT_ID,
+                                           SE_PASSWORD_START_ADDRESS,
+                                           &gucSlotImage[SE_PASSWORD_START_ADDRESS],
+                                           SE_PASSWORD_LENGTH);
+    if (eResult != ATCA_SUCCESS)
     {
-        APP_PRINTFError("Buffer provided is NULL");
+        APP_PRINTFError("Flash read error from SE. Reason: 0x%02X", eResult);
+        memset(&gucSlotImage[SE_PASSWORD_START_ADDRESS], 0x00, SE_PASSWORD_LENGTH);
         return SE_OPERATION_RESULT_FAILURE;
     }
+#endif
+
+    memcpy(gucStagingImage, gucSlotImage, sizeof(gucStagingImage));
+    gbIsWriteActive = true;
+    return SE_OPERATION_RESULT_SUCCESS;
+}
 
-    // SSID、PW、セキュリティタイプの取得
-    const uint8_t uxStatementNum = 3;
-    for (uint8_t uxCount = 0; uxCount < uxStatementNum; uxCount++)
+SEOperation_t eSEOperationCommitWrite(void)
+{
+    if (gbIsWriteActive == false)
     {
-        switch (uxCount)
+        APP_PRINTFError("SE write transaction is not active.");
+        return SE_OPERATION_RESULT_FAILURE;
+    }
+
+    TickType_t xStartTick = xTaskGetTickCount();
+    ATCA_STATUS eResult = ATCA_SUCCESS;
+    uint32_t ulDirtyBlockNum = 0;
+    uint32_t ulWriteNum = 0;
+    size_t xRunStart = 0;
+    size_t xRunEnd = 0; // 書き込む範囲の末尾。0の場合は書き込む範囲なし
+
+    // プロビジョニングフラグを含む先頭ブロックが最後になるよう、アドレスの大きい側から書き込む
+    for (int32_t lBlock = (int32_t)SE_SLOT_IMAGE_BLOCK_NUM - 1; lBlock >= 0; lBlock--)
+    {
+        size_t xBlockStart = (size_t)lBlock * SE_DATA_BLOCK_SIZE;
+        size_t xBlockLength = SE_SLOT_IMAGE_LENGTH - xBlockStart;
+        if (xBlockLength > SE_DATA_BLOCK_SIZE)
         {
-        case 0:
-            eResult = eWriteECC608Flash(ATCA_ZONE_DATA,
-                                        SAVE_SLOT_ID,
-                                        SE_SSID_START_ADDRESS,
-                                        pxWiFiInfo->cWifiSSID,
-                                        SE_SSID_LENGTH);
-            break;
-        case 1:
-            eResult = eWriteECC608Flash(ATCA_ZONE_DATA,
-                                        SAVE_SLOT_ID,
-                                        SE_PASSWORD_START_ADDRESS,
-                                        pxWiFiInfo->cWiFiPassword,
-                                        SE_PASSWORD_LENGTH);
-            break;
-        case 2:
-            eResult = eWriteECC608Flash(ATCA_ZONE_DATA,
-                                        SAVE_SLOT_ID,
-                                        SE_SECURITY_TYPE_START_ADDRESS,
-                                        (uint8_t *)&uxSecType,
-                                        SE_SECURITY_TYPE_LENGTH);
-            break;
+            xBlockLength = SE_DATA_BLOCK_SIZE;
         }
+        bool bIsDirty = (memcmp(&gucStagingImage[xBlockStart], &gucSlotImage[xBlockStart], xBlockLength) != 0);
 
-        if (eResult != ATCA_SUCCESS)
+        // 変更のないブロック、または先頭ブロックの手前で、連続した変更のあるブロックを1回で書き込む
+        if ((xRunEnd != 0) && ((bIsDirty == false) || (lBlock == 0)))
         {
-            APP_PRINTFError("Flash write error to SE. StatementNum: %d Reason: 0x%02X", uxCount, eResult);
-            return SE_OPERATION_RESULT_FAILURE;
+            eResult = eWriteECC608Flash(ATCA_ZONE_DATA, SAVE_SLOT_ID, xRunStart, &gucStagingImage[xRunStart], xRunEnd - xRunStart);
+            ulWriteNum++;
+            xRunEnd = 0;
+            if (eResult != ATCA_SUCCESS)
+            {
+                break;
+            }
         }
+
+        if (bIsDirty == true)
+        {
+            ulDirtyBlockNum++;
+            if (xRunEnd == 0)
+            {
+                xRunEnd = xBlockStart + xBlockLength;
+            }
+            xRunStart = xBlockStart;
+        }
+    }
+    if ((eResult == ATCA_SUCCESS) && (xRunEnd != 0))
+    {
+        eResult = eWriteECC608Flash(ATCA_ZONE_DATA, SAVE_SLOT_ID, xRunStart, &gucStagingImage[xRunStart], xRunEnd - xRunStart);
+        ulWriteNum++;
+    }
+
+    if (eResult == ATCA_SUCCESS)
+    {
+        memcpy(gucSlotImage, gucStagingImage, sizeof(gucSlotImage));
+    }
+    else
+    {
+        // 途中まで書き込んだ可能性があるため、次回の取得時に読み込み直す
+        APP_PRINTFError("Flash write error to SE. Reason: 0x%02X", eResult);
+        gbIsSlotImageValid = false;
     }
+    vprvEndWrite();
+
+    APP_PRINTFInfo("SE write committed: %u of %u blocks changed, %u writes, %u ms.",
+                   ulDirtyBlockNum,
+                   SE_SLOT_IMAGE_BLOCK_NUM,
+                   ulWriteNum,
+                   (uint32_t)(xTaskGetTickCount() - xStartTick) * portTICK_PERIOD_MS);
+    vSEBusPrintStats();
+
+    return (eResult == ATCA_SUCCESS) ? SE_OPERATION_RESULT_SUCCESS : SE_OPERATION_RESULT_FAILURE;
+}
+
+void vSEOperationAbortWrite(void)
+{
+    if (gbIsWriteActive == false)
+    {
+        return;
+    }
+    vprvEndWrite();
+}
+
+SEOperation_t eSetWiFiInfoToSE(const WiFiInfo_t *pxWiFiInfo)
+{
+    uint32_t uxSecType = 0xFFFFFFFF;
+
+    // バリデート
+    if ((pxWiFiInfo == NULL) || (gbIsWriteActive == false))
+    {
+        APP_PRINTFError("Buffer provided is NULL or write transaction is not active.");
+        return SE_OPERATION_RESULT_FAILURE;
+    }
+
+    // WIFISecurity_tからSEに保存するセキュリティタイプに変換
+    if (bprvConvertSecurityTypeEnumToSE(pxWiFiInfo->xWiFiSecurity, &uxSecType) == false)
+    {
+        APP_PRINTFError("Buffer provided is NULL");
+        return SE_OPERATION_RESULT_FAILURE;
+    }
+
+    // SSID、PW、セキュリティタイプを書き込み内容に反映
+    memcpy(&gucStagingImage[SE_SSID_START_ADDRESS], pxWiFiInfo->cWifiSSID, SE_SSID_LENGTH);
+    memcpy(&gucStagingImage[SE_PASSWORD_START_ADDRESS], pxWiFiInfo->cWiFiPassword, SE_PASSWORD_LENGTH);
+    memcpy(&gucStagingImage[SE_SECURITY_TYPE_START_ADDRESS], &uxSecType, SE_SECURITY_TYPE_LENGTH);
 
     return SE_OPERATION_RESULT_SUCCESS;
 }
 
 SEOperation_t eSetProvisioningFlag(const ProvisioningFlag_t xProvisioningFlag)
 {
+    if (gbIsWriteActive == false)
+    {
+        APP_PRINTFError("Write transaction is not active.");
+        return SE_OPERATION_RESULT_FAILURE;
+    }
+
     // プロビジョニングフラグをSEに書き込む値に変換
     uint32_t uxWriteData;
     if (xProvisioningFlag == true)
@@ -443,18 +577,8 @@ SEOperation_t eSetProvisioningFlag(const ProvisioningFlag_t xProvisioningFlag)
         uxWriteData = PROVISIONING_FLAG_NOT_IMPLEMENTED;
     }
 
-    // SEに書き込み
-    ATCA_STATUS eResult = eWriteECC608Flash(ATCA_ZONE_DATA,
-                                            SAVE_SLOT_ID,
-                                            SE_PROVISIONING_FLAG_START_ADDRESS,
-                                            (uint8_t *)&uxWriteData,
-                                            SE_PROVISIONING_FLAG_LENGTH);
-
-    if (eResult != ATCA_SUCCESS)
-    {
-        APP_PRINTFError("Flash write error to SE. Reason: 0x%02X", eResult);
-        return SE_OPERATION_RESULT_FAILURE;
-    }
+    // 書き込み内容に反映
+    memcpy(&gucStagingImage[SE_PROVISIONING_FLAG_START_ADDRESS], &uxWriteData, SE_PROVISIONING_FLAG_LENGTH);
 
     return SE_OPERATION_RESULT_SUCCESS;
 }
@@ -462,24 +586,14 @@ SEOperation_t eSetProvisioningFlag(const ProvisioningFlag_t xProvisioningFlag)
 SEOperation_t eSetIoTEndpoint(const AWSIoTEndpoint_t *pxEndpoint)
 {
     // バリデート
-    if (pxEndpoint == NULL)
+    if ((pxEndpoint == NULL) || (gbIsWriteActive == false))
     {
-        APP_PRINTFError("Buffer provided is NULL");
+        APP_PRINTFError("Buffer provided is NULL or write transaction is not active.");
         return SE_OPERATION_RESULT_FAILURE;
     }
 
-    // SEに書き込み
-    ATCA_STATUS eResult = eWriteECC608Flash(ATCA_ZONE_DATA,
-                                            SAVE_SLOT_ID,
-                                            SE_IOT_ENDPOINT_START_ADDRESS,
-                                            pxEndpoint->ucEndpoint,
-                                            SE_IOT_ENDPOINT_LENGTH);
-
-    if (eResult != ATCA_SUCCESS)
-    {
-        APP_PRINTFError("Flash write error to SE. Reason: 0x%02X", eResult);
-        return SE_OPERATION_RESULT_FAILURE;
-    }
+    // 書き込み内容に反映
+    memcpy(&gucStagingImage[SE_IOT_ENDPOINT_START_ADDRESS], pxEndpoint->ucEndpoint, SE_IOT_ENDPOINT_LENGTH);
 
     return SE_OPERATION_RESULT_SUCCESS;
 }
@@ -487,29 +601,15 @@ SEOperation_t eSetIoTEndpoint(const AWSIoTEndpoint_t *pxEndpoint)
 SEOperation_t eSetThingName(const ThingName_t *pxName)
 {
     // バリデート
-    if (pxName == NULL)
+    if ((pxName == NULL) || (gbIsWriteActive == false))
     {
-        APP_PRINTFError("Buffer provided is NULL");
+        APP_PRINTFError("Buffer provided is NULL or write transaction is not active.");
         return SE_OPERATION_RESULT_FAILURE;
     }
 
-    // SE内のThingName領域は128ByteでThingName本来のサイズは36Byte（文字）であるため、128Byteに合わせるためバッファにコピーする
-    uint8_t uxThingName[SE_THING_NAME_LENGTH];
-    memset(uxThingName, 0x00, sizeof(uxThingName));
-    strncpy((char *)uxThingName, (const char *)pxName->ucName, THING_NAME_LENGTH);
-
-    // SEに書き込み
-    ATCA_STATUS eResult = eWriteECC608Flash(ATCA_ZONE_DATA,
-                                            SAVE_SLOT_ID,
-                                            SE_THING_NAME_START_ADDRESS,
-                                            uxThingName,
-                                            SE_THING_NAME_LENGTH);
-
-    if (eResult != ATCA_SUCCESS)
-    {
-        APP_PRINTFError("Flash write error to SE. Reason: 0x%02X", eResult);
-        return SE_OPERATION_RESULT_FAILURE;
-    }
+    // SE内のThingName領域は128ByteでThingName本来のサイズは36Byte（文字）であるため、残りは0x00で埋める
+    memset(&gucStagingImage[SE_THING_NAME_START_ADDRESS], 0x00, SE_THING_NAME_LENGTH);
+    strncpy((char *)&gucStagingImage[SE_THING_NAME_START_ADDRESS], (const char *)pxName->ucName, THING_NAME_LENGTH);
 
     return SE_OPERATION_RESULT_SUCCESS;
 }
@@ -523,26 +623,28 @@ static ATCA_STATUS eReadECC608Flash(uint8_t uxZone, uint16_t uxSlot, size_t xOff
 
     ATCA_STATUS eResult = ATCA_SUCCESS;
 
-    // I2CバスがReady状態になるまで待機
-    if (bprvWaitI2CBusReady() == false)
-    {
-        return ATCA_TIMEOUT;
-    }
     uint8_t uxRetryCount;
     for (uxRetryCount = 0; uxRetryCount < SE_OPERATION_FLASH_RETRY_COUNT; uxRetryCount++)
     {
+        // I2Cバスのロックを取得
+        if (bSEBusLock(SE_OPERATION_FLASH_RW_TIMEOUT_MS) == false)
+        {
+            return ATCA_TIMEOUT;
+        }
+
         // 指定箇所からデータ読み込み
         eResult = atcab_read_bytes_zone(uxZone, uxSlot, xOffset, puxData, xLength);
+        vSEBusUnlock();
 
         if (eResult == ATCA_SUCCESS)
         {
             break;
         }
 
-        APP_PRINTFWarn("Flash read failed. Retry...");
+        APP_PRINTFWarn("Flash read failed. Retry... Count: %d", uxRetryCount + 1);
 
-        // 100ms待機
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // 待機時間を伸ばしながらリトライ
+        vSEBusBackoff(uxRetryCount);
     }
 
     return eResult;
@@ -552,63 +654,76 @@ static ATCA_STATUS eWriteECC608Flash(uint8_t uxZone, uint16_t uxSlot, size_t xOf
 {
     ATCA_STATUS eResult = ATCA_SUCCESS;
 
-    // I2CバスがReady状態になるまで待機
-    if (bprvWaitI2CBusReady() == false)
-    {
-        return ATCA_TIMEOUT;
-    }
-
     uint8_t uxRetryCount;
     for (uxRetryCount = 0; uxRetryCount < SE_OPERATION_FLASH_RETRY_COUNT; uxRetryCount++)
     {
+        // I2Cバスのロックを取得
+        if (bSEBusLock(SE_OPERATION_FLASH_RW_TIMEOUT_MS) == false)
+        {
+            return ATCA_TIMEOUT;
+        }
+
         // 指定箇所へのデータ書き込み
         eResult = atcab_write_bytes_zone(uxZone, uxSlot, xOffset, puxData, xLength);
+        vSEBusUnlock();
 
         if (eResult == ATCA_SUCCESS)
         {
             break;
         }
 
-        APP_PRINTFWarn("Flash write failed. Retry...");
+        APP_PRINTFWarn("Flash write failed. Retry... Count: %d", uxRetryCount + 1);
 
-        // 100ms待機
-        vTaskDelay(pdMS_TO_TICKS(100));
+        // 待機時間を伸ばしながらリトライ
+        vSEBusBackoff(uxRetryCount);
     }
 
     return eResult;
 }
 
-static bool bprvWaitI2CBusReady(void)
+static bool bprvLoadSlotImage(void)
 {
-
-    // ドライバがBusy状態じゃないか確認
-    uint8_t uxRetryCout;
-    const uint8_t uxWaitInterval = 100; // 待機する間隔
-    const uint8_t uxMaxRetryCount = (SE_OPERATION_FLASH_RW_TIMEOUT_MS / uxWaitInterval);
-    for (uxRetryCout = 0; uxRetryCout < uxMaxRetryCount; uxRetryCout++)
+    // 読み込み済み
+    if (gbIsSlotImageValid == true)
     {
-        bool isBusy = I2C2_IsBusy();
-        if (isBusy == false)
-        {
-            APP_PRINTFDebug("I2C bus is ready.");
-            break;
-        }
-        APP_PRINTFWarn("Wait for the I2C bus to be ready....");
-
-        // 100ms待機
-        vTaskDelay(pdMS_TO_TICKS(uxWaitInterval));
+        return true;
     }
 
-    // タイムアウトしたかの判定
-    if (uxRetryCout == uxMaxRetryCount)
+    TickType_t xStartTick = xTaskGetTickCount();
+    ATCA_STATUS eResult = eReadECC608Flash(ATCA_ZONE_DATA,
+                                           SAVE_SLOT_ID,
+                                           0,
+                                           gucSlotImage,
+                                           SE_SLOT_IMAGE_LENGTH);
+    if (eResult != ATCA_SUCCESS)
     {
-        APP_PRINTFError("The I2C bus remained busy and timed out. TIMEOUT = %dms", SE_OPERATION_FLASH_RW_TIMEOUT_MS);
+        APP_PRINTFError("Flash read error from SE. Reason: 0x%02X", eResult);
         return false;
     }
 
+#if (SE_SLOT_IMAGE_KEEP_PASSWORD == 0)
+    memset(&gucSlotImage[SE_PASSWORD_START_ADDRESS], 0x00, SE_PASSWORD_LENGTH);
+#endif
+    gbIsSlotImageValid = true;
+
+    APP_PRINTFInfo("Loaded SE slot image: %u bytes in %u ms, %u field reads served since last load.",
+                   SE_SLOT_IMAGE_LENGTH,
+                   (uint32_t)(xTaskGetTickCount() - xStartTick) * portTICK_PERIOD_MS,
+                   gulSlotImageHitCount);
+    gulSlotImageHitCount = 0;
+    vSEBusPrintStats();
     return true;
 }
 
+static void vprvEndWrite(void)
+{
+    memset(gucStagingImage, 0x00, sizeof(gucStagingImage));
+#if (SE_SLOT_IMAGE_KEEP_PASSWORD == 0)
+    memset(&gucSlotImage[SE_PASSWORD_START_ADDRESS], 0x00, SE_PASSWORD_LENGTH);
+#endif
+    gbIsWriteActive = false;
+}
+
 static bool bprvConvertSecurityTypeSEToEnum(const uint32_t xSecTypeFromSE, WIFISecurity_t *pxSecurity)
 {
     switch (xSecTypeFromSE)
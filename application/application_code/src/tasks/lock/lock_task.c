@@ -33,6 +33,7 @@
 #endif
 
 #include "tasks/shadow/include/device_shadow_task.h"
+#include "tasks/ota/include/ota_agent_task.h"
 
 // --------------------------------------------------
 // 自ファイル内でのみ使用する#defineマクロ
@@ -270,6 +271,12 @@ static void prvLockTask(void *pvParameters)
                 break;
             }
 
+            // 解施錠の間はOTAのデータブロックの要求を止め、モーターの制御とShadowの更新を優先する
+            if ((xReceiveQueueData.eOp == LOCK_OP_UNLOCK) || (xReceiveQueueData.eOp == LOCK_OP_LOCK))
+            {
+                vOTAAgentTaskBeginInteractiveOperation();
+            }
+
             if (xReceiveQueueData.eOp == LOCK_OP_UNLOCK)
             {
                 // オートロックタイマーをスタートさせる
@@ -333,6 +340,11 @@ static void prvLockTask(void *pvParameters)
                 xTaskNotify(xReceiveQueueData.xTaskHandle, COMPLETE_LOCKED_UNLOCKED_EVENT, eSetBits);
             }
 
+            if (bShouldUpdateShadow == true)
+            {
+                vOTAAgentTaskEndInteractiveOperation();
+            }
+
             PRINT_TASK_REMAINING_STACK_SIZE();
             break;
         default:
@@ -20,6 +20,7 @@ extern "C"
 #include <stdbool.h>
 
 #include "FreeRTOS.h"
+#include "event_groups.h"
 
 #include "transport_interface.h"
 #include "transport_secure_sockets.h"
@@ -53,6 +54,18 @@ extern "C"
  */
 #define MQTT_CONNECT_RETRY_REPEAT_AD_INFINITUM ((uint32_t)(0xFFFFFFFF))
 
+/**
+ * @brief MQTT接続状態を通知するイベントグループのビット。MQTT接続中にセットされる
+ */
+#define MQTT_CONNECTION_EVENT_BIT_CONNECTED ((EventBits_t)(1U << 0))
+
+/**
+ * @brief MQTT接続状態を通知するイベントグループのビット。通信断から自動再接続した際にセットされる
+ *
+ * @note 本ビットはクリアされないため、再接続を検知したいタスクが参照後にクリアする
+ */
+#define MQTT_CONNECTION_EVENT_BIT_RECONNECTED ((EventBits_t)(1U << 1))
+
     // --------------------------------------------------
     // typedef定義
     // --------------------------------------------------
@@ -82,6 +95,64 @@ extern "C"
         MQTT_OPERATION_TASK_RESULT_NOT_MQTT_CONNECTED = 2
     } MQTTOperationTaskResult_t;
 
+    /**
+     * @brief MQTT Agentのコマンドの優先度
+     */
+    typedef enum
+    {
+        /**
+         * @brief 対話系。Shadowや鍵状態の報告など、ユーザ操作を起点とするコマンド
+         */
+        MQTT_COMMAND_PRIORITY_INTERACTIVE = 0,
+
+        /**
+         * @brief 一括系。OTAなど、遅延しても問題ないコマンド
+         */
+        MQTT_COMMAND_PRIORITY_BULK = 1,
+
+        /**
+         * @brief 優先度の数
+         */
+        MQTT_COMMAND_PRIORITY_NUM = 2
+    } MQTTCommandPriority_t;
+
+    /**
+     * @brief Subscribeしたトピックのコールバック関数を実行するタスク
+     */
+    typedef enum
+    {
+        /**
+         * @brief MQTT Taskで実行する。処理が軽いコールバック関数に使用する
+         */
+        MQTT_DISPATCH_MODE_INLINE = 0,
+
+        /**
+         * @brief 受信したPublishをコピーし、Dispatch Taskで実行する。JSONの解析など処理が重いコールバック関数に使用する
+         */
+        MQTT_DISPATCH_MODE_WORKER = 1
+    } MQTTDispatchMode_t;
+
+    /**
+     * @brief MQTTで使用するトランスポート層の種類
+     */
+    typedef enum
+    {
+        /**
+         * @brief Secure SocketsのTLSでAWS IoTに接続する
+         */
+        MQTT_TRANSPORT_TYPE_TLS = 0,
+
+        /**
+         * @brief Secure Socketsの平文TCPでブローカーに接続する。性能計測用
+         */
+        MQTT_TRANSPORT_TYPE_PLAINTEXT = 1,
+
+        /**
+         * @brief メモリ上のパイプで疑似ブローカーと接続する。性能計測用
+         */
+        MQTT_TRANSPORT_TYPE_PIPE = 2
+    } MQTTTransportType_t;
+
     typedef enum
     {
         /**
@@ -110,6 +181,8 @@ extern "C"
     {
         TaskHandle_t xNotifyTaskHandle;
         void *pxArgs;
+        MQTTCommandPriority_t ePriority; /**< コマンドキューの優先度。コマンドを発行したタスクによって決まる */
+        TickType_t xEnqueueTick;         /**< MQTT Agentにエンキューした時間。0の場合は完了までの時間を計測しない */
     };
 
     /**
@@ -137,6 +210,33 @@ extern "C"
         void *pxIncomingCallbackContext;
     } MQTTCommandDoneArgs_t;
 
+    /**
+     * @brief ストリーム受信でコールバック関数に渡すペイロードの断片
+     */
+    typedef struct
+    {
+        const char *pcTopicName;    /**< 受信したPublishのトピック */
+        uint16_t usTopicNameLength; /**< トピックの長さ */
+        const uint8_t *pucData;     /**< ペイロードの断片。コールバック関数から戻った後は使用できない */
+        size_t uxDataLength;        /**< ペイロードの断片の長さ */
+        size_t uxOffset;            /**< ペイロード先頭からの断片の位置 */
+        size_t uxTotalLength;       /**< ペイロード全体の長さ */
+        bool bIsLast;               /**< ペイロードの最後の断片か */
+    } MQTTStreamChunk_t;
+
+    /**
+     * @brief ストリーム受信で、ペイロードの断片を受け取るコールバック関数
+     *
+     * @note MQTT Taskのコンテキストで実行される
+     *
+     * @param[in] pvContext #eMQTTRegisterStreamReceive で指定したコンテキスト
+     * @param[in] pxChunk   ペイロードの断片
+     *
+     * @retval true  続きの断片を受け取る
+     * @retval false このPublishの残りの断片を破棄する
+     */
+    typedef bool (*MQTTStreamChunkCallback_t)(void *pvContext, const MQTTStreamChunk_t *pxChunk);
+
     /**
      * @brief 本ライブラリで使用するMQTTやその下位レイヤのコンテキストをまとめた構造体
      */
@@ -148,11 +248,11 @@ extern "C"
         NetworkContext_t xNetworkContext;                             /**< ネットワークのコンテキスト */
         TransportInterface_t xTransport;                              /**< トランスポート層へアクセスするためのインターフェース */
         MQTTAgentContext_t xMqttAgentContext;                         /**< MQTTのコンテキスト */
-        MQTTAgentMessageContext_t xMQTTAgentMsgContext;               /**< MQTTのメッセージコンテキスト */
         MQTTAgentMessageInterface_t xMsgInterface;                    /**< MQTTのメッセージインターフェース */
         MQTTConnectInfo_t xMQTTConnectInfo;                           /**< MQTT接続に必要な情報 */
         MQTTFixedBuffer_t xFixedBuffer;                               /**< MQTTで利用するバッファ。uxBufferをバッファとする。  */
         uint8_t uxBuffer[MQTT_BUFFER_SIZE];                           /**< MQTT通信で使用するバッファ */
+        bool bSessionPresent;                                         /**< 直前のMQTT接続でブローカーのセッションが復元されたか */
 
     } MQTTCommunicationContext_t;
 
@@ -223,6 +323,21 @@ extern "C"
         bool (*bRejects)(const uint32_t uxRetryCount);
     } MQTTConnectRejectConditionFunction_t;
 
+    /**
+     * @brief MQTT接続にかかった時間のフェーズごとの内訳
+     *
+     * @note
+     * Secure Sockets層は名前解決、TCP接続、TLSハンドシェイクを1つのAPI内で行うため、uxSocketConnectMsはこれらの合計になる。
+     */
+    typedef struct
+    {
+        uint32_t uxReadSettingsMs;   /**< SEからの接続情報の読み出し。RAMのキャッシュを使用した場合は0になる */
+        uint32_t uxSocketConnectMs;  /**< 名前解決、TCP接続、TLSハンドシェイク。リトライした場合はリトライを含む */
+        uint32_t uxMQTTConnectMs;    /**< MQTT CONNECTの送信からCONNACKの受信まで */
+        uint32_t uxSessionRestoreMs; /**< セッションの復元と再Subscribe */
+        bool bIsReconnect;           /**< 通信断からの自動再接続か */
+    } MQTTConnectTiming_t;
+
     // --------------------------------------------------
     // extern変数宣言
     // --------------------------------------------------
@@ -242,9 +357,27 @@ extern "C"
      *
      * @retval #MQTT_OPERATION_TASK_RESULT_SUCCESS 成功
      * @retval #MQTT_OPERATION_TASK_RESULT_FAILED  失敗
+     *
+     * @see #MQTT_DEFAULT_TRANSPORT_TYPE
      */
     MQTTOperationTaskResult_t eMQTTCommunicationInit(void);
 
+    /**
+     * @brief 使用するトランスポート層を指定して、本ライブラリを初期化する
+     *
+     * @details
+     * 初期化以降のMQTT接続/再接続は、すべて指定したトランスポート層で行う。
+     *
+     * @warning
+     * 本APIはスレッドセーフでない。wake_up_task以外から呼び出してはいけない。
+     *
+     * @param[in] eTransportType トランスポート層の種類
+     *
+     * @retval #MQTT_OPERATION_TASK_RESULT_SUCCESS 成功
+     * @retval #MQTT_OPERATION_TASK_RESULT_FAILED  失敗
+     */
+    MQTTOperationTaskResult_t eMQTTCommunicationInitWithTransport(const MQTTTransportType_t eTransportType);
+
     /**
      * @brief AWS IoTにMQTT接続を行い、Pub/Subコマンドを処理するMQTT Taskを作成する。
      *
@@ -274,6 +407,15 @@ extern "C"
      * @details
      * core_mqtt_agent.h の MQTTAgent_Publish を呼び出す。
      *
+     * QoS1の場合は、トピックとペイロードをMQTT Task内の送信ストアにコピーしてからPublishし、PUBACKを受信するまで待機する。
+     * 送信中のQoS1 Publish数は #MQTT_QOS1_INFLIGHT_WINDOW に制限され、上限に達している場合は空きが出るまで待機する。
+     * PUBACKを受信する前に通信断が発生した場合は、再接続後に送信ストアから再送する(永続セッションの場合はMQTT Agentが再送する)。
+     * いずれも #MQTT_PUB_SUB_TIMEOUT_MS を超えた場合は失敗とする。
+     *
+     * 送信レートの上限(#MQTT_PUBLISH_RATE_LIMIT_ENABLE)を超えている場合は、失敗にせずに送信できるまで待機する。
+     *
+     * @note QoS1の場合、pxContextBufferは使用しない。
+     *
      * @param[in] pxPublishInfo   Publishに必要な情報 @ref MQTTPublishInfo_t
      * @param[in] pxContextBuffer コマンド終了時のコンテキストを維持するために使用するバッファ。この変数はSubscribe関数が終了した後も永続化する必要がある。
      *
@@ -284,6 +426,27 @@ extern "C"
      */
     MQTTOperationTaskResult_t eMQTTpublish(const MQTTPublishInfo_t *pxPublishInfo, StaticMQTTCommandBuffer_t *pxContextBuffer);
 
+    /**
+     * @brief 送信待ちの間に同じトピックへの新しいPublishで上書きしてよいPublishを行う
+     *
+     * @details
+     * 最新の状態だけが届けばよい進捗通知などに使用する。
+     * 送信レートの上限(#MQTT_PUBLISH_RATE_LIMIT_ENABLE)を超えている場合は、トピックとペイロードをコピーして送信を予約し、すぐに戻る。
+     * 送信前に同じトピックへのPublishが再度行われた場合は、予約済みのPublishを上書きし、最新のものだけを送信する。
+     *
+     * 上限を超えていない場合、QoS1の場合、予約領域に空きがない場合、サイズが予約領域を超える場合は #eMQTTpublish と同じ動作となる。
+     *
+     * @warning この関数は #eMQTTConnectToAWSIoT を呼び出す必要がある
+     *
+     * @param[in] pxPublishInfo   Publishに必要な情報 @ref MQTTPublishInfo_t
+     * @param[in] pxContextBuffer #eMQTTpublish と同じ動作となる場合に使用するバッファ
+     *
+     * @retval #MQTT_OPERATION_TASK_RESULT_SUCCESS            成功。送信を予約した場合も含む
+     * @retval #MQTT_OPERATION_TASK_RESULT_FAILED             失敗
+     * @retval #MQTT_OPERATION_TASK_RESULT_NOT_MQTT_CONNECTED MQTT接続が行われていない
+     */
+    MQTTOperationTaskResult_t eMQTTPublishCoalescable(const MQTTPublishInfo_t *pxPublishInfo, StaticMQTTCommandBuffer_t *pxContextBuffer);
+
     /**
      * @brief MQTT Subscribeを行う
      *
@@ -297,13 +460,19 @@ extern "C"
      * @param[in] pxIncomingCallbackContext Topicからデータを受信した場合のコールバック関数に渡される引数
      * @param[in] pxContextBuffer           コマンド終了時のコンテキストを維持するために使用するバッファ。この変数はSubscribe関数が終了した後も永続化する必要がある。
      *
+     * @note
+     * #MQTT_PERSISTENT_SESSION_ENABLE が1で、ブローカーのセッションが復元されている場合、
+     * 同じトピック、コールバック関数、引数の組み合わせで既にSubscribe済みであればブローカーへの送信を行わずに成功を返す。
+     *
      * @warning
      * - xIncomingCallback
      *   このコールバックはMQTT Taskのコンテキストで実行される。他のSubscribeしたTopicを受信出来なくなってしまうため、
-     *   コールバック関数内で時間がかかる処理をしてはいけない。
+     *   コールバック関数内で時間がかかる処理をしてはいけない。時間がかかる場合は #eMQTTSubscribeWithDispatchMode を使用する。
      * - pxIncomingCallbackContext
      *   この構造体のインスタンスとそれが指す変数は、Callback関数が実行されるまで、参照可能である必要がある。
      *   つまり、この構造体はコールバックがコールされるまでスコープを維持するか、動的または静的領域にメモリ確保する必要がある。
+     * - pxSubscribeInfo->pTopicFilter
+     *   トピック文字列はコピーされないため、Unsubscribeするまで参照可能である必要がある。
      *
      * @retval #MQTT_OPERATION_TASK_RESULT_SUCCESS            成功
      * @retval #MQTT_OPERATION_TASK_RESULT_FAILED             失敗
@@ -314,6 +483,36 @@ extern "C"
                                              void *pxIncomingCallbackContext,
                                              StaticMQTTCommandBuffer_t *pxContextBuffer);
 
+    /**
+     * @brief コールバック関数を実行するタスクを指定してMQTT Subscribeを行う
+     *
+     * @details
+     * #MQTT_DISPATCH_MODE_WORKER を指定した場合、受信したPublishはバッファプールにコピーされ、Dispatch Taskでコールバック関数が実行される。
+     * MQTT Taskはコピー後すぐにソケットの受信とコマンドの処理に戻る。
+     * バッファプールに空きがない場合は、順序が入れ替わらないよう受信したPublishを破棄する。
+     * #MQTT_DISPATCH_WORKER_ENABLE が0の場合は、MQTT Taskで実行する。
+     *
+     * @note
+     * #MQTT_DISPATCH_MODE_WORKER の場合、コールバック関数はUnsubscribe後に実行される可能性がある。
+     * そのため、xIncomingCallbackとpxIncomingCallbackContextは静的領域に確保したものを指定する。
+     * また、組み合わせは #MQTT_DISPATCH_SUBSCRIBER_MAX_NUM 個まで登録でき、登録は解除されない。
+     *
+     * @param[in] pxSubscribeInfo           Subscribeに必要な情報 @ref MQTTSubscribeInfo_t
+     * @param[in] xIncomingCallback         SubscribeしたTopicからデータを受信した場合のコールバック関数
+     * @param[in] pxIncomingCallbackContext Topicからデータを受信した場合のコールバック関数に渡される引数
+     * @param[in] pxContextBuffer           コマンド終了時のコンテキストを維持するために使用するバッファ。この変数はSubscribe関数が終了した後も永続化する必要がある。
+     * @param[in] eDispatchMode             コールバック関数を実行するタスク
+     *
+     * @retval #MQTT_OPERATION_TASK_RESULT_SUCCESS            成功
+     * @retval #MQTT_OPERATION_TASK_RESULT_FAILED             失敗
+     * @retval #MQTT_OPERATION_TASK_RESULT_NOT_MQTT_CONNECTED MQTT接続が行われていない
+     */
+    MQTTOperationTaskResult_t eMQTTSubscribeWithDispatchMode(const MQTTSubscribeInfo_t *pxSubscribeInfo,
+                                                             IncomingPubCallback_t xIncomingCallback,
+                                                             void *pxIncomingCallbackContext,
+                                                             StaticMQTTCommandBuffer_t *pxContextBuffer,
+                                                             const MQTTDispatchMode_t eDispatchMode);
+
     /**
      * @brief SubscribeしたトピックをUnsubscribeする
      *
@@ -358,6 +557,109 @@ extern "C"
      */
     MQTTOperationTaskResult_t eMQTTDisconnectAndTaskShutdown(void);
 
+    /**
+     * @brief トピックフィルタに一致するPublishを、ペイロードの断片として受け取るように登録する
+     *
+     * @details
+     * 登録したトピックフィルタに一致し、ペイロードが uxMinPayloadLength 以上のPublishは、
+     * MQTT通信バッファ(#MQTT_BUFFER_SIZE)に格納せずに、トランスポート層から読み込んだ順に xCallback へ渡す。
+     * ペイロードを渡し終えたPublishは、#eMQTTSubscribe で登録したコールバック関数には渡されない。
+     * ブローカーへのSubscribeは別途 #eMQTTSubscribe で行う必要がある。
+     *
+     * @note QoS2のPublishは対象外
+     *
+     * @param[in] pcTopicFilter       トピックフィルタ。登録を解除するまで保持すること
+     * @param[in] usTopicFilterLength トピックフィルタの長さ
+     * @param[in] uxMinPayloadLength  ストリーム受信とするペイロードの最小長。0の場合はすべてのPublishを対象とする
+     * @param[in] xCallback           ペイロードの断片を受け取るコールバック関数
+     * @param[in] pvContext           コールバック関数に渡す引数
+     *
+     * @retval #MQTT_OPERATION_TASK_RESULT_SUCCESS 成功
+     * @retval #MQTT_OPERATION_TASK_RESULT_FAILED  失敗。登録数が #MQTT_STREAM_SUBSCRIBER_MAX_NUM を超えた、または #MQTT_STREAM_RECEIVE_ENABLE が0
+     */
+    MQTTOperationTaskResult_t eMQTTRegisterStreamReceive(const char *pcTopicFilter,
+                                                         const uint16_t usTopicFilterLength,
+                                                         const size_t uxMinPayloadLength,
+                                                         const MQTTStreamChunkCallback_t xCallback,
+                                                         void *pvContext);
+
+    /**
+     * @brief #eMQTTRegisterStreamReceive の登録を解除する
+     *
+     * @param[in] pcTopicFilter       登録時に指定したトピックフィルタ
+     * @param[in] usTopicFilterLength トピックフィルタの長さ
+     */
+    void vMQTTUnregisterStreamReceive(const char *pcTopicFilter, const uint16_t usTopicFilterLength);
+
+    /**
+     * @brief 直前のMQTT接続でブローカーのセッションが復元されたかを取得する
+     *
+     * @retval true  セッションが復元された。Subscribe済みのトピックは再度Subscribeする必要がない
+     * @retval false セッションは新規に作成された
+     */
+    bool bMQTTIsSessionPresent(void);
+
+    /**
+     * @brief 直前のMQTT接続にかかった時間の内訳を取得する
+     *
+     * @param[out] pxTiming 接続にかかった時間
+     */
+    void vMQTTGetLastConnectTiming(MQTTConnectTiming_t *pxTiming);
+
+    /**
+     * @brief MQTT通信のメトリクスをデバッグ出力に表示する
+     *
+     * @details
+     * Publish/Subscribe/Unsubscribeの完了までの時間のヒストグラム、コマンドキューの滞留数、送受信したバイト数、
+     * 再接続回数、KeepAliveの往復時間を表示する。
+     *
+     * @note #MQTT_METRICS_ENABLE が0の場合は、無効であることのみ表示する
+     */
+    void vMQTTPrintMetrics(void);
+
+    /**
+     * @brief MQTT接続状態を通知するイベントグループを取得する
+     *
+     * @details
+     * MQTT Taskは通信断を検知すると、Wi-Fiを切断せずにTLSとMQTTの再接続を繰り返す。
+     * 再接続中は #MQTT_CONNECTION_EVENT_BIT_CONNECTED がクリアされ、再接続後に
+     * #MQTT_CONNECTION_EVENT_BIT_CONNECTED と #MQTT_CONNECTION_EVENT_BIT_RECONNECTED がセットされる。
+     *
+     * @return EventGroupHandle_t イベントグループ。#eMQTTCommunicationInit 前はNULL
+     */
+    EventGroupHandle_t xMQTTGetConnectionEventGroup(void);
+
+    /**
+     * @brief MQTTが接続中になるまで待機する
+     *
+     * @param[in] uxTimeoutMs タイムアウト
+     *
+     * @retval true  MQTT接続中
+     * @retval false タイムアウトまでに接続されなかった
+     */
+    bool bMQTTWaitForConnection(const uint32_t uxTimeoutMs);
+
+    /**
+     * @brief 一括系のコマンドを発行するタスクとして登録する
+     *
+     * @details
+     * 登録したタスクが発行するPub/Subコマンドは、対話系のコマンドより後に処理される。
+     * 登録していないタスクが発行するコマンドは対話系として扱う。
+     *
+     * @param[in] xTaskHandle 登録するタスク
+     *
+     * @retval #MQTT_OPERATION_TASK_RESULT_SUCCESS 成功
+     * @retval #MQTT_OPERATION_TASK_RESULT_FAILED  登録数が #MQTT_BULK_TASK_MAX_NUM を超えた
+     */
+    MQTTOperationTaskResult_t eMQTTRegisterBulkTask(const TaskHandle_t xTaskHandle);
+
+    /**
+     * @brief 一括系のコマンドを発行するタスクの登録を解除する
+     *
+     * @param[in] xTaskHandle 登録を解除するタスク
+     */
+    void vMQTTUnregisterBulkTask(const TaskHandle_t xTaskHandle);
+
     // --------------------------------------------------
     // インライン関数
     // --------------------------------------------------
@@ -8,10 +8,14 @@
 // システムヘッダの取り込み
 // --------------------------------------------------
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
 
 #include "FreeRTOS.h"
+#include "semphr.h"
+#include "event_groups.h"
+#include "timers.h"
 
 #include "transport_interface.h"
 #include "transport_secure_sockets.h"
@@ -20,7 +24,6 @@
 #include "core_mqtt_serializer.h"
 #include "freertos_agent_message.h"
 #include "freertos_command_pool.h"
-#include "freertos_agent_message.h"
 
 #include "mqtt_subscription_manager.h"
 
@@ -36,8 +39,14 @@
 #include "config/mqtt_config.h"
 
 #include "tasks/mqtt/include/mqtt_operation_task.h"
+#include "tasks/mqtt/private/include/mqtt_priority_message.h"
+#include "tasks/mqtt/private/include/mqtt_dispatch_worker.h"
+#include "tasks/mqtt/private/include/mqtt_transport.h"
+#include "tasks/mqtt/private/include/mqtt_stream_receive.h"
+#include "tasks/mqtt/private/include/mqtt_metrics.h"
 #include "tasks/flash/include/flash_data.h"
 #include "tasks/flash/include/flash_task.h"
+#include "common/randutil/include/randutil.h"
 // --------------------------------------------------
 // 自ファイル内でのみ使用する#defineマクロ
 // --------------------------------------------------
@@ -51,6 +60,19 @@
  */
 #define SOCKET_CONNECT_WAITE_TIME_MS 100
 
+/**
+ * @brief 再接続中のMQTT Taskにシャットダウンを要求した際に、タスクの終了を待機する時間
+ *
+ * @details
+ * TLSハンドシェイク中に要求した場合はハンドシェイクの完了まで終了しないため、MQTT接続より長く待機する
+ */
+#define MQTT_RECONNECT_ABORT_WAIT_TIME_MS (10U * 1000U)
+
+/**
+ * @brief MQTT Taskにシャットダウンを要求するイベントビット
+ */
+#define MQTT_CONNECTION_EVENT_BIT_SHUTDOWN_REQUEST ((EventBits_t)(1U << 2))
+
 // --------------------------------------------------
 // 自ファイル内でのみ使用するtypedef定義
 // --------------------------------------------------
@@ -59,6 +81,51 @@
 // 自ファイル内でのみ使用するenumタグ定義（typedefを同時に行う）
 // --------------------------------------------------
 
+/**
+ * @brief MQTT Taskの接続状態
+ */
+typedef enum
+{
+    MQTT_CONNECTION_STATE_DISCONNECTED = 0,       /**< 未接続 */
+    MQTT_CONNECTION_STATE_CONNECTED = 1,          /**< 接続中。MQTT TaskはCommandを処理する */
+    MQTT_CONNECTION_STATE_RECONNECTING = 2,       /**< 通信断により再接続中。MQTT TaskはCommandを処理できない */
+    MQTT_CONNECTION_STATE_SHUTDOWN_REQUESTED = 3, /**< 再接続中にシャットダウンが要求された */
+} MQTTConnectionState_t;
+
+/**
+ * @brief QoS1 Publishの送信ストアの状態
+ */
+typedef enum
+{
+    MQTT_OUTGOING_PUBLISH_STATE_FREE = 0,      /**< 未使用 */
+    MQTT_OUTGOING_PUBLISH_STATE_RESERVED = 1,  /**< 呼び出し元が確保済み。MQTT Agentには渡していない */
+    MQTT_OUTGOING_PUBLISH_STATE_PENDING = 2,   /**< MQTT Agentに渡し、PUBACKを待機している */
+    MQTT_OUTGOING_PUBLISH_STATE_ACKED = 3,     /**< PUBACKを受信した */
+    MQTT_OUTGOING_PUBLISH_STATE_FAILED = 4,    /**< 通信断などによりMQTT Agentがコマンドを破棄した */
+    MQTT_OUTGOING_PUBLISH_STATE_ABANDONED = 5, /**< 呼び出し元がタイムアウトした。完了時にMQTT Taskが解放する */
+} MQTTOutgoingPublishState_t;
+
+/**
+ * @brief 送信レートを制限するPublishの種類
+ */
+typedef enum
+{
+    MQTT_PUBLISH_CLASS_SHADOW = 0,  /**< Device Shadow */
+    MQTT_PUBLISH_CLASS_OTA = 1,     /**< OTA(Jobs, Streams) */
+    MQTT_PUBLISH_CLASS_DEFAULT = 2, /**< その他 */
+    MQTT_PUBLISH_CLASS_NUM = 3,     /**< 種類の数 */
+} MQTTPublishClass_t;
+
+/**
+ * @brief 送信待ちの間に上書きできるPublishの保持領域の状態
+ */
+typedef enum
+{
+    MQTT_COALESCED_PUBLISH_STATE_FREE = 0,    /**< 未使用 */
+    MQTT_COALESCED_PUBLISH_STATE_WAITING = 1, /**< トークンの補充を待っている。同じトピックのPublishで上書きできる */
+    MQTT_COALESCED_PUBLISH_STATE_SENDING = 2, /**< MQTT Agentに渡した。完了時にMQTT Taskが解放する */
+} MQTTCoalescedPublishState_t;
+
 /**
  * @brief MQTT Taskに渡すパラメータ
  */
@@ -80,6 +147,200 @@ typedef struct
 // 自ファイル内でのみ使用するstruct/unionタグ定義（typedefを同時に行う）
 // --------------------------------------------------
 
+/**
+ * @brief ブローカーにSubscribe済みのトピックとコールバック関数の組み合わせ
+ *
+ * @details
+ * 永続セッションの再接続時に、SubscriptionManagerの振り分けを本一覧から復元する。
+ */
+typedef struct
+{
+    /**
+     * @brief Subscribeしたトピック。pTopicFilterはcTopicFilterを指す
+     */
+    MQTTSubscribeInfo_t xSubscribeInfo;
+
+    /**
+     * @brief Subscribeしたトピックのコピー。呼び出し元の領域が解放されても参照できるよう保持する
+     */
+    char cTopicFilter[MQTT_SUBSCRIBE_TOPIC_MAX_LENGTH];
+
+    /**
+     * @brief トピックを受信した時に呼び出すCallback関数
+     */
+    IncomingPubCallback_t xIncomingCallback;
+
+    /**
+     * @brief Callback関数に渡す引数
+     */
+    void *pvIncomingCallbackContext;
+} MQTTRetainedSubscription_t;
+
+/**
+ * @brief 再接続時にSubscribe済みトピック一覧をまとめてSubscribeするコマンド
+ *
+ * @details
+ * MQTT AgentがSUBACKを受信するまで参照するため、ファイル内で1つだけ保持する
+ */
+typedef struct
+{
+    MQTTAgentCommandContext_t xCommandContext;                                            /**< コマンド完了時のコールバック関数に渡すコンテキスト */
+    MQTTAgentCommandInfo_t xCommandInfo;                                                  /**< MQTT Agentに渡すコマンドの情報 */
+    MQTTAgentSubscribeArgs_t xSubscribeArgs;                                              /**< MQTT Agentに渡すSubscribeの引数 */
+    MQTTSubscribeInfo_t xSubscribeInfoList[MQTT_MAX_SUBSCRIBE_NUM];                       /**< Subscribeするトピック。pTopicFilterはcTopicFilterListを指す */
+    char cTopicFilterList[MQTT_MAX_SUBSCRIBE_NUM][MQTT_SUBSCRIBE_TOPIC_MAX_LENGTH];       /**< Subscribeするトピックのコピー */
+    volatile bool bIsPending;                                                             /**< MQTT Agentに渡し、完了していない */
+} MQTTResubscribeCommand_t;
+
+/**
+ * @brief QoS1 Publishの送信ストア
+ *
+ * @details
+ * PUBACKを受信するまでトピックとペイロードを保持し、再接続時にMQTT Agentまたは呼び出し元が再送する。
+ */
+typedef struct
+{
+    /**
+     * @brief 送信ストアの状態。MQTT Taskと競合するため、クリティカルセクション内で更新する
+     */
+    volatile MQTTOutgoingPublishState_t eState;
+
+    /**
+     * @brief 完了を通知するイベントビット
+     */
+    EventBits_t xDoneEventBit;
+
+    /**
+     * @brief MQTT Agentに渡すPublish情報。トピックとペイロードは本ストアを参照する
+     */
+    MQTTPublishInfo_t xPublishInfo;
+
+    /**
+     * @brief MQTT Agentのコマンド情報
+     */
+    MQTTAgentCommandInfo_t xCommandInfo;
+
+    /**
+     * @brief コマンド完了時のコンテキスト。pxArgsに本ストアを格納する
+     */
+    MQTTAgentCommandContext_t xCommandContext;
+
+    /**
+     * @brief トピックのコピー
+     */
+    uint8_t ucTopic[MQTT_QOS1_STORE_TOPIC_MAX_LENGTH];
+
+    /**
+     * @brief ペイロードのコピー
+     */
+    uint8_t ucPayload[MQTT_QOS1_STORE_PAYLOAD_MAX_LENGTH];
+} MQTTOutgoingPublish_t;
+
+/**
+ * @brief Publishの種類を判定するトピックフィルタ
+ */
+typedef struct
+{
+    const char *pcTopicFilter;        /**< トピックフィルタ */
+    uint16_t usTopicFilterLength;     /**< トピックフィルタの長さ */
+    MQTTPublishClass_t ePublishClass; /**< 一致した場合のPublishの種類 */
+} MQTTPublishClassFilter_t;
+
+/**
+ * @brief Publishの種類ごとの送信レートを制限するトークンバケット
+ */
+typedef struct
+{
+    uint32_t ulPublishPerSecond;  /**< 1秒あたりに補充するトークン数 */
+    uint32_t ulBurst;             /**< 保持できるトークン数の上限 */
+    uint32_t ulMilliTokens;       /**< 残りのトークン数の1000倍。クリティカルセクション内で更新する */
+    TickType_t xLastRefillTick;   /**< 最後にトークンを補充した時間 */
+    SemaphoreHandle_t xWaitMutex; /**< トークンを待機するPublishを1つずつ処理するためのMutex */
+    uint32_t ulThrottledCount;    /**< 送信レートの上限を超えたPublish数 */
+    uint32_t ulCoalescedCount;    /**< 送信待ちの間に上書きされたPublish数 */
+    uint32_t ulTotalWaitMs;       /**< トークンの補充を待機した時間の合計 */
+} MQTTPublishRateLimiter_t;
+
+/**
+ * @brief 送信待ちの間に同じトピックへの新しいPublishで上書きできるPublishの保持領域
+ */
+typedef struct
+{
+    /**
+     * @brief 保持領域の状態。MQTT Taskと競合するため、クリティカルセクション内で更新する
+     */
+    volatile MQTTCoalescedPublishState_t eState;
+
+    /**
+     * @brief Publishの種類
+     */
+    MQTTPublishClass_t ePublishClass;
+
+    /**
+     * @brief MQTT Agentに渡すPublish情報。トピックとペイロードは本領域を参照する
+     */
+    MQTTPublishInfo_t xPublishInfo;
+
+    /**
+     * @brief MQTT Agentのコマンド情報
+     */
+    MQTTAgentCommandInfo_t xCommandInfo;
+
+    /**
+     * @brief コマンド完了時のコンテキスト。pxArgsに本領域を格納する
+     */
+    MQTTAgentCommandContext_t xCommandContext;
+
+    /**
+     * @brief トピックのコピー
+     */
+    uint8_t ucTopic[MQTT_RATE_LIMIT_COALESCE_TOPIC_MAX_LENGTH];
+
+    /**
+     * @brief ペイロードのコピー
+     */
+    uint8_t ucPayload[MQTT_RATE_LIMIT_COALESCE_PAYLOAD_MAX_LENGTH];
+} MQTTCoalescedPublish_t;
+
+/**
+ * @brief メトリクスを診断用トピックへPublishするための領域
+ *
+ * @details
+ * MQTT Agentはコマンドの完了までトピックとペイロードを参照するため、完了するまで内容を保持する
+ */
+typedef struct
+{
+    /**
+     * @brief Publishのコマンドが完了していないか
+     */
+    bool bIsSending;
+
+    /**
+     * @brief Publishの情報
+     */
+    MQTTPublishInfo_t xPublishInfo;
+
+    /**
+     * @brief MQTT Agentのコマンド情報
+     */
+    MQTTAgentCommandInfo_t xCommandInfo;
+
+    /**
+     * @brief コマンド完了時のコンテキスト
+     */
+    MQTTAgentCommandContext_t xCommandContext;
+
+    /**
+     * @brief 診断用トピック
+     */
+    char cTopic[MQTT_METRICS_TOPIC_MAX_LENGTH];
+
+    /**
+     * @brief メトリクスのJSON
+     */
+    char cPayload[MQTT_METRICS_SNAPSHOT_BUFFER_SIZE];
+} MQTTMetricsPublish_t;
+
 // --------------------------------------------------
 // ファイル内で共有するstatic変数宣言
 // --------------------------------------------------
@@ -100,9 +361,173 @@ static uint32_t guxGlobalEntryTimeMs = 0;
 static MQTTCommunicationContext_t gxMQTTCommunicationContext;
 
 /**
- * @brief MQTTSubscribeを管理する配列
+ * @brief MQTTで使用するトランスポート層。eMQTTCommunicationInitWithTransportで選択する
+ */
+static const MQTTTransport_t *gpxTransport = NULL;
+
+/**
+ * @brief MQTTSubscribeを管理するトピックツリー
+ */
+static SubscriptionManager_t gxSubscriptionManager;
+
+#if MQTT_MAX_SUBSCRIBE_NUM > SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS
+
+/**
+ * SubscriptionManagerが保持できるSubscription数はSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONSで決まるため、
+ * MQTT_MAX_SUBSCRIBE_NUMを大きくする場合はSUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONSも合わせて見直す
+ */
+#    error "MQTT_MAX_SUBSCRIBE_NUM exceeds SUBSCRIPTION_MANAGER_MAX_SUBSCRIPTIONS"
+#endif
+
+/**
+ * @brief MQTT Taskの接続状態。シャットダウン要求と競合するため、クリティカルセクション内で更新する
+ */
+static volatile MQTTConnectionState_t gxConnectionState = MQTT_CONNECTION_STATE_DISCONNECTED;
+
+/**
+ * @brief MQTT接続状態を通知するイベントグループ
+ */
+static EventGroupHandle_t gxMQTTConnectionEventGroup = NULL;
+
+/**
+ * @brief QoS1 Publishの送信ストア
+ */
+static MQTTOutgoingPublish_t gxOutgoingPublishList[MQTT_QOS1_INFLIGHT_WINDOW];
+
+#if (MQTT_QOS1_INFLIGHT_WINDOW == 0) || (MQTT_QOS1_INFLIGHT_WINDOW > 24)
+
+/**
+ * 送信ストアの完了通知はイベントグループのビットを使用するため、24個より多くは確保できない
+ */
+#    error "MQTT_QOS1_INFLIGHT_WINDOW must be between 1 and 24"
+#endif
+
+/**
+ * @brief 送信中のQoS1 Publish数を制限するカウンティングセマフォ
+ */
+static SemaphoreHandle_t gxQoS1InflightSemaphore = NULL;
+
+/**
+ * @brief QoS1 Publishの完了を通知するイベントグループ。送信ストア1つにつき1ビット使用する
+ */
+static EventGroupHandle_t gxOutgoingPublishEventGroup = NULL;
+
+#if (MQTT_PUBLISH_RATE_LIMIT_ENABLE == 1)
+/**
+ * @brief Publishの種類を判定するトピックフィルタの一覧。一致しない場合は #MQTT_PUBLISH_CLASS_DEFAULT とする
+ */
+static const MQTTPublishClassFilter_t gxPublishClassFilterList[] = {
+    {
+        .pcTopicFilter = "$aws/things/+/shadow/#",
+        .usTopicFilterLength = sizeof("$aws/things/+/shadow/#") - 1,
+        .ePublishClass = MQTT_PUBLISH_CLASS_SHADOW,
+    },
+    {
+        .pcTopicFilter = "$aws/things/+/jobs/#",
+        .usTopicFilterLength = sizeof("$aws/things/+/jobs/#") - 1,
+        .ePublishClass = MQTT_PUBLISH_CLASS_OTA,
+    },
+    {
+        .pcTopicFilter = "$aws/things/+/streams/#",
+        .usTopicFilterLength = sizeof("$aws/things/+/streams/#") - 1,
+        .ePublishClass = MQTT_PUBLISH_CLASS_OTA,
+    },
+};
+
+/**
+ * @brief Publishの種類ごとのトークンバケット
+ */
+static MQTTPublishRateLimiter_t gxPublishRateLimiterList[MQTT_PUBLISH_CLASS_NUM] = {
+    [MQTT_PUBLISH_CLASS_SHADOW] = {
+        .ulPublishPerSecond = MQTT_RATE_LIMIT_SHADOW_PUBLISH_PER_SECOND,
+        .ulBurst = MQTT_RATE_LIMIT_SHADOW_BURST,
+    },
+    [MQTT_PUBLISH_CLASS_OTA] = {
+        .ulPublishPerSecond = MQTT_RATE_LIMIT_OTA_PUBLISH_PER_SECOND,
+        .ulBurst = MQTT_RATE_LIMIT_OTA_BURST,
+    },
+    [MQTT_PUBLISH_CLASS_DEFAULT] = {
+        .ulPublishPerSecond = MQTT_RATE_LIMIT_DEFAULT_PUBLISH_PER_SECOND,
+        .ulBurst = MQTT_RATE_LIMIT_DEFAULT_BURST,
+    },
+};
+
+#    if (MQTT_RATE_LIMIT_SHADOW_PUBLISH_PER_SECOND == 0) || (MQTT_RATE_LIMIT_OTA_PUBLISH_PER_SECOND == 0) || (MQTT_RATE_LIMIT_DEFAULT_PUBLISH_PER_SECOND == 0)
+
+/**
+ * トークンの補充を待つ時間を1秒あたりの送信数で割って求めるため、0にはできない
+ */
+#        error "MQTT_RATE_LIMIT_*_PUBLISH_PER_SECOND must be 1 or more"
+#    endif
+
+#    if (MQTT_RATE_LIMIT_SHADOW_BURST == 0) || (MQTT_RATE_LIMIT_OTA_BURST == 0) || (MQTT_RATE_LIMIT_DEFAULT_BURST == 0)
+
+/**
+ * 1つもトークンを貯められないと送信できないため、0にはできない
+ */
+#        error "MQTT_RATE_LIMIT_*_BURST must be 1 or more"
+#    endif
+
+/**
+ * @brief 送信待ちの間に上書きできるPublishの保持領域
+ */
+static MQTTCoalescedPublish_t gxCoalescedPublishList[MQTT_RATE_LIMIT_COALESCE_SLOT_NUM];
+
+/**
+ * @brief gxCoalescedPublishListの内容を保護するMutex
+ */
+static SemaphoreHandle_t gxCoalescedPublishMutex = NULL;
+
+/**
+ * @brief トークンが補充された時に、送信待ちのPublishを送信するタイマー
+ */
+static TimerHandle_t gxCoalescedPublishTimer = NULL;
+#endif
+
+#if (MQTT_METRICS_ENABLE == 1)
+/**
+ * @brief メトリクスを診断用トピックへPublishするための領域
+ */
+static MQTTMetricsPublish_t gxMetricsPublish;
+
+/**
+ * @brief メトリクスを定期的に診断用トピックへPublishするタイマー
+ */
+static TimerHandle_t gxMetricsPublishTimer = NULL;
+#endif
+
+/**
+ * @brief MQTT Agentの優先度付きコマンドキュー
+ */
+static MQTTPriorityMessageContext_t gxPriorityMessageContext;
+
+/**
+ * @brief 一括系のコマンドを発行するタスクの一覧
+ */
+static TaskHandle_t gxBulkTaskHandleList[MQTT_BULK_TASK_MAX_NUM] = {NULL};
+
+/**
+ * @brief ブローカーにSubscribe済みのトピック一覧
+ */
+static MQTTRetainedSubscription_t gxRetainedSubscriptionList[MQTT_MAX_SUBSCRIBE_NUM];
+
+/**
+ * @brief 再接続時にSubscribe済みトピック一覧をまとめてSubscribeするコマンド
+ */
+static MQTTResubscribeCommand_t gxResubscribeCommand;
+
+/**
+ * @brief gxRetainedSubscriptionListを保護するMutex
+ */
+static SemaphoreHandle_t gxRetainedSubscriptionMutex = NULL;
+
+/**
+ * @brief gxRetainedSubscriptionListを作成した時のClientID
+ *
+ * @details
+ * 異なるClientIDで接続した場合、ブローカーのセッションは別物になるため一覧を破棄する
  */
-static SubscriptionElement_t gxSubscribeElementList[MQTT_MAX_SUBSCRIBE_NUM];
+static uint8_t gucSessionClientID[THING_NAME_LENGTH + 1] = {0x00};
 
 /**
  * @brief MQTT に接続するために使用するClientID(ThingName)
@@ -123,6 +548,24 @@ static uint8_t gxMQTTClientID[THING_NAME_LENGTH + 1] = {0x00};
  */
 static AWSIoTEndpoint_t gxIoTEndpoint;
 
+/**
+ * @brief gxMQTTClientIDとgxIoTEndpointにSEから読み出した接続情報が保持されているか
+ *
+ * @details
+ * 同じClient ID Typeで再度接続する場合は、I2C経由のSEの読み出しを省略する
+ */
+static bool gbIsConnectionInfoCached = false;
+
+/**
+ * @brief gxMQTTClientIDを読み出した時のClient ID Type
+ */
+static MQTTThingNameType geCachedThingNameType = MQTT_THING_NAME_TYPE_PROVISIONING;
+
+/**
+ * @brief 直前のMQTT接続にかかった時間の内訳
+ */
+static MQTTConnectTiming_t gxLastConnectTiming;
+
 // --------------------------------------------------
 // static関数プロトタイプ宣言
 // --------------------------------------------------
@@ -226,38 +669,384 @@ static bool bprvSocketConnectWithRetry(NetworkContext_t *pNetworkContext,
  */
 static bool bprvGetMQTTInfoFromFlash(const MQTTThingNameType eThingNameType, uint8_t *pucThingName, uint8_t *pucIoTEndpoint);
 
-// --------------------------------------------------
-// 変数定義（staticを除く）
-// --------------------------------------------------
+/**
+ * @brief Subscribe済みトピック一覧に追加する
+ *
+ * @details
+ * トピックは一覧にコピーする。同じ組み合わせが登録済みの場合は、登録済みのコピーを返す
+ *
+ * @param[in] pxSubscribeInfo           Subscribeしたトピック
+ * @param[in] xIncomingCallback         トピックを受信した時に呼び出すCallback関数
+ * @param[in] pvIncomingCallbackContext Callback関数に渡す引数
+ *
+ * @return 一覧に保持したトピック。一覧に空きがない、またはトピックが長すぎる場合はNULL
+ */
+static const char *pcprvAddRetainedSubscription(const MQTTSubscribeInfo_t *pxSubscribeInfo,
+                                                IncomingPubCallback_t xIncomingCallback,
+                                                void *pvIncomingCallbackContext);
 
-// --------------------------------------------------
-// 関数定義（staticを除く）
-// --------------------------------------------------
+/**
+ * @brief Subscribe済みトピック一覧から削除する
+ *
+ * @param[in] pcTopicFilter       Unsubscribeしたトピック
+ * @param[in] uxTopicFilterLength トピックの長さ
+ */
+static void vprvRemoveRetainedSubscription(const char *pcTopicFilter, const uint16_t uxTopicFilterLength);
 
-MQTTOperationTaskResult_t eMQTTCommunicationInit(void)
-{
+/**
+ * @brief Subscribe済みトピック一覧に登録されているか確認する
+ *
+ * @param[in] pxSubscribeInfo           Subscribeするトピック
+ * @param[in] xIncomingCallback         トピックを受信した時に呼び出すCallback関数
+ * @param[in] pvIncomingCallbackContext Callback関数に渡す引数
+ *
+ * @retval true  登録済み
+ * @retval false 未登録
+ */
+static bool bprvIsRetainedSubscription(const MQTTSubscribeInfo_t *pxSubscribeInfo,
+                                       IncomingPubCallback_t xIncomingCallback,
+                                       const void *pvIncomingCallbackContext);
 
-    // MQTT Subscriptionを初期化
-    memset(gxSubscribeElementList, 0x00, sizeof(SubscriptionElement_t) * MQTT_MAX_SUBSCRIBE_NUM);
+/**
+ * @brief Subscribe済みトピック一覧からSubscriptionManagerの振り分けを復元する
+ *
+ * @param[in] bDiscardRetainedSubscriptions trueの場合、Subscribe済みトピック一覧を破棄して振り分けを空にする
+ */
+static void vprvRestoreSubscriptionRouting(const bool bDiscardRetainedSubscriptions);
 
-    // MQTT Agentで使用するQueueの作成
-    QueueHandle_t xHandle = xQueueCreate(MQTT_AGENT_COMMAND_QUEUE_LENGTH,
-                                         sizeof(MQTTAgentCommand_t *));
-    // xMsgInterfaceの初期化
-    gxMQTTCommunicationContext.xMQTTAgentMsgContext.queue = xHandle;
-    gxMQTTCommunicationContext.xMsgInterface.pMsgCtx = &gxMQTTCommunicationContext.xMQTTAgentMsgContext;
-    gxMQTTCommunicationContext.xMsgInterface.send = &Agent_MessageSend;
-    gxMQTTCommunicationContext.xMsgInterface.recv = &Agent_MessageReceive;
-    gxMQTTCommunicationContext.xMsgInterface.getCommand = &Agent_GetCommand;
-    gxMQTTCommunicationContext.xMsgInterface.releaseCommand = &Agent_ReleaseCommand;
+/**
+ * @brief MQTT Taskが終了するまで待機する
+ *
+ * @param[in] uxTimeoutMs タイムアウト
+ *
+ * @retval #MQTT_OPERATION_TASK_RESULT_SUCCESS MQTT Taskが終了した
+ * @retval #MQTT_OPERATION_TASK_RESULT_FAILED  タイムアウト
+ */
+static MQTTOperationTaskResult_t eprvWaitMQTTTaskDeleted(const uint32_t uxTimeoutMs);
+
+/**
+ * @brief 通信断から再接続する
+ *
+ * @details
+ * 上限付き指数バックオフとFull Jitterで待機しながら、TLS接続とMQTT接続を再試行する。
+ * セッションが復元されなかった場合は、Subscribe済みトピック一覧を再度Subscribeする。
+ *
+ * @param[in] pxContext MQTT Taskのパラメータ
+ *
+ * @retval true  再接続成功
+ * @retval false シャットダウンが要求されたため再接続を中断した
+ */
+static bool bprvReconnectWithBackoff(const MQTTTaskParameters_t *pxContext);
+
+/**
+ * @brief 再接続までの待機時間を取得する
+ *
+ * @param[in] uxAttempt これまでに失敗した再接続の回数
+ *
+ * @return uint32_t 0から上限までの乱数の待機時間(ms)
+ */
+static uint32_t uxprvGetBackoffDelayMs(const uint32_t uxAttempt);
+
+/**
+ * @brief Subscribe済みトピック一覧をまとめてSubscribeするコマンドをMQTT Agentに渡す
+ *
+ * @details
+ * MQTT Taskから呼ぶため、コマンドの完了は待たない。SUBACKは #vprvResubscribeCommandDoneCallback で確認する
+ *
+ * @param[in] pxContext MQTT Taskのパラメータ
+ *
+ * @retval true  コマンドをMQTT Agentに渡した、またはSubscribeするトピックがない
+ * @retval false コマンドをMQTT Agentに渡せなかった
+ */
+static bool bprvResubscribeRetainedSubscriptions(const MQTTTaskParameters_t *pxContext);
+
+/**
+ * @brief 再接続時のSubscribeコマンドが終了したことを検知するCallback関数
+ *
+ * @details
+ * コマンドが失敗した場合は接続を切り、再接続からやり直す。
+ * ブローカーに拒否されたトピックは、Subscribe済みトピック一覧とSubscriptionManagerから削除する
+ *
+ * @param[in] pCmdCallbackContext 使用しない
+ * @param[in] pReturnInfo         Subscribeコマンドの実行結果
+ */
+static void vprvResubscribeCommandDoneCallback(MQTTAgentCommandContext_t *pCmdCallbackContext, MQTTAgentReturnInfo_t *pReturnInfo);
+
+/**
+ * @brief MQTT接続にかかった時間の内訳を記録して出力する
+ *
+ * @param[in] pxTiming 接続にかかった時間
+ */
+static void vprvRecordConnectTiming(const MQTTConnectTiming_t *pxTiming);
+
+/**
+ * @brief QoS1のPublishを行い、PUBACKを受信するまで待機する
+ *
+ * @param[in] pxPublishInfo Publishに必要な情報
+ *
+ * @retval #MQTT_OPERATION_TASK_RESULT_SUCCESS PUBACKを受信した
+ * @retval #MQTT_OPERATION_TASK_RESULT_FAILED  失敗。タイムアウトも含む
+ */
+static MQTTOperationTaskResult_t eprvPublishQoS1(const MQTTPublishInfo_t *pxPublishInfo);
+
+/**
+ * @brief 空いているQoS1 Publishの送信ストアを確保する
+ *
+ * @return MQTTOutgoingPublish_t* 確保した送信ストア。空きがない場合はNULL
+ */
+static MQTTOutgoingPublish_t *xprvAcquireOutgoingPublish(void);
+
+/**
+ * @brief QoS1 Publishの送信ストアを解放し、送信ウィンドウを1つ空ける
+ *
+ * @param[in] pxOutgoing 解放する送信ストア
+ */
+static void vprvReleaseOutgoingPublish(MQTTOutgoingPublish_t *pxOutgoing);
+
+/**
+ * @brief MQTTAgentのQoS1 Publishコマンドが終了したことを検知するCallback関数
+ *
+ * @details
+ * PUBACKを受信した時、または通信断によりMQTT Agentがコマンドを破棄した時に呼び出される。
+ *
+ * @param[in] pCmdCallbackContext 送信ストアのコンテキスト
+ * @param[in] pReturnInfo         Publishコマンドの実行結果
+ */
+static void vprvMQTTQoS1PublishDoneCallback(MQTTAgentCommandContext_t *pCmdCallbackContext, MQTTAgentReturnInfo_t *pReturnInfo);
+
+/**
+ * @brief 呼び出し元のタスクが発行するコマンドの優先度を取得する
+ *
+ * @return MQTTCommandPriority_t 一括系として登録されたタスクの場合は #MQTT_COMMAND_PRIORITY_BULK 、それ以外は #MQTT_COMMAND_PRIORITY_INTERACTIVE
+ */
+static MQTTCommandPriority_t eprvGetCurrentTaskCommandPriority(void);
+
+/**
+ * @brief QoS0のPublishを行い、MQTT Agentがコマンドを処理するまで待機する
+ *
+ * @param[in] pxPublishInfo   Publishに必要な情報
+ * @param[in] pxContextBuffer コマンド終了時のコンテキストを維持するために使用するバッファ
+ *
+ * @retval #MQTT_OPERATION_TASK_RESULT_SUCCESS 成功
+ * @retval #MQTT_OPERATION_TASK_RESULT_FAILED  失敗
+ */
+static MQTTOperationTaskResult_t eprvPublishQoS0(const MQTTPublishInfo_t *pxPublishInfo, StaticMQTTCommandBuffer_t *pxContextBuffer);
+
+#if (MQTT_PUBLISH_RATE_LIMIT_ENABLE == 1)
+/**
+ * @brief トピックからPublishの種類を判定する
+ *
+ * @param[in] pcTopicName       トピック
+ * @param[in] usTopicNameLength トピックの長さ
+ *
+ * @return MQTTPublishClass_t Publishの種類
+ */
+static MQTTPublishClass_t eprvGetPublishClass(const char *pcTopicName, const uint16_t usTopicNameLength);
+
+/**
+ * @brief トークンを補充し、トークンが補充されるまでの時間を取得する
+ *
+ * @param[in] ePublishClass Publishの種類
+ * @param[in] bTake         trueの場合、トークンが残っていれば1つ消費する
+ *
+ * @return uint32_t トークンが1つ補充されるまでの時間[ms]。トークンが残っている場合は0
+ */
+static uint32_t ulprvCheckPublishToken(const MQTTPublishClass_t ePublishClass, const bool bTake);
+
+/**
+ * @brief トークンを1つ消費する。トークンが残っていない場合は補充されるまで待機する
+ *
+ * @param[in] ePublishClass Publishの種類
+ */
+static void vprvWaitForPublishToken(const MQTTPublishClass_t ePublishClass);
+
+/**
+ * @brief トークンが補充された時に、送信待ちのPublishをMQTT Agentに渡すタイマーのCallback関数
+ *
+ * @param[in] xTimer タイマーハンドル
+ */
+static void vprvCoalescedPublishTimerCallback(TimerHandle_t xTimer);
+
+/**
+ * @brief 送信待ちのPublishのコマンドが終了したことを検知するCallback関数
+ *
+ * @param[in] pCmdCallbackContext 保持領域のコンテキスト
+ * @param[in] pReturnInfo         Publishコマンドの実行結果
+ */
+static void vprvMQTTCoalescedPublishDoneCallback(MQTTAgentCommandContext_t *pCmdCallbackContext, MQTTAgentReturnInfo_t *pReturnInfo);
+
+/**
+ * @brief Publishの種類ごとの送信レート制限の統計情報を出力する
+ */
+static void vprvPrintPublishRateLimitStats(void);
+#endif
+
+#if (MQTT_METRICS_ENABLE == 1)
+/**
+ * @brief メトリクスを診断用トピックへPublishするタイマーのCallback関数
+ *
+ * @param[in] xTimer タイマーハンドル
+ */
+static void vprvMetricsPublishTimerCallback(TimerHandle_t xTimer);
+
+/**
+ * @brief メトリクスのPublishのコマンドが終了したことを検知するCallback関数
+ *
+ * @param[in] pCmdCallbackContext MQTTAgent_Publish()を呼び出した際に指定したコンテキスト
+ * @param[in] pReturnInfo         Publishコマンドの実行結果
+ */
+static void vprvMQTTMetricsPublishDoneCallback(MQTTAgentCommandContext_t *pCmdCallbackContext, MQTTAgentReturnInfo_t *pReturnInfo);
+#endif
+
+// --------------------------------------------------
+// 変数定義（staticを除く）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 関数定義（staticを除く）
+// --------------------------------------------------
+
+MQTTOperationTaskResult_t eMQTTCommunicationInit(void)
+{
+    return eMQTTCommunicationInitWithTransport(MQTT_DEFAULT_TRANSPORT_TYPE);
+}
+
+MQTTOperationTaskResult_t eMQTTCommunicationInitWithTransport(const MQTTTransportType_t eTransportType)
+{
+    // トランスポート層の選択
+    gpxTransport = pxMQTTTransportGet(eTransportType);
+    if (gpxTransport == NULL)
+    {
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+    if ((gpxTransport->bInit != NULL) && (gpxTransport->bInit() == false))
+    {
+        APP_PRINTFError("Failed to initialize mqtt transport: %s", gpxTransport->pcName);
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+    APP_PRINTFDebug("MQTT transport: %s", gpxTransport->pcName);
+
+    // MQTT Subscriptionを初期化
+    SubscriptionManager_Init(&gxSubscriptionManager);
+    memset(gxRetainedSubscriptionList, 0x00, sizeof(gxRetainedSubscriptionList));
+    memset(gucSessionClientID, 0x00, sizeof(gucSessionClientID));
+    gxRetainedSubscriptionMutex = xSemaphoreCreateMutex();
+    if (gxRetainedSubscriptionMutex == NULL)
+    {
+        APP_PRINTFError("Failed to create retained subscription mutex.");
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+
+    // QoS1 Publishの送信ストアを初期化
+    memset(gxOutgoingPublishList, 0x00, sizeof(gxOutgoingPublishList));
+    gxQoS1InflightSemaphore = xSemaphoreCreateCounting(MQTT_QOS1_INFLIGHT_WINDOW, MQTT_QOS1_INFLIGHT_WINDOW);
+    gxOutgoingPublishEventGroup = xEventGroupCreate();
+    if ((gxQoS1InflightSemaphore == NULL) || (gxOutgoingPublishEventGroup == NULL))
+    {
+        APP_PRINTFError("Failed to create qos1 in-flight resources.");
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+    for (uint32_t i = 0; i < MQTT_QOS1_INFLIGHT_WINDOW; i++)
+    {
+        gxOutgoingPublishList[i].eState = MQTT_OUTGOING_PUBLISH_STATE_FREE;
+        gxOutgoingPublishList[i].xDoneEventBit = (EventBits_t)(1U << i);
+    }
+
+#if (MQTT_PUBLISH_RATE_LIMIT_ENABLE == 1)
+    // Publishの送信レートを制限するトークンバケットの初期化。起動直後はバースト分のトークンを持つ
+    for (uint32_t i = 0; i < MQTT_PUBLISH_CLASS_NUM; i++)
+    {
+        MQTTPublishRateLimiter_t *pxLimiter = &gxPublishRateLimiterList[i];
+        pxLimiter->ulMilliTokens = pxLimiter->ulBurst * 1000U;
+        pxLimiter->xLastRefillTick = xTaskGetTickCount();
+        pxLimiter->ulThrottledCount = 0;
+        pxLimiter->ulCoalescedCount = 0;
+        pxLimiter->ulTotalWaitMs = 0;
+        pxLimiter->xWaitMutex = xSemaphoreCreateMutex();
+        if (pxLimiter->xWaitMutex == NULL)
+        {
+            APP_PRINTFError("Failed to create publish rate limit mutex.");
+            return MQTT_OPERATION_TASK_RESULT_FAILED;
+        }
+    }
+    memset(gxCoalescedPublishList, 0x00, sizeof(gxCoalescedPublishList));
+    gxCoalescedPublishMutex = xSemaphoreCreateMutex();
+    gxCoalescedPublishTimer = xTimerCreate("MQTTCoalesce", 1, pdFALSE, NULL, vprvCoalescedPublishTimerCallback);
+    if ((gxCoalescedPublishMutex == NULL) || (gxCoalescedPublishTimer == NULL))
+    {
+        APP_PRINTFError("Failed to create coalesced publish resources.");
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+#endif
+
+#if (MQTT_METRICS_ENABLE == 1)
+    // メトリクスを定期的にPublishするタイマーの作成。再初期化時は作成済みのタイマーを使用する
+    memset(&gxMetricsPublish, 0x00, sizeof(gxMetricsPublish));
+    if ((MQTT_METRICS_PUBLISH_INTERVAL_MS > 0) && (gxMetricsPublishTimer == NULL))
+    {
+        gxMetricsPublishTimer = xTimerCreate("MQTTMetrics", pdMS_TO_TICKS(MQTT_METRICS_PUBLISH_INTERVAL_MS), pdTRUE, NULL, vprvMetricsPublishTimerCallback);
+        if (gxMetricsPublishTimer == NULL)
+        {
+            APP_PRINTFError("Failed to create mqtt metrics timer.");
+            return MQTT_OPERATION_TASK_RESULT_FAILED;
+        }
+    }
+#endif
+
+    // MQTT接続状態を通知するイベントグループの作成
+    gxMQTTConnectionEventGroup = xEventGroupCreate();
+    if (gxMQTTConnectionEventGroup == NULL)
+    {
+        APP_PRINTFError("Failed to create mqtt connection event group.");
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+
+#if (MQTT_DISPATCH_WORKER_ENABLE == 1)
+    // 受信したPublishのコールバック関数を実行するDispatch Taskの作成
+    if (bMQTTDispatchWorkerInit() == false)
+    {
+        APP_PRINTFError("Failed to initialize mqtt dispatch worker.");
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+#endif
+
+    // MQTT Agentで使用する優先度付きQueueの作成
+    if (bMQTTPriorityMessageInit(&gxPriorityMessageContext) == false)
+    {
+        APP_PRINTFError("Failed to create mqtt agent command queue.");
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+    // xMsgInterfaceの初期化
+    gxMQTTCommunicationContext.xMsgInterface.pMsgCtx = &gxPriorityMessageContext.xAgentMessageContext;
+    gxMQTTCommunicationContext.xMsgInterface.send = &bMQTTPriorityMessageSend;
+    gxMQTTCommunicationContext.xMsgInterface.recv = &bMQTTPriorityMessageReceive;
+    gxMQTTCommunicationContext.xMsgInterface.getCommand = &Agent_GetCommand;
+    gxMQTTCommunicationContext.xMsgInterface.releaseCommand = &Agent_ReleaseCommand;
     Agent_InitializePool();
 
+    // コマンドを作り直したため、前回のMQTT Taskで処理されなかった再Subscribeのコマンドは破棄されている
+    memset(&gxResubscribeCommand, 0x00, sizeof(gxResubscribeCommand));
+
     // MQTTが使用するネットワークインターフェース設定
     memset(&gxMQTTCommunicationContext.xMqttAgentContext, 0x00, sizeof(gxMQTTCommunicationContext.xMqttAgentContext));
     memset(&gxMQTTCommunicationContext.xTransport, 0x00, sizeof(gxMQTTCommunicationContext.xTransport));
     gxMQTTCommunicationContext.xTransport.pNetworkContext = &gxMQTTCommunicationContext.xNetworkContext;
-    gxMQTTCommunicationContext.xTransport.send = SecureSocketsTransport_Send;
-    gxMQTTCommunicationContext.xTransport.recv = SecureSocketsTransport_Recv;
+    TransportSend_t xTransportSend = gpxTransport->xSend;
+    TransportRecv_t xTransportRecv = gpxTransport->xRecv;
+#if (MQTT_METRICS_ENABLE == 1)
+    // 送受信したバイト数とKeepAliveの往復時間を計測する
+    vMQTTMetricsInit(xTransportSend, xTransportRecv);
+    xTransportSend = lMQTTMetricsTransportSend;
+    xTransportRecv = lMQTTMetricsTransportRecv;
+#endif
+    gxMQTTCommunicationContext.xTransport.send = xTransportSend;
+#if (MQTT_STREAM_RECEIVE_ENABLE == 1)
+    // ストリーム受信を登録したトピックのペイロードは、MQTT通信バッファを介さずに受け取る
+    vMQTTStreamReceiveInit(xTransportRecv);
+    gxMQTTCommunicationContext.xTransport.recv = lMQTTStreamReceiveRecv;
+#else
+    gxMQTTCommunicationContext.xTransport.recv = xTransportRecv;
+#endif
 
     // ネットワークバッファの初期化
     gxMQTTCommunicationContext.xFixedBuffer.pBuffer = &(gxMQTTCommunicationContext.uxBuffer[0]);
@@ -270,7 +1059,7 @@ MQTTOperationTaskResult_t eMQTTCommunicationInit(void)
                                           &gxMQTTCommunicationContext.xTransport,
                                           &prvGetTimeMs,
                                           &vprvIncomingPublishCallback,
-                                          &gxSubscribeElementList[0]);
+                                          &gxSubscriptionManager);
 
     // MQTTを初期化した時間を記録
     guxGlobalEntryTimeMs = prvGetTimeMs();
@@ -290,27 +1079,42 @@ MQTTOperationTaskResult_t eMQTTConnectToAWSIoT(const MQTTThingNameType eThingNam
                                                const MQTTConnectRejectConditionFunction_t *pxRetryConditionFunction)
 {
 
-    // Flashからデータを取得
-    memset(gxMQTTClientID, '\0', sizeof(gxMQTTClientID));
-    memset(&gxIoTEndpoint, 0x00, sizeof(gxIoTEndpoint));
-    if (bprvGetMQTTInfoFromFlash(eThingNameType, gxMQTTClientID, gxIoTEndpoint.ucEndpoint) == false)
+    MQTTConnectTiming_t xTiming = {0x00};
+    uint32_t uxPhaseStartMs = prvGetTimeMs();
+
+    // Flashからデータを取得。前回と同じClient ID Typeの場合はRAMに保持している接続情報を使用する
+    if ((gbIsConnectionInfoCached == false) || (geCachedThingNameType != eThingNameType))
     {
-        APP_PRINTFError("Read flash error.");
-        return MQTT_OPERATION_TASK_RESULT_FAILED;
+        gbIsConnectionInfoCached = false;
+        memset(gxMQTTClientID, '\0', sizeof(gxMQTTClientID));
+        memset(&gxIoTEndpoint, 0x00, sizeof(gxIoTEndpoint));
+        if (bprvGetMQTTInfoFromFlash(eThingNameType, gxMQTTClientID, gxIoTEndpoint.ucEndpoint) == false)
+        {
+            APP_PRINTFError("Read flash error.");
+            return MQTT_OPERATION_TASK_RESULT_FAILED;
+        }
+        gbIsConnectionInfoCached = true;
+        geCachedThingNameType = eThingNameType;
+        xTiming.uxReadSettingsMs = prvGetTimeMs() - uxPhaseStartMs;
+    }
+    else
+    {
+        APP_PRINTFDebug("Use cached mqtt connection info.");
     }
 
     // ----- TLS socket connect ----
     memset(&gxMQTTCommunicationContext.xSecureSocketsTransportParams, 0x00, sizeof(gxMQTTCommunicationContext.xSecureSocketsTransportParams));
     gxMQTTCommunicationContext.xNetworkContext.pParams = &gxMQTTCommunicationContext.xSecureSocketsTransportParams;
 
-    // 接続先情報の格納
-    gxMQTTCommunicationContext.xServerInfo.pHostName = (const char *)gxIoTEndpoint.ucEndpoint;
-    gxMQTTCommunicationContext.xServerInfo.hostNameLength = strlen((const char *)gxIoTEndpoint.ucEndpoint);
-    gxMQTTCommunicationContext.xServerInfo.port = AWS_IOT_MQTT_PORT;
+    // 接続先情報の格納。トランスポート層に接続先の指定がない場合はSEに保存されたIoT Endpointに接続する
+    const char *pcHostName = (gpxTransport->pcHostName != NULL) ? gpxTransport->pcHostName : (const char *)gxIoTEndpoint.ucEndpoint;
+    gxMQTTCommunicationContext.xServerInfo.pHostName = pcHostName;
+    gxMQTTCommunicationContext.xServerInfo.hostNameLength = strlen(pcHostName);
+    gxMQTTCommunicationContext.xServerInfo.port = gpxTransport->usPort;
 
     // ソケットの設定
     memset(&gxMQTTCommunicationContext.xSocketsConfig, 0x00, sizeof(gxMQTTCommunicationContext.xSocketsConfig));
-    gxMQTTCommunicationContext.xSocketsConfig.enableTls = true;
+    gxMQTTCommunicationContext.xSocketsConfig.enableTls = gpxTransport->bEnableTls;
     gxMQTTCommunicationContext.xSocketsConfig.pAlpnProtos = NULL;
     gxMQTTCommunicationContext.xSocketsConfig.maxFragmentLength = 0;
     gxMQTTCommunicationContext.xSocketsConfig.disableSni = false;
@@ -321,6 +1125,7 @@ MQTTOperationTaskResult_t eMQTTConnectToAWSIoT(const MQTTThingNameType eThingNam
 
     // Socket connect
     APP_PRINTFDebug("Connect socket...");
+    uxPhaseStartMs = prvGetTimeMs();
     if (bprvSocketConnectWithRetry(&gxMQTTCommunicationContext.xNetworkContext,
                                    &gxMQTTCommunicationContext.xServerInfo,
                                    &gxMQTTCommunicationContext.xSocketsConfig,
@@ -330,11 +1135,12 @@ MQTTOperationTaskResult_t eMQTTConnectToAWSIoT(const MQTTThingNameType eThingNam
         APP_PRINTFError("Failed to connect socket.");
         return MQTT_OPERATION_TASK_RESULT_FAILED;
     }
+    xTiming.uxSocketConnectMs = prvGetTimeMs() - uxPhaseStartMs;
 
     // ----- MQTT connect ----
     bool bSessionPresent = false;
     memset(&(gxMQTTCommunicationContext.xMQTTConnectInfo), 0x00, sizeof(gxMQTTCommunicationContext.xMQTTConnectInfo));
-    gxMQTTCommunicationContext.xMQTTConnectInfo.cleanSession = true;
+    gxMQTTCommunicationContext.xMQTTConnectInfo.cleanSession = (MQTT_PERSISTENT_SESSION_ENABLE == 1) ? false : true;
     gxMQTTCommunicationContext.xMQTTConnectInfo.pClientIdentifier = (const char *)gxMQTTClientID;
     gxMQTTCommunicationContext.xMQTTConnectInfo.clientIdentifierLength = strlen((const char *)gxMQTTClientID);
     gxMQTTCommunicationContext.xMQTTConnectInfo.keepAliveSeconds = MQTT_KEEP_ALIVE_INTERVAL_SECONDS;
@@ -343,6 +1149,7 @@ MQTTOperationTaskResult_t eMQTTConnectToAWSIoT(const MQTTThingNameType eThingNam
     // MQTT接続
     // MEMO:
     // 既にソケット接続が終わっているため、この時点でMQTT接続が失敗する可能性は低い。したがってMQTT接続自体のリトライは行わない。
+    uxPhaseStartMs = prvGetTimeMs();
     if (MQTT_Connect((MQTTContext_t *)(&(gxMQTTCommunicationContext.xMqttAgentContext)),
                      (const MQTTConnectInfo_t *)(&(gxMQTTCommunicationContext.xMQTTConnectInfo)),
                      NULL,
@@ -352,6 +1159,42 @@ MQTTOperationTaskResult_t eMQTTConnectToAWSIoT(const MQTTThingNameType eThingNam
         APP_PRINTFError("Failed to connect mqtt.");
         return MQTT_OPERATION_TASK_RESULT_FAILED;
     }
+    xTiming.uxMQTTConnectMs = prvGetTimeMs() - uxPhaseStartMs;
+
+    // ----- Session restore ----
+    uxPhaseStartMs = prvGetTimeMs();
+    // 前回と異なるClientIDの場合、ブローカーのセッションと手元のSubscribe済みトピック一覧は対応しない
+    if (strncmp((const char *)gucSessionClientID, (const char *)gxMQTTClientID, THING_NAME_LENGTH) != 0)
+    {
+        bSessionPresent = false;
+    }
+    strncpy((char *)gucSessionClientID, (const char *)gxMQTTClientID, THING_NAME_LENGTH);
+    gxMQTTCommunicationContext.bSessionPresent = bSessionPresent;
+    APP_PRINTFDebug("MQTT session present: %d", bSessionPresent);
+
+    // MQTT Taskが受信を始める前に振り分けを準備する。セッションが復元されなかった場合は、各タスクが改めてSubscribeする
+    vprvRestoreSubscriptionRouting(bSessionPresent == false);
+
+    // セッションが復元された場合は未完了のQoS1 Publishを再送し、そうでない場合は未完了のコマンドを破棄する
+    if (MQTTAgent_ResumeSession(&(gxMQTTCommunicationContext.xMqttAgentContext), bSessionPresent) != MQTTSuccess)
+    {
+        APP_PRINTFError("Failed to resume mqtt session.");
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+    xTiming.uxSessionRestoreMs = prvGetTimeMs() - uxPhaseStartMs;
+    vprvRecordConnectTiming(&xTiming);
+
+    // 接続状態を通知
+    gxConnectionState = MQTT_CONNECTION_STATE_CONNECTED;
+    xEventGroupClearBits(gxMQTTConnectionEventGroup, MQTT_CONNECTION_EVENT_BIT_SHUTDOWN_REQUEST | MQTT_CONNECTION_EVENT_BIT_RECONNECTED);
+    xEventGroupSetBits(gxMQTTConnectionEventGroup, MQTT_CONNECTION_EVENT_BIT_CONNECTED);
+
+#if (MQTT_METRICS_ENABLE == 1)
+    if (gxMetricsPublishTimer != NULL)
+    {
+        xTimerStart(gxMetricsPublishTimer, 0);
+    }
+#endif
 
     if (gxMQTTTaskHandle == NULL)
     {
@@ -373,9 +1216,6 @@ MQTTOperationTaskResult_t eMQTTConnectToAWSIoT(const MQTTThingNameType eThingNam
         }
     }
 
-    // MQTT Subscriptionを初期化
-    memset(gxSubscribeElementList, 0x00, sizeof(SubscriptionElement_t) * MQTT_MAX_SUBSCRIBE_NUM);
-
     APP_PRINTFDebug("MQTT Connect To AWSIoT finished.");
     return MQTT_OPERATION_TASK_RESULT_SUCCESS;
 }
@@ -389,42 +1229,124 @@ MQTTOperationTaskResult_t eMQTTpublish(const MQTTPublishInfo_t *pxPublishInfo, S
         return MQTT_OPERATION_TASK_RESULT_NOT_MQTT_CONNECTED;
     }
 
-    // MQTTPublishに必要なCallbackを登録
-    memset(pxContextBuffer, 0x00, sizeof(StaticMQTTCommandBuffer_t));
-    MQTTAgentCommandInfo_t *pxAgentCommandInfo = &(pxContextBuffer->u.xPublish.xMQTTAgentCommandInfo);
-    MQTTAgentCommandContext_t *pxCommandContext = &(pxContextBuffer->u.xPublish.xMQTTAgentCommand);
-    pxCommandContext->xNotifyTaskHandle = xTaskGetCurrentTaskHandle();
+    // QoS1の場合はPUBACKを受信するまで送信ストアで保持する
+    if (pxPublishInfo->qos == MQTTQoS1)
+    {
+        return eprvPublishQoS1(pxPublishInfo);
+    }
 
-    pxAgentCommandInfo->cmdCompleteCallback = &vprvMQTTCommandDoneCallback;
-    pxAgentCommandInfo->pCmdCompleteCallbackContext = pxCommandContext;
-    pxAgentCommandInfo->blockTimeMs = MQTT_TASK_COMMAND_ENQUEUE_TIMEOUT_MS;
+#if (MQTT_PUBLISH_RATE_LIMIT_ENABLE == 1)
+    // 送信レートの上限を超えている場合は、トークンが補充されるまで待機する
+    vprvWaitForPublishToken(eprvGetPublishClass(pxPublishInfo->pTopicName, pxPublishInfo->topicNameLength));
+#endif
 
-    // MQTT Agentに対してPublish
-    MQTTStatus_t xMQTTResult = MQTTAgent_Publish((const MQTTAgentContext_t *)(&(gxMQTTCommunicationContext.xMqttAgentContext)),
-                                                 (MQTTPublishInfo_t *)pxPublishInfo,
-                                                 (const MQTTAgentCommandInfo_t *)pxAgentCommandInfo);
-    if (xMQTTResult != MQTTSuccess)
+    return eprvPublishQoS0(pxPublishInfo, pxContextBuffer);
+}
+
+MQTTOperationTaskResult_t eMQTTPublishCoalescable(const MQTTPublishInfo_t *pxPublishInfo, StaticMQTTCommandBuffer_t *pxContextBuffer)
+{
+#if (MQTT_PUBLISH_RATE_LIMIT_ENABLE == 1)
+    // MQTTに接続しているか調査
+    if (gxMQTTCommunicationContext.xMqttAgentContext.mqttContext.connectStatus != MQTTConnected)
     {
-        APP_PRINTFError("MQTT publish error. Reason: %d", xMQTTResult);
-        return MQTT_OPERATION_TASK_RESULT_FAILED;
+        APP_PRINTFWarn("MQTT is not connected");
+        return MQTT_OPERATION_TASK_RESULT_NOT_MQTT_CONNECTED;
     }
 
-    APP_PRINTFDebug("MQTT publish command send success. Waiting for publish done...");
+    // 保持領域に収まらないPublishは、上書きせずに送信する
+    if ((pxPublishInfo->qos != MQTTQoS0) ||
+        (pxPublishInfo->topicNameLength > MQTT_RATE_LIMIT_COALESCE_TOPIC_MAX_LENGTH) ||
+        (pxPublishInfo->payloadLength > MQTT_RATE_LIMIT_COALESCE_PAYLOAD_MAX_LENGTH))
+    {
+        return eMQTTpublish(pxPublishInfo, pxContextBuffer);
+    }
 
-    // PublishのCallbackを待機
-    bool bIsSuccess = bprvWaitTaskNotify(MQTT_PUB_SUB_TIMEOUT_MS);
+    const MQTTPublishClass_t ePublishClass = eprvGetPublishClass(pxPublishInfo->pTopicName, pxPublishInfo->topicNameLength);
+    MQTTPublishRateLimiter_t *pxLimiter = &gxPublishRateLimiterList[ePublishClass];
 
-    if (bIsSuccess == false)
+    xSemaphoreTake(gxCoalescedPublishMutex, portMAX_DELAY);
+
+    // 同じトピックのPublishが送信待ちの場合は上書きする
+    MQTTCoalescedPublish_t *pxCoalesced = NULL;
+    for (uint32_t i = 0; i < MQTT_RATE_LIMIT_COALESCE_SLOT_NUM; i++)
     {
-        APP_PRINTFError("MQTT publish timeout.");
+        if ((gxCoalescedPublishList[i].eState == MQTT_COALESCED_PUBLISH_STATE_WAITING) &&
+            (gxCoalescedPublishList[i].xPublishInfo.topicNameLength == pxPublishInfo->topicNameLength) &&
+            (memcmp(gxCoalescedPublishList[i].ucTopic, pxPublishInfo->pTopicName, pxPublishInfo->topicNameLength) == 0))
+        {
+            pxCoalesced = &gxCoalescedPublishList[i];
+            break;
+        }
+    }
 
-        // コンテキストをNULLにしておく
-        pxCommandContext->xNotifyTaskHandle = NULL;
-        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    if (pxCoalesced != NULL)
+    {
+        taskENTER_CRITICAL();
+        pxLimiter->ulCoalescedCount++;
+        taskEXIT_CRITICAL();
+        APP_PRINTFDebug("MQTT publish coalesced. TOPIC: %.*s", pxPublishInfo->topicNameLength, pxPublishInfo->pTopicName);
     }
+    else
+    {
+        // トークンが残っていればすぐに送信する
+        if (ulprvCheckPublishToken(ePublishClass, true) == 0)
+        {
+            xSemaphoreGive(gxCoalescedPublishMutex);
+            return eprvPublishQoS0(pxPublishInfo, pxContextBuffer);
+        }
 
-    APP_PRINTFDebug("MQTT publish success. TOPIC: %s", pxPublishInfo->pTopicName);
+        for (uint32_t i = 0; i < MQTT_RATE_LIMIT_COALESCE_SLOT_NUM; i++)
+        {
+            if (gxCoalescedPublishList[i].eState == MQTT_COALESCED_PUBLISH_STATE_FREE)
+            {
+                pxCoalesced = &gxCoalescedPublishList[i];
+                break;
+            }
+        }
+
+        // 保持領域に空きがない場合は、トークンが補充されるまで待機して送信する
+        if (pxCoalesced == NULL)
+        {
+            xSemaphoreGive(gxCoalescedPublishMutex);
+            return eMQTTpublish(pxPublishInfo, pxContextBuffer);
+        }
+
+        taskENTER_CRITICAL();
+        pxLimiter->ulThrottledCount++;
+        taskEXIT_CRITICAL();
+        APP_PRINTFDebug("MQTT publish deferred by rate limit. TOPIC: %.*s", pxPublishInfo->topicNameLength, pxPublishInfo->pTopicName);
+    }
+
+    // トピックとペイロードを保持領域にコピーし、トークンが補充されたらタイマーから送信する
+    memcpy(pxCoalesced->ucTopic, pxPublishInfo->pTopicName, pxPublishInfo->topicNameLength);
+    memcpy(pxCoalesced->ucPayload, pxPublishInfo->pPayload, pxPublishInfo->payloadLength);
+    pxCoalesced->xPublishInfo = *pxPublishInfo;
+    pxCoalesced->xPublishInfo.pTopicName = (const char *)pxCoalesced->ucTopic;
+    pxCoalesced->xPublishInfo.pPayload = pxCoalesced->ucPayload;
+    pxCoalesced->ePublishClass = ePublishClass;
+
+    memset(&pxCoalesced->xCommandContext, 0x00, sizeof(pxCoalesced->xCommandContext));
+    pxCoalesced->xCommandContext.pxArgs = pxCoalesced;
+    pxCoalesced->xCommandContext.ePriority = eprvGetCurrentTaskCommandPriority();
+    pxCoalesced->xCommandInfo.cmdCompleteCallback = &vprvMQTTCoalescedPublishDoneCallback;
+    pxCoalesced->xCommandInfo.pCmdCompleteCallbackContext = &pxCoalesced->xCommandContext;
+    pxCoalesced->xCommandInfo.blockTimeMs = 0;
+
+    taskENTER_CRITICAL();
+    pxCoalesced->eState = MQTT_COALESCED_PUBLISH_STATE_WAITING;
+    taskEXIT_CRITICAL();
+
+    if (xTimerIsTimerActive(gxCoalescedPublishTimer) == pdFALSE)
+    {
+        uint32_t ulWaitMs = ulprvCheckPublishToken(ePublishClass, false);
+        xTimerChangePeriod(gxCoalescedPublishTimer, pdMS_TO_TICKS(ulWaitMs) + 1, 0);
+    }
+
+    xSemaphoreGive(gxCoalescedPublishMutex);
     return MQTT_OPERATION_TASK_RESULT_SUCCESS;
+#else
+    return eMQTTpublish(pxPublishInfo, pxContextBuffer);
+#endif
 }
 
 MQTTOperationTaskResult_t eMQTTSubscribe(const MQTTSubscribeInfo_t *pxSubscribeInfo,
@@ -432,6 +1354,19 @@ MQTTOperationTaskResult_t eMQTTSubscribe(const MQTTSubscribeInfo_t *pxSubscribeI
                                          void *pxIncomingCallbackContext,
                                          StaticMQTTCommandBuffer_t *pxContextBuffer)
 {
+    return eMQTTSubscribeWithDispatchMode(pxSubscribeInfo,
+                                          xIncomingCallback,
+                                          pxIncomingCallbackContext,
+                                          pxContextBuffer,
+                                          MQTT_DISPATCH_MODE_INLINE);
+}
+
+MQTTOperationTaskResult_t eMQTTSubscribeWithDispatchMode(const MQTTSubscribeInfo_t *pxSubscribeInfo,
+                                                         IncomingPubCallback_t xIncomingCallback,
+                                                         void *pxIncomingCallbackContext,
+                                                         StaticMQTTCommandBuffer_t *pxContextBuffer,
+                                                         const MQTTDispatchMode_t eDispatchMode)
+{
 
     // MQTTに接続しているか調査
     if (gxMQTTCommunicationContext.xMqttAgentContext.mqttContext.connectStatus != MQTTConnected)
@@ -440,12 +1375,36 @@ MQTTOperationTaskResult_t eMQTTSubscribe(const MQTTSubscribeInfo_t *pxSubscribeI
         return MQTT_OPERATION_TASK_RESULT_NOT_MQTT_CONNECTED;
     }
 
-    // CallbackContextを初期化
-
-    // MQTT Agentに対してSubscribe
-    memset(pxContextBuffer, 0x00, sizeof(StaticMQTTUnsubscribeCommandBuffer_t));
-    MQTTAgentCommandContext_t *pxAgentContext = &(pxContextBuffer->u.xSubscribe.xMQTTCommandContext);
-    MQTTCommandDoneArgs_t *pxMQTTCommandDone = &(pxContextBuffer->u.xSubscribe.xMQTTCommandDoneArgs);
+#if (MQTT_DISPATCH_WORKER_ENABLE == 1)
+    // Dispatch Taskで実行する場合は、コピーしてDispatch Taskに渡すコールバック関数をSubscriptionManagerに登録する
+    if (eDispatchMode == MQTT_DISPATCH_MODE_WORKER)
+    {
+        void *pvDispatchContext = pvMQTTDispatchWorkerGetContext(xIncomingCallback, pxIncomingCallbackContext);
+        if (pvDispatchContext == NULL)
+        {
+            return MQTT_OPERATION_TASK_RESULT_FAILED;
+        }
+        xIncomingCallback = &vMQTTDispatchWorkerIncomingPublishCallback;
+        pxIncomingCallbackContext = pvDispatchContext;
+    }
+#else
+    (void)eDispatchMode; // Dispatch Taskを使用しないため、常にMQTT Taskで実行する
+#endif
+
+    // セッションが復元されていてSubscribe済みの場合は、ブローカーにSubscriptionが残っているため送信しない
+    if ((gxMQTTCommunicationContext.bSessionPresent == true) &&
+        (bprvIsRetainedSubscription(pxSubscribeInfo, xIncomingCallback, pxIncomingCallbackContext) == true))
+    {
+        APP_PRINTFDebug("MQTT subscription restored from session. TOPIC: %.*s", pxSubscribeInfo->topicFilterLength, pxSubscribeInfo->pTopicFilter);
+        return MQTT_OPERATION_TASK_RESULT_SUCCESS;
+    }
+
+    // CallbackContextを初期化
+
+    // MQTT Agentに対してSubscribe
+    memset(pxContextBuffer, 0x00, sizeof(StaticMQTTUnsubscribeCommandBuffer_t));
+    MQTTAgentCommandContext_t *pxAgentContext = &(pxContextBuffer->u.xSubscribe.xMQTTCommandContext);
+    MQTTCommandDoneArgs_t *pxMQTTCommandDone = &(pxContextBuffer->u.xSubscribe.xMQTTCommandDoneArgs);
     MQTTAgentCommandInfo_t *pxMQTTAgentCommandInfo = &(pxContextBuffer->u.xSubscribe.xMQTTCommandInfo);
     MQTTAgentSubscribeArgs_t *pxSubscribeArgs = &(pxContextBuffer->u.xSubscribe.xSubscribeArgs);
 
@@ -461,6 +1420,8 @@ MQTTOperationTaskResult_t eMQTTSubscribe(const MQTTSubscribeInfo_t *pxSubscribeI
     // Subscribe Commandが完了した際に呼ばれるコールバックの引数を格納
     pxAgentContext->pxArgs = pxMQTTCommandDone;
     pxAgentContext->xNotifyTaskHandle = xTaskGetCurrentTaskHandle();
+    pxAgentContext->ePriority = eprvGetCurrentTaskCommandPriority();
+    pxAgentContext->xEnqueueTick = xTaskGetTickCount();
 
     // Subscribe Commandが完了した際に呼ばれるコールバックを登録
     pxMQTTAgentCommandInfo->cmdCompleteCallback = &vprvMQTTSubscribeCommandDoneCallback;
@@ -525,6 +1486,8 @@ MQTTOperationTaskResult_t eMQTTUnsubscribe(const MQTTSubscribeInfo_t *pxSubscrib
     // Unsubscribe Commandが完了した際に呼ばれるコールバックの引数を格納
     pxAgentContext->pxArgs = pxMQTTCommandDone;
     pxAgentContext->xNotifyTaskHandle = xTaskGetCurrentTaskHandle();
+    pxAgentContext->ePriority = eprvGetCurrentTaskCommandPriority();
+    pxAgentContext->xEnqueueTick = xTaskGetTickCount();
 
     // Subscribe Commandが完了した際に呼ばれるコールバックを登録
     pxMQTTAgentCommandInfo->cmdCompleteCallback = &vprvMQTTUnsubscribeCommandDoneCallback;
@@ -567,6 +1530,27 @@ MQTTOperationTaskResult_t eMQTTDisconnectAndTaskShutdown(void)
         return MQTT_OPERATION_TASK_RESULT_SUCCESS;
     }
 
+    // 再接続中のMQTT TaskはCommandを処理できないため、Terminateの代わりに再接続の中断を要求する
+    // MQTT Taskが再接続を完了する処理と競合しないよう、状態の確認と更新を同時に行う
+    bool bIsConnected = false;
+    taskENTER_CRITICAL();
+    if (gxConnectionState == MQTT_CONNECTION_STATE_CONNECTED)
+    {
+        bIsConnected = true;
+    }
+    else
+    {
+        gxConnectionState = MQTT_CONNECTION_STATE_SHUTDOWN_REQUESTED;
+    }
+    taskEXIT_CRITICAL();
+
+    if (bIsConnected == false)
+    {
+        APP_PRINTFInfo("MQTT is reconnecting. Request to abort reconnection.");
+        xEventGroupSetBits(gxMQTTConnectionEventGroup, MQTT_CONNECTION_EVENT_BIT_SHUTDOWN_REQUEST);
+        return eprvWaitMQTTTaskDeleted(MQTT_RECONNECT_ABORT_WAIT_TIME_MS);
+    }
+
     static MQTTAgentCommandContext_t xDisconnectDoneCallbackContext; // 他のタスクに渡すコンテキストになるため、static領域に生成する
 
     // MQTT Agentに渡すパラメータを格納
@@ -600,8 +1584,136 @@ MQTTOperationTaskResult_t eMQTTDisconnectAndTaskShutdown(void)
     }
 
     // MQTT Taskが終了するまで待機
+    return eprvWaitMQTTTaskDeleted(MQTT_CONNECT_TIMEOUT_MS);
+}
+
+MQTTOperationTaskResult_t eMQTTRegisterStreamReceive(const char *pcTopicFilter,
+                                                     const uint16_t usTopicFilterLength,
+                                                     const size_t uxMinPayloadLength,
+                                                     const MQTTStreamChunkCallback_t xCallback,
+                                                     void *pvContext)
+{
+#if (MQTT_STREAM_RECEIVE_ENABLE == 1)
+    if ((pcTopicFilter == NULL) || (xCallback == NULL))
+    {
+        APP_PRINTFError("Invalid stream receive parameter.");
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+
+    if (bMQTTStreamReceiveRegister(pcTopicFilter, usTopicFilterLength, uxMinPayloadLength, xCallback, pvContext) == false)
+    {
+        APP_PRINTFError("Failed to register stream receive. topic: %.*s", usTopicFilterLength, pcTopicFilter);
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+
+    APP_PRINTFDebug("Registered stream receive. topic: %.*s", usTopicFilterLength, pcTopicFilter);
+    return MQTT_OPERATION_TASK_RESULT_SUCCESS;
+#else
+    (void)pcTopicFilter;
+    (void)usTopicFilterLength;
+    (void)uxMinPayloadLength;
+    (void)xCallback;
+    (void)pvContext;
+    return MQTT_OPERATION_TASK_RESULT_FAILED;
+#endif
+}
+
+void vMQTTUnregisterStreamReceive(const char *pcTopicFilter, const uint16_t usTopicFilterLength)
+{
+#if (MQTT_STREAM_RECEIVE_ENABLE == 1)
+    vMQTTStreamReceiveUnregister(pcTopicFilter, usTopicFilterLength);
+#else
+    (void)pcTopicFilter;
+    (void)usTopicFilterLength;
+#endif
+}
+
+bool bMQTTIsSessionPresent(void)
+{
+    return gxMQTTCommunicationContext.bSessionPresent;
+}
+
+void vMQTTGetLastConnectTiming(MQTTConnectTiming_t *pxTiming)
+{
+    taskENTER_CRITICAL();
+    *pxTiming = gxLastConnectTiming;
+    taskEXIT_CRITICAL();
+}
+
+void vMQTTPrintMetrics(void)
+{
+#if (MQTT_METRICS_ENABLE == 1)
+    vMQTTMetricsPrint();
+#else
+    APP_PRINTFInfo("MQTT metrics is disabled.");
+#endif
+}
+
+EventGroupHandle_t xMQTTGetConnectionEventGroup(void)
+{
+    return gxMQTTConnectionEventGroup;
+}
+
+bool bMQTTWaitForConnection(const uint32_t uxTimeoutMs)
+{
+    if (gxMQTTConnectionEventGroup == NULL)
+    {
+        return false;
+    }
+
+    EventBits_t xBits = xEventGroupWaitBits(gxMQTTConnectionEventGroup,
+                                            MQTT_CONNECTION_EVENT_BIT_CONNECTED,
+                                            pdFALSE,
+                                            pdTRUE,
+                                            pdMS_TO_TICKS(uxTimeoutMs));
+
+    return ((xBits & MQTT_CONNECTION_EVENT_BIT_CONNECTED) != 0) ? true : false;
+}
+
+MQTTOperationTaskResult_t eMQTTRegisterBulkTask(const TaskHandle_t xTaskHandle)
+{
+    MQTTOperationTaskResult_t eResult = MQTT_OPERATION_TASK_RESULT_FAILED;
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < MQTT_BULK_TASK_MAX_NUM; i++)
+    {
+        if ((gxBulkTaskHandleList[i] == NULL) || (gxBulkTaskHandleList[i] == xTaskHandle))
+        {
+            gxBulkTaskHandleList[i] = xTaskHandle;
+            eResult = MQTT_OPERATION_TASK_RESULT_SUCCESS;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if (eResult != MQTT_OPERATION_TASK_RESULT_SUCCESS)
+    {
+        APP_PRINTFError("Bulk task list is full.");
+    }
+    return eResult;
+}
+
+void vMQTTUnregisterBulkTask(const TaskHandle_t xTaskHandle)
+{
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < MQTT_BULK_TASK_MAX_NUM; i++)
+    {
+        if (gxBulkTaskHandleList[i] == xTaskHandle)
+        {
+            gxBulkTaskHandleList[i] = NULL;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+// --------------------------------------------------
+// static関数定義
+// --------------------------------------------------
+
+static MQTTOperationTaskResult_t eprvWaitMQTTTaskDeleted(const uint32_t uxTimeoutMs)
+{
     const uint32_t xWaitTimeOneLoopMS = 500U;
-    const uint32_t xWaitingMaxCount = (uint32_t)(MQTT_CONNECT_TIMEOUT_MS / xWaitTimeOneLoopMS);
+    const uint32_t xWaitingMaxCount = (uint32_t)(uxTimeoutMs / xWaitTimeOneLoopMS);
     uint32_t xWaitingCount;
     for (xWaitingCount = 0; xWaitingCount < xWaitingMaxCount; xWaitingCount++)
     {
@@ -623,10 +1735,6 @@ MQTTOperationTaskResult_t eMQTTDisconnectAndTaskShutdown(void)
     return MQTT_OPERATION_TASK_RESULT_SUCCESS;
 }
 
-// --------------------------------------------------
-// static関数定義
-// --------------------------------------------------
-
 static bool bprvSocketConnectWithRetry(NetworkContext_t *pNetworkContext,
                                        const ServerInfo_t *pServerInfo,
                                        const SocketsConfig_t *pSocketsConfig,
@@ -640,12 +1748,15 @@ static bool bprvSocketConnectWithRetry(NetworkContext_t *pNetworkContext,
     for (uint32_t uxRetryCount = 0; uxRetryCount < uxMaxRetry; uxRetryCount++)
     {
         // ソケット接続
-        xTransportResult = SecureSocketsTransport_Connect(pNetworkContext,
-                                                          pServerInfo,
-                                                          pSocketsConfig);
+        xTransportResult = gpxTransport->xConnect(pNetworkContext,
+                                                  pServerInfo,
+                                                  pSocketsConfig);
 
         if (xTransportResult == TRANSPORT_SOCKET_STATUS_SUCCESS)
         {
+#if (MQTT_STREAM_RECEIVE_ENABLE == 1)
+            vMQTTStreamReceiveReset();
+#endif
             APP_PRINTFDebug("Socket connection established");
             return true;
         }
@@ -689,10 +1800,10 @@ static uint32_t prvGetTimeMs(void)
 
 static bool bprvSocketDisconnect(const NetworkContext_t *pxNetworkContext)
 {
-    APP_PRINTFDebug("Disconnecting TLS connection.");
+    APP_PRINTFDebug("Disconnecting %s connection.", gpxTransport->pcName);
 
     // ネットワークレイヤの切断
-    TransportSocketStatus_t xNetworkStatus = SecureSocketsTransport_Disconnect(pxNetworkContext);
+    TransportSocketStatus_t xNetworkStatus = gpxTransport->xDisconnect(pxNetworkContext);
 
     return (xNetworkStatus == TRANSPORT_SOCKET_STATUS_SUCCESS) ? true : false;
 }
@@ -752,8 +1863,372 @@ static bool bprvGetMQTTInfoFromFlash(const MQTTThingNameType eThingNameType, uin
     return true;
 }
 
+static const char *pcprvAddRetainedSubscription(const MQTTSubscribeInfo_t *pxSubscribeInfo,
+                                                IncomingPubCallback_t xIncomingCallback,
+                                                void *pvIncomingCallbackContext)
+{
+    MQTTRetainedSubscription_t *pxEmpty = NULL;
+    const char *pcTopicFilter = NULL;
+    bool bIsExist = false;
+
+    if (pxSubscribeInfo->topicFilterLength >= MQTT_SUBSCRIBE_TOPIC_MAX_LENGTH)
+    {
+        APP_PRINTFError("Topic filter is too long to retain. TOPIC: %.*s", pxSubscribeInfo->topicFilterLength, pxSubscribeInfo->pTopicFilter);
+        return NULL;
+    }
+
+    xSemaphoreTake(gxRetainedSubscriptionMutex, portMAX_DELAY);
+    for (uint32_t i = 0; i < MQTT_MAX_SUBSCRIBE_NUM; i++)
+    {
+        MQTTRetainedSubscription_t *pxEntry = &gxRetainedSubscriptionList[i];
+        if (pxEntry->xSubscribeInfo.topicFilterLength == 0)
+        {
+            pxEmpty = (pxEmpty == NULL) ? pxEntry : pxEmpty;
+        }
+        else if ((pxEntry->xSubscribeInfo.topicFilterLength == pxSubscribeInfo->topicFilterLength) &&
+                 (strncmp(pxEntry->xSubscribeInfo.pTopicFilter, pxSubscribeInfo->pTopicFilter, pxSubscribeInfo->topicFilterLength) == 0) &&
+                 (pxEntry->xIncomingCallback == xIncomingCallback) &&
+                 (pxEntry->pvIncomingCallbackContext == pvIncomingCallbackContext))
+        {
+            bIsExist = true;
+            pcTopicFilter = pxEntry->cTopicFilter;
+            break;
+        }
+    }
+
+    if ((bIsExist == false) && (pxEmpty != NULL))
+    {
+        memset(pxEmpty->cTopicFilter, 0x00, sizeof(pxEmpty->cTopicFilter));
+        memcpy(pxEmpty->cTopicFilter, pxSubscribeInfo->pTopicFilter, pxSubscribeInfo->topicFilterLength);
+        pxEmpty->xSubscribeInfo = *pxSubscribeInfo;
+        pxEmpty->xSubscribeInfo.pTopicFilter = pxEmpty->cTopicFilter;
+        pxEmpty->xIncomingCallback = xIncomingCallback;
+        pxEmpty->pvIncomingCallbackContext = pvIncomingCallbackContext;
+        pcTopicFilter = pxEmpty->cTopicFilter;
+    }
+    xSemaphoreGive(gxRetainedSubscriptionMutex);
+
+    if (pcTopicFilter == NULL)
+    {
+        APP_PRINTFError("Retained subscription list is full. TOPIC: %.*s", pxSubscribeInfo->topicFilterLength, pxSubscribeInfo->pTopicFilter);
+    }
+
+    return pcTopicFilter;
+}
+
+static void vprvRemoveRetainedSubscription(const char *pcTopicFilter, const uint16_t uxTopicFilterLength)
+{
+    xSemaphoreTake(gxRetainedSubscriptionMutex, portMAX_DELAY);
+    for (uint32_t i = 0; i < MQTT_MAX_SUBSCRIBE_NUM; i++)
+    {
+        MQTTRetainedSubscription_t *pxEntry = &gxRetainedSubscriptionList[i];
+        if ((pxEntry->xSubscribeInfo.topicFilterLength == uxTopicFilterLength) &&
+            (strncmp(pxEntry->xSubscribeInfo.pTopicFilter, pcTopicFilter, uxTopicFilterLength) == 0))
+        {
+            memset(pxEntry, 0x00, sizeof(MQTTRetainedSubscription_t));
+        }
+    }
+    xSemaphoreGive(gxRetainedSubscriptionMutex);
+}
+
+static bool bprvIsRetainedSubscription(const MQTTSubscribeInfo_t *pxSubscribeInfo,
+                                       IncomingPubCallback_t xIncomingCallback,
+                                       const void *pvIncomingCallbackContext)
+{
+    bool bIsExist = false;
+
+    xSemaphoreTake(gxRetainedSubscriptionMutex, portMAX_DELAY);
+    for (uint32_t i = 0; i < MQTT_MAX_SUBSCRIBE_NUM; i++)
+    {
+        const MQTTRetainedSubscription_t *pxEntry = &gxRetainedSubscriptionList[i];
+        if ((pxEntry->xSubscribeInfo.topicFilterLength == pxSubscribeInfo->topicFilterLength) &&
+            (strncmp(pxEntry->xSubscribeInfo.pTopicFilter, pxSubscribeInfo->pTopicFilter, pxSubscribeInfo->topicFilterLength) == 0) &&
+            (pxEntry->xIncomingCallback == xIncomingCallback) &&
+            (pxEntry->pvIncomingCallbackContext == pvIncomingCallbackContext))
+        {
+            bIsExist = true;
+            break;
+        }
+    }
+    xSemaphoreGive(gxRetainedSubscriptionMutex);
+
+    return bIsExist;
+}
+
+static void vprvRestoreSubscriptionRouting(const bool bDiscardRetainedSubscriptions)
+{
+    xSemaphoreTake(gxRetainedSubscriptionMutex, portMAX_DELAY);
+
+    SubscriptionManager_Init(&gxSubscriptionManager);
+
+    if (bDiscardRetainedSubscriptions == true)
+    {
+        memset(gxRetainedSubscriptionList, 0x00, sizeof(gxRetainedSubscriptionList));
+    }
+
+    for (uint32_t i = 0; i < MQTT_MAX_SUBSCRIBE_NUM; i++)
+    {
+        const MQTTRetainedSubscription_t *pxEntry = &gxRetainedSubscriptionList[i];
+        if (pxEntry->xSubscribeInfo.topicFilterLength == 0)
+        {
+            continue;
+        }
+
+        if (SubscriptionManager_AddSubscription(&gxSubscriptionManager,
+                                                pxEntry->xSubscribeInfo.pTopicFilter,
+                                                pxEntry->xSubscribeInfo.topicFilterLength,
+                                                pxEntry->xIncomingCallback,
+                                                pxEntry->pvIncomingCallbackContext) == false)
+        {
+            APP_PRINTFError("Failed to restore subscription. TOPIC: %.*s", pxEntry->xSubscribeInfo.topicFilterLength, pxEntry->xSubscribeInfo.pTopicFilter);
+        }
+    }
+
+    xSemaphoreGive(gxRetainedSubscriptionMutex);
+}
+
+static bool bprvReconnectWithBackoff(const MQTTTaskParameters_t *pxContext)
+{
+    uint32_t uxAttempt = 0;
+    bool bSessionPresent = false;
+    bool bIsShutdownRequested = false;
+
+    while (true)
+    {
+        // 再接続まで待機する。待機中にシャットダウンが要求された場合は中断する
+        const uint32_t uxDelayMs = uxprvGetBackoffDelayMs(uxAttempt);
+        APP_PRINTFInfo("MQTT reconnect attempt %u after %u ms.", uxAttempt + 1, uxDelayMs);
+        (void)xEventGroupWaitBits(gxMQTTConnectionEventGroup,
+                                  MQTT_CONNECTION_EVENT_BIT_SHUTDOWN_REQUEST,
+                                  pdTRUE,
+                                  pdFALSE,
+                                  pdMS_TO_TICKS(uxDelayMs));
+        if (gxConnectionState == MQTT_CONNECTION_STATE_SHUTDOWN_REQUESTED)
+        {
+            return false;
+        }
+        uxAttempt++;
+#if (MQTT_METRICS_ENABLE == 1)
+        vMQTTMetricsRecordReconnectAttempt();
+#endif
+
+        // ----- TLS socket connect ----
+        MQTTConnectTiming_t xTiming = {.bIsReconnect = true};
+        uint32_t uxPhaseStartMs = prvGetTimeMs();
+        if (gpxTransport->xConnect(pxContext->pxNetworkContext,
+                                   &gxMQTTCommunicationContext.xServerInfo,
+                                   &gxMQTTCommunicationContext.xSocketsConfig) != TRANSPORT_SOCKET_STATUS_SUCCESS)
+        {
+            APP_PRINTFWarn("MQTT reconnect failed. Socket connect error.");
+            continue;
+        }
+#if (MQTT_STREAM_RECEIVE_ENABLE == 1)
+        // 切断前に受信途中だったパケットの状態を破棄
+        vMQTTStreamReceiveReset();
+#endif
+        xTiming.uxSocketConnectMs = prvGetTimeMs() - uxPhaseStartMs;
+
+        // ----- MQTT connect ----
+        bSessionPresent = false;
+        uxPhaseStartMs = prvGetTimeMs();
+        MQTTStatus_t xMQTTStatus = MQTT_Connect((MQTTContext_t *)pxContext->pxMqttAgentContext,
+                                                (const MQTTConnectInfo_t *)(&(gxMQTTCommunicationContext.xMQTTConnectInfo)),
+                                                NULL,
+                                                MQTT_CONNECT_TIMEOUT_MS,
+                                                &bSessionPresent);
+        if (xMQTTStatus != MQTTSuccess)
+        {
+            APP_PRINTFWarn("MQTT reconnect failed. MQTT connect error: %d", xMQTTStatus);
+            (void)bprvSocketDisconnect(pxContext->pxNetworkContext);
+            continue;
+        }
+        gxMQTTCommunicationContext.bSessionPresent = bSessionPresent;
+        xTiming.uxMQTTConnectMs = prvGetTimeMs() - uxPhaseStartMs;
+
+        // ----- Session restore ----
+        // 各タスクのSubscriptionは維持したまま再接続するため、一覧は破棄せずに振り分けを復元する
+        uxPhaseStartMs = prvGetTimeMs();
+        vprvRestoreSubscriptionRouting(false);
+        xMQTTStatus = MQTTAgent_ResumeSession(pxContext->pxMqttAgentContext, bSessionPresent);
+        if ((xMQTTStatus != MQTTSuccess) ||
+            ((bSessionPresent == false) && (bprvResubscribeRetainedSubscriptions(pxContext) == false)))
+        {
+            APP_PRINTFWarn("MQTT reconnect failed. Session restore error: %d", xMQTTStatus);
+            (void)MQTT_Disconnect((MQTTContext_t *)pxContext->pxMqttAgentContext);
+            (void)bprvSocketDisconnect(pxContext->pxNetworkContext);
+            continue;
+        }
+        xTiming.uxSessionRestoreMs = prvGetTimeMs() - uxPhaseStartMs;
+        vprvRecordConnectTiming(&xTiming);
+
+        // シャットダウン要求と競合しないよう、状態の確認と更新を同時に行う
+        taskENTER_CRITICAL();
+        bIsShutdownRequested = (gxConnectionState == MQTT_CONNECTION_STATE_SHUTDOWN_REQUESTED) ? true : false;
+        if (bIsShutdownRequested == false)
+        {
+            gxConnectionState = MQTT_CONNECTION_STATE_CONNECTED;
+        }
+        taskEXIT_CRITICAL();
+
+        if (bIsShutdownRequested == true)
+        {
+            (void)MQTT_Disconnect((MQTTContext_t *)pxContext->pxMqttAgentContext);
+            (void)bprvSocketDisconnect(pxContext->pxNetworkContext);
+            return false;
+        }
+
+#if (MQTT_METRICS_ENABLE == 1)
+        vMQTTMetricsRecordReconnectSuccess();
+#endif
+
+        // 依存するタスクに再接続を通知
+        xEventGroupSetBits(gxMQTTConnectionEventGroup, MQTT_CONNECTION_EVENT_BIT_CONNECTED | MQTT_CONNECTION_EVENT_BIT_RECONNECTED);
+        APP_PRINTFInfo("MQTT reconnected. Session present: %d", bSessionPresent);
+        return true;
+    }
+}
+
+static uint32_t uxprvGetBackoffDelayMs(const uint32_t uxAttempt)
+{
+    // 再接続に失敗するたびに上限を2倍にする
+    uint32_t uxCeilingMs = MQTT_RECONNECT_BACKOFF_BASE_MS;
+    for (uint32_t i = 0; (i < uxAttempt) && (uxCeilingMs < MQTT_RECONNECT_BACKOFF_MAX_MS); i++)
+    {
+        uxCeilingMs *= 2U;
+    }
+    if (uxCeilingMs > MQTT_RECONNECT_BACKOFF_MAX_MS)
+    {
+        uxCeilingMs = MQTT_RECONNECT_BACKOFF_MAX_MS;
+    }
+
+    // Full Jitter: 0から上限までの乱数時間待機する
+    uint32_t uxRandom = 0;
+    if (xGetRandomBytes((uint8_t *)&uxRandom, sizeof(uxRandom)) != sizeof(uxRandom))
+    {
+        // 乱数が取得できない場合は、デバイスごとに異なる起動からの経過時間で代用する
+        uxRandom = (uint32_t)xTaskGetTickCount();
+    }
+
+    return uxRandom % (uxCeilingMs + 1U);
+}
+
+static bool bprvResubscribeRetainedSubscriptions(const MQTTTaskParameters_t *pxContext)
+{
+    MQTTResubscribeCommand_t *pxCommand = &gxResubscribeCommand;
+
+    // 前回の接続で処理されなかったコマンドが残っている場合は、そのコマンドが同じ一覧をSubscribeする
+    if (pxCommand->bIsPending == true)
+    {
+        APP_PRINTFDebug("MQTT resubscribe command is already pending.");
+        return true;
+    }
+
+    memset(pxCommand, 0x00, sizeof(MQTTResubscribeCommand_t));
+    size_t uxSubscribeNum = 0;
+
+    // 同じトピックに複数のコールバックが登録されている場合があるため、重複を除いてまとめる
+    // コマンドの完了までに一覧が更新されても影響しないよう、トピックはコピーする
+    xSemaphoreTake(gxRetainedSubscriptionMutex, portMAX_DELAY);
+    for (uint32_t i = 0; i < MQTT_MAX_SUBSCRIBE_NUM; i++)
+    {
+        const MQTTSubscribeInfo_t *pxEntry = &gxRetainedSubscriptionList[i].xSubscribeInfo;
+        bool bIsDuplicated = false;
+        if (pxEntry->topicFilterLength == 0)
+        {
+            continue;
+        }
+
+        for (size_t j = 0; j < uxSubscribeNum; j++)
+        {
+            if ((pxCommand->xSubscribeInfoList[j].topicFilterLength == pxEntry->topicFilterLength) &&
+                (strncmp(pxCommand->xSubscribeInfoList[j].pTopicFilter, pxEntry->pTopicFilter, pxEntry->topicFilterLength) == 0))
+            {
+                bIsDuplicated = true;
+                break;
+            }
+        }
+
+        if (bIsDuplicated == false)
+        {
+            memcpy(pxCommand->cTopicFilterList[uxSubscribeNum], pxEntry->pTopicFilter, pxEntry->topicFilterLength);
+            pxCommand->xSubscribeInfoList[uxSubscribeNum] = *pxEntry;
+            pxCommand->xSubscribeInfoList[uxSubscribeNum].pTopicFilter = pxCommand->cTopicFilterList[uxSubscribeNum];
+            uxSubscribeNum++;
+        }
+    }
+    xSemaphoreGive(gxRetainedSubscriptionMutex);
+
+    if (uxSubscribeNum == 0)
+    {
+        return true;
+    }
+
+    pxCommand->xSubscribeArgs.pSubscribeInfo = pxCommand->xSubscribeInfoList;
+    pxCommand->xSubscribeArgs.numSubscriptions = uxSubscribeNum;
+
+    // 再接続直後に他のコマンドより先に処理されるよう、対話系の優先度で渡す
+    pxCommand->xCommandContext.ePriority = MQTT_COMMAND_PRIORITY_INTERACTIVE;
+    pxCommand->xCommandInfo.cmdCompleteCallback = &vprvResubscribeCommandDoneCallback;
+    pxCommand->xCommandInfo.pCmdCompleteCallbackContext = &pxCommand->xCommandContext;
+
+    // MQTT Task自身がコマンドを処理するため、キューが空くのを待たない
+    pxCommand->xCommandInfo.blockTimeMs = 0;
+
+    // CommandLoopに戻った後にSUBSCRIBEを送信し、SUBACKはコマンドの完了として受け取る
+    pxCommand->bIsPending = true;
+    MQTTStatus_t xMQTTStatus = MQTTAgent_Subscribe(pxContext->pxMqttAgentContext,
+                                                   &pxCommand->xSubscribeArgs,
+                                                   &pxCommand->xCommandInfo);
+    if (xMQTTStatus != MQTTSuccess)
+    {
+        pxCommand->bIsPending = false;
+        APP_PRINTFError("MQTT resubscribe failed. Reason: %d", xMQTTStatus);
+        return false;
+    }
+
+    APP_PRINTFInfo("MQTT resubscribe command queued. %u topics.", uxSubscribeNum);
+    return true;
+}
+
 // --------------- CALLBACKS ----------------
 
+static void vprvResubscribeCommandDoneCallback(MQTTAgentCommandContext_t *pCmdCallbackContext, MQTTAgentReturnInfo_t *pReturnInfo)
+{
+    (void)pCmdCallbackContext; // このパラメータは使用しない
+
+    MQTTResubscribeCommand_t *pxCommand = &gxResubscribeCommand;
+    pxCommand->bIsPending = false;
+
+    if (pReturnInfo->returnCode != MQTTSuccess)
+    {
+        APP_PRINTFError("MQTT resubscribe failed. Reason: %d", pReturnInfo->returnCode);
+
+        // 再接続中にコマンドが破棄された場合は、再接続処理が改めてSubscribeする
+        // 接続中の場合は、ブローカーにSubscriptionが無いまま動作しないよう切断してCommandLoopを終了させる
+        if (gxConnectionState == MQTT_CONNECTION_STATE_CONNECTED)
+        {
+            (void)MQTT_Disconnect(&(gxMQTTCommunicationContext.xMqttAgentContext.mqttContext));
+        }
+        return;
+    }
+
+    // ブローカーに拒否されたトピックは、再接続しても受信できないため振り分けを削除する
+    for (size_t i = 0; i < pxCommand->xSubscribeArgs.numSubscriptions; i++)
+    {
+        const MQTTSubscribeInfo_t *pxSubscribeInfo = &pxCommand->xSubscribeInfoList[i];
+        if ((pReturnInfo->pSubackCodes != NULL) && (pReturnInfo->pSubackCodes[i] == (uint8_t)MQTTSubAckFailure))
+        {
+            APP_PRINTFError("MQTT resubscribe rejected by broker. TOPIC: %.*s", pxSubscribeInfo->topicFilterLength, pxSubscribeInfo->pTopicFilter);
+            SubscriptionManager_RemoveSubscription(&gxSubscriptionManager,
+                                                   pxSubscribeInfo->pTopicFilter,
+                                                   pxSubscribeInfo->topicFilterLength);
+            vprvRemoveRetainedSubscription(pxSubscribeInfo->pTopicFilter, pxSubscribeInfo->topicFilterLength);
+        }
+    }
+
+    APP_PRINTFInfo("MQTT resubscribed %u topics.", pxCommand->xSubscribeArgs.numSubscriptions);
+}
+
 static void vprvIncomingPublishCallback(MQTTAgentContext_t *pMqttAgentContext,
                                         uint16_t packetId,
                                         MQTTPublishInfo_t *pxPublishInfo)
@@ -762,8 +2237,16 @@ static void vprvIncomingPublishCallback(MQTTAgentContext_t *pMqttAgentContext,
 
     APP_PRINTFDebug("Incoming Publish Callback.");
 
+#if (MQTT_STREAM_RECEIVE_ENABLE == 1)
+    // ペイロードをストリーム受信で渡し終えたPublishは、通常のコールバック関数に渡さない
+    if (bMQTTStreamReceiveIsStreamedPublish(pxPublishInfo) == true)
+    {
+        return;
+    }
+#endif
+
     // SubscriptionListに登録されているトピックに一致するコールバックを呼び出す
-    const bool bCanCallback = SubscriptionManager_HandleIncomingPublishes((SubscriptionElement_t *)(pMqttAgentContext->pIncomingCallbackContext),
+    const bool bCanCallback = SubscriptionManager_HandleIncomingPublishes((SubscriptionManager_t *)(pMqttAgentContext->pIncomingCallbackContext),
                                                                           pxPublishInfo);
 
     // 登録されているコールバック関数が見つからなかった場合はエラーを表示する
@@ -777,6 +2260,14 @@ static void vprvIncomingPublishCallback(MQTTAgentContext_t *pMqttAgentContext,
 static void vprvMQTTCommandDoneCallback(MQTTAgentCommandContext_t *pCmdCallbackContext,
                                         MQTTAgentReturnInfo_t *pReturnInfo)
 {
+#if (MQTT_METRICS_ENABLE == 1)
+    // Disconnectのコマンドは完了までの時間を計測しないため、xEnqueueTickが0の場合は記録しない
+    if (pCmdCallbackContext->xEnqueueTick != 0)
+    {
+        vMQTTMetricsRecordCommandLatency(MQTT_METRICS_COMMAND_PUBLISH, pCmdCallbackContext->xEnqueueTick, (pReturnInfo->returnCode == MQTTSuccess) ? true : false);
+    }
+#endif
+
     if (pReturnInfo->returnCode != MQTTSuccess)
     {
         APP_PRINTFError("MQTTCommandDoneCallback Error. Reason %d", pReturnInfo->returnCode);
@@ -795,6 +2286,10 @@ static void vprvMQTTCommandDoneCallback(MQTTAgentCommandContext_t *pCmdCallbackC
 
 static void vprvMQTTSubscribeCommandDoneCallback(MQTTAgentCommandContext_t *pCmdCallbackContext, MQTTAgentReturnInfo_t *pReturnInfo)
 {
+#if (MQTT_METRICS_ENABLE == 1)
+    vMQTTMetricsRecordCommandLatency(MQTT_METRICS_COMMAND_SUBSCRIBE, pCmdCallbackContext->xEnqueueTick, (pReturnInfo->returnCode == MQTTSuccess) ? true : false);
+#endif
+
     if (pCmdCallbackContext->xNotifyTaskHandle == NULL)
     {
         APP_PRINTFWarn("Notify task handle is NULL");
@@ -810,22 +2305,32 @@ static void vprvMQTTSubscribeCommandDoneCallback(MQTTAgentCommandContext_t *pCmd
             return;
         }
 
-        // SubscriptionManagerに当該トピックとコールバック関数を登録する
         MQTTCommandDoneArgs_t *pxSubscribeArgs = (MQTTCommandDoneArgs_t *)pCmdCallbackContext->pxArgs;
-        APP_PRINTFDebug("Register with SubscriptionManager for topic %s.",
-                        pxSubscribeArgs->pxMQTTAgentSubscribeArgs->pSubscribeInfo->pTopicFilter);
-        bool bHaveAdded = SubscriptionManager_AddSubscription(&gxSubscribeElementList[0],
-                                                              pxSubscribeArgs->pxMQTTAgentSubscribeArgs->pSubscribeInfo->pTopicFilter,
-                                                              pxSubscribeArgs->pxMQTTAgentSubscribeArgs->pSubscribeInfo->topicFilterLength,
-                                                              pxSubscribeArgs->pxMQTTSubscribeIncomingPubCallback,
-                                                              pxSubscribeArgs->pxIncomingCallbackContext);
+        const MQTTSubscribeInfo_t *pxSubscribeInfo = pxSubscribeArgs->pxMQTTAgentSubscribeArgs->pSubscribeInfo;
+
+        // 再接続時に振り分けを復元できるよう、Subscribe済みトピック一覧にトピックをコピーして登録する
+        // SubscriptionManagerはトピックをコピーしないため、呼び出し元の領域ではなく一覧のコピーを登録する
+        const char *pcTopicFilter = pcprvAddRetainedSubscription(pxSubscribeInfo,
+                                                                 (IncomingPubCallback_t)pxSubscribeArgs->pxMQTTSubscribeIncomingPubCallback,
+                                                                 pxSubscribeArgs->pxIncomingCallbackContext);
 
         // Subscriptionリストへの追加失敗判定。1度にSubscribeできる上限に達した可能性がある。
         // 本エラーが発生した場合は MQTT_MAX_SUBSCRIBE_NUM を見直す必要がある
+        bool bHaveAdded = false;
+        if (pcTopicFilter != NULL)
+        {
+            APP_PRINTFDebug("Register with SubscriptionManager for topic %.*s.", pxSubscribeInfo->topicFilterLength, pcTopicFilter);
+            bHaveAdded = SubscriptionManager_AddSubscription(&gxSubscriptionManager,
+                                                             pcTopicFilter,
+                                                             pxSubscribeInfo->topicFilterLength,
+                                                             pxSubscribeArgs->pxMQTTSubscribeIncomingPubCallback,
+                                                             pxSubscribeArgs->pxIncomingCallbackContext);
+        }
+
         if (bHaveAdded == false)
         {
-            APP_PRINTFError("Failed to register an incoming publish callback for topic %s.",
-                            pxSubscribeArgs->pxMQTTAgentSubscribeArgs->pSubscribeInfo->pTopicFilter);
+            APP_PRINTFError("Failed to register an incoming publish callback for topic %.*s.",
+                            pxSubscribeInfo->topicFilterLength, pxSubscribeInfo->pTopicFilter);
         }
     }
 
@@ -835,6 +2340,10 @@ static void vprvMQTTSubscribeCommandDoneCallback(MQTTAgentCommandContext_t *pCmd
 
 static void vprvMQTTUnsubscribeCommandDoneCallback(MQTTAgentCommandContext_t *pCmdCallbackContext, MQTTAgentReturnInfo_t *pReturnInfo)
 {
+#if (MQTT_METRICS_ENABLE == 1)
+    vMQTTMetricsRecordCommandLatency(MQTT_METRICS_COMMAND_UNSUBSCRIBE, pCmdCallbackContext->xEnqueueTick, (pReturnInfo->returnCode == MQTTSuccess) ? true : false);
+#endif
+
     if (pCmdCallbackContext->xNotifyTaskHandle == NULL)
     {
         APP_PRINTFWarn("Notify task handle is NULL");
@@ -849,9 +2358,11 @@ static void vprvMQTTUnsubscribeCommandDoneCallback(MQTTAgentCommandContext_t *pC
         APP_PRINTFDebug("Remove with SubscriptionManager for topic %s.",
                         pxSubscribeArgs->pxMQTTAgentSubscribeArgs->pSubscribeInfo->pTopicFilter);
 
-        SubscriptionManager_RemoveSubscription(&gxSubscribeElementList[0],
+        SubscriptionManager_RemoveSubscription(&gxSubscriptionManager,
                                                pxSubscribeArgs->pxMQTTAgentSubscribeArgs->pSubscribeInfo->pTopicFilter,
                                                pxSubscribeArgs->pxMQTTAgentSubscribeArgs->pSubscribeInfo->topicFilterLength);
+        vprvRemoveRetainedSubscription(pxSubscribeArgs->pxMQTTAgentSubscribeArgs->pSubscribeInfo->pTopicFilter,
+                                       pxSubscribeArgs->pxMQTTAgentSubscribeArgs->pSubscribeInfo->topicFilterLength);
     }
 
     // タスクに通知
@@ -871,41 +2382,605 @@ static void vprvMQTTTask(void *pvParams)
 
     APP_PRINTFDebug("Context Memory 0x%p 0x%p", pxContext->pxMqttAgentContext, pxContext->pxNetworkContext);
 
-    do
+    while (true)
     {
-        // MQTT Agentのコマンドを処理する。この関数は、MQTTやその下位レイヤの接続が切れるまでMQTTコマンドを処理しし続け、返却されることはない。
+        // MQTT Agentのコマンドを処理する。この関数は、MQTTやその下位レイヤの接続が切れるか、Terminateされるまで返却されない。
         APP_PRINTFDebug("Start MQTT Command Loop");
         xMQTTStatus = MQTTAgent_CommandLoop(pxContext->pxMqttAgentContext);
 
-        if ((xMQTTStatus == MQTTSuccess) &&
-            (pxContext->pxMqttAgentContext->mqttContext.connectStatus == MQTTNotConnected))
+        if (xMQTTStatus == MQTTSuccess)
         {
-            // 既にMQTTレイヤはDisconnectされているため、ソケットレイヤを切断する
-            bSocketDisconnectResult = bprvSocketDisconnect(pxContext->pxNetworkContext);
+            // MQTTAgent_Terminateにより終了した
+            if (pxContext->pxMqttAgentContext->mqttContext.connectStatus == MQTTNotConnected)
+            {
+                // 既にMQTTレイヤはDisconnectされているため、ソケットレイヤを切断する
+                bSocketDisconnectResult = bprvSocketDisconnect(pxContext->pxNetworkContext);
+            }
+            else
+            {
+                // MQTTレイヤが切断されていないため、切断する
+                APP_PRINTFDebug("MQTT disconnect...");
+                xMQTTStatus = MQTT_Disconnect((MQTTContext_t *)pxContext->pxMqttAgentContext);
+                bSocketDisconnectResult = bprvSocketDisconnect(pxContext->pxNetworkContext);
+            }
+
+            if ((xMQTTStatus != MQTTSuccess) || (bSocketDisconnectResult == false))
+            {
+                APP_PRINTFError("MQTT task error. Reason: %d", xMQTTStatus);
+            }
+            break;
         }
-        else if (xMQTTStatus == MQTTSuccess)
+
+        // ソケットの切断やKeepAliveの失敗によりCommandLoopが終了したため、Wi-Fiは維持したまま再接続する
+        APP_PRINTFWarn("MQTT connection lost. Reason: %d", xMQTTStatus);
+        taskENTER_CRITICAL();
+        if (gxConnectionState == MQTT_CONNECTION_STATE_CONNECTED)
         {
-            // MQTTレイヤが切断されていないため、切断する
-            APP_PRINTFDebug("MQTT disconnect...");
-            xMQTTStatus = MQTT_Disconnect((MQTTContext_t *)pxContext->pxMqttAgentContext);
-            bSocketDisconnectResult = bprvSocketDisconnect(pxContext->pxNetworkContext);
+            gxConnectionState = MQTT_CONNECTION_STATE_RECONNECTING;
         }
+        taskEXIT_CRITICAL();
+        xEventGroupClearBits(gxMQTTConnectionEventGroup, MQTT_CONNECTION_EVENT_BIT_CONNECTED);
+        (void)bprvSocketDisconnect(pxContext->pxNetworkContext);
 
-        if ((xMQTTStatus != MQTTSuccess) || (bSocketDisconnectResult == false))
+        if (bprvReconnectWithBackoff(pxContext) == false)
         {
-            APP_PRINTFError("MQTT task error. Reason: %d", xMQTTStatus);
+            APP_PRINTFInfo("MQTT reconnection aborted by shutdown request.");
+            break;
         }
+    }
 
-    } while (false); // MQTTAgent_CommandLoop内部でループ処理が行われているためfalseで問題ない。
+    gxConnectionState = MQTT_CONNECTION_STATE_DISCONNECTED;
+    xEventGroupClearBits(gxMQTTConnectionEventGroup, MQTT_CONNECTION_EVENT_BIT_CONNECTED);
 
     APP_PRINTFDebug("MQTT task completed. Therefore, it is deleted.");
 
+#if (MQTT_AGENT_ENABLE_QUEUE_STATS == 1)
+    // 優先度ごとのコマンドキューの待ち時間を出力
+    vMQTTPriorityMessagePrintStats(&gxPriorityMessageContext);
+#endif
+
+#if (MQTT_DISPATCH_WORKER_ENABLE == 1)
+    // Dispatch Taskに渡したPublish数を出力
+    vMQTTDispatchWorkerPrintStats();
+#endif
+
+#if (MQTT_PUBLISH_RATE_LIMIT_ENABLE == 1)
+    // 送信レートの上限を超えたPublish数を出力
+    vprvPrintPublishRateLimitStats();
+#endif
+
+#if (MQTT_STREAM_RECEIVE_ENABLE == 1)
+    // ストリーム受信したPublish数とスループットを出力
+    vMQTTStreamReceivePrintStats();
+#endif
+
+#if (MQTT_METRICS_ENABLE == 1)
+    // 切断中はメトリクスをPublishしない
+    if (gxMetricsPublishTimer != NULL)
+    {
+        xTimerStop(gxMetricsPublishTimer, 0);
+    }
+    // コマンドごとの完了までの時間と送受信したバイト数を出力
+    vMQTTMetricsPrint();
+#endif
+
     PRINT_TASK_REMAINING_STACK_SIZE();
     // タスクハンドルを破棄
     gxMQTTTaskHandle = NULL;
     vTaskDelete(NULL);
 }
 
+static MQTTOperationTaskResult_t eprvPublishQoS0(const MQTTPublishInfo_t *pxPublishInfo, StaticMQTTCommandBuffer_t *pxContextBuffer)
+{
+    // MQTTPublishに必要なCallbackを登録
+    memset(pxContextBuffer, 0x00, sizeof(StaticMQTTCommandBuffer_t));
+    MQTTAgentCommandInfo_t *pxAgentCommandInfo = &(pxContextBuffer->u.xPublish.xMQTTAgentCommandInfo);
+    MQTTAgentCommandContext_t *pxCommandContext = &(pxContextBuffer->u.xPublish.xMQTTAgentCommand);
+    pxCommandContext->xNotifyTaskHandle = xTaskGetCurrentTaskHandle();
+    pxCommandContext->ePriority = eprvGetCurrentTaskCommandPriority();
+    pxCommandContext->xEnqueueTick = xTaskGetTickCount();
+
+    pxAgentCommandInfo->cmdCompleteCallback = &vprvMQTTCommandDoneCallback;
+    pxAgentCommandInfo->pCmdCompleteCallbackContext = pxCommandContext;
+    pxAgentCommandInfo->blockTimeMs = MQTT_TASK_COMMAND_ENQUEUE_TIMEOUT_MS;
+
+    // MQTT Agentに対してPublish
+    MQTTStatus_t xMQTTResult = MQTTAgent_Publish((const MQTTAgentContext_t *)(&(gxMQTTCommunicationContext.xMqttAgentContext)),
+                                                 (MQTTPublishInfo_t *)pxPublishInfo,
+                                                 (const MQTTAgentCommandInfo_t *)pxAgentCommandInfo);
+    if (xMQTTResult != MQTTSuccess)
+    {
+        APP_PRINTFError("MQTT publish error. Reason: %d", xMQTTResult);
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+
+    APP_PRINTFDebug("MQTT publish command send success. Waiting for publish done...");
+
+    // PublishのCallbackを待機
+    bool bIsSuccess = bprvWaitTaskNotify(MQTT_PUB_SUB_TIMEOUT_MS);
+
+    if (bIsSuccess == false)
+    {
+        APP_PRINTFError("MQTT publish timeout.");
+
+        // コンテキストをNULLにしておく
+        pxCommandContext->xNotifyTaskHandle = NULL;
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+
+    APP_PRINTFDebug("MQTT publish success. TOPIC: %s", pxPublishInfo->pTopicName);
+    return MQTT_OPERATION_TASK_RESULT_SUCCESS;
+}
+
+static MQTTOperationTaskResult_t eprvPublishQoS1(const MQTTPublishInfo_t *pxPublishInfo)
+{
+    if ((pxPublishInfo->topicNameLength > MQTT_QOS1_STORE_TOPIC_MAX_LENGTH) ||
+        (pxPublishInfo->payloadLength > MQTT_QOS1_STORE_PAYLOAD_MAX_LENGTH))
+    {
+        APP_PRINTFError("QoS1 publish exceeds store size. Topic length: %d, Payload length: %d",
+                        pxPublishInfo->topicNameLength,
+                        pxPublishInfo->payloadLength);
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+
+    const TickType_t xStartTick = xTaskGetTickCount();
+    const TickType_t xTimeoutTicks = pdMS_TO_TICKS(MQTT_PUB_SUB_TIMEOUT_MS);
+#if (MQTT_PUBLISH_RATE_LIMIT_ENABLE == 1)
+    const MQTTPublishClass_t ePublishClass = eprvGetPublishClass(pxPublishInfo->pTopicName, pxPublishInfo->topicNameLength);
+#endif
+
+    // 送信中のQoS1 Publish数がウィンドウの上限に達している場合は、空きが出るまで待機する
+    if (xSemaphoreTake(gxQoS1InflightSemaphore, xTimeoutTicks) != pdTRUE)
+    {
+        APP_PRINTFError("QoS1 in-flight window is full.");
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+
+    MQTTOutgoingPublish_t *pxOutgoing = xprvAcquireOutgoingPublish();
+    if (pxOutgoing == NULL)
+    {
+        // セマフォの数と送信ストアの数は一致するため、ここには来ない
+        APP_PRINTFError("QoS1 outgoing store is empty.");
+        xSemaphoreGive(gxQoS1InflightSemaphore);
+        return MQTT_OPERATION_TASK_RESULT_FAILED;
+    }
+
+    // 再送に備え、トピックとペイロードを送信ストアにコピーする
+    memcpy(pxOutgoing->ucTopic, pxPublishInfo->pTopicName, pxPublishInfo->topicNameLength);
+    memcpy(pxOutgoing->ucPayload, pxPublishInfo->pPayload, pxPublishInfo->payloadLength);
+    pxOutgoing->xPublishInfo = *pxPublishInfo;
+    pxOutgoing->xPublishInfo.pTopicName = (const char *)pxOutgoing->ucTopic;
+    pxOutgoing->xPublishInfo.pPayload = pxOutgoing->ucPayload;
+    pxOutgoing->xPublishInfo.dup = false;
+
+    memset(&pxOutgoing->xCommandContext, 0x00, sizeof(pxOutgoing->xCommandContext));
+    pxOutgoing->xCommandContext.pxArgs = pxOutgoing;
+    pxOutgoing->xCommandContext.ePriority = eprvGetCurrentTaskCommandPriority();
+    pxOutgoing->xCommandInfo.cmdCompleteCallback = &vprvMQTTQoS1PublishDoneCallback;
+    pxOutgoing->xCommandInfo.pCmdCompleteCallbackContext = &pxOutgoing->xCommandContext;
+    pxOutgoing->xCommandInfo.blockTimeMs = MQTT_TASK_COMMAND_ENQUEUE_TIMEOUT_MS;
+
+    MQTTOperationTaskResult_t eResult = MQTT_OPERATION_TASK_RESULT_FAILED;
+    while (true)
+    {
+        TickType_t xElapsedTicks = xTaskGetTickCount() - xStartTick;
+        if (xElapsedTicks >= xTimeoutTicks)
+        {
+            APP_PRINTFError("MQTT QoS1 publish timeout.");
+            break;
+        }
+
+#if (MQTT_PUBLISH_RATE_LIMIT_ENABLE == 1)
+        // 再接続後の再送も含め、送信レートの上限を超えている場合はトークンが補充されるまで待機する
+        vprvWaitForPublishToken(ePublishClass);
+#endif
+
+        taskENTER_CRITICAL();
+        pxOutgoing->eState = MQTT_OUTGOING_PUBLISH_STATE_PENDING;
+        taskEXIT_CRITICAL();
+        xEventGroupClearBits(gxOutgoingPublishEventGroup, pxOutgoing->xDoneEventBit);
+        pxOutgoing->xCommandContext.xEnqueueTick = xTaskGetTickCount();
+
+        // MQTT Agentに対してPublish
+        MQTTStatus_t xMQTTResult = MQTTAgent_Publish((const MQTTAgentContext_t *)(&(gxMQTTCommunicationContext.xMqttAgentContext)),
+                                                     &pxOutgoing->xPublishInfo,
+                                                     (const MQTTAgentCommandInfo_t *)&pxOutgoing->xCommandInfo);
+        if (xMQTTResult != MQTTSuccess)
+        {
+            // MQTT Taskにコマンドが渡っていないため、呼び出し元で送信ストアを解放できる
+            APP_PRINTFError("MQTT QoS1 publish error. Reason: %d", xMQTTResult);
+            break;
+        }
+
+        APP_PRINTFDebug("MQTT QoS1 publish command send success. Waiting for PUBACK...");
+
+        // PUBACKを受信するか、MQTT Agentがコマンドを破棄するまで待機
+        xEventGroupWaitBits(gxOutgoingPublishEventGroup,
+                            pxOutgoing->xDoneEventBit,
+                            pdTRUE,
+                            pdTRUE,
+                            xTimeoutTicks - xElapsedTicks);
+
+        bool bAbandoned = false;
+        taskENTER_CRITICAL();
+        if (pxOutgoing->eState == MQTT_OUTGOING_PUBLISH_STATE_PENDING)
+        {
+            // MQTT Agentがまだ送信ストアを参照しているため、解放はMQTT Taskに任せる
+            pxOutgoing->eState = MQTT_OUTGOING_PUBLISH_STATE_ABANDONED;
+            bAbandoned = true;
+        }
+        taskEXIT_CRITICAL();
+
+        if (bAbandoned == true)
+        {
+            APP_PRINTFError("MQTT QoS1 publish timeout. PUBACK was not received.");
+            return MQTT_OPERATION_TASK_RESULT_FAILED;
+        }
+
+        if (pxOutgoing->eState == MQTT_OUTGOING_PUBLISH_STATE_ACKED)
+        {
+            APP_PRINTFDebug("MQTT QoS1 publish success. TOPIC: %s", pxPublishInfo->pTopicName);
+            eResult = MQTT_OPERATION_TASK_RESULT_SUCCESS;
+            break;
+        }
+
+        // シャットダウンによりコマンドが破棄された場合は再送しない
+        if ((gxConnectionState == MQTT_CONNECTION_STATE_DISCONNECTED) ||
+            (gxConnectionState == MQTT_CONNECTION_STATE_SHUTDOWN_REQUESTED))
+        {
+            APP_PRINTFError("MQTT QoS1 publish aborted by disconnection.");
+            break;
+        }
+
+        // 通信断によりコマンドが破棄されたため、再接続を待ってから送信ストアの内容を再送する
+        APP_PRINTFWarn("MQTT QoS1 publish was not acknowledged. Retry after reconnection.");
+        xElapsedTicks = xTaskGetTickCount() - xStartTick;
+        if ((xElapsedTicks >= xTimeoutTicks) ||
+            (bMQTTWaitForConnection((uint32_t)((xTimeoutTicks - xElapsedTicks) * portTICK_PERIOD_MS)) == false))
+        {
+            APP_PRINTFError("MQTT QoS1 publish timeout. Connection was not recovered.");
+            break;
+        }
+    }
+
+    vprvReleaseOutgoingPublish(pxOutgoing);
+    return eResult;
+}
+
+static void vprvRecordConnectTiming(const MQTTConnectTiming_t *pxTiming)
+{
+    taskENTER_CRITICAL();
+    gxLastConnectTiming = *pxTiming;
+    taskEXIT_CRITICAL();
+
+    APP_PRINTFInfo("MQTT connect timing: reconnect=%d, settings=%u ms, socket(dns+tcp+tls)=%u ms, mqtt connect=%u ms, session restore=%u ms",
+                   pxTiming->bIsReconnect,
+                   pxTiming->uxReadSettingsMs,
+                   pxTiming->uxSocketConnectMs,
+                   pxTiming->uxMQTTConnectMs,
+                   pxTiming->uxSessionRestoreMs);
+}
+
+static MQTTCommandPriority_t eprvGetCurrentTaskCommandPriority(void)
+{
+    TaskHandle_t xCurrentTaskHandle = xTaskGetCurrentTaskHandle();
+    for (uint32_t i = 0; i < MQTT_BULK_TASK_MAX_NUM; i++)
+    {
+        if (gxBulkTaskHandleList[i] == xCurrentTaskHandle)
+        {
+            return MQTT_COMMAND_PRIORITY_BULK;
+        }
+    }
+    return MQTT_COMMAND_PRIORITY_INTERACTIVE;
+}
+
+static MQTTOutgoingPublish_t *xprvAcquireOutgoingPublish(void)
+{
+    MQTTOutgoingPublish_t *pxOutgoing = NULL;
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < MQTT_QOS1_INFLIGHT_WINDOW; i++)
+    {
+        if (gxOutgoingPublishList[i].eState == MQTT_OUTGOING_PUBLISH_STATE_FREE)
+        {
+            gxOutgoingPublishList[i].eState = MQTT_OUTGOING_PUBLISH_STATE_RESERVED;
+            pxOutgoing = &gxOutgoingPublishList[i];
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return pxOutgoing;
+}
+
+static void vprvReleaseOutgoingPublish(MQTTOutgoingPublish_t *pxOutgoing)
+{
+    taskENTER_CRITICAL();
+    pxOutgoing->eState = MQTT_OUTGOING_PUBLISH_STATE_FREE;
+    taskEXIT_CRITICAL();
+
+    xSemaphoreGive(gxQoS1InflightSemaphore);
+}
+
+static void vprvMQTTQoS1PublishDoneCallback(MQTTAgentCommandContext_t *pCmdCallbackContext, MQTTAgentReturnInfo_t *pReturnInfo)
+{
+    MQTTOutgoingPublish_t *pxOutgoing = (MQTTOutgoingPublish_t *)pCmdCallbackContext->pxArgs;
+    bool bAbandoned = false;
+
+#if (MQTT_METRICS_ENABLE == 1)
+    vMQTTMetricsRecordCommandLatency(MQTT_METRICS_COMMAND_PUBLISH, pCmdCallbackContext->xEnqueueTick, (pReturnInfo->returnCode == MQTTSuccess) ? true : false);
+#endif
+
+    taskENTER_CRITICAL();
+    if (pxOutgoing->eState == MQTT_OUTGOING_PUBLISH_STATE_ABANDONED)
+    {
+        bAbandoned = true;
+    }
+    else
+    {
+        pxOutgoing->eState = (pReturnInfo->returnCode == MQTTSuccess) ? MQTT_OUTGOING_PUBLISH_STATE_ACKED : MQTT_OUTGOING_PUBLISH_STATE_FAILED;
+    }
+    taskEXIT_CRITICAL();
+
+    if (pReturnInfo->returnCode != MQTTSuccess)
+    {
+        APP_PRINTFWarn("MQTT QoS1 publish was discarded. Reason %d", pReturnInfo->returnCode);
+    }
+
+    if (bAbandoned == true)
+    {
+        // 呼び出し元がタイムアウト済みのため、ここで送信ストアを解放する
+        vprvReleaseOutgoingPublish(pxOutgoing);
+        return;
+    }
+
+    // 呼び出し元に通知
+    xEventGroupSetBits(gxOutgoingPublishEventGroup, pxOutgoing->xDoneEventBit);
+}
+
+#if (MQTT_PUBLISH_RATE_LIMIT_ENABLE == 1)
+static MQTTPublishClass_t eprvGetPublishClass(const char *pcTopicName, const uint16_t usTopicNameLength)
+{
+    for (uint32_t i = 0; i < (sizeof(gxPublishClassFilterList) / sizeof(gxPublishClassFilterList[0])); i++)
+    {
+        bool bIsMatch = false;
+        if ((MQTT_MatchTopic(pcTopicName, usTopicNameLength,
+                             gxPublishClassFilterList[i].pcTopicFilter, gxPublishClassFilterList[i].usTopicFilterLength,
+                             &bIsMatch) == MQTTSuccess) &&
+            (bIsMatch == true))
+        {
+            return gxPublishClassFilterList[i].ePublishClass;
+        }
+    }
+    return MQTT_PUBLISH_CLASS_DEFAULT;
+}
+
+static uint32_t ulprvCheckPublishToken(const MQTTPublishClass_t ePublishClass, const bool bTake)
+{
+    MQTTPublishRateLimiter_t *pxLimiter = &gxPublishRateLimiterList[ePublishClass];
+    uint32_t ulWaitMs = 0;
+
+    taskENTER_CRITICAL();
+
+    // 経過時間分のトークンを補充する。1msあたり ulPublishPerSecond / 1000 個補充される
+    TickType_t xNowTick = xTaskGetTickCount();
+    uint64_t ullMilliTokens = (uint64_t)pxLimiter->ulMilliTokens +
+                              ((uint64_t)(xNowTick - pxLimiter->xLastRefillTick) * portTICK_PERIOD_MS * pxLimiter->ulPublishPerSecond);
+    uint32_t ulMaxMilliTokens = pxLimiter->ulBurst * 1000U;
+    pxLimiter->ulMilliTokens = (ullMilliTokens > ulMaxMilliTokens) ? ulMaxMilliTokens : (uint32_t)ullMilliTokens;
+    pxLimiter->xLastRefillTick = xNowTick;
+
+    if (pxLimiter->ulMilliTokens >= 1000U)
+    {
+        if (bTake == true)
+        {
+            pxLimiter->ulMilliTokens -= 1000U;
+        }
+    }
+    else
+    {
+        ulWaitMs = ((1000U - pxLimiter->ulMilliTokens) + pxLimiter->ulPublishPerSecond - 1U) / pxLimiter->ulPublishPerSecond;
+    }
+
+    taskEXIT_CRITICAL();
+
+    return ulWaitMs;
+}
+
+static void vprvWaitForPublishToken(const MQTTPublishClass_t ePublishClass)
+{
+    MQTTPublishRateLimiter_t *pxLimiter = &gxPublishRateLimiterList[ePublishClass];
+
+    if (ulprvCheckPublishToken(ePublishClass, true) == 0)
+    {
+        return;
+    }
+
+    // 待機中のPublishは1つずつトークンを受け取る
+    const TickType_t xStartTick = xTaskGetTickCount();
+    xSemaphoreTake(pxLimiter->xWaitMutex, portMAX_DELAY);
+    uint32_t ulWaitMs = 0;
+    while ((ulWaitMs = ulprvCheckPublishToken(ePublishClass, true)) != 0)
+    {
+        vTaskDelay(pdMS_TO_TICKS(ulWaitMs) + 1);
+    }
+    xSemaphoreGive(pxLimiter->xWaitMutex);
+
+    uint32_t ulWaitedMs = (uint32_t)(xTaskGetTickCount() - xStartTick) * portTICK_PERIOD_MS;
+    taskENTER_CRITICAL();
+    pxLimiter->ulThrottledCount++;
+    pxLimiter->ulTotalWaitMs += ulWaitedMs;
+    taskEXIT_CRITICAL();
+
+    APP_PRINTFDebug("MQTT publish throttled. Class: %d, Wait: %u ms", ePublishClass, ulWaitedMs);
+}
+
+static void vprvCoalescedPublishTimerCallback(TimerHandle_t xTimer)
+{
+    // Publish中のタスクが保持領域を更新している場合は、次のTickで再度確認する
+    if (xSemaphoreTake(gxCoalescedPublishMutex, 0) != pdTRUE)
+    {
+        xTimerChangePeriod(xTimer, 1, 0);
+        return;
+    }
+
+    uint32_t ulNextWaitMs = UINT32_MAX;
+    for (uint32_t i = 0; i < MQTT_RATE_LIMIT_COALESCE_SLOT_NUM; i++)
+    {
+        MQTTCoalescedPublish_t *pxCoalesced = &gxCoalescedPublishList[i];
+        if (pxCoalesced->eState != MQTT_COALESCED_PUBLISH_STATE_WAITING)
+        {
+            continue;
+        }
+
+        uint32_t ulWaitMs = ulprvCheckPublishToken(pxCoalesced->ePublishClass, true);
+        if (ulWaitMs == 0)
+        {
+            taskENTER_CRITICAL();
+            pxCoalesced->eState = MQTT_COALESCED_PUBLISH_STATE_SENDING;
+            taskEXIT_CRITICAL();
+            pxCoalesced->xCommandContext.xEnqueueTick = xTaskGetTickCount();
+
+            // タイマータスクを止めないよう、コマンドキューに空きがない場合は待機せずに次の機会に送信する
+            MQTTStatus_t xMQTTResult = MQTTAgent_Publish((const MQTTAgentContext_t *)(&(gxMQTTCommunicationContext.xMqttAgentContext)),
+                                                         &pxCoalesced->xPublishInfo,
+                                                         (const MQTTAgentCommandInfo_t *)&pxCoalesced->xCommandInfo);
+            if (xMQTTResult == MQTTSuccess)
+            {
+                continue;
+            }
+
+            APP_PRINTFWarn("Failed to send coalesced publish. Reason: %d", xMQTTResult);
+            taskENTER_CRITICAL();
+            pxCoalesced->eState = MQTT_COALESCED_PUBLISH_STATE_WAITING;
+            taskEXIT_CRITICAL();
+            ulWaitMs = 1000U / gxPublishRateLimiterList[pxCoalesced->ePublishClass].ulPublishPerSecond;
+        }
+
+        ulNextWaitMs = (ulWaitMs < ulNextWaitMs) ? ulWaitMs : ulNextWaitMs;
+    }
+
+    xSemaphoreGive(gxCoalescedPublishMutex);
+
+    // 送信待ちのPublishが残っている場合は、次にトークンが補充される時間に再度実行する
+    if (ulNextWaitMs != UINT32_MAX)
+    {
+        xTimerChangePeriod(xTimer, pdMS_TO_TICKS(ulNextWaitMs) + 1, 0);
+    }
+}
+
+static void vprvMQTTCoalescedPublishDoneCallback(MQTTAgentCommandContext_t *pCmdCallbackContext, MQTTAgentReturnInfo_t *pReturnInfo)
+{
+    MQTTCoalescedPublish_t *pxCoalesced = (MQTTCoalescedPublish_t *)pCmdCallbackContext->pxArgs;
+
+#if (MQTT_METRICS_ENABLE == 1)
+    vMQTTMetricsRecordCommandLatency(MQTT_METRICS_COMMAND_PUBLISH, pCmdCallbackContext->xEnqueueTick, (pReturnInfo->returnCode == MQTTSuccess) ? true : false);
+#endif
+
+    // QoS0のため、通信断などでコマンドが破棄された場合も再送せずに解放する
+    if (pReturnInfo->returnCode != MQTTSuccess)
+    {
+        APP_PRINTFWarn("Coalesced publish was not sent. Reason: %d", pReturnInfo->returnCode);
+    }
+
+    taskENTER_CRITICAL();
+    pxCoalesced->eState = MQTT_COALESCED_PUBLISH_STATE_FREE;
+    taskEXIT_CRITICAL();
+}
+
+static void vprvPrintPublishRateLimitStats(void)
+{
+    for (uint32_t i = 0; i < MQTT_PUBLISH_CLASS_NUM; i++)
+    {
+        const MQTTPublishRateLimiter_t *pxLimiter = &gxPublishRateLimiterList[i];
+        APP_PRINTFInfo("MQTT publish rate limit: class=%u, throttled=%u, coalesced=%u, total wait=%u ms",
+                       i,
+                       pxLimiter->ulThrottledCount,
+                       pxLimiter->ulCoalescedCount,
+                       pxLimiter->ulTotalWaitMs);
+    }
+}
+#endif
+
+#if (MQTT_METRICS_ENABLE == 1)
+static void vprvMetricsPublishTimerCallback(TimerHandle_t xTimer)
+{
+    (void)xTimer;
+
+    // 切断中や、前回のPublishが完了していない場合は次の周期に送信する
+    bool bIsSending = false;
+    taskENTER_CRITICAL();
+    bIsSending = gxMetricsPublish.bIsSending;
+    taskEXIT_CRITICAL();
+    if ((gxConnectionState != MQTT_CONNECTION_STATE_CONNECTED) || (bIsSending == true))
+    {
+        return;
+    }
+
+#if (MQTT_PUBLISH_RATE_LIMIT_ENABLE == 1)
+    // タイマータスクを止めないよう、トークンがない場合は待機せずに次の周期に送信する
+    if (ulprvCheckPublishToken(MQTT_PUBLISH_CLASS_DEFAULT, true) != 0)
+    {
+        APP_PRINTFDebug("MQTT metrics publish skipped by rate limit.");
+        return;
+    }
+#endif
+
+    int lTopicLength = snprintf(gxMetricsPublish.cTopic, sizeof(gxMetricsPublish.cTopic), MQTT_METRICS_TOPIC_FORMAT, (const char *)gxMQTTClientID);
+    size_t uxPayloadLength = uxMQTTMetricsFormatSnapshot(gxMetricsPublish.cPayload, sizeof(gxMetricsPublish.cPayload));
+    if ((lTopicLength <= 0) || ((size_t)lTopicLength >= sizeof(gxMetricsPublish.cTopic)) || (uxPayloadLength == 0))
+    {
+        APP_PRINTFWarn("Failed to create mqtt metrics snapshot.");
+        return;
+    }
+
+    memset(&gxMetricsPublish.xPublishInfo, 0x00, sizeof(gxMetricsPublish.xPublishInfo));
+    gxMetricsPublish.xPublishInfo.qos = MQTTQoS0;
+    gxMetricsPublish.xPublishInfo.pTopicName = gxMetricsPublish.cTopic;
+    gxMetricsPublish.xPublishInfo.topicNameLength = (uint16_t)lTopicLength;
+    gxMetricsPublish.xPublishInfo.pPayload = gxMetricsPublish.cPayload;
+    gxMetricsPublish.xPublishInfo.payloadLength = uxPayloadLength;
+
+    // 診断用のPublishで鍵操作の応答を遅らせないよう、一括系のコマンドとして送信する
+    memset(&gxMetricsPublish.xCommandContext, 0x00, sizeof(gxMetricsPublish.xCommandContext));
+    gxMetricsPublish.xCommandContext.ePriority = MQTT_COMMAND_PRIORITY_BULK;
+    gxMetricsPublish.xCommandContext.xEnqueueTick = xTaskGetTickCount();
+    gxMetricsPublish.xCommandInfo.cmdCompleteCallback = &vprvMQTTMetricsPublishDoneCallback;
+    gxMetricsPublish.xCommandInfo.pCmdCompleteCallbackContext = &gxMetricsPublish.xCommandContext;
+    gxMetricsPublish.xCommandInfo.blockTimeMs = 0;
+
+    taskENTER_CRITICAL();
+    gxMetricsPublish.bIsSending = true;
+    taskEXIT_CRITICAL();
+
+    // タイマータスクを止めないよう、コマンドキューに空きがない場合は待機せずに次の周期に送信する
+    MQTTStatus_t xMQTTResult = MQTTAgent_Publish((const MQTTAgentContext_t *)(&(gxMQTTCommunicationContext.xMqttAgentContext)),
+                                                 &gxMetricsPublish.xPublishInfo,
+                                                 (const MQTTAgentCommandInfo_t *)&gxMetricsPublish.xCommandInfo);
+    if (xMQTTResult != MQTTSuccess)
+    {
+        APP_PRINTFWarn("Failed to publish mqtt metrics. Reason: %d", xMQTTResult);
+        taskENTER_CRITICAL();
+        gxMetricsPublish.bIsSending = false;
+        taskEXIT_CRITICAL();
+    }
+}
+
+static void vprvMQTTMetricsPublishDoneCallback(MQTTAgentCommandContext_t *pCmdCallbackContext, MQTTAgentReturnInfo_t *pReturnInfo)
+{
+    vMQTTMetricsRecordCommandLatency(MQTT_METRICS_COMMAND_PUBLISH, pCmdCallbackContext->xEnqueueTick, (pReturnInfo->returnCode == MQTTSuccess) ? true : false);
+
+    if (pReturnInfo->returnCode != MQTTSuccess)
+    {
+        APP_PRINTFWarn("MQTT metrics was not sent. Reason: %d", pReturnInfo->returnCode);
+    }
+
+    taskENTER_CRITICAL();
+    gxMetricsPublish.bIsSending = false;
+    taskEXIT_CRITICAL();
+}
+#endif
+
 // --------------------------------------------------
 // Unit Test用関数定義(関数のプロトタイプ宣言は「自身のファイル名+ "_test.h"」で宣言されていること)
 // --------------------------------------------------
@@ -0,0 +1,111 @@
+/**
+ * @file mqtt_dispatch_worker.h
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+#ifndef MQTT_DISPATCH_WORKER_H_
+#define MQTT_DISPATCH_WORKER_H_
+
+#ifdef __cplusplus // Provide Cplusplus Compatibility
+
+extern "C"
+{
+#endif /* end Provide Cplusplus Compatibility */
+
+// --------------------------------------------------
+// ###   システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+#include "core_mqtt.h"
+#include "mqtt_subscription_manager.h"
+
+    // --------------------------------------------------
+    // ユーザ作成ヘッダの取り込み
+    // --------------------------------------------------
+
+#include "config/mqtt_config.h"
+
+    // --------------------------------------------------
+    // #defineマクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // #define関数マクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // typedef定義
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // enumタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // struct/unionタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // extern変数宣言
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // 関数プロトタイプ宣言
+    // --------------------------------------------------
+
+    /**
+     * @brief Dispatch Workerのバッファプール、キュー、タスクを作成する
+     *
+     * @note 2回目以降の呼び出しでは何もしない
+     *
+     * @retval true  成功
+     * @retval false 失敗
+     */
+    bool bMQTTDispatchWorkerInit(void);
+
+    /**
+     * @brief コールバック関数をDispatch Workerで実行するためのコンテキストを取得する
+     *
+     * @details
+     * 同じコールバック関数と引数の組み合わせには同じコンテキストを返す。
+     * 戻り値を引数として #vMQTTDispatchWorkerIncomingPublishCallback をSubscriptionManagerに登録する。
+     *
+     * @param[in] xIncomingCallback         Dispatch Workerで実行するコールバック関数
+     * @param[in] pvIncomingCallbackContext コールバック関数に渡す引数
+     *
+     * @return void* コンテキスト。登録数が #MQTT_DISPATCH_SUBSCRIBER_MAX_NUM を超えた場合はNULL
+     */
+    void *pvMQTTDispatchWorkerGetContext(IncomingPubCallback_t xIncomingCallback, void *pvIncomingCallbackContext);
+
+    /**
+     * @brief 受信したPublishをバッファプールにコピーしてDispatch Workerに渡す
+     *
+     * @details
+     * SubscriptionManagerから呼び出される。MQTT Taskのコンテキストで実行され、コピー後すぐに戻る。
+     * バッファプールに空きがない場合、またはトピックとペイロードがバッファに収まらない場合は、破棄してエラーログを出力する。
+     * MQTT Taskのコンテキストでコールバック関数を実行すると、キューに溜まったPublishと順序が入れ替わるため実行しない。
+     *
+     * @param[in] pvIncomingCallbackContext #pvMQTTDispatchWorkerGetContext で取得したコンテキスト
+     * @param[in] pxPublishInfo             受信したPublish
+     */
+    void vMQTTDispatchWorkerIncomingPublishCallback(void *pvIncomingCallbackContext, MQTTPublishInfo_t *pxPublishInfo);
+
+    /**
+     * @brief Dispatch Workerの統計情報を出力する
+     */
+    void vMQTTDispatchWorkerPrintStats(void);
+
+    // --------------------------------------------------
+    // インライン関数
+    // --------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end MQTT_DISPATCH_WORKER_H_ */
@@ -0,0 +1,166 @@
+/**
+ * @file mqtt_metrics.h
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+#ifndef MQTT_METRICS_H_
+#define MQTT_METRICS_H_
+
+#ifdef __cplusplus // Provide Cplusplus Compatibility
+
+extern "C"
+{
+#endif /* end Provide Cplusplus Compatibility */
+
+// --------------------------------------------------
+// ###   システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+#include "transport_interface.h"
+
+    // --------------------------------------------------
+    // ユーザ作成ヘッダの取り込み
+    // --------------------------------------------------
+
+#include "config/mqtt_config.h"
+
+    // --------------------------------------------------
+    // #defineマクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // #define関数マクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // typedef定義
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // enumタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    /**
+     * @brief 完了までの時間を計測するコマンドの種類
+     */
+    typedef enum
+    {
+        MQTT_METRICS_COMMAND_PUBLISH = 0, /**< Publish */
+        MQTT_METRICS_COMMAND_SUBSCRIBE,   /**< Subscribe */
+        MQTT_METRICS_COMMAND_UNSUBSCRIBE, /**< Unsubscribe */
+        MQTT_METRICS_COMMAND_NUM,         /**< コマンドの種類の数 */
+    } MQTTMetricsCommandType_t;
+
+    // --------------------------------------------------
+    // struct/unionタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // extern変数宣言
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // 関数プロトタイプ宣言
+    // --------------------------------------------------
+
+    /**
+     * @brief メトリクスを初期化する
+     *
+     * @param[in] xTransportSend 実際にデータを送信するトランスポート層の送信関数
+     * @param[in] xTransportRecv 実際にデータを受信するトランスポート層の受信関数
+     */
+    void vMQTTMetricsInit(TransportSend_t xTransportSend, TransportRecv_t xTransportRecv);
+
+    /**
+     * @brief 送信したバイト数を計測する送信関数
+     *
+     * @details
+     * PINGREQを送信した場合は、KeepAliveの往復時間の計測を開始する
+     *
+     * @param[in] pNetworkContext ネットワークコンテキスト
+     * @param[in] pBuffer         送信するデータ
+     * @param[in] bytesToSend     送信するデータの長さ
+     *
+     * @return int32_t 送信したバイト数。エラーの場合は負の値
+     */
+    int32_t lMQTTMetricsTransportSend(NetworkContext_t *pNetworkContext, const void *pBuffer, size_t bytesToSend);
+
+    /**
+     * @brief 受信したバイト数を計測する受信関数
+     *
+     * @details
+     * PINGRESPを受信した場合は、KeepAliveの往復時間を記録する
+     *
+     * @param[in]  pNetworkContext ネットワークコンテキスト
+     * @param[out] pBuffer         受信したデータを格納するバッファ
+     * @param[in]  bytesToRecv     受信するデータの長さ
+     *
+     * @return int32_t 受信したバイト数。データがない場合は0、エラーの場合は負の値
+     */
+    int32_t lMQTTMetricsTransportRecv(NetworkContext_t *pNetworkContext, void *pBuffer, size_t bytesToRecv);
+
+    /**
+     * @brief コマンドのエンキューから完了までの時間を記録する
+     *
+     * @param[in] eCommandType コマンドの種類
+     * @param[in] xEnqueueTick MQTT Agentにエンキューした時間
+     * @param[in] bIsSuccess   コマンドが成功したか
+     */
+    void vMQTTMetricsRecordCommandLatency(MQTTMetricsCommandType_t eCommandType, TickType_t xEnqueueTick, bool bIsSuccess);
+
+    /**
+     * @brief MQTT Agentのコマンドキューの滞留数を記録する
+     *
+     * @param[in] uxQueueDepth エンキュー直後のコマンドキューの滞留数
+     */
+    void vMQTTMetricsRecordQueueDepth(UBaseType_t uxQueueDepth);
+
+    /**
+     * @brief 再接続を試行したことを記録する
+     */
+    void vMQTTMetricsRecordReconnectAttempt(void);
+
+    /**
+     * @brief 再接続に成功したことを記録する
+     */
+    void vMQTTMetricsRecordReconnectSuccess(void);
+
+    /**
+     * @brief 受信したパケットの種類を記録する
+     *
+     * @details
+     * PINGRESPを受信した場合は、KeepAliveの往復時間を記録する
+     *
+     * @param[in] ucFixedHeaderFirstByte 受信したパケットの固定ヘッダの先頭バイト
+     */
+    void vMQTTMetricsRecordIncomingPacket(uint8_t ucFixedHeaderFirstByte);
+
+    /**
+     * @brief メトリクスをJSONに変換する
+     *
+     * @param[out] pcBuffer     JSONを格納するバッファ
+     * @param[in]  uxBufferSize バッファのサイズ
+     *
+     * @return size_t JSONの長さ。バッファに収まらなかった場合は0
+     */
+    size_t uxMQTTMetricsFormatSnapshot(char *pcBuffer, size_t uxBufferSize);
+
+    /**
+     * @brief メトリクスを出力する
+     */
+    void vMQTTMetricsPrint(void);
+
+    // --------------------------------------------------
+    // インライン関数
+    // --------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end MQTT_METRICS_H_ */
@@ -0,0 +1,181 @@
+/**
+ * @file mqtt_priority_message.h
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+#ifndef MQTT_PRIORITY_MESSAGE_H_
+#define MQTT_PRIORITY_MESSAGE_H_
+
+#ifdef __cplusplus // Provide Cplusplus Compatibility
+
+extern "C"
+{
+#endif /* end Provide Cplusplus Compatibility */
+
+// --------------------------------------------------
+// ###   システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "core_mqtt_agent.h"
+#include "freertos_agent_message.h"
+
+    // --------------------------------------------------
+    // ユーザ作成ヘッダの取り込み
+    // --------------------------------------------------
+
+#include "config/mqtt_config.h"
+#include "tasks/mqtt/include/mqtt_operation_task.h"
+
+// --------------------------------------------------
+// #defineマクロ
+// --------------------------------------------------
+
+// --------------------------------------------------
+// #define関数マクロ
+// --------------------------------------------------
+
+// --------------------------------------------------
+// typedef定義
+// --------------------------------------------------
+
+// --------------------------------------------------
+// enumタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// struct/unionタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+#if (MQTT_AGENT_ENABLE_QUEUE_STATS == 1)
+
+    /**
+     * @brief 優先度ごとのコマンドキューの統計情報
+     */
+    typedef struct
+    {
+        uint32_t ulDequeueCount;   /**< MQTT Taskが取り出したコマンド数 */
+        uint32_t ulTotalWaitTicks; /**< エンキューから取り出しまでの待ち時間の合計 */
+        uint32_t ulMaxWaitTicks;   /**< エンキューから取り出しまでの待ち時間の最大値 */
+        uint32_t ulSendFailCount;  /**< キューが満杯のためエンキューに失敗した回数 */
+    } MQTTPriorityMessageStats_t;
+#endif
+
+    /**
+     * @brief 優先度付きのMQTT Agentコマンドキュー
+     *
+     * @details
+     * 優先度ごとにキューを分け、MQTT Taskは対話系のコマンドを先に取り出す。
+     * ただし、一括系のコマンドが待っている間に対話系を #MQTT_AGENT_BULK_STARVATION_LIMIT 回続けて取り出した場合は、一括系を1つ取り出す。
+     */
+    typedef struct
+    {
+        /**
+         * @brief MQTT Agentに渡すコンテキスト。本構造体の先頭に置き、MQTTAgentMessageInterface_t.pMsgCtxには本メンバのアドレスを渡す
+         *
+         * @note queueは使用しない
+         */
+        MQTTAgentMessageContext_t xAgentMessageContext;
+
+        /**
+         * @brief 優先度ごとのコマンドキュー
+         */
+        QueueHandle_t xLaneQueue[MQTT_COMMAND_PRIORITY_NUM];
+
+        /**
+         * @brief 全キューに入っているコマンド数を表すカウンティングセマフォ。MQTT Taskはこれを待機する
+         */
+        SemaphoreHandle_t xCommandCountSemaphore;
+
+        /**
+         * @brief 一括系のコマンドが待っている間に、対話系のコマンドを続けて取り出した回数
+         */
+        uint32_t uxConsecutiveInteractiveCount;
+
+#if (MQTT_AGENT_ENABLE_QUEUE_STATS == 1)
+
+        /**
+         * @brief 優先度ごとの統計情報
+         */
+        MQTTPriorityMessageStats_t xStats[MQTT_COMMAND_PRIORITY_NUM];
+#endif
+    } MQTTPriorityMessageContext_t;
+
+    // --------------------------------------------------
+    // extern変数宣言
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // 関数プロトタイプ宣言
+    // --------------------------------------------------
+
+    /**
+     * @brief 優先度付きのMQTT Agentコマンドキューを初期化する
+     *
+     * @param[out] pxContext 初期化するコンテキスト
+     *
+     * @retval true  成功
+     * @retval false 失敗
+     */
+    bool bMQTTPriorityMessageInit(MQTTPriorityMessageContext_t *pxContext);
+
+    /**
+     * @brief コマンドを優先度に応じたキューに追加する
+     *
+     * @details
+     * MQTTAgentMessageInterface_t.sendに登録する。
+     * 優先度はコマンドのMQTTAgentCommandContext_t.ePriorityで決まり、コンテキストがない場合は対話系とする。
+     *
+     * @param[in] pMsgCtx        #MQTTPriorityMessageContext_t のxAgentMessageContext
+     * @param[in] pCommandToSend 追加するコマンド
+     * @param[in] blockTimeMs    キューが満杯の場合に待機する時間
+     *
+     * @retval true  成功
+     * @retval false 失敗
+     */
+    bool bMQTTPriorityMessageSend(MQTTAgentMessageContext_t *pMsgCtx,
+                                  MQTTAgentCommand_t *const *pCommandToSend,
+                                  uint32_t blockTimeMs);
+
+    /**
+     * @brief 優先度の高いキューからコマンドを取り出す
+     *
+     * @details
+     * MQTTAgentMessageInterface_t.recvに登録する。MQTT Taskからのみ呼び出される。
+     *
+     * @param[in]  pMsgCtx          #MQTTPriorityMessageContext_t のxAgentMessageContext
+     * @param[out] pReceivedCommand 取り出したコマンド
+     * @param[in]  blockTimeMs      コマンドがない場合に待機する時間
+     *
+     * @retval true  成功
+     * @retval false 失敗。タイムアウトも含む
+     */
+    bool bMQTTPriorityMessageReceive(MQTTAgentMessageContext_t *pMsgCtx,
+                                     MQTTAgentCommand_t **pReceivedCommand,
+                                     uint32_t blockTimeMs);
+
+#if (MQTT_AGENT_ENABLE_QUEUE_STATS == 1)
+
+    /**
+     * @brief 優先度ごとのコマンドキューの統計情報を出力する
+     *
+     * @param[in] pxContext コンテキスト
+     */
+    void vMQTTPriorityMessagePrintStats(const MQTTPriorityMessageContext_t *pxContext);
+#endif
+
+    // --------------------------------------------------
+    // インライン関数
+    // --------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end MQTT_PRIORITY_MESSAGE_H_ */
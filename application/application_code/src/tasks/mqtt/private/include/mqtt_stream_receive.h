@@ -0,0 +1,144 @@
+/**
+ * @file mqtt_stream_receive.h
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+#ifndef MQTT_STREAM_RECEIVE_H_
+#define MQTT_STREAM_RECEIVE_H_
+
+#ifdef __cplusplus // Provide Cplusplus Compatibility
+
+extern "C"
+{
+#endif /* end Provide Cplusplus Compatibility */
+
+// --------------------------------------------------
+// ###   システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+#include "core_mqtt.h"
+#include "transport_interface.h"
+
+    // --------------------------------------------------
+    // ユーザ作成ヘッダの取り込み
+    // --------------------------------------------------
+
+#include "config/mqtt_config.h"
+#include "tasks/mqtt/include/mqtt_operation_task.h"
+
+    // --------------------------------------------------
+    // #defineマクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // #define関数マクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // typedef定義
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // enumタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // struct/unionタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // extern変数宣言
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // 関数プロトタイプ宣言
+    // --------------------------------------------------
+
+    /**
+     * @brief ストリーム受信を初期化する
+     *
+     * @param[in] xTransportRecv 実際にデータを受信するトランスポート層の受信関数
+     */
+    void vMQTTStreamReceiveInit(TransportRecv_t xTransportRecv);
+
+    /**
+     * @brief 受信途中のパケットの状態を破棄する
+     *
+     * @note トランスポート層を接続し直した後、MQTT接続を行う前に呼び出す
+     */
+    void vMQTTStreamReceiveReset(void);
+
+    /**
+     * @brief coreMQTTに登録する受信関数
+     *
+     * @details
+     * トランスポート層から受信したパケットをcoreMQTTに渡す。
+     * ストリーム受信を登録したトピックのPublishの場合は、ペイロードをチャンク単位でコールバック関数に渡し、
+     * coreMQTTにはペイロードを取り除いたPublishを渡す。QoS1のPUBACKはcoreMQTTが送信する。
+     *
+     * @param[in]  pNetworkContext ネットワークコンテキスト
+     * @param[out] pBuffer         受信したデータを格納するバッファ
+     * @param[in]  bytesToRecv     受信するデータの長さ
+     *
+     * @return int32_t 受信したバイト数。データがない場合は0、エラーの場合は負の値
+     */
+    int32_t lMQTTStreamReceiveRecv(NetworkContext_t *pNetworkContext, void *pBuffer, size_t bytesToRecv);
+
+    /**
+     * @brief ストリーム受信するトピックフィルタを登録する
+     *
+     * @param[in] pcTopicFilter       トピックフィルタ
+     * @param[in] usTopicFilterLength トピックフィルタの長さ
+     * @param[in] uxMinPayloadLength  ストリーム受信とするペイロードの最小長
+     * @param[in] xCallback           ペイロードの断片を受け取るコールバック関数
+     * @param[in] pvContext           コールバック関数に渡す引数
+     *
+     * @retval true  成功
+     * @retval false 登録数が #MQTT_STREAM_SUBSCRIBER_MAX_NUM を超えた
+     */
+    bool bMQTTStreamReceiveRegister(const char *pcTopicFilter,
+                                    const uint16_t usTopicFilterLength,
+                                    const size_t uxMinPayloadLength,
+                                    const MQTTStreamChunkCallback_t xCallback,
+                                    void *pvContext);
+
+    /**
+     * @brief ストリーム受信するトピックフィルタの登録を解除する
+     *
+     * @param[in] pcTopicFilter       トピックフィルタ
+     * @param[in] usTopicFilterLength トピックフィルタの長さ
+     */
+    void vMQTTStreamReceiveUnregister(const char *pcTopicFilter, const uint16_t usTopicFilterLength);
+
+    /**
+     * @brief 受信したPublishが、ペイロードをストリーム受信で渡し終えたものかを判定する
+     *
+     * @details
+     * trueを返した場合、そのPublishは通常のコールバック関数に渡してはいけない
+     *
+     * @param[in] pxPublishInfo coreMQTTから渡されたPublish
+     *
+     * @retval true  ストリーム受信で渡し終えたPublish
+     * @retval false 通常のPublish
+     */
+    bool bMQTTStreamReceiveIsStreamedPublish(const MQTTPublishInfo_t *pxPublishInfo);
+
+    /**
+     * @brief ストリーム受信の統計情報を出力する
+     */
+    void vMQTTStreamReceivePrintStats(void);
+
+    // --------------------------------------------------
+    // インライン関数
+    // --------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end MQTT_STREAM_RECEIVE_H_ */
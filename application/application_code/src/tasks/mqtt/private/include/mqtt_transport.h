@@ -0,0 +1,157 @@
+/**
+ * @file mqtt_transport.h
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+#ifndef MQTT_TRANSPORT_H_
+#define MQTT_TRANSPORT_H_
+
+#ifdef __cplusplus // Provide Cplusplus Compatibility
+
+extern "C"
+{
+#endif /* end Provide Cplusplus Compatibility */
+
+// --------------------------------------------------
+// ###   システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+#include "transport_interface.h"
+#include "transport_secure_sockets.h"
+
+    // --------------------------------------------------
+    // ユーザ作成ヘッダの取り込み
+    // --------------------------------------------------
+
+#include "config/mqtt_config.h"
+#include "tasks/mqtt/include/mqtt_operation_task.h"
+
+    // --------------------------------------------------
+    // #defineマクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // #define関数マクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // typedef定義
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // enumタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // struct/unionタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    /**
+     * @brief MQTTが使用するトランスポート層の実装
+     */
+    typedef struct
+    {
+        /**
+         * @brief ログに表示する名前
+         */
+        const char *pcName;
+
+        /**
+         * @brief 接続先のホスト名。NULLの場合はSEに保存されたIoT Endpointに接続する
+         */
+        const char *pcHostName;
+
+        /**
+         * @brief 接続先のポート番号
+         */
+        uint16_t usPort;
+
+        /**
+         * @brief TLSを使用するか
+         */
+        bool bEnableTls;
+
+        /**
+         * @brief トランスポート層を初期化する。不要な場合はNULL
+         */
+        bool (*bInit)(void);
+
+        /**
+         * @brief 接続する
+         */
+        TransportSocketStatus_t (*xConnect)(NetworkContext_t *pNetworkContext,
+                                            const ServerInfo_t *pServerInfo,
+                                            const SocketsConfig_t *pSocketsConfig);
+
+        /**
+         * @brief 切断する
+         */
+        TransportSocketStatus_t (*xDisconnect)(const NetworkContext_t *pNetworkContext);
+
+        /**
+         * @brief 送信する。MQTTのTransportInterface_tに登録する
+         */
+        TransportSend_t xSend;
+
+        /**
+         * @brief 受信する。MQTTのTransportInterface_tに登録する
+         */
+        TransportRecv_t xRecv;
+    } MQTTTransport_t;
+
+    // --------------------------------------------------
+    // extern変数宣言
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // 関数プロトタイプ宣言
+    // --------------------------------------------------
+
+    /**
+     * @brief トランスポート層の実装を取得する
+     *
+     * @param[in] eTransportType トランスポート層の種類
+     *
+     * @return const MQTTTransport_t* トランスポート層の実装。不正な種類、または接続先が設定されていない場合はNULL
+     */
+    const MQTTTransport_t *pxMQTTTransportGet(const MQTTTransportType_t eTransportType);
+
+    /**
+     * @brief パイプトランスポートの対向(ブローカー役)として、MQTTが送信したデータを読み出す
+     *
+     * @details
+     * #MQTT_TRANSPORT_TYPE_PIPE を選択した場合に、テスト用の疑似ブローカーから呼び出す。
+     *
+     * @param[out] pvBuffer      読み出したデータを格納するバッファ
+     * @param[in]  uxBufferSize  バッファのサイズ
+     * @param[in]  xTicksToWait  データがない場合に待機する時間
+     *
+     * @return size_t 読み出したバイト数
+     */
+    size_t uxMQTTPipeTransportPeerRead(void *pvBuffer, const size_t uxBufferSize, const TickType_t xTicksToWait);
+
+    /**
+     * @brief パイプトランスポートの対向(ブローカー役)として、MQTTが受信するデータを書き込む
+     *
+     * @param[in] pvData       書き込むデータ
+     * @param[in] uxLength     書き込むデータの長さ
+     * @param[in] xTicksToWait バッファに空きがない場合に待機する時間
+     *
+     * @return size_t 書き込んだバイト数
+     */
+    size_t uxMQTTPipeTransportPeerWrite(const void *pvData, const size_t uxLength, const TickType_t xTicksToWait);
+
+    // --------------------------------------------------
+    // インライン関数
+    // --------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end MQTT_TRANSPORT_H_ */
@@ -0,0 +1,298 @@
+/**
+ * @file mqtt_dispatch_worker.c
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+
+// --------------------------------------------------
+// システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#include "core_mqtt.h"
+#include "mqtt_subscription_manager.h"
+
+// --------------------------------------------------
+// ユーザ作成ヘッダの取り込み
+// --------------------------------------------------
+#include "common/include/application_define.h"
+#include "config/task_config.h"
+#include "config/mqtt_config.h"
+
+#include "tasks/mqtt/private/include/mqtt_dispatch_worker.h"
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#defineマクロ
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#define関数マクロ
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するtypedef定義
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するenumタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するstruct/unionタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+/**
+ * @brief Dispatch Workerで実行するコールバック関数と引数の組み合わせ
+ */
+typedef struct
+{
+    IncomingPubCallback_t xIncomingCallback; /**< コールバック関数。NULLの場合は未使用 */
+    void *pvIncomingCallbackContext;         /**< コールバック関数に渡す引数 */
+} MQTTDispatchSubscriber_t;
+
+/**
+ * @brief 受信したPublishをDispatch Workerに渡すためのバッファ
+ */
+typedef struct
+{
+    const MQTTDispatchSubscriber_t *pxSubscriber; /**< 実行するコールバック関数 */
+    MQTTQoS_t eQoS;                               /**< 受信したPublishのQoS */
+    bool bRetain;                                 /**< 受信したPublishのRetainフラグ */
+    bool bDup;                                    /**< 受信したPublishのDupフラグ */
+    uint16_t uxTopicNameLength;                   /**< トピックの長さ */
+    size_t uxPayloadLength;                       /**< ペイロードの長さ */
+    uint8_t ucData[MQTT_BUFFER_SIZE];             /**< トピックとペイロードを続けて格納する */
+} MQTTDispatchBuffer_t;
+
+// --------------------------------------------------
+// ファイル内で共有するstatic変数宣言
+// --------------------------------------------------
+
+/**
+ * @brief Dispatch Workerで実行するコールバック関数の一覧
+ */
+static MQTTDispatchSubscriber_t gxDispatchSubscriberList[MQTT_DISPATCH_SUBSCRIBER_MAX_NUM];
+
+/**
+ * @brief バッファプール
+ */
+static MQTTDispatchBuffer_t gxDispatchBufferPool[MQTT_DISPATCH_BUFFER_POOL_NUM];
+
+/**
+ * @brief 空いているバッファのキュー
+ */
+static QueueHandle_t gxFreeBufferQueue = NULL;
+
+/**
+ * @brief Dispatch Workerが処理するバッファのキュー
+ */
+static QueueHandle_t gxDispatchQueue = NULL;
+
+/**
+ * @brief Dispatch Workerに渡したPublish数
+ */
+static uint32_t gulDispatchedCount = 0;
+
+/**
+ * @brief バッファプールに空きがない、またはバッファに収まらないため破棄したPublish数
+ */
+static uint32_t gulDroppedCount = 0;
+
+/**
+ * @brief Dispatch Workerのキューに溜まったPublish数の最大値
+ */
+static uint32_t gulMaxQueueDepth = 0;
+
+// --------------------------------------------------
+// static関数プロトタイプ宣言
+// --------------------------------------------------
+
+/**
+ * @brief Dispatch Workerタスクのエントリーポイント
+ *
+ * @param[in] pvParams 使用しない
+ */
+static void vprvMQTTDispatchTask(void *pvParams);
+
+// --------------------------------------------------
+// 変数定義（staticを除く）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 関数定義（staticを除く）
+// --------------------------------------------------
+
+bool bMQTTDispatchWorkerInit(void)
+{
+    // 既に作成済み
+    if (gxDispatchQueue != NULL)
+    {
+        return true;
+    }
+
+    memset(gxDispatchSubscriberList, 0x00, sizeof(gxDispatchSubscriberList));
+
+    gxFreeBufferQueue = xQueueCreate(MQTT_DISPATCH_BUFFER_POOL_NUM, sizeof(MQTTDispatchBuffer_t *));
+    gxDispatchQueue = xQueueCreate(MQTT_DISPATCH_BUFFER_POOL_NUM, sizeof(MQTTDispatchBuffer_t *));
+    if ((gxFreeBufferQueue == NULL) || (gxDispatchQueue == NULL))
+    {
+        APP_PRINTFError("Failed to create mqtt dispatch queue.");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < MQTT_DISPATCH_BUFFER_POOL_NUM; i++)
+    {
+        MQTTDispatchBuffer_t *pxBuffer = &gxDispatchBufferPool[i];
+        xQueueSendToBack(gxFreeBufferQueue, &pxBuffer, 0);
+    }
+
+    if (xTaskCreate(&vprvMQTTDispatchTask,
+                    "MQTT Dispatch Task",
+                    MQTT_DISPATCH_TASK_STACK_SIZE,
+                    NULL,
+                    MQTT_DISPATCH_TASK_PRIORITY,
+                    NULL) == pdFAIL)
+    {
+        APP_PRINTFError("MQTT dispatch task create failed.");
+        return false;
+    }
+
+    return true;
+}
+
+void *pvMQTTDispatchWorkerGetContext(IncomingPubCallback_t xIncomingCallback, void *pvIncomingCallbackContext)
+{
+    MQTTDispatchSubscriber_t *pxSubscriber = NULL;
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < MQTT_DISPATCH_SUBSCRIBER_MAX_NUM; i++)
+    {
+        // 登録済みの組み合わせを優先する
+        if ((gxDispatchSubscriberList[i].xIncomingCallback == xIncomingCallback) &&
+            (gxDispatchSubscriberList[i].pvIncomingCallbackContext == pvIncomingCallbackContext))
+        {
+            pxSubscriber = &gxDispatchSubscriberList[i];
+            break;
+        }
+
+        if ((pxSubscriber == NULL) && (gxDispatchSubscriberList[i].xIncomingCallback == NULL))
+        {
+            pxSubscriber = &gxDispatchSubscriberList[i];
+        }
+    }
+
+    if ((pxSubscriber != NULL) && (pxSubscriber->xIncomingCallback == NULL))
+    {
+        pxSubscriber->xIncomingCallback = xIncomingCallback;
+        pxSubscriber->pvIncomingCallbackContext = pvIncomingCallbackContext;
+    }
+    taskEXIT_CRITICAL();
+
+    if (pxSubscriber == NULL)
+    {
+        APP_PRINTFError("MQTT dispatch subscriber list is full.");
+    }
+    return pxSubscriber;
+}
+
+void vMQTTDispatchWorkerIncomingPublishCallback(void *pvIncomingCallbackContext, MQTTPublishInfo_t *pxPublishInfo)
+{
+    const MQTTDispatchSubscriber_t *pxSubscriber = (const MQTTDispatchSubscriber_t *)pvIncomingCallbackContext;
+
+    // MQTT Taskで実行するとキューに溜まったPublishより先に処理され順序が入れ替わるため、渡せない場合は破棄する
+    MQTTDispatchBuffer_t *pxBuffer = NULL;
+    if ((size_t)pxPublishInfo->topicNameLength + pxPublishInfo->payloadLength > sizeof(pxBuffer->ucData))
+    {
+        gulDroppedCount++;
+        APP_PRINTFError("MQTT dispatch dropped publish for %.*s; %u bytes exceed the dispatch buffer. Dropped: %u",
+                        pxPublishInfo->topicNameLength,
+                        pxPublishInfo->pTopicName,
+                        (uint32_t)pxPublishInfo->payloadLength,
+                        gulDroppedCount);
+        return;
+    }
+
+    // 空いているバッファを取得する。MQTT Taskを止めないため待機しない
+    if (xQueueReceive(gxFreeBufferQueue, &pxBuffer, 0) != pdPASS)
+    {
+        gulDroppedCount++;
+        APP_PRINTFError("MQTT dispatch dropped publish for %.*s; buffer pool is full. Dropped: %u",
+                        pxPublishInfo->topicNameLength,
+                        pxPublishInfo->pTopicName,
+                        gulDroppedCount);
+        return;
+    }
+
+    // 受信バッファはMQTT Taskが再利用するため、トピックとペイロードをコピーする
+    pxBuffer->pxSubscriber = pxSubscriber;
+    pxBuffer->eQoS = pxPublishInfo->qos;
+    pxBuffer->bRetain = pxPublishInfo->retain;
+    pxBuffer->bDup = pxPublishInfo->dup;
+    pxBuffer->uxTopicNameLength = pxPublishInfo->topicNameLength;
+    pxBuffer->uxPayloadLength = pxPublishInfo->payloadLength;
+    memcpy(&pxBuffer->ucData[0], pxPublishInfo->pTopicName, pxPublishInfo->topicNameLength);
+    memcpy(&pxBuffer->ucData[pxPublishInfo->topicNameLength], pxPublishInfo->pPayload, pxPublishInfo->payloadLength);
+
+    // バッファ数とキューの長さは一致するため、必ず追加できる
+    xQueueSendToBack(gxDispatchQueue, &pxBuffer, 0);
+    gulDispatchedCount++;
+
+    uint32_t ulQueueDepth = (uint32_t)uxQueueMessagesWaiting(gxDispatchQueue);
+    if (ulQueueDepth > gulMaxQueueDepth)
+    {
+        gulMaxQueueDepth = ulQueueDepth;
+    }
+}
+
+void vMQTTDispatchWorkerPrintStats(void)
+{
+    APP_PRINTFInfo("MQTT dispatch: dispatched=%u, dropped=%u, max queue depth=%u",
+                   gulDispatchedCount,
+                   gulDroppedCount,
+                   gulMaxQueueDepth);
+}
+
+// --------------------------------------------------
+// static関数定義
+// --------------------------------------------------
+
+static void vprvMQTTDispatchTask(void *pvParams)
+{
+    (void)pvParams; // 使用しない
+
+    while (true)
+    {
+        MQTTDispatchBuffer_t *pxBuffer = NULL;
+        if (xQueueReceive(gxDispatchQueue, &pxBuffer, portMAX_DELAY) != pdPASS)
+        {
+            continue;
+        }
+
+        // バッファからPublish情報を復元してコールバック関数を実行
+        MQTTPublishInfo_t xPublishInfo = {
+            .qos = pxBuffer->eQoS,
+            .retain = pxBuffer->bRetain,
+            .dup = pxBuffer->bDup,
+            .pTopicName = (const char *)&pxBuffer->ucData[0],
+            .topicNameLength = pxBuffer->uxTopicNameLength,
+            .pPayload = &pxBuffer->ucData[pxBuffer->uxTopicNameLength],
+            .payloadLength = pxBuffer->uxPayloadLength,
+        };
+        pxBuffer->pxSubscriber->xIncomingCallback(pxBuffer->pxSubscriber->pvIncomingCallbackContext, &xPublishInfo);
+
+        // バッファを返却
+        xQueueSendToBack(gxFreeBufferQueue, &pxBuffer, 0);
+    }
+}
+
+// --------------------------------------------------
+// Unit Test用関数定義(関数のプロトタイプ宣言は「自身のファイル名+ "_test.h"」で宣言されていること)
+// --------------------------------------------------
+#if (BUILD_MODE_TEST == 1) /* BUILD_MODE_TESTが定義されているとき */
+#endif                     /* end  BUILD_MODE_TEST */
@@ -0,0 +1,410 @@
+/**
+ * @file mqtt_metrics.c
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+
+// --------------------------------------------------
+// システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "transport_interface.h"
+
+// --------------------------------------------------
+// ユーザ作成ヘッダの取り込み
+// --------------------------------------------------
+#include "common/include/application_define.h"
+#include "config/mqtt_config.h"
+
+#include "tasks/mqtt/private/include/mqtt_metrics.h"
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#defineマクロ
+// --------------------------------------------------
+
+/**
+ * @brief 完了までの時間のヒストグラムの区間数。最後の区間は上限なし
+ */
+#define MQTT_METRICS_LATENCY_BUCKET_NUM (7U)
+
+/**
+ * @brief 固定ヘッダの先頭バイトからパケット種別を取り出すマスク
+ */
+#define MQTT_METRICS_PACKET_TYPE_MASK (0xF0U)
+
+/**
+ * @brief PINGREQのパケット種別
+ */
+#define MQTT_METRICS_PACKET_TYPE_PINGREQ (0xC0U)
+
+/**
+ * @brief PINGRESPのパケット種別
+ */
+#define MQTT_METRICS_PACKET_TYPE_PINGRESP (0xD0U)
+
+/**
+ * @brief PINGREQのパケット長
+ */
+#define MQTT_METRICS_PINGREQ_PACKET_LENGTH (2U)
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#define関数マクロ
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するtypedef定義
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するenumタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するstruct/unionタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+/**
+ * @brief コマンドの完了までの時間の統計情報
+ */
+typedef struct
+{
+    uint32_t ulCount;                                   /**< 完了したコマンド数 */
+    uint32_t ulFailCount;                               /**< 失敗したコマンド数 */
+    uint32_t ulTotalMs;                                 /**< 完了までの時間の合計 */
+    uint32_t ulMaxMs;                                   /**< 完了までの時間の最大値 */
+    uint32_t ulBucket[MQTT_METRICS_LATENCY_BUCKET_NUM]; /**< 完了までの時間のヒストグラム */
+} MQTTMetricsLatency_t;
+
+/**
+ * @brief MQTT通信のメトリクス
+ */
+typedef struct
+{
+    TickType_t xStartTick; /**< 計測を開始した時間 */
+
+    MQTTMetricsLatency_t xLatency[MQTT_METRICS_COMMAND_NUM]; /**< コマンドの種類ごとの完了までの時間 */
+
+    uint32_t ulQueueDepthSampleCount; /**< コマンドキューの滞留数を記録した回数 */
+    uint32_t ulQueueDepthTotal;       /**< コマンドキューの滞留数の合計 */
+    uint32_t ulQueueDepthMax;         /**< コマンドキューの滞留数の最大値 */
+
+    uint32_t ulBytesSent;     /**< 送信したバイト数 */
+    uint32_t ulBytesReceived; /**< 受信したバイト数 */
+
+    uint32_t ulReconnectAttemptCount; /**< 再接続を試行した回数 */
+    uint32_t ulReconnectSuccessCount; /**< 再接続に成功した回数 */
+
+    TickType_t xPingRequestTick; /**< PINGREQを送信した時間 */
+    bool bIsPingPending;         /**< PINGRESPを待っているか */
+    uint32_t ulPingCount;        /**< KeepAliveの往復時間を計測した回数 */
+    uint32_t ulPingLastRttMs;    /**< 直近のKeepAliveの往復時間 */
+    uint32_t ulPingMaxRttMs;     /**< KeepAliveの往復時間の最大値 */
+} MQTTMetrics_t;
+
+// --------------------------------------------------
+// ファイル内で共有するstatic変数宣言
+// --------------------------------------------------
+
+/**
+ * @brief ヒストグラムの各区間の上限[ms]。最後の区間は上限なし
+ */
+static const uint32_t gulLatencyBucketUpperMs[MQTT_METRICS_LATENCY_BUCKET_NUM - 1] = {10U, 50U, 100U, 500U, 1000U, 5000U};
+
+/**
+ * @brief JSONのキーとして使用するコマンドの種類の名前
+ */
+static const char *const gpcCommandName[MQTT_METRICS_COMMAND_NUM] = {"pub", "sub", "uns"};
+
+/**
+ * @brief 実際にデータを送信するトランスポート層の送信関数
+ */
+static TransportSend_t gxTransportSend = NULL;
+
+/**
+ * @brief 実際にデータを受信するトランスポート層の受信関数
+ */
+static TransportRecv_t gxTransportRecv = NULL;
+
+/**
+ * @brief MQTT通信のメトリクス
+ *
+ * @details
+ * 複数のタスクから更新されるため、クリティカルセクション内でアクセスする
+ */
+static MQTTMetrics_t gxMetrics;
+
+// --------------------------------------------------
+// static関数プロトタイプ宣言
+// --------------------------------------------------
+
+/**
+ * @brief メトリクスの複製を取得する
+ *
+ * @param[out] pxMetrics メトリクスの複製
+ */
+static void vprvGetMetrics(MQTTMetrics_t *pxMetrics);
+
+// --------------------------------------------------
+// 変数定義（staticを除く）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 関数定義（staticを除く）
+// --------------------------------------------------
+
+void vMQTTMetricsInit(TransportSend_t xTransportSend, TransportRecv_t xTransportRecv)
+{
+    taskENTER_CRITICAL();
+    gxTransportSend = xTransportSend;
+    gxTransportRecv = xTransportRecv;
+    memset(&gxMetrics, 0x00, sizeof(gxMetrics));
+    gxMetrics.xStartTick = xTaskGetTickCount();
+    taskEXIT_CRITICAL();
+}
+
+int32_t lMQTTMetricsTransportSend(NetworkContext_t *pNetworkContext, const void *pBuffer, size_t bytesToSend)
+{
+    const uint8_t *pucBuffer = (const uint8_t *)pBuffer;
+
+    // PINGREQは2バイトで一度に送信される
+    bool bIsPingRequest = (bytesToSend == MQTT_METRICS_PINGREQ_PACKET_LENGTH) &&
+                          (pucBuffer[0] == MQTT_METRICS_PACKET_TYPE_PINGREQ) &&
+                          (pucBuffer[1] == 0x00U);
+    TickType_t xSendTick = xTaskGetTickCount();
+
+    int32_t lResult = gxTransportSend(pNetworkContext, pBuffer, bytesToSend);
+    if (lResult > 0)
+    {
+        taskENTER_CRITICAL();
+        gxMetrics.ulBytesSent += (uint32_t)lResult;
+        if (bIsPingRequest == true)
+        {
+            gxMetrics.xPingRequestTick = xSendTick;
+            gxMetrics.bIsPingPending = true;
+        }
+        taskEXIT_CRITICAL();
+    }
+    return lResult;
+}
+
+int32_t lMQTTMetricsTransportRecv(NetworkContext_t *pNetworkContext, void *pBuffer, size_t bytesToRecv)
+{
+    int32_t lResult = gxTransportRecv(pNetworkContext, pBuffer, bytesToRecv);
+    if (lResult > 0)
+    {
+        taskENTER_CRITICAL();
+        gxMetrics.ulBytesReceived += (uint32_t)lResult;
+        taskEXIT_CRITICAL();
+    }
+
+    // coreMQTTは固定ヘッダの先頭バイトを1バイトだけ読み込むため、KeepAliveの応答待ちの場合はPINGRESPか判定する
+    if ((lResult == 1) && (bytesToRecv == 1U))
+    {
+        vMQTTMetricsRecordIncomingPacket(*(const uint8_t *)pBuffer);
+    }
+    return lResult;
+}
+
+void vMQTTMetricsRecordCommandLatency(MQTTMetricsCommandType_t eCommandType, TickType_t xEnqueueTick, bool bIsSuccess)
+{
+    if (eCommandType >= MQTT_METRICS_COMMAND_NUM)
+    {
+        return;
+    }
+
+    uint32_t ulLatencyMs = (uint32_t)(xTaskGetTickCount() - xEnqueueTick) * portTICK_PERIOD_MS;
+    size_t uxBucket = 0;
+    while ((uxBucket < (MQTT_METRICS_LATENCY_BUCKET_NUM - 1)) && (ulLatencyMs > gulLatencyBucketUpperMs[uxBucket]))
+    {
+        uxBucket++;
+    }
+
+    taskENTER_CRITICAL();
+    MQTTMetricsLatency_t *pxLatency = &gxMetrics.xLatency[eCommandType];
+    pxLatency->ulCount++;
+    if (bIsSuccess != true)
+    {
+        pxLatency->ulFailCount++;
+    }
+    pxLatency->ulTotalMs += ulLatencyMs;
+    if (ulLatencyMs > pxLatency->ulMaxMs)
+    {
+        pxLatency->ulMaxMs = ulLatencyMs;
+    }
+    pxLatency->ulBucket[uxBucket]++;
+    taskEXIT_CRITICAL();
+}
+
+void vMQTTMetricsRecordQueueDepth(UBaseType_t uxQueueDepth)
+{
+    taskENTER_CRITICAL();
+    gxMetrics.ulQueueDepthSampleCount++;
+    gxMetrics.ulQueueDepthTotal += (uint32_t)uxQueueDepth;
+    if ((uint32_t)uxQueueDepth > gxMetrics.ulQueueDepthMax)
+    {
+        gxMetrics.ulQueueDepthMax = (uint32_t)uxQueueDepth;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void vMQTTMetricsRecordReconnectAttempt(void)
+{
+    taskENTER_CRITICAL();
+    gxMetrics.ulReconnectAttemptCount++;
+    // 切断前に送信したPINGREQの応答は届かない
+    gxMetrics.bIsPingPending = false;
+    taskEXIT_CRITICAL();
+}
+
+void vMQTTMetricsRecordReconnectSuccess(void)
+{
+    taskENTER_CRITICAL();
+    gxMetrics.ulReconnectSuccessCount++;
+    taskEXIT_CRITICAL();
+}
+
+void vMQTTMetricsRecordIncomingPacket(uint8_t ucFixedHeaderFirstByte)
+{
+    if ((ucFixedHeaderFirstByte & MQTT_METRICS_PACKET_TYPE_MASK) != MQTT_METRICS_PACKET_TYPE_PINGRESP)
+    {
+        return;
+    }
+
+    TickType_t xNowTick = xTaskGetTickCount();
+
+    taskENTER_CRITICAL();
+    if (gxMetrics.bIsPingPending == true)
+    {
+        uint32_t ulRttMs = (uint32_t)(xNowTick - gxMetrics.xPingRequestTick) * portTICK_PERIOD_MS;
+        gxMetrics.bIsPingPending = false;
+        gxMetrics.ulPingCount++;
+        gxMetrics.ulPingLastRttMs = ulRttMs;
+        if (ulRttMs > gxMetrics.ulPingMaxRttMs)
+        {
+            gxMetrics.ulPingMaxRttMs = ulRttMs;
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+size_t uxMQTTMetricsFormatSnapshot(char *pcBuffer, size_t uxBufferSize)
+{
+    MQTTMetrics_t xMetrics;
+    vprvGetMetrics(&xMetrics);
+
+    uint32_t ulUptimeSeconds = (uint32_t)((xTaskGetTickCount() - xMetrics.xStartTick) / configTICK_RATE_HZ);
+    uint32_t ulQueueDepthAverage = (xMetrics.ulQueueDepthSampleCount == 0) ? 0 : (xMetrics.ulQueueDepthTotal / xMetrics.ulQueueDepthSampleCount);
+
+    int lLength = snprintf(pcBuffer, uxBufferSize,
+                           "{\"up\":%u,\"tx\":%u,\"rx\":%u,\"rc\":[%u,%u],\"rtt\":[%u,%u,%u],\"q\":[%u,%u]",
+                           ulUptimeSeconds,
+                           xMetrics.ulBytesSent,
+                           xMetrics.ulBytesReceived,
+                           xMetrics.ulReconnectAttemptCount,
+                           xMetrics.ulReconnectSuccessCount,
+                           xMetrics.ulPingCount,
+                           xMetrics.ulPingLastRttMs,
+                           xMetrics.ulPingMaxRttMs,
+                           xMetrics.ulQueueDepthMax,
+                           ulQueueDepthAverage);
+    if ((lLength < 0) || ((size_t)lLength >= uxBufferSize))
+    {
+        return 0;
+    }
+    size_t uxLength = (size_t)lLength;
+
+    // コマンドの種類ごとに [完了数, 失敗数, 最大時間, ヒストグラム...] とする
+    for (size_t i = 0; i < MQTT_METRICS_COMMAND_NUM; i++)
+    {
+        const MQTTMetricsLatency_t *pxLatency = &xMetrics.xLatency[i];
+        lLength = snprintf(&pcBuffer[uxLength], uxBufferSize - uxLength,
+                           ",\"%s\":[%u,%u,%u,%u,%u,%u,%u,%u,%u,%u]",
+                           gpcCommandName[i],
+                           pxLatency->ulCount,
+                           pxLatency->ulFailCount,
+                           pxLatency->ulMaxMs,
+                           pxLatency->ulBucket[0],
+                           pxLatency->ulBucket[1],
+                           pxLatency->ulBucket[2],
+                           pxLatency->ulBucket[3],
+                           pxLatency->ulBucket[4],
+                           pxLatency->ulBucket[5],
+                           pxLatency->ulBucket[6]);
+        if ((lLength < 0) || ((size_t)lLength >= (uxBufferSize - uxLength)))
+        {
+            return 0;
+        }
+        uxLength += (size_t)lLength;
+    }
+
+    if ((uxLength + 1U) >= uxBufferSize)
+    {
+        return 0;
+    }
+    pcBuffer[uxLength++] = '}';
+    pcBuffer[uxLength] = '\0';
+    return uxLength;
+}
+
+void vMQTTMetricsPrint(void)
+{
+    MQTTMetrics_t xMetrics;
+    vprvGetMetrics(&xMetrics);
+
+    uint32_t ulQueueDepthAverage = (xMetrics.ulQueueDepthSampleCount == 0) ? 0 : (xMetrics.ulQueueDepthTotal / xMetrics.ulQueueDepthSampleCount);
+
+    APP_PRINTFInfo("MQTT metrics: sent=%u bytes, received=%u bytes, reconnect=%u/%u, queue depth max=%u avg=%u",
+                   xMetrics.ulBytesSent,
+                   xMetrics.ulBytesReceived,
+                   xMetrics.ulReconnectSuccessCount,
+                   xMetrics.ulReconnectAttemptCount,
+                   xMetrics.ulQueueDepthMax,
+                   ulQueueDepthAverage);
+    APP_PRINTFInfo("MQTT metrics: keepalive count=%u, rtt last=%ums max=%ums",
+                   xMetrics.ulPingCount,
+                   xMetrics.ulPingLastRttMs,
+                   xMetrics.ulPingMaxRttMs);
+
+    for (size_t i = 0; i < MQTT_METRICS_COMMAND_NUM; i++)
+    {
+        const MQTTMetricsLatency_t *pxLatency = &xMetrics.xLatency[i];
+        uint32_t ulAverageMs = (pxLatency->ulCount == 0) ? 0 : (pxLatency->ulTotalMs / pxLatency->ulCount);
+        APP_PRINTFInfo("MQTT metrics: %s count=%u, failed=%u, avg=%ums, max=%ums, <=10ms:%u <=50ms:%u <=100ms:%u <=500ms:%u <=1s:%u <=5s:%u >5s:%u",
+                       gpcCommandName[i],
+                       pxLatency->ulCount,
+                       pxLatency->ulFailCount,
+                       ulAverageMs,
+                       pxLatency->ulMaxMs,
+                       pxLatency->ulBucket[0],
+                       pxLatency->ulBucket[1],
+                       pxLatency->ulBucket[2],
+                       pxLatency->ulBucket[3],
+                       pxLatency->ulBucket[4],
+                       pxLatency->ulBucket[5],
+                       pxLatency->ulBucket[6]);
+    }
+}
+
+// --------------------------------------------------
+// static関数定義
+// --------------------------------------------------
+
+static void vprvGetMetrics(MQTTMetrics_t *pxMetrics)
+{
+    taskENTER_CRITICAL();
+    *pxMetrics = gxMetrics;
+    taskEXIT_CRITICAL();
+}
+
+// --------------------------------------------------
+// Unit Test用関数定義(関数のプロトタイプ宣言は「自身のファイル名+ "_test.h"」で宣言されていること)
+// --------------------------------------------------
+#if (BUILD_MODE_TEST == 1) /* BUILD_MODE_TESTが定義されているとき */
+#endif                     /* end  BUILD_MODE_TEST */
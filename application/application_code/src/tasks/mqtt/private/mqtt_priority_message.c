@@ -0,0 +1,266 @@
+/**
+ * @file mqtt_priority_message.c
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+
+// --------------------------------------------------
+// システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include "core_mqtt_agent.h"
+
+// --------------------------------------------------
+// ユーザ作成ヘッダの取り込み
+// --------------------------------------------------
+#include "common/include/application_define.h"
+#include "config/queue_config.h"
+#include "config/mqtt_config.h"
+
+#include "tasks/mqtt/include/mqtt_operation_task.h"
+#include "tasks/mqtt/private/include/mqtt_priority_message.h"
+#include "tasks/mqtt/private/include/mqtt_metrics.h"
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#defineマクロ
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#define関数マクロ
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するtypedef定義
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するenumタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するstruct/unionタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+/**
+ * @brief コマンドキューに格納する要素
+ */
+typedef struct
+{
+    MQTTAgentCommand_t *pxCommand; /**< MQTT Agentのコマンド */
+    TickType_t xEnqueueTick;       /**< エンキューした時間 */
+} MQTTPriorityMessageItem_t;
+
+// --------------------------------------------------
+// ファイル内で共有するstatic変数宣言
+// --------------------------------------------------
+
+// --------------------------------------------------
+// static関数プロトタイプ宣言
+// --------------------------------------------------
+
+/**
+ * @brief コマンドの優先度を取得する
+ *
+ * @param[in] pxCommand MQTT Agentのコマンド
+ *
+ * @return MQTTCommandPriority_t コマンドの優先度
+ */
+static MQTTCommandPriority_t eprvGetCommandPriority(const MQTTAgentCommand_t *pxCommand);
+
+/**
+ * @brief 次にコマンドを取り出すキューを選択する
+ *
+ * @param[in,out] pxContext コンテキスト
+ *
+ * @return MQTTCommandPriority_t 取り出すキューの優先度
+ */
+static MQTTCommandPriority_t eprvSelectLane(MQTTPriorityMessageContext_t *pxContext);
+
+// --------------------------------------------------
+// 変数定義（staticを除く）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 関数定義（staticを除く）
+// --------------------------------------------------
+
+bool bMQTTPriorityMessageInit(MQTTPriorityMessageContext_t *pxContext)
+{
+    memset(pxContext, 0x00, sizeof(MQTTPriorityMessageContext_t));
+
+    pxContext->xLaneQueue[MQTT_COMMAND_PRIORITY_INTERACTIVE] = xQueueCreate(MQTT_AGENT_COMMAND_QUEUE_LENGTH,
+                                                                            sizeof(MQTTPriorityMessageItem_t));
+    pxContext->xLaneQueue[MQTT_COMMAND_PRIORITY_BULK] = xQueueCreate(MQTT_AGENT_BULK_COMMAND_QUEUE_LENGTH,
+                                                                     sizeof(MQTTPriorityMessageItem_t));
+    pxContext->xCommandCountSemaphore = xSemaphoreCreateCounting(MQTT_AGENT_COMMAND_QUEUE_LENGTH + MQTT_AGENT_BULK_COMMAND_QUEUE_LENGTH, 0);
+
+    if ((pxContext->xLaneQueue[MQTT_COMMAND_PRIORITY_INTERACTIVE] == NULL) ||
+        (pxContext->xLaneQueue[MQTT_COMMAND_PRIORITY_BULK] == NULL) ||
+        (pxContext->xCommandCountSemaphore == NULL))
+    {
+        APP_PRINTFError("Failed to create mqtt agent command queue.");
+        return false;
+    }
+
+    return true;
+}
+
+bool bMQTTPriorityMessageSend(MQTTAgentMessageContext_t *pMsgCtx,
+                              MQTTAgentCommand_t *const *pCommandToSend,
+                              uint32_t blockTimeMs)
+{
+    if ((pMsgCtx == NULL) || (pCommandToSend == NULL))
+    {
+        return false;
+    }
+
+    MQTTPriorityMessageContext_t *pxContext = (MQTTPriorityMessageContext_t *)pMsgCtx;
+    MQTTCommandPriority_t ePriority = eprvGetCommandPriority(*pCommandToSend);
+
+    MQTTPriorityMessageItem_t xItem = {
+        .pxCommand = *pCommandToSend,
+        .xEnqueueTick = xTaskGetTickCount(),
+    };
+
+    if (xQueueSendToBack(pxContext->xLaneQueue[ePriority], &xItem, pdMS_TO_TICKS(blockTimeMs)) != pdPASS)
+    {
+#if (MQTT_AGENT_ENABLE_QUEUE_STATS == 1)
+        taskENTER_CRITICAL();
+        pxContext->xStats[ePriority].ulSendFailCount++;
+        taskEXIT_CRITICAL();
+#endif
+        APP_PRINTFWarn("MQTT agent command queue is full. Priority: %d", ePriority);
+        return false;
+    }
+
+    // キューに追加してからカウントを増やすため、MQTT Taskがカウントを取得した時点で必ずいずれかのキューにコマンドがある
+    xSemaphoreGive(pxContext->xCommandCountSemaphore);
+
+#if (MQTT_METRICS_ENABLE == 1)
+    vMQTTMetricsRecordQueueDepth(uxQueueMessagesWaiting(pxContext->xLaneQueue[MQTT_COMMAND_PRIORITY_INTERACTIVE]) +
+                                 uxQueueMessagesWaiting(pxContext->xLaneQueue[MQTT_COMMAND_PRIORITY_BULK]));
+#endif
+    return true;
+}
+
+bool bMQTTPriorityMessageReceive(MQTTAgentMessageContext_t *pMsgCtx,
+                                 MQTTAgentCommand_t **pReceivedCommand,
+                                 uint32_t blockTimeMs)
+{
+    if ((pMsgCtx == NULL) || (pReceivedCommand == NULL))
+    {
+        return false;
+    }
+
+    MQTTPriorityMessageContext_t *pxContext = (MQTTPriorityMessageContext_t *)pMsgCtx;
+
+    if (xSemaphoreTake(pxContext->xCommandCountSemaphore, pdMS_TO_TICKS(blockTimeMs)) != pdTRUE)
+    {
+        return false;
+    }
+
+    MQTTCommandPriority_t eLane = eprvSelectLane(pxContext);
+    MQTTPriorityMessageItem_t xItem = {0x00};
+    if (xQueueReceive(pxContext->xLaneQueue[eLane], &xItem, 0) != pdPASS)
+    {
+        // ここには来ないが、念のためもう一方のキューも確認する
+        eLane = (eLane == MQTT_COMMAND_PRIORITY_INTERACTIVE) ? MQTT_COMMAND_PRIORITY_BULK : MQTT_COMMAND_PRIORITY_INTERACTIVE;
+        if (xQueueReceive(pxContext->xLaneQueue[eLane], &xItem, 0) != pdPASS)
+        {
+            APP_PRINTFError("MQTT agent command queue is inconsistent.");
+            return false;
+        }
+    }
+
+#if (MQTT_AGENT_ENABLE_QUEUE_STATS == 1)
+    // エンキューからMQTT Taskが取り出すまでの待ち時間を記録
+    uint32_t ulWaitTicks = (uint32_t)(xTaskGetTickCount() - xItem.xEnqueueTick);
+    MQTTPriorityMessageStats_t *pxStats = &pxContext->xStats[eLane];
+    pxStats->ulDequeueCount++;
+    pxStats->ulTotalWaitTicks += ulWaitTicks;
+    if (ulWaitTicks > pxStats->ulMaxWaitTicks)
+    {
+        pxStats->ulMaxWaitTicks = ulWaitTicks;
+        APP_PRINTFDebug("MQTT agent command queue max wait updated. Priority: %d, Wait: %u ms", eLane, ulWaitTicks * portTICK_PERIOD_MS);
+    }
+#endif
+
+    *pReceivedCommand = xItem.pxCommand;
+    return true;
+}
+
+#if (MQTT_AGENT_ENABLE_QUEUE_STATS == 1)
+void vMQTTPriorityMessagePrintStats(const MQTTPriorityMessageContext_t *pxContext)
+{
+    for (uint32_t i = 0; i < MQTT_COMMAND_PRIORITY_NUM; i++)
+    {
+        const MQTTPriorityMessageStats_t *pxStats = &pxContext->xStats[i];
+        uint32_t ulAverageWaitMs = (pxStats->ulDequeueCount == 0) ? 0 : (pxStats->ulTotalWaitTicks * portTICK_PERIOD_MS) / pxStats->ulDequeueCount;
+        APP_PRINTFInfo("MQTT agent command queue: priority=%u, count=%u, average wait=%u ms, max wait=%u ms, send failed=%u",
+                       i,
+                       pxStats->ulDequeueCount,
+                       ulAverageWaitMs,
+                       pxStats->ulMaxWaitTicks * portTICK_PERIOD_MS,
+                       pxStats->ulSendFailCount);
+    }
+}
+#endif
+
+// --------------------------------------------------
+// static関数定義
+// --------------------------------------------------
+
+static MQTTCommandPriority_t eprvGetCommandPriority(const MQTTAgentCommand_t *pxCommand)
+{
+    // コンテキストを持たないコマンドは対話系とする
+    if ((pxCommand == NULL) || (pxCommand->pCmdContext == NULL))
+    {
+        return MQTT_COMMAND_PRIORITY_INTERACTIVE;
+    }
+
+    MQTTCommandPriority_t ePriority = pxCommand->pCmdContext->ePriority;
+    if ((ePriority != MQTT_COMMAND_PRIORITY_INTERACTIVE) && (ePriority != MQTT_COMMAND_PRIORITY_BULK))
+    {
+        return MQTT_COMMAND_PRIORITY_INTERACTIVE;
+    }
+
+    return ePriority;
+}
+
+static MQTTCommandPriority_t eprvSelectLane(MQTTPriorityMessageContext_t *pxContext)
+{
+    bool bInteractiveWaiting = (uxQueueMessagesWaiting(pxContext->xLaneQueue[MQTT_COMMAND_PRIORITY_INTERACTIVE]) > 0) ? true : false;
+    bool bBulkWaiting = (uxQueueMessagesWaiting(pxContext->xLaneQueue[MQTT_COMMAND_PRIORITY_BULK]) > 0) ? true : false;
+
+    if (bInteractiveWaiting == true)
+    {
+        if (bBulkWaiting == false)
+        {
+            pxContext->uxConsecutiveInteractiveCount = 0;
+            return MQTT_COMMAND_PRIORITY_INTERACTIVE;
+        }
+
+        // 一括系が待っていても、上限回数までは対話系を優先する
+        if (pxContext->uxConsecutiveInteractiveCount < MQTT_AGENT_BULK_STARVATION_LIMIT)
+        {
+            pxContext->uxConsecutiveInteractiveCount++;
+            return MQTT_COMMAND_PRIORITY_INTERACTIVE;
+        }
+    }
+
+    pxContext->uxConsecutiveInteractiveCount = 0;
+    return MQTT_COMMAND_PRIORITY_BULK;
+}
+
+// --------------------------------------------------
+// Unit Test用関数定義(関数のプロトタイプ宣言は「自身のファイル名+ "_test.h"」で宣言されていること)
+// --------------------------------------------------
+#if (BUILD_MODE_TEST == 1) /* BUILD_MODE_TESTが定義されているとき */
+#endif                     /* end  BUILD_MODE_TEST */
@@ -0,0 +1,668 @@
+/**
+ * @file mqtt_stream_receive.c
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+
+// --------------------------------------------------
+// システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "core_mqtt.h"
+#include "transport_interface.h"
+
+// --------------------------------------------------
+// ユーザ作成ヘッダの取り込み
+// --------------------------------------------------
+#include "common/include/application_define.h"
+#include "config/mqtt_config.h"
+
+#include "tasks/mqtt/include/mqtt_operation_task.h"
+#include "tasks/mqtt/private/include/mqtt_stream_receive.h"
+#include "tasks/mqtt/private/include/mqtt_metrics.h"
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#defineマクロ
+// --------------------------------------------------
+
+/**
+ * @brief 固定ヘッダの先頭バイトからパケット種別を取り出すマスク
+ */
+#define MQTT_STREAM_PACKET_TYPE_MASK (0xF0U)
+
+/**
+ * @brief PUBLISHのパケット種別
+ */
+#define MQTT_STREAM_PACKET_TYPE_PUBLISH (0x30U)
+
+/**
+ * @brief 固定ヘッダの先頭バイトからPUBLISHのQoSを取り出すマスク
+ */
+#define MQTT_STREAM_PUBLISH_QOS_MASK (0x06U)
+
+/**
+ * @brief 固定ヘッダの最大長。パケット種別1バイトと残りの長さ最大4バイト
+ */
+#define MQTT_STREAM_FIXED_HEADER_MAX_LENGTH (5U)
+
+/**
+ * @brief PUBLISHの可変ヘッダの最大長。トピック長2バイト、トピック、パケットID2バイト
+ */
+#define MQTT_STREAM_VARIABLE_HEADER_MAX_LENGTH (2U + MQTT_STREAM_TOPIC_MAX_LENGTH + 2U)
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#define関数マクロ
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するtypedef定義
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するenumタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+/**
+ * @brief 受信中のパケットの状態
+ */
+typedef enum
+{
+    MQTT_STREAM_RECV_STATE_FIXED_HEADER = 0, /**< 固定ヘッダを読み込み中 */
+    MQTT_STREAM_RECV_STATE_VARIABLE_HEADER,  /**< PUBLISHの可変ヘッダを読み込み中 */
+    MQTT_STREAM_RECV_STATE_PAYLOAD,          /**< PUBLISHのペイロードをコールバック関数に渡している */
+    MQTT_STREAM_RECV_STATE_OUTPUT,           /**< 読み込み済みのヘッダをcoreMQTTに渡している */
+    MQTT_STREAM_RECV_STATE_PASSTHROUGH,      /**< パケットの残りをそのままcoreMQTTに渡している */
+} MQTTStreamReceiveState_t;
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するstruct/unionタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+/**
+ * @brief ストリーム受信を登録したトピックフィルタ
+ */
+typedef struct
+{
+    const char *pcTopicFilter;           /**< トピックフィルタ。NULLの場合は未使用 */
+    uint16_t usTopicFilterLength;        /**< トピックフィルタの長さ */
+    size_t uxMinPayloadLength;           /**< ストリーム受信とするペイロードの最小長 */
+    MQTTStreamChunkCallback_t xCallback; /**< ペイロードの断片を受け取るコールバック関数 */
+    void *pvContext;                     /**< コールバック関数に渡す引数 */
+} MQTTStreamSubscriber_t;
+
+/**
+ * @brief 受信中のパケットの情報
+ */
+typedef struct
+{
+    MQTTStreamReceiveState_t eState; /**< 受信状態 */
+
+    uint8_t ucFixedHeader[MQTT_STREAM_FIXED_HEADER_MAX_LENGTH]; /**< 読み込んだ固定ヘッダ */
+    size_t uxFixedHeaderLength;                                 /**< 読み込んだ固定ヘッダの長さ */
+    size_t uxRemainingLength;                                   /**< 固定ヘッダの残りの長さ */
+    size_t uxRemainingLengthMultiplier;                         /**< 残りの長さの次のバイトに掛ける値 */
+
+    uint8_t ucVariableHeader[MQTT_STREAM_VARIABLE_HEADER_MAX_LENGTH]; /**< 読み込んだPUBLISHの可変ヘッダ */
+    size_t uxVariableHeaderRead;                                      /**< 読み込んだ可変ヘッダの長さ */
+    size_t uxVariableHeaderLength;                                    /**< 可変ヘッダの長さ */
+
+    MQTTStreamSubscriber_t xSubscriber; /**< ペイロードを渡す登録先 */
+    size_t uxPayloadLength;             /**< ペイロードの長さ */
+    size_t uxPayloadOffset;             /**< コールバック関数に渡し終えたペイロードの長さ */
+    bool bIsAborted;                    /**< コールバック関数が残りの断片の破棄を要求した */
+    TickType_t xStartTick;              /**< ペイロードの受信を開始した時間 */
+
+    uint8_t ucOutput[MQTT_STREAM_FIXED_HEADER_MAX_LENGTH + MQTT_STREAM_VARIABLE_HEADER_MAX_LENGTH]; /**< coreMQTTに渡すヘッダ */
+    size_t uxOutputLength;                                                                          /**< coreMQTTに渡すヘッダの長さ */
+    size_t uxOutputOffset;                                                                          /**< coreMQTTに渡し終えたヘッダの長さ */
+    size_t uxPassthroughLength;                                                                     /**< そのままcoreMQTTに渡すパケットの残りの長さ */
+} MQTTStreamReceiveContext_t;
+
+/**
+ * @brief ストリーム受信の統計情報
+ */
+typedef struct
+{
+    uint32_t ulStreamedPublishCount; /**< ストリーム受信したPublish数 */
+    uint32_t ulAbortedPublishCount;  /**< コールバック関数が途中で破棄したPublish数 */
+    uint32_t ulChunkCount;           /**< コールバック関数に渡した断片の数 */
+    uint32_t ulTotalBytes;           /**< ストリーム受信したペイロードの合計 */
+    uint32_t ulMaxPayloadLength;     /**< ストリーム受信したペイロードの最大長 */
+    uint32_t ulTotalStreamTicks;     /**< ペイロードの受信にかかった時間の合計 */
+} MQTTStreamReceiveStats_t;
+
+// --------------------------------------------------
+// ファイル内で共有するstatic変数宣言
+// --------------------------------------------------
+
+/**
+ * @brief ストリーム受信を登録したトピックフィルタの一覧
+ */
+static MQTTStreamSubscriber_t gxStreamSubscriberList[MQTT_STREAM_SUBSCRIBER_MAX_NUM];
+
+/**
+ * @brief 実際にデータを受信するトランスポート層の受信関数
+ */
+static TransportRecv_t gxTransportRecv = NULL;
+
+/**
+ * @brief 受信中のパケットの情報。MQTT Taskからのみアクセスする
+ */
+static MQTTStreamReceiveContext_t gxStreamReceiveContext;
+
+/**
+ * @brief コールバック関数に渡すペイロードの断片を格納するバッファ
+ */
+static uint8_t gucChunkBuffer[MQTT_STREAM_CHUNK_SIZE];
+
+/**
+ * @brief ペイロードを取り除いたPublishをcoreMQTTに渡したか
+ */
+static bool gbIsStreamedPublishPending = false;
+
+/**
+ * @brief ストリーム受信の統計情報
+ */
+static MQTTStreamReceiveStats_t gxStreamReceiveStats;
+
+// --------------------------------------------------
+// static関数プロトタイプ宣言
+// --------------------------------------------------
+
+/**
+ * @brief 次のパケットを受信できる状態にする
+ */
+static void vprvStartNextPacket(void);
+
+/**
+ * @brief 読み込み済みのヘッダをcoreMQTTに渡し、パケットの残りをそのまま渡す状態にする
+ */
+static void vprvStartPassthrough(void);
+
+/**
+ * @brief ペイロードを取り除いたPublishをcoreMQTTに渡す状態にする
+ */
+static void vprvStartStrippedPublish(void);
+
+/**
+ * @brief 固定ヘッダを1バイト読み込む
+ *
+ * @param[in] pNetworkContext ネットワークコンテキスト
+ *
+ * @return int32_t 読み込めた場合は正の値、データがない場合は0、エラーの場合は負の値
+ */
+static int32_t lprvReadFixedHeader(NetworkContext_t *pNetworkContext);
+
+/**
+ * @brief PUBLISHの可変ヘッダを読み込む
+ *
+ * @param[in] pNetworkContext ネットワークコンテキスト
+ *
+ * @return int32_t 読み込めた場合は正の値、データがない場合は0、エラーの場合は負の値
+ */
+static int32_t lprvReadVariableHeader(NetworkContext_t *pNetworkContext);
+
+/**
+ * @brief PUBLISHのペイロードを読み込み、コールバック関数に渡す
+ *
+ * @param[in] pNetworkContext ネットワークコンテキスト
+ *
+ * @return int32_t ペイロードをすべて渡し終えた場合は正の値、データがない場合は0、エラーの場合は負の値
+ */
+static int32_t lprvReadPayload(NetworkContext_t *pNetworkContext);
+
+/**
+ * @brief トピックに一致するストリーム受信の登録先を探す
+ *
+ * @param[in]  pcTopicName       トピック
+ * @param[in]  usTopicNameLength トピックの長さ
+ * @param[in]  uxPayloadLength   ペイロードの長さ
+ * @param[out] pxSubscriber      見つかった登録先
+ *
+ * @retval true  見つかった
+ * @retval false 見つからなかった
+ */
+static bool bprvFindSubscriber(const char *pcTopicName,
+                               const uint16_t usTopicNameLength,
+                               const size_t uxPayloadLength,
+                               MQTTStreamSubscriber_t *pxSubscriber);
+
+// --------------------------------------------------
+// 変数定義（staticを除く）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 関数定義（staticを除く）
+// --------------------------------------------------
+
+void vMQTTStreamReceiveInit(TransportRecv_t xTransportRecv)
+{
+    gxTransportRecv = xTransportRecv;
+    memset(gxStreamSubscriberList, 0x00, sizeof(gxStreamSubscriberList));
+    memset(&gxStreamReceiveStats, 0x00, sizeof(gxStreamReceiveStats));
+    vMQTTStreamReceiveReset();
+}
+
+void vMQTTStreamReceiveReset(void)
+{
+    gbIsStreamedPublishPending = false;
+    vprvStartNextPacket();
+}
+
+int32_t lMQTTStreamReceiveRecv(NetworkContext_t *pNetworkContext, void *pBuffer, size_t bytesToRecv)
+{
+    MQTTStreamReceiveContext_t *pxContext = &gxStreamReceiveContext;
+
+    for (;;)
+    {
+        int32_t lResult = 0;
+        switch (pxContext->eState)
+        {
+        case MQTT_STREAM_RECV_STATE_OUTPUT:
+        {
+            // 読み込み済みのヘッダをcoreMQTTに渡す
+            size_t uxCopyLength = pxContext->uxOutputLength - pxContext->uxOutputOffset;
+            uxCopyLength = (uxCopyLength < bytesToRecv) ? uxCopyLength : bytesToRecv;
+            memcpy(pBuffer, &pxContext->ucOutput[pxContext->uxOutputOffset], uxCopyLength);
+            pxContext->uxOutputOffset += uxCopyLength;
+            if (pxContext->uxOutputOffset >= pxContext->uxOutputLength)
+            {
+                if (pxContext->uxPassthroughLength > 0)
+                {
+                    pxContext->eState = MQTT_STREAM_RECV_STATE_PASSTHROUGH;
+                }
+                else
+                {
+                    vprvStartNextPacket();
+                }
+            }
+            return (int32_t)uxCopyLength;
+        }
+
+        case MQTT_STREAM_RECV_STATE_PASSTHROUGH:
+        {
+            // パケットの残りはバッファを介さずにcoreMQTTに渡す
+            size_t uxRecvLength = (pxContext->uxPassthroughLength < bytesToRecv) ? pxContext->uxPassthroughLength : bytesToRecv;
+            lResult = gxTransportRecv(pNetworkContext, pBuffer, uxRecvLength);
+            if (lResult > 0)
+            {
+                pxContext->uxPassthroughLength -= (size_t)lResult;
+                if (pxContext->uxPassthroughLength == 0)
+                {
+                    vprvStartNextPacket();
+                }
+            }
+            return lResult;
+        }
+
+        case MQTT_STREAM_RECV_STATE_FIXED_HEADER:
+            lResult = lprvReadFixedHeader(pNetworkContext);
+            break;
+
+        case MQTT_STREAM_RECV_STATE_VARIABLE_HEADER:
+            lResult = lprvReadVariableHeader(pNetworkContext);
+            break;
+
+        case MQTT_STREAM_RECV_STATE_PAYLOAD:
+            lResult = lprvReadPayload(pNetworkContext);
+            break;
+
+        default:
+            APP_PRINTFError("Invalid stream receive state: %d", pxContext->eState);
+            return -1;
+        }
+
+        // データがない場合は読み込み途中の状態を保持したまま戻り、次の呼び出しで続きから読み込む
+        if (lResult <= 0)
+        {
+            return lResult;
+        }
+    }
+}
+
+bool bMQTTStreamReceiveRegister(const char *pcTopicFilter,
+                                const uint16_t usTopicFilterLength,
+                                const size_t uxMinPayloadLength,
+                                const MQTTStreamChunkCallback_t xCallback,
+                                void *pvContext)
+{
+    MQTTStreamSubscriber_t *pxFreeSubscriber = NULL;
+    bool bIsRegistered = false;
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < MQTT_STREAM_SUBSCRIBER_MAX_NUM; i++)
+    {
+        MQTTStreamSubscriber_t *pxSubscriber = &gxStreamSubscriberList[i];
+        if (pxSubscriber->pcTopicFilter == NULL)
+        {
+            if (pxFreeSubscriber == NULL)
+            {
+                pxFreeSubscriber = pxSubscriber;
+            }
+            continue;
+        }
+
+        // 同じトピックフィルタが登録済みの場合は上書きする
+        if ((pxSubscriber->usTopicFilterLength == usTopicFilterLength) &&
+            (strncmp(pxSubscriber->pcTopicFilter, pcTopicFilter, usTopicFilterLength) == 0))
+        {
+            pxFreeSubscriber = pxSubscriber;
+            break;
+        }
+    }
+    if (pxFreeSubscriber != NULL)
+    {
+        pxFreeSubscriber->pcTopicFilter = pcTopicFilter;
+        pxFreeSubscriber->usTopicFilterLength = usTopicFilterLength;
+        pxFreeSubscriber->uxMinPayloadLength = uxMinPayloadLength;
+        pxFreeSubscriber->xCallback = xCallback;
+        pxFreeSubscriber->pvContext = pvContext;
+        bIsRegistered = true;
+    }
+    taskEXIT_CRITICAL();
+
+    return bIsRegistered;
+}
+
+void vMQTTStreamReceiveUnregister(const char *pcTopicFilter, const uint16_t usTopicFilterLength)
+{
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < MQTT_STREAM_SUBSCRIBER_MAX_NUM; i++)
+    {
+        MQTTStreamSubscriber_t *pxSubscriber = &gxStreamSubscriberList[i];
+        if ((pxSubscriber->pcTopicFilter != NULL) &&
+            (pxSubscriber->usTopicFilterLength == usTopicFilterLength) &&
+            (strncmp(pxSubscriber->pcTopicFilter, pcTopicFilter, usTopicFilterLength) == 0))
+        {
+            memset(pxSubscriber, 0x00, sizeof(MQTTStreamSubscriber_t));
+        }
+    }
+    taskEXIT_CRITICAL();
+}
+
+bool bMQTTStreamReceiveIsStreamedPublish(const MQTTPublishInfo_t *pxPublishInfo)
+{
+    // coreMQTTは受信したパケットを順番に処理するため、ペイロードを取り除いたPublishは直後の受信Publishとなる
+    if ((gbIsStreamedPublishPending == false) || (pxPublishInfo->payloadLength != 0))
+    {
+        return false;
+    }
+
+    gbIsStreamedPublishPending = false;
+    return true;
+}
+
+void vMQTTStreamReceivePrintStats(void)
+{
+    uint32_t ulTotalStreamMs = gxStreamReceiveStats.ulTotalStreamTicks * portTICK_PERIOD_MS;
+    uint32_t ulBytesPerSecond = (ulTotalStreamMs == 0) ? 0 : (uint32_t)(((uint64_t)gxStreamReceiveStats.ulTotalBytes * 1000U) / ulTotalStreamMs);
+
+    APP_PRINTFInfo("MQTT stream receive: publishes=%u, aborted=%u, chunks=%u, bytes=%u, max payload=%u, throughput=%u B/s, buffer=%u bytes",
+                   gxStreamReceiveStats.ulStreamedPublishCount,
+                   gxStreamReceiveStats.ulAbortedPublishCount,
+                   gxStreamReceiveStats.ulChunkCount,
+                   gxStreamReceiveStats.ulTotalBytes,
+                   gxStreamReceiveStats.ulMaxPayloadLength,
+                   ulBytesPerSecond,
+                   sizeof(gucChunkBuffer) + sizeof(gxStreamReceiveContext));
+}
+
+// --------------------------------------------------
+// static関数定義
+// --------------------------------------------------
+
+static void vprvStartNextPacket(void)
+{
+    memset(&gxStreamReceiveContext, 0x00, sizeof(gxStreamReceiveContext));
+    gxStreamReceiveContext.eState = MQTT_STREAM_RECV_STATE_FIXED_HEADER;
+    gxStreamReceiveContext.uxRemainingLengthMultiplier = 1;
+}
+
+static void vprvStartPassthrough(void)
+{
+    MQTTStreamReceiveContext_t *pxContext = &gxStreamReceiveContext;
+
+    // 読み込み済みの固定ヘッダと可変ヘッダを、受信した順にcoreMQTTに渡す
+    memcpy(&pxContext->ucOutput[0], pxContext->ucFixedHeader, pxContext->uxFixedHeaderLength);
+    memcpy(&pxContext->ucOutput[pxContext->uxFixedHeaderLength], pxContext->ucVariableHeader, pxContext->uxVariableHeaderRead);
+    pxContext->uxOutputLength = pxContext->uxFixedHeaderLength + pxContext->uxVariableHeaderRead;
+    pxContext->uxOutputOffset = 0;
+    pxContext->uxPassthroughLength = pxContext->uxRemainingLength - pxContext->uxVariableHeaderRead;
+    pxContext->eState = MQTT_STREAM_RECV_STATE_OUTPUT;
+}
+
+static void vprvStartStrippedPublish(void)
+{
+    MQTTStreamReceiveContext_t *pxContext = &gxStreamReceiveContext;
+    size_t uxOutputLength = 0;
+
+    // フラグはそのままにして、残りの長さを可変ヘッダのみの長さにする
+    pxContext->ucOutput[uxOutputLength++] = pxContext->ucFixedHeader[0];
+    size_t uxRemainingLength = pxContext->uxVariableHeaderLength;
+    do
+    {
+        uint8_t ucEncodedByte = (uint8_t)(uxRemainingLength % 128U);
+        uxRemainingLength /= 128U;
+        if (uxRemainingLength > 0)
+        {
+            ucEncodedByte |= 0x80U;
+        }
+        pxContext->ucOutput[uxOutputLength++] = ucEncodedByte;
+    } while (uxRemainingLength > 0);
+
+    memcpy(&pxContext->ucOutput[uxOutputLength], pxContext->ucVariableHeader, pxContext->uxVariableHeaderLength);
+    uxOutputLength += pxContext->uxVariableHeaderLength;
+
+    pxContext->uxOutputLength = uxOutputLength;
+    pxContext->uxOutputOffset = 0;
+    pxContext->uxPassthroughLength = 0;
+    pxContext->eState = MQTT_STREAM_RECV_STATE_OUTPUT;
+    gbIsStreamedPublishPending = true;
+}
+
+static int32_t lprvReadFixedHeader(NetworkContext_t *pNetworkContext)
+{
+    MQTTStreamReceiveContext_t *pxContext = &gxStreamReceiveContext;
+    uint8_t ucByte = 0;
+
+    int32_t lResult = gxTransportRecv(pNetworkContext, &ucByte, 1);
+    if (lResult <= 0)
+    {
+        return lResult;
+    }
+    pxContext->ucFixedHeader[pxContext->uxFixedHeaderLength++] = ucByte;
+
+    // パケット種別
+    if (pxContext->uxFixedHeaderLength == 1)
+    {
+        return lResult;
+    }
+
+    // 残りの長さ
+    pxContext->uxRemainingLength += (size_t)(ucByte & 0x7FU) * pxContext->uxRemainingLengthMultiplier;
+    pxContext->uxRemainingLengthMultiplier *= 128U;
+    if ((ucByte & 0x80U) != 0)
+    {
+        if (pxContext->uxFixedHeaderLength >= MQTT_STREAM_FIXED_HEADER_MAX_LENGTH)
+        {
+            APP_PRINTFError("Invalid remaining length in mqtt packet.");
+            return -1;
+        }
+        return lResult;
+    }
+
+#if (MQTT_METRICS_ENABLE == 1)
+    vMQTTMetricsRecordIncomingPacket(pxContext->ucFixedHeader[0]);
+#endif
+
+    // QoS2はPUBRELまでcoreMQTTがペイロードを保持する前提のため、対象外とする
+    uint8_t ucPacketType = pxContext->ucFixedHeader[0] & MQTT_STREAM_PACKET_TYPE_MASK;
+    uint8_t ucQoS = (pxContext->ucFixedHeader[0] & MQTT_STREAM_PUBLISH_QOS_MASK) >> 1;
+    if ((ucPacketType == MQTT_STREAM_PACKET_TYPE_PUBLISH) && (ucQoS <= (uint8_t)MQTTQoS1) && (pxContext->uxRemainingLength >= 2U))
+    {
+        // まずトピックの長さを読み込む
+        pxContext->uxVariableHeaderRead = 0;
+        pxContext->uxVariableHeaderLength = 2;
+        pxContext->eState = MQTT_STREAM_RECV_STATE_VARIABLE_HEADER;
+    }
+    else
+    {
+        vprvStartPassthrough();
+    }
+    return lResult;
+}
+
+static int32_t lprvReadVariableHeader(NetworkContext_t *pNetworkContext)
+{
+    MQTTStreamReceiveContext_t *pxContext = &gxStreamReceiveContext;
+
+    int32_t lResult = gxTransportRecv(pNetworkContext,
+                                      &pxContext->ucVariableHeader[pxContext->uxVariableHeaderRead],
+                                      pxContext->uxVariableHeaderLength - pxContext->uxVariableHeaderRead);
+    if (lResult <= 0)
+    {
+        return lResult;
+    }
+    pxContext->uxVariableHeaderRead += (size_t)lResult;
+    if (pxContext->uxVariableHeaderRead < pxContext->uxVariableHeaderLength)
+    {
+        return lResult;
+    }
+
+    // トピックの長さを読み込んだら、トピックとパケットIDの長さを可変ヘッダの長さにする
+    if (pxContext->uxVariableHeaderLength == 2U)
+    {
+        size_t uxTopicNameLength = ((size_t)pxContext->ucVariableHeader[0] << 8) | pxContext->ucVariableHeader[1];
+        size_t uxPacketIdLength = ((pxContext->ucFixedHeader[0] & MQTT_STREAM_PUBLISH_QOS_MASK) != 0) ? 2U : 0U;
+        if ((uxTopicNameLength == 0) ||
+            (uxTopicNameLength > MQTT_STREAM_TOPIC_MAX_LENGTH) ||
+            ((2U + uxTopicNameLength + uxPacketIdLength) > pxContext->uxRemainingLength))
+        {
+            vprvStartPassthrough();
+            return lResult;
+        }
+        pxContext->uxVariableHeaderLength = 2U + uxTopicNameLength + uxPacketIdLength;
+        return lResult;
+    }
+
+    // 可変ヘッダを読み込み終えたので、ストリーム受信の対象か判定する
+    pxContext->uxPayloadLength = pxContext->uxRemainingLength - pxContext->uxVariableHeaderLength;
+    uint16_t usTopicNameLength = (uint16_t)(((uint16_t)pxContext->ucVariableHeader[0] << 8) | pxContext->ucVariableHeader[1]);
+    if (bprvFindSubscriber((const char *)&pxContext->ucVariableHeader[2],
+                           usTopicNameLength,
+                           pxContext->uxPayloadLength,
+                           &pxContext->xSubscriber) == false)
+    {
+        vprvStartPassthrough();
+        return lResult;
+    }
+
+    APP_PRINTFDebug("Start stream receive. topic: %.*s, payload: %u bytes",
+                    usTopicNameLength, (const char *)&pxContext->ucVariableHeader[2], pxContext->uxPayloadLength);
+    pxContext->uxPayloadOffset = 0;
+    pxContext->bIsAborted = false;
+    pxContext->xStartTick = xTaskGetTickCount();
+    pxContext->eState = MQTT_STREAM_RECV_STATE_PAYLOAD;
+    return lResult;
+}
+
+static int32_t lprvReadPayload(NetworkContext_t *pNetworkContext)
+{
+    MQTTStreamReceiveContext_t *pxContext = &gxStreamReceiveContext;
+
+    while (pxContext->uxPayloadOffset < pxContext->uxPayloadLength)
+    {
+        size_t uxRecvLength = pxContext->uxPayloadLength - pxContext->uxPayloadOffset;
+        uxRecvLength = (uxRecvLength < sizeof(gucChunkBuffer)) ? uxRecvLength : sizeof(gucChunkBuffer);
+        int32_t lResult = gxTransportRecv(pNetworkContext, gucChunkBuffer, uxRecvLength);
+        if (lResult <= 0)
+        {
+            return lResult;
+        }
+
+        // 破棄を要求された場合は、パケットの区切りを保つために読み込みだけ行う
+        if (pxContext->bIsAborted == false)
+        {
+            const MQTTStreamChunk_t xChunk = {
+                .pcTopicName = (const char *)&pxContext->ucVariableHeader[2],
+                .usTopicNameLength = (uint16_t)(((uint16_t)pxContext->ucVariableHeader[0] << 8) | pxContext->ucVariableHeader[1]),
+                .pucData = gucChunkBuffer,
+                .uxDataLength = (size_t)lResult,
+                .uxOffset = pxContext->uxPayloadOffset,
+                .uxTotalLength = pxContext->uxPayloadLength,
+                .bIsLast = ((pxContext->uxPayloadOffset + (size_t)lResult) >= pxContext->uxPayloadLength),
+            };
+            if (pxContext->xSubscriber.xCallback(pxContext->xSubscriber.pvContext, &xChunk) == false)
+            {
+                APP_PRINTFWarn("Stream receive aborted by callback. offset: %u", pxContext->uxPayloadOffset);
+                pxContext->bIsAborted = true;
+                gxStreamReceiveStats.ulAbortedPublishCount++;
+            }
+            gxStreamReceiveStats.ulChunkCount++;
+        }
+        pxContext->uxPayloadOffset += (size_t)lResult;
+    }
+
+    // 統計情報の更新
+    gxStreamReceiveStats.ulStreamedPublishCount++;
+    gxStreamReceiveStats.ulTotalBytes += (uint32_t)pxContext->uxPayloadLength;
+    gxStreamReceiveStats.ulTotalStreamTicks += (uint32_t)(xTaskGetTickCount() - pxContext->xStartTick);
+    if (pxContext->uxPayloadLength > gxStreamReceiveStats.ulMaxPayloadLength)
+    {
+        gxStreamReceiveStats.ulMaxPayloadLength = (uint32_t)pxContext->uxPayloadLength;
+    }
+
+    // ペイロードを渡し終えたので、coreMQTTにはペイロードを取り除いたPublishを渡す
+    vprvStartStrippedPublish();
+    return 1;
+}
+
+static bool bprvFindSubscriber(const char *pcTopicName,
+                               const uint16_t usTopicNameLength,
+                               const size_t uxPayloadLength,
+                               MQTTStreamSubscriber_t *pxSubscriber)
+{
+    bool bIsFound = false;
+
+    if (uxPayloadLength == 0)
+    {
+        return false;
+    }
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0; i < MQTT_STREAM_SUBSCRIBER_MAX_NUM; i++)
+    {
+        const MQTTStreamSubscriber_t *pxCandidate = &gxStreamSubscriberList[i];
+        if ((pxCandidate->pcTopicFilter == NULL) || (uxPayloadLength < pxCandidate->uxMinPayloadLength))
+        {
+            continue;
+        }
+
+        bool bIsMatch = false;
+        if ((MQTT_MatchTopic(pcTopicName, usTopicNameLength,
+                             pxCandidate->pcTopicFilter, pxCandidate->usTopicFilterLength,
+                             &bIsMatch) == MQTTSuccess) &&
+            (bIsMatch == true))
+        {
+            // 受信中に登録が解除されても影響しないようにコピーする
+            *pxSubscriber = *pxCandidate;
+            bIsFound = true;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return bIsFound;
+}
+
+// --------------------------------------------------
+// Unit Test用関数定義(関数のプロトタイプ宣言は「自身のファイル名+ "_test.h"」で宣言されていること)
+// --------------------------------------------------
+#if (BUILD_MODE_TEST == 1) /* BUILD_MODE_TESTが定義されているとき */
+#endif                     /* end  BUILD_MODE_TEST */
@@ -0,0 +1,288 @@
+/**
+ * @file mqtt_transport.c
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+
+// --------------------------------------------------
+// システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "stream_buffer.h"
+
+#include "transport_interface.h"
+#include "transport_secure_sockets.h"
+
+// --------------------------------------------------
+// ユーザ作成ヘッダの取り込み
+// --------------------------------------------------
+#include "common/include/application_define.h"
+#include "config/mqtt_config.h"
+
+#include "tasks/mqtt/include/mqtt_operation_task.h"
+#include "tasks/mqtt/private/include/mqtt_transport.h"
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#defineマクロ
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#define関数マクロ
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するtypedef定義
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するenumタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するstruct/unionタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// ファイル内で共有するstatic変数宣言
+// --------------------------------------------------
+
+/**
+ * @brief MQTTからブローカー役へ向かうパイプ
+ */
+static StreamBufferHandle_t gxPipeToPeer = NULL;
+
+/**
+ * @brief ブローカー役からMQTTへ向かうパイプ
+ */
+static StreamBufferHandle_t gxPipeFromPeer = NULL;
+
+/**
+ * @brief パイプトランスポートが接続中か
+ */
+static volatile bool gbIsPipeConnected = false;
+
+// --------------------------------------------------
+// static関数プロトタイプ宣言
+// --------------------------------------------------
+
+/**
+ * @brief パイプトランスポートを初期化する
+ *
+ * @retval true  成功
+ * @retval false 失敗
+ */
+static bool bprvPipeInit(void);
+
+/**
+ * @brief パイプトランスポートを接続する。パイプに残っているデータは破棄する
+ *
+ * @param[in] pNetworkContext 使用しない
+ * @param[in] pServerInfo     使用しない
+ * @param[in] pSocketsConfig  使用しない
+ *
+ * @return TransportSocketStatus_t 接続結果
+ */
+static TransportSocketStatus_t xprvPipeConnect(NetworkContext_t *pNetworkContext,
+                                               const ServerInfo_t *pServerInfo,
+                                               const SocketsConfig_t *pSocketsConfig);
+
+/**
+ * @brief パイプトランスポートを切断する
+ *
+ * @param[in] pNetworkContext 使用しない
+ *
+ * @return TransportSocketStatus_t 切断結果
+ */
+static TransportSocketStatus_t xprvPipeDisconnect(const NetworkContext_t *pNetworkContext);
+
+/**
+ * @brief パイプトランスポートで送信する
+ *
+ * @param[in] pNetworkContext 使用しない
+ * @param[in] pBuffer         送信するデータ
+ * @param[in] bytesToSend     送信するデータの長さ
+ *
+ * @return int32_t 送信したバイト数。切断中は-1
+ */
+static int32_t lprvPipeSend(NetworkContext_t *pNetworkContext, const void *pBuffer, size_t bytesToSend);
+
+/**
+ * @brief パイプトランスポートで受信する
+ *
+ * @param[in]  pNetworkContext 使用しない
+ * @param[out] pBuffer         受信したデータを格納するバッファ
+ * @param[in]  bytesToRecv     受信するデータの長さ
+ *
+ * @return int32_t 受信したバイト数。データがない場合は0、切断中は-1
+ */
+static int32_t lprvPipeRecv(NetworkContext_t *pNetworkContext, void *pBuffer, size_t bytesToRecv);
+
+// --------------------------------------------------
+// 変数定義（staticを除く）
+// --------------------------------------------------
+
+/**
+ * @brief トランスポート層の実装一覧。MQTTTransportType_tの順に並べる
+ */
+static const MQTTTransport_t gxTransportList[] = {
+    [MQTT_TRANSPORT_TYPE_TLS] = {
+        .pcName = "tls",
+        .pcHostName = NULL,
+        .usPort = AWS_IOT_MQTT_PORT,
+        .bEnableTls = true,
+        .bInit = NULL,
+        .xConnect = &SecureSocketsTransport_Connect,
+        .xDisconnect = &SecureSocketsTransport_Disconnect,
+        .xSend = &SecureSocketsTransport_Send,
+        .xRecv = &SecureSocketsTransport_Recv,
+    },
+    [MQTT_TRANSPORT_TYPE_PLAINTEXT] = {
+        .pcName = "plaintext",
+        .pcHostName = MQTT_PLAINTEXT_BROKER_HOST_NAME,
+        .usPort = MQTT_PLAINTEXT_BROKER_PORT,
+        .bEnableTls = false,
+        .bInit = NULL,
+        .xConnect = &SecureSocketsTransport_Connect,
+        .xDisconnect = &SecureSocketsTransport_Disconnect,
+        .xSend = &SecureSocketsTransport_Send,
+        .xRecv = &SecureSocketsTransport_Recv,
+    },
+    [MQTT_TRANSPORT_TYPE_PIPE] = {
+        .pcName = "pipe",
+        .pcHostName = "pipe",
+        .usPort = 0,
+        .bEnableTls = false,
+        .bInit = &bprvPipeInit,
+        .xConnect = &xprvPipeConnect,
+        .xDisconnect = &xprvPipeDisconnect,
+        .xSend = &lprvPipeSend,
+        .xRecv = &lprvPipeRecv,
+    },
+};
+
+/**
+ * 平文のMQTTの接続先は計測環境ごとに異なるため既定値を持たない。
+ * 既定のトランスポート層に平文のMQTTを選択する場合は、#MQTT_PLAINTEXT_BROKER_HOST_NAME も設定する
+ */
+_Static_assert((MQTT_DEFAULT_TRANSPORT_TYPE != MQTT_TRANSPORT_TYPE_PLAINTEXT) || (sizeof(MQTT_PLAINTEXT_BROKER_HOST_NAME) > 1U),
+               "MQTT_PLAINTEXT_BROKER_HOST_NAME must be set to use MQTT_TRANSPORT_TYPE_PLAINTEXT");
+
+// --------------------------------------------------
+// 関数定義（staticを除く）
+// --------------------------------------------------
+
+const MQTTTransport_t *pxMQTTTransportGet(const MQTTTransportType_t eTransportType)
+{
+    if ((uint32_t)eTransportType >= (sizeof(gxTransportList) / sizeof(gxTransportList[0])))
+    {
+        APP_PRINTFError("Invalid mqtt transport type: %d", eTransportType);
+        return NULL;
+    }
+
+    // 接続先が設定されていないトランスポート層は使用できない
+    const MQTTTransport_t *pxTransport = &gxTransportList[eTransportType];
+    if ((pxTransport->pcHostName != NULL) && (pxTransport->pcHostName[0] == '\0'))
+    {
+        APP_PRINTFError("Host name of mqtt transport is not configured: %s", pxTransport->pcName);
+        return NULL;
+    }
+    return pxTransport;
+}
+
+size_t uxMQTTPipeTransportPeerRead(void *pvBuffer, const size_t uxBufferSize, const TickType_t xTicksToWait)
+{
+    if (gxPipeToPeer == NULL)
+    {
+        return 0;
+    }
+    return xStreamBufferReceive(gxPipeToPeer, pvBuffer, uxBufferSize, xTicksToWait);
+}
+
+size_t uxMQTTPipeTransportPeerWrite(const void *pvData, const size_t uxLength, const TickType_t xTicksToWait)
+{
+    if (gxPipeFromPeer == NULL)
+    {
+        return 0;
+    }
+    return xStreamBufferSend(gxPipeFromPeer, pvData, uxLength, xTicksToWait);
+}
+
+// --------------------------------------------------
+// static関数定義
+// --------------------------------------------------
+
+static bool bprvPipeInit(void)
+{
+    // 既に作成済み
+    if ((gxPipeToPeer != NULL) && (gxPipeFromPeer != NULL))
+    {
+        return true;
+    }
+
+    gxPipeToPeer = xStreamBufferCreate(MQTT_PIPE_TRANSPORT_BUFFER_SIZE, 1);
+    gxPipeFromPeer = xStreamBufferCreate(MQTT_PIPE_TRANSPORT_BUFFER_SIZE, 1);
+    if ((gxPipeToPeer == NULL) || (gxPipeFromPeer == NULL))
+    {
+        APP_PRINTFError("Failed to create pipe transport buffer.");
+        return false;
+    }
+    return true;
+}
+
+static TransportSocketStatus_t xprvPipeConnect(NetworkContext_t *pNetworkContext,
+                                               const ServerInfo_t *pServerInfo,
+                                               const SocketsConfig_t *pSocketsConfig)
+{
+    (void)pNetworkContext;
+    (void)pServerInfo;
+    (void)pSocketsConfig;
+
+    // 前回の接続で残ったデータを破棄する
+    (void)xStreamBufferReset(gxPipeToPeer);
+    (void)xStreamBufferReset(gxPipeFromPeer);
+    gbIsPipeConnected = true;
+    return TRANSPORT_SOCKET_STATUS_SUCCESS;
+}
+
+static TransportSocketStatus_t xprvPipeDisconnect(const NetworkContext_t *pNetworkContext)
+{
+    (void)pNetworkContext;
+
+    gbIsPipeConnected = false;
+    return TRANSPORT_SOCKET_STATUS_SUCCESS;
+}
+
+static int32_t lprvPipeSend(NetworkContext_t *pNetworkContext, const void *pBuffer, size_t bytesToSend)
+{
+    (void)pNetworkContext;
+
+    if (gbIsPipeConnected == false)
+    {
+        return -1;
+    }
+
+    // 空きがない場合は0を返し、coreMQTTに再送させる
+    return (int32_t)xStreamBufferSend(gxPipeToPeer, pBuffer, bytesToSend, 0);
+}
+
+static int32_t lprvPipeRecv(NetworkContext_t *pNetworkContext, void *pBuffer, size_t bytesToRecv)
+{
+    (void)pNetworkContext;
+
+    if (gbIsPipeConnected == false)
+    {
+        return -1;
+    }
+
+    return (int32_t)xStreamBufferReceive(gxPipeFromPeer, pBuffer, bytesToRecv, 0);
+}
+
+// --------------------------------------------------
+// Unit Test用関数定義(関数のプロトタイプ宣言は「自身のファイル名+ "_test.h"」で宣言されていること)
+// --------------------------------------------------
+#if (BUILD_MODE_TEST == 1) /* BUILD_MODE_TESTが定義されているとき */
+#endif                     /* end  BUILD_MODE_TEST */
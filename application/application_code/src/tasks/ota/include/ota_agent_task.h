@@ -86,6 +86,20 @@ extern "C"
      */
     OTAAgentTaskResult_t eOTAAgentTaskShutdown(void);
 
+    /**
+     * @brief ユーザー操作に応答する処理(解施錠、Shadowの送受信など)の開始を通知する
+     *
+     * @details
+     * vOTAAgentTaskEndInteractiveOperationで終了を通知するまで、FWのデータブロックの要求を止める。
+     * OTAAgentTaskが起動していなくても呼べる
+     */
+    void vOTAAgentTaskBeginInteractiveOperation(void);
+
+    /**
+     * @brief ユーザー操作に応答する処理の終了を通知する
+     */
+    void vOTAAgentTaskEndInteractiveOperation(void);
+
     // --------------------------------------------------
     // インライン関数
     // --------------------------------------------------
@@ -7,12 +7,13 @@
 // --------------------------------------------------
 // システムヘッダの取り込み
 // --------------------------------------------------
+#include <stdio.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdbool.h>
 
 #include "FreeRTOS.h"
-#include "semphr.h"
+#include "queue.h"
 
 #include "ota.h"
 #include "ota_config.h"
@@ -33,6 +34,12 @@
 #include "tasks/flash/include/flash_task.h"
 
 #include "tasks/ota/include/ota_agent_task.h"
+#include "tasks/ota/private/include/ota_download_scheduler.h"
+#if ((configENABLED_DATA_PROTOCOLS & OTA_DATA_OVER_HTTP) != 0)
+#    include "tasks/ota/private/include/ota_http_data_plane.h"
+#endif
+#include "tasks/ota/private/include/ota_resume_checkpoint.h"
+#include "tasks/ota/private/include/ota_staging_writer.h"
 
 // --------------------------------------------------
 // 自ファイル内でのみ使用する#defineマクロ
@@ -53,19 +60,29 @@
 #define OTA_AGENT_TOPIC_PREFIX_LENGTH ((uint16_t)(sizeof(OTA_AGENT_TOPIC_PREFIX) - 1))
 
 /**
- * @brief ジョブが通知されるトピック
+ * @brief ジョブが通知されるトピックのThingName以降の部分
  */
-#define OTA_AGENT_JOB_NOTIFY_TOPIC_FILTER OTA_AGENT_TOPIC_PREFIX "+/jobs/notify-next"
+#define OTA_AGENT_JOB_NOTIFY_TOPIC_FILTER_BODY "/jobs/notify-next"
 
 /**
- * @brief @ref OTA_AGENT_JOB_NOTIFY_TOPIC_FILTER の長さ(NULL文字含まず)
+ * @brief @ref OTA_AGENT_JOB_NOTIFY_TOPIC_FILTER_BODY の長さ(NULL文字含まず)
  */
-#define OTA_AGENT_JOB_NOTIFY_TOPIC_FILTER_LENGTH ((uint16_t)(sizeof(OTA_AGENT_JOB_NOTIFY_TOPIC_FILTER) - 1))
+#define OTA_AGENT_JOB_NOTIFY_TOPIC_FILTER_BODY_LENGTH ((uint16_t)(sizeof(OTA_AGENT_JOB_NOTIFY_TOPIC_FILTER_BODY) - 1))
 
 /**
- * @brief ファイルブロックが送られてくるトピック
+ * @brief ファイルブロックが送られてくるトピックのThingName以降の部分
  */
-#define OTA_AGENT_DATA_STREAM_TOPIC_FILTER OTA_AGENT_TOPIC_PREFIX "+/streams/#"
+#define OTA_AGENT_DATA_STREAM_TOPIC_FILTER_BODY "/streams/#"
+
+/**
+ * @brief @ref OTA_AGENT_DATA_STREAM_TOPIC_FILTER_BODY の長さ(NULL文字含まず)
+ */
+#define OTA_AGENT_DATA_STREAM_TOPIC_FILTER_BODY_LENGTH ((uint16_t)(sizeof(OTA_AGENT_DATA_STREAM_TOPIC_FILTER_BODY) - 1))
+
+/**
+ * @brief ファイルブロックを直接受信するトピック。受信側はThingNameを問わずストリームのトピックを受け付ける
+ */
+#define OTA_AGENT_DATA_STREAM_TOPIC_FILTER OTA_AGENT_TOPIC_PREFIX "+" OTA_AGENT_DATA_STREAM_TOPIC_FILTER_BODY
 
 /**
  * @brief @ref OTA_AGENT_DATA_STREAM_TOPIC_FILTER の長さ(NULL文字含まず)
@@ -92,6 +109,24 @@
  */
 #define OTA_AGENT_JOB_STATUS_UPDATE_RESPONSE_TOPIC_FILTER_BODY_LENGTH ((uint16_t)(sizeof(OTA_AGENT_JOB_STATUS_UPDATE_RESPONSE_TOPIC_FILTER_BODY) - 1))
 
+/**
+ * @brief トピックのThingName以降の部分の最大長(NULL文字含まず)
+ */
+#define OTA_AGENT_TOPIC_FILTER_BODY_MAX_LENGTH (32U)
+
+/**
+ * @brief ThingNameを埋め込んだトピックフィルタのバッファサイズ(NULL文字含む)
+ */
+#define OTA_AGENT_TOPIC_FILTER_SIZE (OTA_AGENT_TOPIC_PREFIX_LENGTH + THING_NAME_LENGTH + OTA_AGENT_TOPIC_FILTER_BODY_MAX_LENGTH + 1)
+
+#if otaconfigMAX_NUM_OTA_DATA_BUFFERS > UINT8_MAX
+
+/**
+ * 空いているバッファのインデックスをuint8_tでキューに格納するため、バッファ数はUINT8_MAX以下にする
+ */
+#    error "otaconfigMAX_NUM_OTA_DATA_BUFFERS exceeds UINT8_MAX"
+#endif
+
 // --------------------------------------------------
 // 自ファイル内でのみ使用する#define関数マクロ
 // --------------------------------------------------
@@ -104,6 +139,29 @@
 // 自ファイル内でのみ使用するenumタグ定義（typedefを同時に行う）
 // --------------------------------------------------
 
+/**
+ * @brief データブロックの受信経路
+ */
+typedef enum
+{
+    OTA_FILE_BLOCK_SOURCE_MQTT_COPY = 0, /**< MQTT通信バッファからコピーした */
+    OTA_FILE_BLOCK_SOURCE_MQTT_STREAM,   /**< MQTTで断片単位でバッファに直接受信した */
+    OTA_FILE_BLOCK_SOURCE_HTTP,          /**< HTTPのRange GETで取得した */
+    OTA_FILE_BLOCK_SOURCE_NUM,           /**< 受信経路の数 */
+} OTAFileBlockSource_t;
+
+/**
+ * @brief OTAで使用するトピック
+ */
+typedef enum
+{
+    OTA_AGENT_TOPIC_JOB_NOTIFY = 0,             /**< ジョブが通知されるトピック */
+    OTA_AGENT_TOPIC_DATA_STREAM,                /**< ファイルブロックが送られてくるトピック */
+    OTA_AGENT_TOPIC_JOBS_GET_RESPONSE,          /**< ジョブ取得の結果が通知されるトピック */
+    OTA_AGENT_TOPIC_JOB_STATUS_UPDATE_RESPONSE, /**< ジョブステータス更新の結果が通知されるトピック */
+    OTA_AGENT_TOPIC_NUM,                        /**< トピックの数 */
+} OTAAgentTopic_t;
+
 // --------------------------------------------------
 // 自ファイル内でのみ使用するstruct/unionタグ定義（typedefを同時に行う）
 // --------------------------------------------------
@@ -113,11 +171,34 @@
  */
 typedef struct OTATopicFilterCallback
 {
-    const char *pcTopicFilter;       /**< トピックフィルタ */
-    uint16_t uxTopicFilterLength;    /**< pcTopicFilterの文字数(NULL文字含まず)*/
-    IncomingPubCallback_t xCallback; /**< pcTopicFilterのトピックを受信したときに呼ぶ関数 */
+    const char *pcTopicFilterBody;    /**< トピックフィルタのThingName以降の部分 */
+    uint16_t uxTopicFilterBodyLength; /**< pcTopicFilterBodyの文字数(NULL文字含まず)*/
+    IncomingPubCallback_t xCallback;  /**< トピックを受信したときに呼ぶ関数 */
 } OTATopicFilterCallback_t;
 
+/**
+ * @brief ThingNameを埋め込んだトピックフィルタ
+ */
+typedef struct
+{
+    char cTopicFilter[OTA_AGENT_TOPIC_FILTER_SIZE]; /**< トピックフィルタ */
+    uint16_t uxTopicFilterLength;                   /**< cTopicFilterの文字数(NULL文字含まず)*/
+} OTATopicFilter_t;
+
+/**
+ * @brief FWのダウンロードの統計情報
+ */
+typedef struct
+{
+    TickType_t xFirstBlockTick;                             /**< 最初のデータブロックを受信した時間 */
+    TickType_t xLastBlockTick;                              /**< 最後のデータブロックを受信した時間 */
+    uint32_t ulBlockCount;                                  /**< OTAAgentに渡したデータブロック数 */
+    uint32_t ulSourceBlockCount[OTA_FILE_BLOCK_SOURCE_NUM]; /**< 受信経路ごとのデータブロック数 */
+    uint32_t ulTotalBytes;                                  /**< OTAAgentに渡したデータブロックの合計サイズ */
+    uint32_t ulDroppedBlockCount;                           /**< バッファが取得できない、またはOTAAgentに通知できずに破棄したデータブロック数 */
+    uint32_t ulOversizedBlockCount;                         /**< イベント用のバッファを超えるため破棄したデータブロック数 */
+} OTADownloadStats_t;
+
 // --------------------------------------------------
 // static関数プロトタイプ宣言
 // --------------------------------------------------
@@ -160,6 +241,20 @@ static void vprvMqttJobCallback(void *pvContext, MQTTPublishInfo_t *pxPublishInf
  */
 static void vprvMqttDataCallback(void *pvContext, MQTTPublishInfo_t *pxPublishInfo);
 
+/**
+ * @brief FWのデータブロックを断片単位で受信したときに呼ばれる関数。断片をバッファに直接書き込み、最後の断片でOTAAgentに通知する。
+ *
+ * @details
+ * MQTT通信バッファを介さないため、#MQTT_BUFFER_SIZE を超えるデータブロックも受信できる。
+ *
+ * @param[in] pvContext 登録時に設定したコンテキスト。使用しない。
+ * @param[in] pxChunk   受信したデータブロックの断片
+ *
+ * @retval true  続きの断片を受け取る
+ * @retval false バッファが取得できないため、残りの断片を破棄する
+ */
+static bool bprvMqttDataStreamCallback(void *pvContext, const MQTTStreamChunk_t *pxChunk);
+
 /**
  * @brief 何も処理する必要がないメッセージを受信したときに呼ばれる関数。ログだけ表示し、何もしない。
  *
@@ -168,6 +263,20 @@ static void vprvMqttDataCallback(void *pvContext, MQTTPublishInfo_t *pxPublishIn
  */
 static void vprvMqttDefaultCallback(void *pvContext, MQTTPublishInfo_t *pxPublishInfo);
 
+/**
+ * @brief ThingNameを埋め込んだトピックフィルタを作成し、トピックとコールバック関数の対応をgxOtaTopicRouterに登録する
+ *
+ * @details
+ * セッションごとに1回だけ行い、OTAAgentのサブスクライブ時はgxOtaTopicRouterをたどるだけにする
+ *
+ * @param[in] pucThingName      ThingName
+ * @param[in] uxThingNameLength ThingNameの長さ(NULL文字含まず)
+ *
+ * @retval true  成功
+ * @retval false トピックフィルタがバッファに収まらない、またはgxOtaTopicRouterに登録できない
+ */
+static bool bprvBuildTopicRouter(const uint8_t *pucThingName, uint16_t uxThingNameLength);
+
 /**
  * @brief 指定されたトピック名のメッセージ受診時に呼び出すべきコールバック関数を返す
  *
@@ -239,6 +348,120 @@ static void vprvOTAAgentTask(void *pvParam);
  */
 static void vprvOtaAppCallback(OtaJobEvent_t xEvent, const void *pvData);
 
+/**
+ * @brief OTAAgentに渡したデータブロックを統計情報に記録する
+ *
+ * @param[in] uxLength データブロックのサイズ
+ * @param[in] eSource  データブロックの受信経路
+ */
+static void vprvRecordFileBlock(const size_t uxLength, const OTAFileBlockSource_t eSource);
+
+#if ((configENABLED_DATA_PROTOCOLS & OTA_DATA_OVER_HTTP) != 0)
+/**
+ * @brief HTTPのデータプレーンを初期化する。OTAAgentがHTTPでデータブロックの取得を開始するときに呼ばれる
+ *
+ * @param[in] pcUrl ジョブドキュメントで指定されたURL
+ *
+ * @return OtaHttpStatus_t 初期化の結果
+ */
+static OtaHttpStatus_t xprvHttpInit(char *pcUrl);
+
+/**
+ * @brief データブロックを要求してよくなるまで待ってから、HTTPでデータブロックを要求する
+ *
+ * @param[in] ulRangeStart 要求する範囲の先頭
+ * @param[in] ulRangeEnd   要求する範囲の末尾
+ *
+ * @return OtaHttpStatus_t xOtaHttpDataPlaneRequestの結果
+ */
+static OtaHttpStatus_t xprvHttpRequest(uint32_t ulRangeStart, uint32_t ulRangeEnd);
+#endif
+
+/**
+ * @brief パブリッシュするトピックがデータブロックの要求か判定する
+ *
+ * @param[in] pcTopic    トピック名
+ * @param[in] uxTopicLen トピック名の長さ(NULL文字含まず)
+ *
+ * @retval true  データブロックの要求
+ * @retval false それ以外
+ */
+static bool bprvIsFileBlockRequestTopic(const char *const pcTopic, uint16_t uxTopicLen);
+
+#if ((configENABLED_DATA_PROTOCOLS & OTA_DATA_OVER_HTTP) != 0)
+/**
+ * @brief HTTPで取得したデータブロックをバッファにコピーしてOTAAgentに通知する
+ *
+ * @param[in] pucData  データブロック
+ * @param[in] uxLength データブロックの長さ
+ *
+ * @retval true  続きのデータブロックを受け取る
+ * @retval false バッファが取得できない、またはOTAAgentに通知できない
+ */
+static bool bprvHttpFileBlockCallback(const uint8_t *pucData, size_t uxLength);
+#endif
+
+/**
+ * @brief 破棄したデータブロックを統計情報に記録する
+ *
+ * @param[in] bIsOversized イベント用のバッファを超えるため破棄したか
+ */
+static void vprvRecordDroppedFileBlock(const bool bIsOversized);
+
+/**
+ * @brief FWのダウンロードの統計情報を出力し、次のダウンロードのために初期化する
+ */
+static void vprvPrintDownloadStats(void);
+
+/**
+ * @brief 受信用のファイルを作成する
+ *
+ * @details
+ * 再起動前に同じイメージを受信していた場合は、受信済みのデータブロックを復元する。受信用のファイルはどちらの場合もotaPal_CreateFileForRxで開く。
+ * ジョブを受け付けた時点で、書き込み先のバンクの消去をOTAStagingEraserTaskで開始する
+ *
+ * @param[in] pxFileContext 受信するファイルの情報
+ *
+ * @return OtaPalStatus_t otaPal_CreateFileForRxの結果。イメージが受信用のバンクに収まらない場合はOtaPalRxFileTooLarge
+ */
+static OtaPalStatus_t xprvPalCreateFileForRx(OtaFileContext_t *const pxFileContext);
+
+/**
+ * @brief データブロックを書き込む
+ *
+ * @details
+ * 書き込みはotaPal_WriteBlockを使わずに行単位で行い、書き込み先のページの消去が済んでいない場合のみ待つ
+ *
+ * @param[in] pxFileContext 受信するファイルの情報
+ * @param[in] ulOffset      受信したファイル内のオフセット
+ * @param[in] pucData       データブロック
+ * @param[in] ulBlockSize   データブロックの長さ
+ *
+ * @return int16_t 成功した場合はulBlockSize、失敗した場合は負の値
+ */
+static int16_t sprvPalWriteBlock(OtaFileContext_t *const pxFileContext, uint32_t ulOffset, uint8_t *const pucData, uint32_t ulBlockSize);
+
+/**
+ * @brief 受信用のファイルを閉じて署名を検証する
+ *
+ * @details
+ * 保持している行を書き込み、残りのページの消去を取りやめてから、otaPal_CloseFileでバンク上のイメージの署名を検証する
+ *
+ * @param[in] pxFileContext 受信するファイルの情報
+ *
+ * @return OtaPalStatus_t otaPal_CloseFileの結果。書き込みに失敗した場合はOtaPalFileClose
+ */
+static OtaPalStatus_t xprvPalCloseFile(OtaFileContext_t *const pxFileContext);
+
+/**
+ * @brief 受信用のファイルを破棄する
+ *
+ * @param[in] pxFileContext 受信するファイルの情報
+ *
+ * @return OtaPalStatus_t otaPal_Abortの結果
+ */
+static OtaPalStatus_t xprvPalAbort(OtaFileContext_t *const pxFileContext);
+
 // --------------------------------------------------
 // ファイル内で共有するstatic変数宣言
 // --------------------------------------------------
@@ -250,20 +473,43 @@ static void vprvOtaAppCallback(OtaJobEvent_t xEvent, const void *pvData);
 static TaskHandle_t gxOTAAgentTaskHandle;
 
 /**
- * @brief MQTTAgentがサブスクライブを要求したときに登録するコールバック関数
+ * @brief トピックを受信したときに呼ぶコールバック関数
  *
  */
-static OTATopicFilterCallback_t gxOtaTopicFilterCallbacks[] = {
-    {
-        .pcTopicFilter = OTA_AGENT_JOB_NOTIFY_TOPIC_FILTER,
-        .uxTopicFilterLength = OTA_AGENT_JOB_NOTIFY_TOPIC_FILTER_LENGTH,
+static const OTATopicFilterCallback_t gxOtaTopicFilterCallbacks[OTA_AGENT_TOPIC_NUM] = {
+    [OTA_AGENT_TOPIC_JOB_NOTIFY] = {
+        .pcTopicFilterBody = OTA_AGENT_JOB_NOTIFY_TOPIC_FILTER_BODY,
+        .uxTopicFilterBodyLength = OTA_AGENT_JOB_NOTIFY_TOPIC_FILTER_BODY_LENGTH,
         .xCallback = vprvMqttJobCallback,
     },
-    {
-        .pcTopicFilter = OTA_AGENT_DATA_STREAM_TOPIC_FILTER,
-        .uxTopicFilterLength = OTA_AGENT_DATA_STREAM_TOPIC_FILTER_LENGTH,
+    [OTA_AGENT_TOPIC_DATA_STREAM] = {
+        .pcTopicFilterBody = OTA_AGENT_DATA_STREAM_TOPIC_FILTER_BODY,
+        .uxTopicFilterBodyLength = OTA_AGENT_DATA_STREAM_TOPIC_FILTER_BODY_LENGTH,
         .xCallback = vprvMqttDataCallback,
-    }};
+    },
+    [OTA_AGENT_TOPIC_JOBS_GET_RESPONSE] = {
+        .pcTopicFilterBody = OTA_AGENT_JOBS_GET_RESPONSE_TOPIC_FILTER_BODY,
+        .uxTopicFilterBodyLength = OTA_AGENT_JOBS_GET_RESPONSE_TOPIC_FILTER_BODY_LENGTH,
+        .xCallback = vprvMqttJobCallback,
+    },
+    [OTA_AGENT_TOPIC_JOB_STATUS_UPDATE_RESPONSE] = {
+        .pcTopicFilterBody = OTA_AGENT_JOB_STATUS_UPDATE_RESPONSE_TOPIC_FILTER_BODY,
+        .uxTopicFilterBodyLength = OTA_AGENT_JOB_STATUS_UPDATE_RESPONSE_TOPIC_FILTER_BODY_LENGTH,
+        .xCallback = vprvMqttDefaultCallback,
+    },
+};
+
+/**
+ * @brief ThingNameを埋め込んだトピックフィルタ。ポリシー上ThingNameをワイルドカードにできないので初期化時に作る
+ *
+ * @note gxOtaTopicRouterはトピックフィルタの文字列をコピーしないため、登録している間は維持する
+ */
+static OTATopicFilter_t gxOtaTopicFilters[OTA_AGENT_TOPIC_NUM];
+
+/**
+ * @brief トピック名からgxOtaTopicFilterCallbacksの要素を解決するトライ木。MQTTTaskの受信の振り分けと同じ仕組みを使う
+ */
+static SubscriptionManager_t gxOtaTopicRouter;
 
 /**
  * @brief OTAAgentが使用するインターフェース
@@ -294,15 +540,22 @@ const OtaInterfaces_t gxOtaInterfaces = {
         .publish = xprvMqttPublish,
         .unsubscribe = xprvMqttUnSubscribe,
     },
+#if ((configENABLED_DATA_PROTOCOLS & OTA_DATA_OVER_HTTP) != 0)
+    .http = {
+        .init = xprvHttpInit,
+        .request = xprvHttpRequest,
+        .deinit = xOtaHttpDataPlaneDeinit,
+    },
+#endif
     .pal = {
         .getPlatformImageState = otaPal_GetPlatformImageState,
         .setPlatformImageState = otaPal_SetPlatformImageState,
-        .writeBlock = otaPal_WriteBlock,
+        .writeBlock = sprvPalWriteBlock,
         .activate = otaPal_ActivateNewImage,
-        .closeFile = otaPal_CloseFile,
+        .closeFile = xprvPalCloseFile,
         .reset = otaPal_ResetDevice,
-        .abort = otaPal_Abort,
-        .createFile = otaPal_CreateFileForRx,
+        .abort = xprvPalAbort,
+        .createFile = xprvPalCreateFileForRx,
     },
 };
 
@@ -363,27 +616,32 @@ const static OtaAppBuffer_t gxOtaBuffer = {
 static OtaEventData_t gxEventBufferPool[otaconfigMAX_NUM_OTA_DATA_BUFFERS];
 
 /**
- * @brief ジョブイベント用のバッファの取得・開放時につかうセマフォ
+ * @brief 空いているジョブイベント用のバッファのインデックスを格納するキュー
+ *
+ * @details
+ * 取得・開放はキューの受信・送信のみで行い、空きを探すためのバッファの走査やMutexの待機は行わない
  */
-static SemaphoreHandle_t gxEventBufferSemaphore;
+static QueueHandle_t gxEventBufferFreeQueue = NULL;
 
-/*
- * 手動でサブスクライブするトピックフィルタ。ポリシー上ThingNameをワイルドカードにできないので初期化時に作る
+/**
+ * @brief バッファが空いておらず、ジョブイベントを破棄した回数
+ */
+static uint32_t gulEventBufferExhaustedCount = 0;
+
+/**
+ * @brief 空いているバッファ数の最小値
  */
+static UBaseType_t guxEventBufferMinFreeNum = otaconfigMAX_NUM_OTA_DATA_BUFFERS;
 
 /**
- * @brief ジョブ取得の結果が通知されるトピック
+ * @brief 断片単位で受信中のデータブロックを書き込んでいるバッファ。MQTT Taskからのみアクセスする
  */
-static uint8_t gucJobsGetResponseTopicFilter
-    [OTA_AGENT_TOPIC_PREFIX_LENGTH + THING_NAME_LENGTH + OTA_AGENT_JOBS_GET_RESPONSE_TOPIC_FILTER_BODY_LENGTH + 1] =
-        OTA_AGENT_TOPIC_PREFIX;
+static OtaEventData_t *gpxStreamEventData = NULL;
 
 /**
- * @brief ジョブステータス更新の結果が通知されるトピック
+ * @brief FWのダウンロードの統計情報
  */
-static uint8_t gucJobStatusUpdateResponseTopicTiler
-    [OTA_AGENT_TOPIC_PREFIX_LENGTH + THING_NAME_LENGTH + OTA_AGENT_JOB_STATUS_UPDATE_RESPONSE_TOPIC_FILTER_BODY_LENGTH + 1] =
-        OTA_AGENT_TOPIC_PREFIX;
+static OTADownloadStats_t gxDownloadStats;
 
 // --------------------------------------------------
 // 変数定義（staticを除く）
@@ -402,17 +660,35 @@ OTAAgentTaskResult_t eOTAAgentTaskInit(void)
         return OTA_AGENT_TASK_RESULT_SUCCESS;
     }
 
-    // イベントバッファ管理用セマフォ作成
-    if (gxEventBufferSemaphore == NULL)
+    // 空いているイベントバッファのインデックスを管理するキュー作成
+    if (gxEventBufferFreeQueue == NULL)
     {
-        gxEventBufferSemaphore = xSemaphoreCreateMutex();
-        if (gxEventBufferSemaphore == NULL)
+        gxEventBufferFreeQueue = xQueueCreate(otaconfigMAX_NUM_OTA_DATA_BUFFERS, sizeof(uint8_t));
+        if (gxEventBufferFreeQueue == NULL)
         {
-            APP_PRINTFError("Failed to initialize OTAAgent; failed to initialize buffer semaphore.");
+            APP_PRINTFError("Failed to initialize OTAAgent; failed to initialize buffer free queue.");
             return OTA_AGENT_TASK_RESULT_FAILED;
         }
+        vprvOtaEventBufferFreeAll();
     }
 
+    // 受信用のバンクを先行して消去するタスクを起動
+    if (bOtaStagingWriterInit() == false)
+    {
+        APP_PRINTFError("Failed to initialize OTAAgent; failed to initialize staging writer.");
+        return OTA_AGENT_TASK_RESULT_FAILED;
+    }
+
+    // 解施錠などの間にデータブロックの要求を止めるためのセマフォを作成
+    if (bOtaDownloadSchedulerInit() == false)
+    {
+        APP_PRINTFError("Failed to initialize OTAAgent; failed to initialize download scheduler.");
+        return OTA_AGENT_TASK_RESULT_FAILED;
+    }
+
+    // 前回のダウンロードの途中で再起動していた場合に続きから受信できるよう、内部フラッシュの記録を検証する
+    vOtaResumeCheckpointInit();
+
     // ClientIDとして使用するThingNameを取得
     ThingName_t xUsualThingName = {.ucName = {0x00}};
     FlashTaskResult_t xFlashReadResult = eReadFlashInfo(READ_FLASH_TYPE_USUAL_THING_NAME,
@@ -426,31 +702,18 @@ OTAAgentTaskResult_t eOTAAgentTaskInit(void)
 
     uint16_t xUsualThingNameLength = strlen((char *)xUsualThingName.ucName);
 
-    // 実際のThingNameが書かれた、ジョブ取得の結果が通知されるトピックを作成
-    memcpy(gucJobsGetResponseTopicFilter + OTA_AGENT_TOPIC_PREFIX_LENGTH,
-           xUsualThingName.ucName,
-           xUsualThingNameLength);
-    memcpy(gucJobsGetResponseTopicFilter + OTA_AGENT_TOPIC_PREFIX_LENGTH + xUsualThingNameLength,
-           OTA_AGENT_JOBS_GET_RESPONSE_TOPIC_FILTER_BODY,
-           OTA_AGENT_JOBS_GET_RESPONSE_TOPIC_FILTER_BODY_LENGTH);
-    gucJobsGetResponseTopicFilter
-        [OTA_AGENT_TOPIC_PREFIX_LENGTH + xUsualThingNameLength + OTA_AGENT_JOBS_GET_RESPONSE_TOPIC_FILTER_BODY_LENGTH] = '\0';
-
-    // 実際のThingNameが書かれた、ジョブステータス更新の結果が通知されるトピックを作成
-    memcpy(gucJobStatusUpdateResponseTopicTiler + OTA_AGENT_TOPIC_PREFIX_LENGTH,
-           xUsualThingName.ucName,
-           xUsualThingNameLength);
-    memcpy(gucJobStatusUpdateResponseTopicTiler + OTA_AGENT_TOPIC_PREFIX_LENGTH + xUsualThingNameLength,
-           OTA_AGENT_JOB_STATUS_UPDATE_RESPONSE_TOPIC_FILTER_BODY,
-           OTA_AGENT_JOB_STATUS_UPDATE_RESPONSE_TOPIC_FILTER_BODY_LENGTH);
-    gucJobStatusUpdateResponseTopicTiler
-        [OTA_AGENT_TOPIC_PREFIX_LENGTH + xUsualThingNameLength + OTA_AGENT_JOB_STATUS_UPDATE_RESPONSE_TOPIC_FILTER_BODY_LENGTH] = '\0';
+    // 実際のThingNameが書かれたトピックを作成し、コールバック関数との対応を登録
+    if (bprvBuildTopicRouter(xUsualThingName.ucName, xUsualThingNameLength) == false)
+    {
+        APP_PRINTFError("Failed to initialize OTAAgent; failed to build topic router.");
+        return OTA_AGENT_TASK_RESULT_FAILED;
+    }
 
     // OTAジョブ取得の結果返却トピックをサブスクライブ
     MQTTSubscribeInfo_t xJobsGetSubscribeInfo = {
         .qos = 0,
-        .pTopicFilter = (char *)gucJobsGetResponseTopicFilter,
-        .topicFilterLength = strlen((char *)gucJobsGetResponseTopicFilter),
+        .pTopicFilter = gxOtaTopicFilters[OTA_AGENT_TOPIC_JOBS_GET_RESPONSE].cTopicFilter,
+        .topicFilterLength = gxOtaTopicFilters[OTA_AGENT_TOPIC_JOBS_GET_RESPONSE].uxTopicFilterLength,
     };
 
     static StaticMQTTCommandBuffer_t xSubscribeMQTTContextBuffer1; // コンテキスト保存場所を永続化したいためStaticで宣言
@@ -469,8 +732,8 @@ OTAAgentTaskResult_t eOTAAgentTaskInit(void)
     // OTAジョブステータス更新の結果返却トピックをサブスクライブ
     MQTTSubscribeInfo_t xSubscribeInfo = {
         .qos = 0,
-        .pTopicFilter = (char *)gucJobStatusUpdateResponseTopicTiler,
-        .topicFilterLength = strlen((char *)gucJobStatusUpdateResponseTopicTiler),
+        .pTopicFilter = gxOtaTopicFilters[OTA_AGENT_TOPIC_JOB_STATUS_UPDATE_RESPONSE].cTopicFilter,
+        .topicFilterLength = gxOtaTopicFilters[OTA_AGENT_TOPIC_JOB_STATUS_UPDATE_RESPONSE].uxTopicFilterLength,
     };
 
     static StaticMQTTCommandBuffer_t xSubscribeMQTTContextBuffer2; // コンテキスト保存場所を永続化したいためStaticで宣言
@@ -524,6 +787,16 @@ OTAAgentTaskResult_t eOTAAgentTaskInit(void)
     return OTA_AGENT_TASK_RESULT_SUCCESS;
 }
 
+void vOTAAgentTaskBeginInteractiveOperation(void)
+{
+    vOtaDownloadSchedulerBeginInteractive();
+}
+
+void vOTAAgentTaskEndInteractiveOperation(void)
+{
+    vOtaDownloadSchedulerEndInteractive();
+}
+
 OTAAgentTaskResult_t eOTAAgentTaskShutdown(void)
 {
     if (gxOTAAgentTaskHandle == NULL)
@@ -559,8 +832,8 @@ OTAAgentTaskResult_t eOTAAgentTaskShutdown(void)
     // OTAジョブステータス更新の結果返却トピックをアンサブスクライブ
     MQTTSubscribeInfo_t xSubscribeInfo = {
         .qos = 0,
-        .pTopicFilter = (char *)gucJobStatusUpdateResponseTopicTiler,
-        .topicFilterLength = strlen((char *)gucJobStatusUpdateResponseTopicTiler),
+        .pTopicFilter = gxOtaTopicFilters[OTA_AGENT_TOPIC_JOB_STATUS_UPDATE_RESPONSE].cTopicFilter,
+        .topicFilterLength = gxOtaTopicFilters[OTA_AGENT_TOPIC_JOB_STATUS_UPDATE_RESPONSE].uxTopicFilterLength,
     };
 
     static StaticMQTTCommandBuffer_t xUnsubscribeMQTTContextBuffer1; // コンテキスト保存場所を永続化したいためStaticで宣言
@@ -578,8 +851,8 @@ OTAAgentTaskResult_t eOTAAgentTaskShutdown(void)
     // OTAジョブ取得の結果返却トピックをアンサブスクライブ
     MQTTSubscribeInfo_t xJobsGetSubscribeInfo = {
         .qos = 0,
-        .pTopicFilter = (char *)gucJobsGetResponseTopicFilter,
-        .topicFilterLength = strlen((char *)gucJobsGetResponseTopicFilter),
+        .pTopicFilter = gxOtaTopicFilters[OTA_AGENT_TOPIC_JOBS_GET_RESPONSE].cTopicFilter,
+        .topicFilterLength = gxOtaTopicFilters[OTA_AGENT_TOPIC_JOBS_GET_RESPONSE].uxTopicFilterLength,
     };
 
     static StaticMQTTCommandBuffer_t xUnsubscribeMQTTContextBuffer2; // コンテキスト保存場所を永続化したいためStaticで宣言
@@ -608,69 +881,54 @@ OTAAgentTaskResult_t eOTAAgentTaskShutdown(void)
 
 static OtaEventData_t *xprvOtaEventBufferGet(void)
 {
-    OtaEventData_t *pxFreeBuffer = NULL;
-
-    // 取得・開放を排他するためにセマフォを取る
-    if (xSemaphoreTake(gxEventBufferSemaphore, portMAX_DELAY) != pdTRUE)
+    // 空いているバッファのインデックスを取り出す。空きがない場合は待機しない
+    uint8_t ucIndex = 0;
+    if (xQueueReceive(gxEventBufferFreeQueue, &ucIndex, 0) != pdTRUE)
     {
-        APP_PRINTFError("Failed to get event buffer; failed to get semaphore.");
+        taskENTER_CRITICAL();
+        gulEventBufferExhaustedCount++;
+        guxEventBufferMinFreeNum = 0;
+        taskEXIT_CRITICAL();
+        APP_PRINTFWarn("Failed to get event buffer; buffer is out of stock. Exhausted count: %u", gulEventBufferExhaustedCount);
         return NULL;
     }
 
-    // 先頭から順番に開いているバッファを探し、見つかったらそのバッファに使用中フラグを付けて返す
-    for (uint32_t ulIndex = 0; ulIndex < otaconfigMAX_NUM_OTA_DATA_BUFFERS; ulIndex++)
+    UBaseType_t uxFreeNum = uxQueueMessagesWaiting(gxEventBufferFreeQueue);
+    taskENTER_CRITICAL();
+    if (uxFreeNum < guxEventBufferMinFreeNum)
     {
-        if (gxEventBufferPool[ulIndex].bufferUsed == false)
-        {
-            gxEventBufferPool[ulIndex].bufferUsed = true;
-            pxFreeBuffer = &gxEventBufferPool[ulIndex];
-            break;
-        }
+        guxEventBufferMinFreeNum = uxFreeNum;
     }
+    taskEXIT_CRITICAL();
 
-    // セマフォが取れていればエラーは出ない
-    xSemaphoreGive(gxEventBufferSemaphore);
-
-    if (pxFreeBuffer != NULL)
-    {
-        APP_PRINTFDebug("Succeeded to get event buffer. Index: %d, Address: %p", pxFreeBuffer - gxEventBufferPool, pxFreeBuffer);
-    }
-    else
-    {
-        APP_PRINTFWarn("Failed to get event buffer; buffer is out of stock.");
-    }
+    OtaEventData_t *pxFreeBuffer = &gxEventBufferPool[ucIndex];
+    pxFreeBuffer->bufferUsed = true;
 
+    APP_PRINTFDebug("Succeeded to get event buffer. Index: %d, Address: %p", ucIndex, pxFreeBuffer);
     return pxFreeBuffer;
 }
 
 static void vprvOtaEventBufferFree(OtaEventData_t *const pxBuffer)
 {
-    // 取得・開放を排他するためにセマフォを取る
-    if (xSemaphoreTake(gxEventBufferSemaphore, portMAX_DELAY) != pdTRUE)
+    // 二重に開放すると同じインデックスがキューに複数格納されるため、使用中のバッファのみ開放する
+    if (pxBuffer->bufferUsed == false)
     {
-        APP_PRINTFError("Failed to free event buffer; failed to get semaphore.");
+        APP_PRINTFWarn("Failed to free event buffer; buffer is not in use. Address: %p", pxBuffer);
         return;
     }
-
-    // 使用していたバッファを開放する
     pxBuffer->bufferUsed = false;
 
-    // セマフォが取れていればエラーは出ない
-    xSemaphoreGive(gxEventBufferSemaphore);
+    // キューの長さはバッファ数と同じため、空きが必ずある
+    uint8_t ucIndex = (uint8_t)(pxBuffer - gxEventBufferPool);
+    (void)xQueueSendToBack(gxEventBufferFreeQueue, &ucIndex, 0);
 
-    APP_PRINTFDebug("Succeeded to free event buffer. Index: %d, Address: %p", pxBuffer - gxEventBufferPool, pxBuffer);
+    APP_PRINTFDebug("Succeeded to free event buffer. Index: %d, Address: %p", ucIndex, pxBuffer);
 }
 
 static void vprvOtaEventBufferFreeAll(void)
 {
-    // 取得・開放を排他するためにセマフォを取る
-    if (xSemaphoreTake(gxEventBufferSemaphore, portMAX_DELAY) != pdTRUE)
-    {
-        APP_PRINTFError("Failed to free all event buffers; failed to get semaphore.");
-        return;
-    }
-
-    // 先頭から順番にバッファの使用中フラグを解除する
+    // 使用中フラグを解除し、すべてのインデックスをキューに格納し直す
+    xQueueReset(gxEventBufferFreeQueue);
     uint32_t ulNumUnfreedBuffers = 0;
     for (uint32_t ulIndex = 0; ulIndex < otaconfigMAX_NUM_OTA_DATA_BUFFERS; ulIndex++)
     {
@@ -679,12 +937,14 @@ static void vprvOtaEventBufferFreeAll(void)
             ulNumUnfreedBuffers++;
             gxEventBufferPool[ulIndex].bufferUsed = false;
         }
-    }
 
-    // セマフォが取れていればエラーは出ない
-    xSemaphoreGive(gxEventBufferSemaphore);
+        uint8_t ucIndex = (uint8_t)ulIndex;
+        (void)xQueueSendToBack(gxEventBufferFreeQueue, &ucIndex, 0);
+    }
 
     APP_PRINTFDebug("Succeeded to free all event buffers. Number of buffers freed: %d", ulNumUnfreedBuffers);
+    APP_PRINTFInfo("OTA event buffer: buffers=%u, min free=%u, exhausted=%u",
+                   otaconfigMAX_NUM_OTA_DATA_BUFFERS, guxEventBufferMinFreeNum, gulEventBufferExhaustedCount);
 }
 
 static void vprvMqttJobCallback(void *pvContext, MQTTPublishInfo_t *pxPublishInfo)
@@ -696,6 +956,14 @@ static void vprvMqttJobCallback(void *pvContext, MQTTPublishInfo_t *pxPublishInf
                    pxPublishInfo->topicNameLength, pxPublishInfo->pTopicName,
                    pxPublishInfo->payloadLength, pxPublishInfo->pPayload);
 
+    // イベント用のバッファを超えるジョブドキュメントは格納できない
+    if (pxPublishInfo->payloadLength > sizeof(((OtaEventData_t *)0)->data))
+    {
+        APP_PRINTFError("Failed to signal OtaAgentEventReceivedJobDocument to OTAAgent; job document size %u exceeds event buffer.",
+                        pxPublishInfo->payloadLength);
+        return;
+    }
+
     // 受信したデータを入れるバッファを取得
     OtaEventData_t *pxEventData = xprvOtaEventBufferGet();
     if (pxEventData == NULL)
@@ -716,6 +984,8 @@ static void vprvMqttJobCallback(void *pvContext, MQTTPublishInfo_t *pxPublishInf
     if (!OTA_SignalEvent(&xEventMsg))
     {
         APP_PRINTFError("Failed to signal OtaAgentEventReceivedJobDocument to OTAAgent; OTA_SignalEvent failed.");
+        vprvOtaEventBufferFree(pxEventData);
+        return;
     }
 
     APP_PRINTFDebug("Succeeded to signal OtaAgentEventReceivedJobDocument to OTAAgent.");
@@ -726,15 +996,25 @@ static void vprvMqttDataCallback(void *pvContext, MQTTPublishInfo_t *pxPublishIn
     // 使用しない
     (void)pvContext;
 
+    // イベント用のバッファを超えるデータブロックは格納できないため破棄する
+    if (pxPublishInfo->payloadLength > sizeof(((OtaEventData_t *)0)->data))
+    {
+        APP_PRINTFWarn("Failed to receive file block; block size %u exceeds event buffer.", pxPublishInfo->payloadLength);
+        vprvRecordDroppedFileBlock(true);
+        return;
+    }
+
     // 受信したデータを入れるバッファを取得
     OtaEventData_t *pxEventData = xprvOtaEventBufferGet();
     if (pxEventData == NULL)
     {
         APP_PRINTFWarn("Failed to signal OtaAgentEventReceivedFileBlock to OTAAgent; failed to get event buffer.");
+        vprvRecordDroppedFileBlock(false);
         return;
     }
 
-    // 受信したデータをバッファに入れる
+    // 受信したデータをバッファに入れる。
+    // MQTT通信バッファは次の受信で上書きされるためコピーが必要になる。ストリーム受信が有効な場合はこの関数は呼ばれない
     memcpy(pxEventData->data, pxPublishInfo->pPayload, pxPublishInfo->payloadLength);
     pxEventData->dataLength = pxPublishInfo->payloadLength;
 
@@ -746,9 +1026,76 @@ static void vprvMqttDataCallback(void *pvContext, MQTTPublishInfo_t *pxPublishIn
     if (!OTA_SignalEvent(&xEventMsg))
     {
         APP_PRINTFError("Failed to signal OtaAgentEventReceivedFileBlock to OTAAgent; OTA_SignalEvent failed.");
+        vprvOtaEventBufferFree(pxEventData);
+        vprvRecordDroppedFileBlock(false);
+        return;
+    }
+    vprvRecordFileBlock(pxPublishInfo->payloadLength, OTA_FILE_BLOCK_SOURCE_MQTT_COPY);
+
+    APP_PRINTFDebug("Succeeded to signal OtaAgentEventReceivedFileBlock to OTAAgent.");
+}
+
+static bool bprvMqttDataStreamCallback(void *pvContext, const MQTTStreamChunk_t *pxChunk)
+{
+    // 使用しない
+    (void)pvContext;
+
+    // 先頭の断片でバッファを取得する。
+    // 前回のデータブロックが通信断で途中になっている場合は、そのバッファを使い回す
+    if (pxChunk->uxOffset == 0)
+    {
+        if (pxChunk->uxTotalLength > sizeof(((OtaEventData_t *)0)->data))
+        {
+            APP_PRINTFWarn("Failed to receive file block; block size %u exceeds event buffer.", pxChunk->uxTotalLength);
+            vprvRecordDroppedFileBlock(true);
+            return false;
+        }
+
+        if (gpxStreamEventData == NULL)
+        {
+            gpxStreamEventData = xprvOtaEventBufferGet();
+        }
+    }
+    if (gpxStreamEventData == NULL)
+    {
+        APP_PRINTFWarn("Failed to signal OtaAgentEventReceivedFileBlock to OTAAgent; failed to get event buffer.");
+        vprvRecordDroppedFileBlock(false);
+        return false;
+    }
+
+    // 先頭の断片で全体の長さを確認しているが、書き込み先がバッファを超えないことを断片ごとに確認する
+    if ((pxChunk->uxOffset + pxChunk->uxDataLength) > sizeof(gpxStreamEventData->data))
+    {
+        APP_PRINTFWarn("Failed to receive file block; chunk exceeds event buffer. Offset: %u, Length: %u", pxChunk->uxOffset, pxChunk->uxDataLength);
+        vprvRecordDroppedFileBlock(true);
+        return false;
+    }
+
+    // 受信した断片をバッファに直接書き込む
+    memcpy(&gpxStreamEventData->data[pxChunk->uxOffset], pxChunk->pucData, pxChunk->uxDataLength);
+    if (pxChunk->bIsLast == false)
+    {
+        return true;
+    }
+    gpxStreamEventData->dataLength = pxChunk->uxTotalLength;
+
+    // OTAAgentにファイルブロック受信を通知
+    OtaEventMsg_t xEventMsg = {
+        .pEventData = gpxStreamEventData,
+        .eventId = OtaAgentEventReceivedFileBlock,
+    };
+    gpxStreamEventData = NULL;
+    if (!OTA_SignalEvent(&xEventMsg))
+    {
+        APP_PRINTFError("Failed to signal OtaAgentEventReceivedFileBlock to OTAAgent; OTA_SignalEvent failed.");
+        vprvOtaEventBufferFree(xEventMsg.pEventData);
+        vprvRecordDroppedFileBlock(false);
+        return true;
     }
+    vprvRecordFileBlock(pxChunk->uxTotalLength, OTA_FILE_BLOCK_SOURCE_MQTT_STREAM);
 
     APP_PRINTFDebug("Succeeded to signal OtaAgentEventReceivedFileBlock to OTAAgent.");
+    return true;
 }
 
 static void vprvMqttDefaultCallback(void *pvContext, MQTTPublishInfo_t *pxPublishInfo)
@@ -761,40 +1108,57 @@ static void vprvMqttDefaultCallback(void *pvContext, MQTTPublishInfo_t *pxPublis
                     pxPublishInfo->payloadLength, pxPublishInfo->pPayload);
 }
 
-static IncomingPubCallback_t xprvGetCallbackForTopic(const char *pcTopicName, uint16_t uxTopicFilterLength)
+static bool bprvBuildTopicRouter(const uint8_t *pucThingName, uint16_t uxThingNameLength)
 {
-    uint32_t ulNumTopicFilters = sizeof(gxOtaTopicFilterCallbacks) / sizeof(OTATopicFilterCallback_t);
+    SubscriptionManager_Init(&gxOtaTopicRouter);
 
-    // gxOtaTopicFilterCallbacksのトピックを先頭から順番にたどって、
-    // pcTopicFilterがそのトピックにマッチしたら、対応するコールバック関数を返す
-    for (uint32_t ulIndex = 0U; ulIndex < ulNumTopicFilters; ulIndex++)
+    for (uint32_t ulIndex = 0U; ulIndex < OTA_AGENT_TOPIC_NUM; ulIndex++)
     {
-        bool xIsMatch = false;
-        MQTTStatus_t xMAtchTopicResult = MQTT_MatchTopic(pcTopicName,
-                                                         uxTopicFilterLength,
-                                                         gxOtaTopicFilterCallbacks[ulIndex].pcTopicFilter,
-                                                         gxOtaTopicFilterCallbacks[ulIndex].uxTopicFilterLength,
-                                                         &xIsMatch);
-        if (xMAtchTopicResult != MQTTSuccess)
+        const OTATopicFilterCallback_t *pxCallback = &gxOtaTopicFilterCallbacks[ulIndex];
+        OTATopicFilter_t *pxTopicFilter = &gxOtaTopicFilters[ulIndex];
+
+        int lLength = snprintf(pxTopicFilter->cTopicFilter,
+                               sizeof(pxTopicFilter->cTopicFilter),
+                               OTA_AGENT_TOPIC_PREFIX "%.*s%.*s",
+                               uxThingNameLength, (const char *)pucThingName,
+                               pxCallback->uxTopicFilterBodyLength, pxCallback->pcTopicFilterBody);
+        if ((lLength < 0) || ((size_t)lLength >= sizeof(pxTopicFilter->cTopicFilter)))
         {
-            APP_PRINTFError("Failed to get callback function for topic %*.s; MQTT_MatchTopic returned %d.",
-                            uxTopicFilterLength, pcTopicName, xMAtchTopicResult);
-            return NULL;
+            APP_PRINTFError("Failed to build topic filter for %s; buffer too small.", pxCallback->pcTopicFilterBody);
+            return false;
         }
+        pxTopicFilter->uxTopicFilterLength = (uint16_t)lLength;
 
-        if (xIsMatch)
+        if (SubscriptionManager_AddSubscription(&gxOtaTopicRouter,
+                                                pxTopicFilter->cTopicFilter,
+                                                pxTopicFilter->uxTopicFilterLength,
+                                                pxCallback->xCallback,
+                                                (void *)pxCallback) == false)
         {
-            APP_PRINTFDebug("A callback found for topic %*.s. matched topic: %*.s.",
-                            uxTopicFilterLength,
-                            pcTopicName,
-                            gxOtaTopicFilterCallbacks[ulIndex].uxTopicFilterLength,
-                            gxOtaTopicFilterCallbacks[ulIndex].pcTopicFilter);
-            return gxOtaTopicFilterCallbacks[ulIndex].xCallback;
+            APP_PRINTFError("Failed to register topic filter %.*s to topic router.",
+                            pxTopicFilter->uxTopicFilterLength, pxTopicFilter->cTopicFilter);
+            return false;
         }
     }
+    return true;
+}
+
+static IncomingPubCallback_t xprvGetCallbackForTopic(const char *pcTopicName, uint16_t uxTopicFilterLength)
+{
+    // OTAAgentが要求するトピックは具体的なトピック名のため、受信したメッセージと同様にトライ木をたどって解決する
+    IncomingPubCallback_t xCallback = NULL;
+    void *pvContext = NULL;
+    if (SubscriptionManager_FindSubscription(&gxOtaTopicRouter, pcTopicName, uxTopicFilterLength, &xCallback, &pvContext) == false)
+    {
+        APP_PRINTFError("Callback not found for %.*s.", uxTopicFilterLength, pcTopicName);
+        return NULL;
+    }
 
-    APP_PRINTFError("Callback not found for %*.s.", uxTopicFilterLength, pcTopicName);
-    return NULL;
+    APP_PRINTFDebug("A callback found for topic %.*s. matched topic: %s.",
+                    uxTopicFilterLength,
+                    pcTopicName,
+                    ((const OTATopicFilterCallback_t *)pvContext)->pcTopicFilterBody);
+    return xCallback;
 }
 
 static OtaMqttStatus_t xprvMqttSubscribe(const char *pcTopicFilter,
@@ -882,12 +1246,26 @@ static OtaMqttStatus_t xprvMqttPublish(const char *const pcTopic,
     APP_PRINTFDebug("pcTopic: %.*s, uxTopicLen: %d", uxTopicLen, pcTopic, uxTopicLen);
     APP_PRINTFDebug("uxQOS: %d", uxQOS);
 
+    // MQTTが再接続中の場合は、接続が回復するまで待機する
+    if (bMQTTWaitForConnection(MQTT_CONNECTION_WAIT_TIMEOUT_MS) == false)
+    {
+        APP_PRINTFError("Failed to publish message. MQTT is not connected.");
+        return OtaMqttPublishFailed;
+    }
+
+    // 解施錠などの応答を遅らせないよう、データブロックの要求は送信するタイミングを調整する
+    if (bprvIsFileBlockRequestTopic(pcTopic, uxTopicLen) == true)
+    {
+        vOtaDownloadSchedulerWaitForTurn();
+    }
+
     static StaticMQTTCommandBuffer_t xSubscribeMQTTContextBuffer; // コンテキスト保存場所を永続化したいためStaticで宣言
     memset(&xSubscribeMQTTContextBuffer, 0x00, sizeof(xSubscribeMQTTContextBuffer));
-    MQTTOperationTaskResult_t xMQTTpublishResult = eMQTTpublish(&xMQTTPublishInfo, &xSubscribeMQTTContextBuffer);
+    // QoS0のジョブの進捗通知やデータブロックの要求は最新のものが届けばよいため、送信レートの上限を超えた場合は上書きを許可する
+    MQTTOperationTaskResult_t xMQTTpublishResult = eMQTTPublishCoalescable(&xMQTTPublishInfo, &xSubscribeMQTTContextBuffer);
     if (xMQTTpublishResult != MQTT_OPERATION_TASK_RESULT_SUCCESS)
     {
-        APP_PRINTFError("Failed to publish message. Topic: %.*s, Message: %.*s; eMQTTpublish returned %d.1",
+        APP_PRINTFError("Failed to publish message. Topic: %.*s, Message: %.*s; eMQTTPublishCoalescable returned %d.1",
                         uxTopicLen, pcTopic, uxMsgSize, pcMsg, xMQTTpublishResult);
         return OtaMqttPublishFailed;
     }
@@ -898,9 +1276,28 @@ static OtaMqttStatus_t xprvMqttPublish(const char *const pcTopic,
 
 static void vprvOTAAgentTask(void *pvParam)
 {
+    // OTAのPub/Subは、鍵状態の報告などの対話系コマンドより後に処理させる
+    if (eMQTTRegisterBulkTask(xTaskGetCurrentTaskHandle()) != MQTT_OPERATION_TASK_RESULT_SUCCESS)
+    {
+        APP_PRINTFWarn("Failed to register OTAAgentTask as bulk mqtt task.");
+    }
+
+    // データブロックはMQTT通信バッファを介さずにイベント用のバッファへ直接受信する。
+    // 登録できない場合はvprvMqttDataCallbackで受信する
+    if (eMQTTRegisterStreamReceive(OTA_AGENT_DATA_STREAM_TOPIC_FILTER,
+                                   OTA_AGENT_DATA_STREAM_TOPIC_FILTER_LENGTH,
+                                   0,
+                                   bprvMqttDataStreamCallback,
+                                   NULL) != MQTT_OPERATION_TASK_RESULT_SUCCESS)
+    {
+        APP_PRINTFWarn("Failed to register stream receive for ota data.");
+    }
+
     OTA_EventProcessingTask(pvParam);
     APP_PRINTFInfo("OTAAgentTask shut down.");
 
+    vMQTTUnregisterStreamReceive(OTA_AGENT_DATA_STREAM_TOPIC_FILTER, OTA_AGENT_DATA_STREAM_TOPIC_FILTER_LENGTH);
+    vMQTTUnregisterBulkTask(xTaskGetCurrentTaskHandle());
     gxOTAAgentTaskHandle = NULL;
     PRINT_TASK_REMAINING_STACK_SIZE();
 
@@ -913,6 +1310,7 @@ static void vprvOtaAppCallback(OtaJobEvent_t xEvent, const void *pvData)
     {
     case OtaJobEventActivate:
         APP_PRINTFInfo("Received OtaJobEventActivate callback from OTAAgent.");
+        vprvPrintDownloadStats();
 
         // リブートする前にスタックサイズを表示
         PRINT_TASK_REMAINING_STACK_SIZE();
@@ -936,7 +1334,8 @@ static void vprvOtaAppCallback(OtaJobEvent_t xEvent, const void *pvData)
     case OtaJobEventFail:
         APP_PRINTFInfo("Received OtaJobEventFail callback from OTAAgent.");
 
-        // 何もしない
+        // 失敗までのダウンロード状況を出力する
+        vprvPrintDownloadStats();
 
         break;
 
@@ -1003,6 +1402,197 @@ static void vprvOtaAppCallback(OtaJobEvent_t xEvent, const void *pvData)
     }
 }
 
+static void vprvRecordFileBlock(const size_t uxLength, const OTAFileBlockSource_t eSource)
+{
+    TickType_t xNowTick = xTaskGetTickCount();
+
+    taskENTER_CRITICAL();
+    if (gxDownloadStats.ulBlockCount == 0)
+    {
+        gxDownloadStats.xFirstBlockTick = xNowTick;
+    }
+    gxDownloadStats.xLastBlockTick = xNowTick;
+    gxDownloadStats.ulBlockCount++;
+    gxDownloadStats.ulSourceBlockCount[eSource]++;
+    gxDownloadStats.ulTotalBytes += (uint32_t)uxLength;
+    taskEXIT_CRITICAL();
+
+    vOtaDownloadSchedulerRecordBlock();
+}
+
+static void vprvRecordDroppedFileBlock(const bool bIsOversized)
+{
+    taskENTER_CRITICAL();
+    if (bIsOversized == true)
+    {
+        gxDownloadStats.ulOversizedBlockCount++;
+    }
+    else
+    {
+        gxDownloadStats.ulDroppedBlockCount++;
+    }
+    taskEXIT_CRITICAL();
+}
+
+#if ((configENABLED_DATA_PROTOCOLS & OTA_DATA_OVER_HTTP) != 0)
+static OtaHttpStatus_t xprvHttpInit(char *pcUrl)
+{
+    return xOtaHttpDataPlaneInit(pcUrl, bprvHttpFileBlockCallback);
+}
+
+static OtaHttpStatus_t xprvHttpRequest(uint32_t ulRangeStart, uint32_t ulRangeEnd)
+{
+    vOtaDownloadSchedulerWaitForTurn();
+    return xOtaHttpDataPlaneRequest(ulRangeStart, ulRangeEnd);
+}
+#endif
+
+static bool bprvIsFileBlockRequestTopic(const char *const pcTopic, uint16_t uxTopicLen)
+{
+    // データブロックの要求は、ストリームのトピックフィルタの末尾のワイルドカードを除いた部分で始まる
+    const OTATopicFilter_t *pxStreamFilter = &gxOtaTopicFilters[OTA_AGENT_TOPIC_DATA_STREAM];
+    if ((pxStreamFilter->uxTopicFilterLength == 0) || (uxTopicLen < pxStreamFilter->uxTopicFilterLength))
+    {
+        return false;
+    }
+    return (strncmp(pcTopic, pxStreamFilter->cTopicFilter, pxStreamFilter->uxTopicFilterLength - 1U) == 0);
+}
+
+#if ((configENABLED_DATA_PROTOCOLS & OTA_DATA_OVER_HTTP) != 0)
+static bool bprvHttpFileBlockCallback(const uint8_t *pucData, size_t uxLength)
+{
+    // イベント用のバッファを超えるデータブロックは格納できないため破棄する
+    if (uxLength > sizeof(((OtaEventData_t *)0)->data))
+    {
+        APP_PRINTFWarn("Failed to receive file block; block size %u exceeds event buffer.", uxLength);
+        vprvRecordDroppedFileBlock(true);
+        return false;
+    }
+
+    OtaEventData_t *pxEventData = xprvOtaEventBufferGet();
+    if (pxEventData == NULL)
+    {
+        APP_PRINTFWarn("Failed to signal OtaAgentEventReceivedFileBlock to OTAAgent; failed to get event buffer.");
+        vprvRecordDroppedFileBlock(false);
+        return false;
+    }
+
+    memcpy(pxEventData->data, pucData, uxLength);
+    pxEventData->dataLength = uxLength;
+
+    // OTAAgentにファイルブロック受信を通知
+    OtaEventMsg_t xEventMsg = {
+        .pEventData = pxEventData,
+        .eventId = OtaAgentEventReceivedFileBlock,
+    };
+    if (!OTA_SignalEvent(&xEventMsg))
+    {
+        APP_PRINTFError("Failed to signal OtaAgentEventReceivedFileBlock to OTAAgent; OTA_SignalEvent failed.");
+        vprvOtaEventBufferFree(pxEventData);
+        vprvRecordDroppedFileBlock(false);
+        return false;
+    }
+    vprvRecordFileBlock(uxLength, OTA_FILE_BLOCK_SOURCE_HTTP);
+    return true;
+}
+#endif
+
+static void vprvPrintDownloadStats(void)
+{
+    OTADownloadStats_t xStats;
+    taskENTER_CRITICAL();
+    xStats = gxDownloadStats;
+    memset(&gxDownloadStats, 0x00, sizeof(gxDownloadStats));
+    taskEXIT_CRITICAL();
+
+    uint32_t ulElapsedMs = (uint32_t)(xStats.xLastBlockTick - xStats.xFirstBlockTick) * portTICK_PERIOD_MS;
+    uint32_t ulBytesPerSecond = (ulElapsedMs == 0) ? 0 : (uint32_t)(((uint64_t)xStats.ulTotalBytes * 1000U) / ulElapsedMs);
+
+    APP_PRINTFInfo("OTA download: blocks=%u (mqtt copied=%u, mqtt streamed=%u, http=%u), bytes=%u, elapsed=%u ms, throughput=%u B/s, dropped=%u, oversized=%u",
+                   xStats.ulBlockCount,
+                   xStats.ulSourceBlockCount[OTA_FILE_BLOCK_SOURCE_MQTT_COPY],
+                   xStats.ulSourceBlockCount[OTA_FILE_BLOCK_SOURCE_MQTT_STREAM],
+                   xStats.ulSourceBlockCount[OTA_FILE_BLOCK_SOURCE_HTTP],
+                   xStats.ulTotalBytes,
+                   ulElapsedMs,
+                   ulBytesPerSecond,
+                   xStats.ulDroppedBlockCount,
+                   xStats.ulOversizedBlockCount);
+    vOtaDownloadSchedulerPrintStats();
+}
+
+static OtaPalStatus_t xprvPalCreateFileForRx(OtaFileContext_t *const pxFileContext)
+{
+    vOtaDownloadSchedulerReset();
+
+    // 再起動前と同じイメージであれば、受信済みのデータブロックを復元する
+    bool bIsResumed = bOtaResumeCheckpointRestore(pxFileContext);
+
+    // ファイルハンドルは再起動をまたいで使えないため、続きから受信する場合もPALでファイルを開き直す
+    // PALがバンクを消去した場合は、消えたデータブロックをbOtaStagingWriterBeginが受信していない状態に戻す
+    OtaPalStatus_t xResult = otaPal_CreateFileForRx(pxFileContext);
+    if (OTA_PAL_MAIN_ERR(xResult) != OtaPalSuccess)
+    {
+        vOtaResumeCheckpointAbort();
+        return xResult;
+    }
+
+    uint32_t ulReclaimedBlockNum = 0;
+    if (bOtaStagingWriterBegin(pxFileContext->fileSize,
+                               bIsResumed ? pxFileContext->pRxBlockBitmap : NULL,
+                               &ulReclaimedBlockNum) == false)
+    {
+        APP_PRINTFError("Failed to create file for rx; failed to begin staging writer for %u bytes.", pxFileContext->fileSize);
+        vOtaResumeCheckpointAbort();
+        (void)otaPal_Abort(pxFileContext);
+        return OTA_PAL_COMBINE_ERR(OtaPalRxFileTooLarge, 0);
+    }
+    if (ulReclaimedBlockNum > 0)
+    {
+        // 消去するページのデータブロックは受信し直すため、消去を始める前に記録を更新しておく
+        pxFileContext->blocksRemaining += ulReclaimedBlockNum;
+        vOtaResumeCheckpointFlush(pxFileContext);
+    }
+    vOtaStagingWriterStartErase();
+
+    if (bIsResumed == false)
+    {
+        vOtaResumeCheckpointBegin(pxFileContext);
+    }
+    return xResult;
+}
+
+static int16_t sprvPalWriteBlock(OtaFileContext_t *const pxFileContext, uint32_t ulOffset, uint8_t *const pucData, uint32_t ulBlockSize)
+{
+    if (bOtaStagingWriterWrite(ulOffset, pucData, ulBlockSize) == false)
+    {
+        return -1;
+    }
+    vOtaResumeCheckpointRecordBlock(pxFileContext, ulOffset);
+    return (int16_t)ulBlockSize;
+}
+
+static OtaPalStatus_t xprvPalCloseFile(OtaFileContext_t *const pxFileContext)
+{
+    // 全てのデータブロックを受信したため、成否にかかわらず続きから受信することはない
+    vOtaResumeCheckpointClear();
+
+    // 行の途中までのデータを書き込んでから、フラッシュのイメージを検証する
+    if (bOtaStagingWriterEnd() == false)
+    {
+        APP_PRINTFError("Failed to close file; failed to write staging image.");
+        return OTA_PAL_COMBINE_ERR(OtaPalFileClose, 0);
+    }
+    return otaPal_CloseFile(pxFileContext);
+}
+
+static OtaPalStatus_t xprvPalAbort(OtaFileContext_t *const pxFileContext)
+{
+    vOtaStagingWriterAbort();
+    vOtaResumeCheckpointAbort();
+    return otaPal_Abort(pxFileContext);
+}
+
 // --------------------------------------------------
 // Unit Test用関数定義(関数のプロトタイプ宣言は「自身のファイル名+ "_test.h"」で宣言されていること)
 // --------------------------------------------------
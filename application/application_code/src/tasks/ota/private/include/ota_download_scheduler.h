@@ -0,0 +1,116 @@
+/**
+ * @file ota_download_scheduler.h
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ *
+ * @details
+ * OTAのデータブロックを要求するタイミングを決める。解施錠やShadowの送受信の間は要求を止め、
+ * ブローカーとの往復時間(RTT)が最小値より伸びている間は要求の間隔を空ける
+ */
+#ifndef OTA_DOWNLOAD_SCHEDULER_H_
+#define OTA_DOWNLOAD_SCHEDULER_H_
+
+#ifdef __cplusplus // Provide Cplusplus Compatibility
+
+extern "C"
+{
+#endif /* end Provide Cplusplus Compatibility */
+
+// --------------------------------------------------
+// ###   システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+    // --------------------------------------------------
+    // ユーザ作成ヘッダの取り込み
+    // --------------------------------------------------
+
+#include "config/ota_app_config.h"
+
+    // --------------------------------------------------
+    // #defineマクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // #define関数マクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // typedef定義
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // enumタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // struct/unionタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // extern変数宣言
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // 関数プロトタイプ宣言
+    // --------------------------------------------------
+
+    /**
+     * @brief 処理の終了を待つためのセマフォを作成する。作成済みの場合は何もしない
+     *
+     * @retval true  成功
+     * @retval false セマフォを作成できない
+     */
+    bool bOtaDownloadSchedulerInit(void);
+
+    /**
+     * @brief ファイルの受信を開始するときに呼び、RTTの推定値と統計を初期化する
+     */
+    void vOtaDownloadSchedulerReset(void);
+
+    /**
+     * @brief ユーザー操作に応答する処理の開始を記録する。任意のタスクから呼べる
+     */
+    void vOtaDownloadSchedulerBeginInteractive(void);
+
+    /**
+     * @brief ユーザー操作に応答する処理の終了を記録する。任意のタスクから呼べる
+     */
+    void vOtaDownloadSchedulerEndInteractive(void);
+
+    /**
+     * @brief データブロックを要求してよくなるまで待ち、要求した時刻を記録する
+     *
+     * @details
+     * ユーザー操作に応答する処理の間と、終了から #OTA_APP_DOWNLOAD_SCHEDULER_RESUME_DELAY_MS の間は待つ。
+     * ただし #OTA_APP_DOWNLOAD_SCHEDULER_MAX_PAUSE_MS を超えては待たない。
+     * その後、前回の要求からRTTに応じた間隔が経過するまで待つ。データブロックを要求する直前に呼ぶこと
+     */
+    void vOtaDownloadSchedulerWaitForTurn(void);
+
+    /**
+     * @brief データブロックを受信したことを記録する
+     *
+     * @details
+     * 要求してから最初に受信したデータブロックまでの時間をRTTとして推定値に反映する
+     */
+    void vOtaDownloadSchedulerRecordBlock(void);
+
+    /**
+     * @brief 受信中に止めた回数と時間、RTTの推定値をログに出力する
+     */
+    void vOtaDownloadSchedulerPrintStats(void);
+
+    // --------------------------------------------------
+    // インライン関数
+    // --------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end OTA_DOWNLOAD_SCHEDULER_H_ */
@@ -0,0 +1,119 @@
+/**
+ * @file ota_http_data_plane.h
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ *
+ * @details
+ * ota_config.h の configENABLED_DATA_PROTOCOLS に OTA_DATA_OVER_HTTP を含む場合のみ使用できる。
+ * 含まない場合はレスポンスのバッファなどを確保しない
+ */
+#ifndef OTA_HTTP_DATA_PLANE_H_
+#define OTA_HTTP_DATA_PLANE_H_
+
+#ifdef __cplusplus // Provide Cplusplus Compatibility
+
+extern "C"
+{
+#endif /* end Provide Cplusplus Compatibility */
+
+// --------------------------------------------------
+// ###   システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+#include "ota.h"
+
+    // --------------------------------------------------
+    // ユーザ作成ヘッダの取り込み
+    // --------------------------------------------------
+
+#include "config/ota_app_config.h"
+
+    // --------------------------------------------------
+    // #defineマクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // #define関数マクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // typedef定義
+    // --------------------------------------------------
+
+    /**
+     * @brief HTTPで取得したデータブロックを受け取るコールバック関数
+     *
+     * @param[in] pucData  データブロック
+     * @param[in] uxLength データブロックの長さ
+     *
+     * @retval true  続きのデータブロックを受け取る
+     * @retval false バッファが取得できないため、今回のリクエストの残りのデータブロックを破棄する
+     */
+    typedef bool (*OtaHttpFileBlockCallback_t)(const uint8_t *pucData, size_t uxLength);
+
+    // --------------------------------------------------
+    // enumタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // struct/unionタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // extern変数宣言
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // 関数プロトタイプ宣言
+    // --------------------------------------------------
+
+    /**
+     * @brief HTTPのデータプレーンを初期化し、URLのホストに接続する
+     *
+     * @param[in] pcUrl      ジョブドキュメントで指定されたURL。http://とhttps://に対応する
+     * @param[in] xCallback  取得したデータブロックを受け取るコールバック関数
+     *
+     * @retval OtaHttpSuccess    成功
+     * @retval OtaHttpInitFailed URLが不正、または接続に失敗した
+     */
+    OtaHttpStatus_t xOtaHttpDataPlaneInit(const char *pcUrl, OtaHttpFileBlockCallback_t xCallback);
+
+    /**
+     * @brief 指定された範囲から始まるデータブロックを取得する
+     *
+     * @details
+     * OTAライブラリは1ブロック分の範囲を要求するが、1回のRange GETで otaconfigMAX_NUM_BLOCKS_REQUEST ブロック分をまとめて取得し、
+     * otaconfigFILE_BLOCK_SIZE ごとに分割してコールバック関数に渡す。
+     * OTAライブラリは要求した後に otaconfigMAX_NUM_BLOCKS_REQUEST ブロックを受信するまで次の要求を行わないため、
+     * 1往復で複数のブロックを受信できる。
+     *
+     * @param[in] ulRangeStart 取得する範囲の先頭
+     * @param[in] ulRangeEnd   取得する範囲の末尾。ファイルの最後のブロックの場合は1ブロックより短い
+     *
+     * @retval OtaHttpSuccess       成功
+     * @retval OtaHttpRequestFailed 取得に失敗した
+     */
+    OtaHttpStatus_t xOtaHttpDataPlaneRequest(uint32_t ulRangeStart, uint32_t ulRangeEnd);
+
+    /**
+     * @brief HTTPのデータプレーンを終了し、ホストから切断する
+     *
+     * @retval OtaHttpSuccess      成功
+     * @retval OtaHttpDeinitFailed 切断に失敗した
+     */
+    OtaHttpStatus_t xOtaHttpDataPlaneDeinit(void);
+
+    // --------------------------------------------------
+    // インライン関数
+    // --------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end OTA_HTTP_DATA_PLANE_H_ */
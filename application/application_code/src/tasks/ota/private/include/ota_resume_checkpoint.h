@@ -0,0 +1,131 @@
+/**
+ * @file ota_resume_checkpoint.h
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+#ifndef OTA_RESUME_CHECKPOINT_H_
+#define OTA_RESUME_CHECKPOINT_H_
+
+#ifdef __cplusplus // Provide Cplusplus Compatibility
+
+extern "C"
+{
+#endif /* end Provide Cplusplus Compatibility */
+
+// --------------------------------------------------
+// ###   システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+#include "ota.h"
+
+    // --------------------------------------------------
+    // ユーザ作成ヘッダの取り込み
+    // --------------------------------------------------
+
+#include "config/ota_app_config.h"
+
+    // --------------------------------------------------
+    // #defineマクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // #define関数マクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // typedef定義
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // enumタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // struct/unionタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // extern変数宣言
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // 関数プロトタイプ宣言
+    // --------------------------------------------------
+
+    /**
+     * @brief 内部フラッシュから最新の記録を読み込み、検証する
+     *
+     * @details
+     * 記録が壊れている、または記録したときと実行中のFWのバージョンが異なる場合は記録を消去する
+     */
+    void vOtaResumeCheckpointInit(void);
+
+    /**
+     * @brief 受信するファイルが記録と同じイメージであれば、受信済みのデータブロックを復元する
+     *
+     * @details
+     * ファイルのサイズ、ファイルID、署名が一致する場合に、ビットマップと残りのデータブロック数を記録の状態に戻す。
+     * 一致しない場合は記録を消去する
+     *
+     * @param[in,out] pxFileContext 受信するファイルの情報。OTAライブラリがビットマップを初期化した後であること
+     *
+     * @retval true  復元した。受信用のファイルはotaPal_CreateFileForRxで開き直し、書き込み済みのデータが残っているか確認すること
+     * @retval false 記録がない、または別のイメージ
+     */
+    bool bOtaResumeCheckpointRestore(OtaFileContext_t *const pxFileContext);
+
+    /**
+     * @brief 新しく受信を開始したファイルを記録の対象にする
+     *
+     * @param[in] pxFileContext 受信するファイルの情報。受信用のファイルを作成した後であること
+     */
+    void vOtaResumeCheckpointBegin(const OtaFileContext_t *const pxFileContext);
+
+    /**
+     * @brief データブロックを書き込んだことを記録する
+     *
+     * @details
+     * #OTA_APP_RESUME_CHECKPOINT_INTERVAL_BLOCKS ごとに、ビットマップを内部フラッシュに書き込む
+     *
+     * @param[in] pxFileContext 受信するファイルの情報
+     * @param[in] ulOffset      書き込んだデータブロックのファイル内のオフセット
+     */
+    void vOtaResumeCheckpointRecordBlock(const OtaFileContext_t *const pxFileContext, uint32_t ulOffset);
+
+    /**
+     * @brief 受信済みのデータブロックのビットマップを、書き込む間隔を待たずに内部フラッシュに書き込む
+     *
+     * @details
+     * 受信済みのデータブロックを受信し直すことにした場合に、そのデータブロックを消去する前に呼ぶ
+     *
+     * @param[in] pxFileContext 受信するファイルの情報
+     */
+    void vOtaResumeCheckpointFlush(const OtaFileContext_t *const pxFileContext);
+
+    /**
+     * @brief 記録を消去する。受信を完了したとき、または別のイメージの受信を開始するときに呼ぶ
+     */
+    void vOtaResumeCheckpointClear(void);
+
+    /**
+     * @brief 受信を中止したときに記録を消去する
+     *
+     * @details
+     * 受信中でない場合は、再起動前の記録を残すため何もしない
+     */
+    void vOtaResumeCheckpointAbort(void);
+
+    // --------------------------------------------------
+    // インライン関数
+    // --------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end OTA_RESUME_CHECKPOINT_H_ */
@@ -0,0 +1,158 @@
+/**
+ * @file ota_staging_writer.h
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ *
+ * @details
+ * 受信中のイメージを書き込むバンク(#OTA_APP_STAGING_IMAGE_ADDRESS)への書き込みを行う。
+ * ページの消去はOTAStagingEraserTaskが先行して行い、データブロックの書き込みは
+ * 書き込み先のページの消去が済んでいない場合のみ待つ。
+ *
+ * データブロックはotaPal_WriteBlockを使わず、消去済みのバンクに行単位で直接書き込む。
+ * otaPal_WriteBlockは書き込むたびにページを消去するため、先行して消去した意味がなくなる。
+ * otaPal_CloseFileとotaPal_ActivateNewImageは、バンクの内容とファイルの情報のみを使い、
+ * otaPal_WriteBlockでの書き込みの記録には依存しないことを前提とする
+ */
+#ifndef OTA_STAGING_WRITER_H_
+#define OTA_STAGING_WRITER_H_
+
+#ifdef __cplusplus // Provide Cplusplus Compatibility
+
+extern "C"
+{
+#endif /* end Provide Cplusplus Compatibility */
+
+// --------------------------------------------------
+// ###   システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+
+    // --------------------------------------------------
+    // ユーザ作成ヘッダの取り込み
+    // --------------------------------------------------
+
+#include "config/ota_app_config.h"
+
+    // --------------------------------------------------
+    // #defineマクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // #define関数マクロ
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // typedef定義
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // enumタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // struct/unionタグ定義（typedefを同時に行う）
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // extern変数宣言
+    // --------------------------------------------------
+
+    // --------------------------------------------------
+    // 関数プロトタイプ宣言
+    // --------------------------------------------------
+
+    /**
+     * @brief OTAStagingEraserTaskと排他用のセマフォを作成する。作成済みの場合は何もしない
+     *
+     * @retval true  成功
+     * @retval false タスクまたはセマフォを作成できない
+     */
+    bool bOtaStagingWriterInit(void);
+
+    /**
+     * @brief 書き込みを開始し、消去するページを決める
+     *
+     * @details
+     * 再起動前の続きから受信する場合は、受信していないデータブロックの範囲に書き込み済みのデータがあるページのみ消去する。
+     * 消去するページに含まれる受信済みのデータブロックと、消去されたままの受信済みのデータブロックは、ビットマップを受信していない状態に戻す
+     *
+     * @param[in]     ulImageSize          書き込むイメージのサイズ
+     * @param[in,out] pucResumeBitmap      続きから受信する場合は受信済みのデータブロックのビットマップ(0が受信済み)。最初から受信する場合はNULL
+     * @param[out]    pulReclaimedBlockNum 受信していない状態に戻したデータブロック数
+     *
+     * @retval true  成功
+     * @retval false イメージがバンクに収まらない、または初期化されていない
+     */
+    bool bOtaStagingWriterBegin(uint32_t ulImageSize, uint8_t *pucResumeBitmap, uint32_t *pulReclaimedBlockNum);
+
+    /**
+     * @brief bOtaStagingWriterBeginで決めたページの消去をOTAStagingEraserTaskで開始する
+     */
+    void vOtaStagingWriterStartErase(void);
+
+    /**
+     * @brief イメージを行単位で書き込む
+     *
+     * @details
+     * 行の全体が揃った部分はすぐに書き込み、行の一部のみの部分は行が揃うかイメージの末尾に達するまで保持する。
+     * 書き込み先のページの消去が済んでいない場合は待つ
+     *
+     * @param[in] ulOffset イメージ内のオフセット
+     * @param[in] pucData  書き込むデータ
+     * @param[in] uxLength 書き込むデータの長さ
+     *
+     * @retval true  成功
+     * @retval false 消去が進まない、または書き込みに失敗した
+     */
+    bool bOtaStagingWriterWrite(uint32_t ulOffset, const uint8_t *pucData, size_t uxLength);
+
+    /**
+     * @brief 保持している行を書き込み、残りのページの消去を取りやめて終了する。書き込みにかかった時間をログに出力する
+     *
+     * @retval true  成功
+     * @retval false 保持している行の書き込みに失敗した
+     */
+    bool bOtaStagingWriterEnd(void);
+
+    /**
+     * @brief 書き込みを中止し、残りのページの消去を取りやめる
+     */
+    void vOtaStagingWriterAbort(void);
+
+    /**
+     * @brief NVMを操作する前に呼び、OTAStagingEraserTaskの消去と排他する
+     *
+     * @details
+     * #bOtaStagingWriterWaitNvm で完了を待てるよう、NVMのコールバック関数を登録する
+     */
+    void vOtaStagingWriterLockNvm(void);
+
+    /**
+     * @brief 開始したNVMの操作の完了を待つ。完了割り込みを待つ間は他のタスクに譲る
+     *
+     * @details
+     * #vOtaStagingWriterLockNvm を呼んでから操作を開始すること
+     *
+     * @retval true  成功
+     * @retval false タイムアウト、または操作に失敗した
+     */
+    bool bOtaStagingWriterWaitNvm(void);
+
+    /**
+     * @brief NVMの操作が終わったら呼ぶ
+     */
+    void vOtaStagingWriterUnlockNvm(void);
+
+    // --------------------------------------------------
+    // インライン関数
+    // --------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* end OTA_STAGING_WRITER_H_ */
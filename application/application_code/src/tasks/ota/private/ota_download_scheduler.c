@@ -0,0 +1,361 @@
+/**
+ * @file ota_download_scheduler.c
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+
+// --------------------------------------------------
+// システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+// --------------------------------------------------
+// ユーザ作成ヘッダの取り込み
+// --------------------------------------------------
+#include "common/include/application_define.h"
+#include "config/ota_app_config.h"
+
+#include "tasks/ota/private/include/ota_download_scheduler.h"
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#defineマクロ
+// --------------------------------------------------
+
+/**
+ * @brief RTTの推定値に新しい計測値を反映する割合(1/2^n)
+ */
+#define OTA_DOWNLOAD_SCHEDULER_RTT_SMOOTHING_SHIFT (3U)
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#define関数マクロ
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するtypedef定義
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するenumタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するstruct/unionタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+/**
+ * @brief データブロックの要求を止めた回数と時間
+ */
+typedef struct
+{
+    uint32_t ulPauseCount;      /**< 止めた回数 */
+    TickType_t xPausedTicks;    /**< 止めた時間の合計 */
+    uint32_t ulPauseTimeoutNum; /**< #OTA_APP_DOWNLOAD_SCHEDULER_MAX_PAUSE_MS を超えたため要求した回数 */
+    uint32_t ulRttSampleNum;    /**< RTTを計測した回数 */
+    TickType_t xPacedTicks;     /**< RTTに応じて要求の間隔を空けた時間の合計 */
+} OTADownloadSchedulerStats_t;
+
+// --------------------------------------------------
+// ファイル内で共有するstatic変数宣言
+// --------------------------------------------------
+
+/**
+ * @brief 実行中のユーザー操作に応答する処理の数
+ */
+static UBaseType_t guxInteractiveOperationNum = 0;
+
+/**
+ * @brief 最後にユーザー操作に応答する処理が終わった時刻
+ */
+static TickType_t gxInteractiveEndTick = 0;
+
+/**
+ * @brief ユーザー操作に応答する処理が終わったことがあるか。gxInteractiveEndTickが有効か
+ */
+static bool gbHasInteractiveEnded = false;
+
+/**
+ * @brief ユーザー操作に応答する処理が終わったことを、待機中のOTAAgentTaskに通知するセマフォ
+ */
+static SemaphoreHandle_t gxInteractiveEndSemaphore = NULL;
+
+/**
+ * @brief 最後にデータブロックを要求した時刻
+ */
+static TickType_t gxRequestTick = 0;
+
+/**
+ * @brief データブロックを要求してから、まだデータブロックを受信していないか
+ */
+static bool gbIsWaitingForBlock = false;
+
+/**
+ * @brief データブロックを要求したことがあるか。gxRequestTickが有効か
+ */
+static bool gbHasRequested = false;
+
+/**
+ * @brief 平滑化したRTT(tick)。計測していない場合は0
+ */
+static TickType_t gxSmoothedRttTicks = 0;
+
+/**
+ * @brief 計測したRTTの最小値(tick)。計測していない場合はportMAX_DELAY
+ */
+static TickType_t gxMinRttTicks = portMAX_DELAY;
+
+/**
+ * @brief 受信中の統計
+ */
+static OTADownloadSchedulerStats_t gxSchedulerStats;
+
+// --------------------------------------------------
+// static関数プロトタイプ宣言
+// --------------------------------------------------
+
+/**
+ * @brief ユーザー操作に応答する処理の間と、終了後の一定時間は待つ
+ */
+static void vprvWaitForInteractiveOperation(void);
+
+/**
+ * @brief RTTの推定値から、データブロックの要求の間隔を求める
+ *
+ * @details
+ * 最小値を伝送路そのものの遅延とみなし、平滑化したRTTが最小値より伸びた分をキューで待たされている時間として
+ * #OTA_APP_DOWNLOAD_SCHEDULER_RTT_GAIN を掛ける
+ *
+ * @return TickType_t 要求の間隔(tick)
+ */
+static TickType_t xprvGetRequestInterval(void);
+
+// --------------------------------------------------
+// 変数定義（staticを除く）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 関数定義（staticを除く）
+// --------------------------------------------------
+
+bool bOtaDownloadSchedulerInit(void)
+{
+    // 既に作成済み
+    if (gxInteractiveEndSemaphore != NULL)
+    {
+        return true;
+    }
+
+    gxInteractiveEndSemaphore = xSemaphoreCreateBinary();
+    if (gxInteractiveEndSemaphore == NULL)
+    {
+        APP_PRINTFError("Failed to create interactive end semaphore.");
+        return false;
+    }
+    return true;
+}
+
+void vOtaDownloadSchedulerReset(void)
+{
+    taskENTER_CRITICAL();
+    gbIsWaitingForBlock = false;
+    gbHasRequested = false;
+    gxSmoothedRttTicks = 0;
+    gxMinRttTicks = portMAX_DELAY;
+    memset(&gxSchedulerStats, 0x00, sizeof(gxSchedulerStats));
+    taskEXIT_CRITICAL();
+}
+
+void vOtaDownloadSchedulerBeginInteractive(void)
+{
+    taskENTER_CRITICAL();
+    guxInteractiveOperationNum++;
+    taskEXIT_CRITICAL();
+}
+
+void vOtaDownloadSchedulerEndInteractive(void)
+{
+    TickType_t xNowTick = xTaskGetTickCount();
+
+    taskENTER_CRITICAL();
+    if (guxInteractiveOperationNum > 0)
+    {
+        guxInteractiveOperationNum--;
+    }
+    if (guxInteractiveOperationNum == 0)
+    {
+        gxInteractiveEndTick = xNowTick;
+        gbHasInteractiveEnded = true;
+    }
+    taskEXIT_CRITICAL();
+
+    // OTAAgentTaskを起動する前にも呼ばれる
+    if (gxInteractiveEndSemaphore != NULL)
+    {
+        (void)xSemaphoreGive(gxInteractiveEndSemaphore);
+    }
+}
+
+void vOtaDownloadSchedulerWaitForTurn(void)
+{
+#if (OTA_APP_DOWNLOAD_SCHEDULER_ENABLE == 1)
+    vprvWaitForInteractiveOperation();
+
+    // 前回の要求からRTTに応じた間隔が経過するまで待つ
+    TickType_t xInterval = xprvGetRequestInterval();
+    TickType_t xElapsed = xTaskGetTickCount() - gxRequestTick;
+    if ((gbHasRequested == true) && (xElapsed < xInterval))
+    {
+        vTaskDelay(xInterval - xElapsed);
+        gxSchedulerStats.xPacedTicks += xInterval - xElapsed;
+    }
+#endif
+
+    TickType_t xNowTick = xTaskGetTickCount();
+    taskENTER_CRITICAL();
+    gxRequestTick = xNowTick;
+    gbHasRequested = true;
+    gbIsWaitingForBlock = true;
+    taskEXIT_CRITICAL();
+}
+
+void vOtaDownloadSchedulerRecordBlock(void)
+{
+    TickType_t xNowTick = xTaskGetTickCount();
+
+    taskENTER_CRITICAL();
+    if (gbIsWaitingForBlock == true)
+    {
+        gbIsWaitingForBlock = false;
+
+        TickType_t xRttTicks = xNowTick - gxRequestTick;
+        if (xRttTicks < gxMinRttTicks)
+        {
+            gxMinRttTicks = xRttTicks;
+        }
+        if (gxSmoothedRttTicks == 0)
+        {
+            gxSmoothedRttTicks = xRttTicks;
+        }
+        else
+        {
+            gxSmoothedRttTicks = gxSmoothedRttTicks - (gxSmoothedRttTicks >> OTA_DOWNLOAD_SCHEDULER_RTT_SMOOTHING_SHIFT) +
+                                 (xRttTicks >> OTA_DOWNLOAD_SCHEDULER_RTT_SMOOTHING_SHIFT);
+        }
+        gxSchedulerStats.ulRttSampleNum++;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void vOtaDownloadSchedulerPrintStats(void)
+{
+    OTADownloadSchedulerStats_t xStats;
+    TickType_t xSmoothedRttTicks;
+    TickType_t xMinRttTicks;
+
+    taskENTER_CRITICAL();
+    xStats = gxSchedulerStats;
+    xSmoothedRttTicks = gxSmoothedRttTicks;
+    xMinRttTicks = (gxMinRttTicks == portMAX_DELAY) ? 0 : gxMinRttTicks;
+    taskEXIT_CRITICAL();
+
+    APP_PRINTFInfo("OTA download scheduler: paused=%u (%u ms, timed out=%u), paced=%u ms, rtt samples=%u, srtt=%u ms, min rtt=%u ms",
+                   xStats.ulPauseCount,
+                   (uint32_t)xStats.xPausedTicks * portTICK_PERIOD_MS,
+                   xStats.ulPauseTimeoutNum,
+                   (uint32_t)xStats.xPacedTicks * portTICK_PERIOD_MS,
+                   xStats.ulRttSampleNum,
+                   (uint32_t)xSmoothedRttTicks * portTICK_PERIOD_MS,
+                   (uint32_t)xMinRttTicks * portTICK_PERIOD_MS);
+}
+
+// --------------------------------------------------
+// static関数定義
+// --------------------------------------------------
+
+static void vprvWaitForInteractiveOperation(void)
+{
+    const TickType_t xResumeDelay = pdMS_TO_TICKS(OTA_APP_DOWNLOAD_SCHEDULER_RESUME_DELAY_MS);
+    const TickType_t xMaxPause = pdMS_TO_TICKS(OTA_APP_DOWNLOAD_SCHEDULER_MAX_PAUSE_MS);
+    const TickType_t xStartTick = xTaskGetTickCount();
+    bool bIsPaused = false;
+
+    for (;;)
+    {
+        TickType_t xNowTick = xTaskGetTickCount();
+        TickType_t xWait = 0;
+
+        taskENTER_CRITICAL();
+        if (guxInteractiveOperationNum > 0)
+        {
+            // 終了が通知されるまで待つ
+            xWait = xResumeDelay;
+        }
+        else if ((gbHasInteractiveEnded == true) && ((xNowTick - gxInteractiveEndTick) < xResumeDelay))
+        {
+            xWait = xResumeDelay - (xNowTick - gxInteractiveEndTick);
+        }
+        taskEXIT_CRITICAL();
+
+        if (xWait == 0)
+        {
+            break;
+        }
+
+        TickType_t xPaused = xNowTick - xStartTick;
+        if (xPaused >= xMaxPause)
+        {
+            APP_PRINTFWarn("OTA file block request resumed; interactive operation did not end within %u ms.", OTA_APP_DOWNLOAD_SCHEDULER_MAX_PAUSE_MS);
+            gxSchedulerStats.ulPauseTimeoutNum++;
+            break;
+        }
+        if (xWait > (xMaxPause - xPaused))
+        {
+            xWait = xMaxPause - xPaused;
+        }
+
+        bIsPaused = true;
+        (void)xSemaphoreTake(gxInteractiveEndSemaphore, xWait);
+    }
+
+    if (bIsPaused == true)
+    {
+        TickType_t xPausedTicks = xTaskGetTickCount() - xStartTick;
+        gxSchedulerStats.ulPauseCount++;
+        gxSchedulerStats.xPausedTicks += xPausedTicks;
+        APP_PRINTFDebug("OTA file block request paused for %u ms.", (uint32_t)xPausedTicks * portTICK_PERIOD_MS);
+    }
+}
+
+static TickType_t xprvGetRequestInterval(void)
+{
+    TickType_t xSmoothedRttTicks;
+    TickType_t xMinRttTicks;
+
+    taskENTER_CRITICAL();
+    xSmoothedRttTicks = gxSmoothedRttTicks;
+    xMinRttTicks = gxMinRttTicks;
+    taskEXIT_CRITICAL();
+
+    if ((xMinRttTicks == portMAX_DELAY) || (xSmoothedRttTicks <= xMinRttTicks))
+    {
+        return 0;
+    }
+
+    uint32_t ulInterval = (uint32_t)(xSmoothedRttTicks - xMinRttTicks) * OTA_APP_DOWNLOAD_SCHEDULER_RTT_GAIN;
+    if (ulInterval > pdMS_TO_TICKS(OTA_APP_DOWNLOAD_SCHEDULER_MAX_INTERVAL_MS))
+    {
+        ulInterval = pdMS_TO_TICKS(OTA_APP_DOWNLOAD_SCHEDULER_MAX_INTERVAL_MS);
+    }
+    return (TickType_t)ulInterval;
+}
+
+// --------------------------------------------------
+// Unit Test用関数定義(関数のプロトタイプ宣言は「自身のファイル名+ "_test.h"」で宣言されていること)
+// --------------------------------------------------
+#if (BUILD_MODE_TEST == 1) /* BUILD_MODE_TESTが定義されているとき */
+#endif                     /* end  BUILD_MODE_TEST */
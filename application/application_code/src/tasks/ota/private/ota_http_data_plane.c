@@ -0,0 +1,519 @@
+/**
+ * @file ota_http_data_plane.c
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+
+// --------------------------------------------------
+// システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "ota.h"
+#include "ota_config.h"
+#include "core_http_client.h"
+#include "transport_interface.h"
+#include "transport_secure_sockets.h"
+
+// --------------------------------------------------
+// ユーザ作成ヘッダの取り込み
+// --------------------------------------------------
+#include "common/include/application_define.h"
+#include "config/ota_app_config.h"
+
+#include "tasks/mqtt/include/mqtt_operation_task.h"
+#include "tasks/ota/private/include/ota_http_data_plane.h"
+
+#if ((configENABLED_DATA_PROTOCOLS & OTA_DATA_OVER_HTTP) != 0)
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#defineマクロ
+// --------------------------------------------------
+
+/**
+ * @brief 1回のRange GETで取得するデータブロック数
+ *
+ * @details
+ * OTAライブラリが1回の要求で受信を待つブロック数と合わせる
+ */
+#define OTA_HTTP_BLOCKS_PER_REQUEST (otaconfigMAX_NUM_BLOCKS_REQUEST)
+
+/**
+ * @brief レスポンスを格納するバッファのサイズ
+ */
+#define OTA_HTTP_RESPONSE_BUFFER_SIZE (OTA_APP_HTTP_RESPONSE_HEADER_SIZE + (OTA_HTTP_BLOCKS_PER_REQUEST * otaconfigFILE_BLOCK_SIZE))
+
+/**
+ * @brief HTTPSのURLのスキーム
+ */
+#define OTA_HTTP_SCHEME_HTTPS "https://"
+
+/**
+ * @brief HTTPのURLのスキーム
+ */
+#define OTA_HTTP_SCHEME_HTTP "http://"
+
+/**
+ * @brief HTTPSの標準のポート番号
+ */
+#define OTA_HTTP_HTTPS_DEFAULT_PORT (443U)
+
+/**
+ * @brief HTTPの標準のポート番号
+ */
+#define OTA_HTTP_HTTP_DEFAULT_PORT (80U)
+
+/**
+ * @brief Range GETが成功した場合のステータスコード(206 Partial Content)
+ */
+#define OTA_HTTP_STATUS_PARTIAL_CONTENT (206U)
+
+#if OTA_HTTP_BLOCKS_PER_REQUEST > otaconfigMAX_NUM_OTA_DATA_BUFFERS
+
+/**
+ * 1回のリクエストで取得したデータブロックはすべてOTAAgentのイベント用のバッファに格納するため、
+ * otaconfigMAX_NUM_BLOCKS_REQUESTを大きくする場合はotaconfigMAX_NUM_OTA_DATA_BUFFERSも合わせて見直す
+ */
+#    error "otaconfigMAX_NUM_BLOCKS_REQUEST exceeds otaconfigMAX_NUM_OTA_DATA_BUFFERS"
+#endif
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#define関数マクロ
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するtypedef定義
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するenumタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するstruct/unionタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+/**
+ * @brief HTTPのデータプレーンの統計情報
+ */
+typedef struct
+{
+    uint32_t ulRequestCount;   /**< Range GETの回数 */
+    uint32_t ulReconnectCount; /**< 接続が切れていたため再接続した回数 */
+    uint32_t ulBlockCount;     /**< コールバック関数に渡したデータブロック数 */
+    uint32_t ulTotalBytes;     /**< 受信したデータの合計 */
+    uint32_t ulTotalRequestMs; /**< Range GETにかかった時間の合計 */
+    uint32_t ulMaxRequestMs;   /**< Range GETにかかった時間の最大値 */
+} OtaHttpDataPlaneStats_t;
+
+// --------------------------------------------------
+// ファイル内で共有するstatic変数宣言
+// --------------------------------------------------
+
+/**
+ * @brief ジョブドキュメントで指定されたURLのコピー
+ */
+static char gcUrl[OTA_APP_HTTP_URL_MAX_SIZE];
+
+/**
+ * @brief URLのホスト名
+ */
+static char gcHost[OTA_APP_HTTP_HOST_MAX_SIZE];
+
+/**
+ * @brief URLのパスとクエリ文字列。gcUrl内を指す
+ */
+static const char *gpcPath = NULL;
+
+/**
+ * @brief URLのパスとクエリ文字列の長さ
+ */
+static size_t guxPathLength = 0;
+
+/**
+ * @brief 取得したデータブロックを受け取るコールバック関数
+ */
+static OtaHttpFileBlockCallback_t gxFileBlockCallback = NULL;
+
+/**
+ * @brief ソケットのパラメータ
+ */
+static SecureSocketsTransportParams_t gxSecureSocketsTransportParams;
+
+/**
+ * @brief ネットワークコンテキスト
+ */
+static NetworkContext_t gxNetworkContext;
+
+/**
+ * @brief coreHTTPが使用するトランスポート層
+ */
+static TransportInterface_t gxTransportInterface;
+
+/**
+ * @brief 接続先の情報
+ */
+static ServerInfo_t gxServerInfo;
+
+/**
+ * @brief ソケットの設定
+ */
+static SocketsConfig_t gxSocketsConfig;
+
+/**
+ * @brief ホストに接続しているか
+ */
+static bool gbIsConnected = false;
+
+/**
+ * @brief リクエストヘッダを作成するバッファ
+ */
+static uint8_t gucRequestBuffer[OTA_APP_HTTP_REQUEST_BUFFER_SIZE];
+
+/**
+ * @brief レスポンスを格納するバッファ
+ */
+static uint8_t gucResponseBuffer[OTA_HTTP_RESPONSE_BUFFER_SIZE];
+
+/**
+ * @brief HTTPのデータプレーンの統計情報
+ */
+static OtaHttpDataPlaneStats_t gxHttpStats;
+
+// --------------------------------------------------
+// static関数プロトタイプ宣言
+// --------------------------------------------------
+
+/**
+ * @brief URLをスキーム、ホスト名、ポート番号、パスに分解する
+ *
+ * @param[in] pcUrl URL
+ *
+ * @retval true  成功
+ * @retval false 対応していないURL
+ */
+static bool bprvParseUrl(const char *pcUrl);
+
+/**
+ * @brief URLのホストに接続する
+ *
+ * @retval true  成功
+ * @retval false 失敗
+ */
+static bool bprvConnect(void);
+
+/**
+ * @brief URLのホストから切断する
+ */
+static void vprvDisconnect(void);
+
+/**
+ * @brief 指定された範囲をRange GETで取得する
+ *
+ * @param[in]  ulRangeStart 取得する範囲の先頭
+ * @param[in]  ulRangeEnd   取得する範囲の末尾
+ * @param[out] pxResponse   レスポンス
+ *
+ * @return HTTPStatus_t HTTPClient_Sendの結果
+ */
+static HTTPStatus_t xprvSendRangeRequest(uint32_t ulRangeStart, uint32_t ulRangeEnd, HTTPResponse_t *pxResponse);
+
+// --------------------------------------------------
+// 変数定義（staticを除く）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 関数定義（staticを除く）
+// --------------------------------------------------
+
+OtaHttpStatus_t xOtaHttpDataPlaneInit(const char *pcUrl, OtaHttpFileBlockCallback_t xCallback)
+{
+    if ((pcUrl == NULL) || (xCallback == NULL))
+    {
+        return OtaHttpInitFailed;
+    }
+
+    if (bprvParseUrl(pcUrl) == false)
+    {
+        APP_PRINTFError("Failed to initialize ota http data plane; unsupported url.");
+        return OtaHttpInitFailed;
+    }
+    gxFileBlockCallback = xCallback;
+    memset(&gxHttpStats, 0x00, sizeof(gxHttpStats));
+
+    if (bprvConnect() == false)
+    {
+        APP_PRINTFError("Failed to initialize ota http data plane; failed to connect to %s:%u.", gcHost, gxServerInfo.port);
+        return OtaHttpInitFailed;
+    }
+
+    APP_PRINTFInfo("OTA http data plane connected to %s:%u. Blocks per request: %u", gcHost, gxServerInfo.port, OTA_HTTP_BLOCKS_PER_REQUEST);
+    return OtaHttpSuccess;
+}
+
+OtaHttpStatus_t xOtaHttpDataPlaneRequest(uint32_t ulRangeStart, uint32_t ulRangeEnd)
+{
+    if ((gxFileBlockCallback == NULL) || (ulRangeEnd < ulRangeStart))
+    {
+        return OtaHttpRequestFailed;
+    }
+
+    // ファイルの最後のブロック以外は、続きのブロックもまとめて要求する。
+    // ファイルの末尾を超えた範囲はサーバーがファイルの末尾までに切り詰めて返す
+    uint32_t ulRequestEnd = ulRangeEnd;
+    if ((ulRangeEnd - ulRangeStart + 1U) >= otaconfigFILE_BLOCK_SIZE)
+    {
+        ulRequestEnd = ulRangeStart + (OTA_HTTP_BLOCKS_PER_REQUEST * otaconfigFILE_BLOCK_SIZE) - 1U;
+    }
+
+    TickType_t xStartTick = xTaskGetTickCount();
+    HTTPResponse_t xResponse;
+    HTTPStatus_t xHttpStatus = xprvSendRangeRequest(ulRangeStart, ulRequestEnd, &xResponse);
+    if (xHttpStatus != HTTPSuccess)
+    {
+        // サーバーがKeep-Aliveの接続を閉じている場合があるため、再接続して1回だけ再送する
+        APP_PRINTFWarn("OTA http request failed. Reconnecting... Status: %d", xHttpStatus);
+        vprvDisconnect();
+        if (bprvConnect() == false)
+        {
+            APP_PRINTFError("Failed to reconnect ota http data plane.");
+            return OtaHttpRequestFailed;
+        }
+        gxHttpStats.ulReconnectCount++;
+        xHttpStatus = xprvSendRangeRequest(ulRangeStart, ulRequestEnd, &xResponse);
+    }
+    if (xHttpStatus != HTTPSuccess)
+    {
+        APP_PRINTFError("OTA http request failed. Status: %d", xHttpStatus);
+        return OtaHttpRequestFailed;
+    }
+    if (xResponse.statusCode != OTA_HTTP_STATUS_PARTIAL_CONTENT)
+    {
+        // 署名付きURLの有効期限切れの場合は403となる
+        APP_PRINTFError("OTA http request failed. Status code: %u", xResponse.statusCode);
+        return OtaHttpRequestFailed;
+    }
+
+    uint32_t ulRequestMs = (uint32_t)(xTaskGetTickCount() - xStartTick) * portTICK_PERIOD_MS;
+    gxHttpStats.ulRequestCount++;
+    gxHttpStats.ulTotalBytes += (uint32_t)xResponse.bodyLen;
+    gxHttpStats.ulTotalRequestMs += ulRequestMs;
+    if (ulRequestMs > gxHttpStats.ulMaxRequestMs)
+    {
+        gxHttpStats.ulMaxRequestMs = ulRequestMs;
+    }
+
+    // 受信したデータをブロック単位でOTAAgentに渡す。OTAAgentは受信した順に連番のブロックとして扱う
+    size_t uxOffset = 0;
+    while (uxOffset < xResponse.bodyLen)
+    {
+        size_t uxBlockLength = xResponse.bodyLen - uxOffset;
+        uxBlockLength = (uxBlockLength < otaconfigFILE_BLOCK_SIZE) ? uxBlockLength : otaconfigFILE_BLOCK_SIZE;
+        if (gxFileBlockCallback(&xResponse.pBody[uxOffset], uxBlockLength) == false)
+        {
+            // 渡せなかったブロックは、OTAAgentが再度要求する
+            APP_PRINTFWarn("OTA http blocks were dropped. Offset: %u", ulRangeStart + uxOffset);
+            break;
+        }
+        gxHttpStats.ulBlockCount++;
+        uxOffset += uxBlockLength;
+    }
+
+    APP_PRINTFDebug("OTA http request done. Range: %u-%u, Received: %u bytes, Time: %u ms", ulRangeStart, ulRequestEnd, xResponse.bodyLen, ulRequestMs);
+    return OtaHttpSuccess;
+}
+
+OtaHttpStatus_t xOtaHttpDataPlaneDeinit(void)
+{
+    vprvDisconnect();
+    gxFileBlockCallback = NULL;
+
+    uint32_t ulBytesPerSecond = (gxHttpStats.ulTotalRequestMs == 0) ? 0 : (uint32_t)(((uint64_t)gxHttpStats.ulTotalBytes * 1000U) / gxHttpStats.ulTotalRequestMs);
+    APP_PRINTFInfo("OTA http data plane: requests=%u, reconnects=%u, blocks=%u, bytes=%u, max request=%u ms, throughput=%u B/s",
+                   gxHttpStats.ulRequestCount,
+                   gxHttpStats.ulReconnectCount,
+                   gxHttpStats.ulBlockCount,
+                   gxHttpStats.ulTotalBytes,
+                   gxHttpStats.ulMaxRequestMs,
+                   ulBytesPerSecond);
+    return OtaHttpSuccess;
+}
+
+// --------------------------------------------------
+// static関数定義
+// --------------------------------------------------
+
+static bool bprvParseUrl(const char *pcUrl)
+{
+    size_t uxUrlLength = strlen(pcUrl);
+    if (uxUrlLength >= sizeof(gcUrl))
+    {
+        APP_PRINTFError("Url is too long. Length: %u", uxUrlLength);
+        return false;
+    }
+    memcpy(gcUrl, pcUrl, uxUrlLength + 1U);
+
+    // スキーム
+    const char *pcHostStart = NULL;
+    if (strncmp(gcUrl, OTA_HTTP_SCHEME_HTTPS, sizeof(OTA_HTTP_SCHEME_HTTPS) - 1U) == 0)
+    {
+        pcHostStart = &gcUrl[sizeof(OTA_HTTP_SCHEME_HTTPS) - 1U];
+        gxServerInfo.port = OTA_HTTP_HTTPS_DEFAULT_PORT;
+        gxSocketsConfig.enableTls = true;
+    }
+    else if (strncmp(gcUrl, OTA_HTTP_SCHEME_HTTP, sizeof(OTA_HTTP_SCHEME_HTTP) - 1U) == 0)
+    {
+        // 計測用のローカルサーバーとの接続を想定する
+        pcHostStart = &gcUrl[sizeof(OTA_HTTP_SCHEME_HTTP) - 1U];
+        gxServerInfo.port = OTA_HTTP_HTTP_DEFAULT_PORT;
+        gxSocketsConfig.enableTls = false;
+    }
+    else
+    {
+        return false;
+    }
+
+    // ホスト名。ポート番号かパスの手前まで
+    size_t uxHostLength = strcspn(pcHostStart, ":/");
+    if ((uxHostLength == 0) || (uxHostLength >= sizeof(gcHost)))
+    {
+        return false;
+    }
+    memcpy(gcHost, pcHostStart, uxHostLength);
+    gcHost[uxHostLength] = '\0';
+
+    // ポート番号
+    const char *pcCursor = &pcHostStart[uxHostLength];
+    if (*pcCursor == ':')
+    {
+        uint32_t ulPort = 0;
+        pcCursor++;
+        while ((*pcCursor >= '0') && (*pcCursor <= '9'))
+        {
+            ulPort = (ulPort * 10U) + (uint32_t)(*pcCursor - '0');
+            if (ulPort > UINT16_MAX)
+            {
+                return false;
+            }
+            pcCursor++;
+        }
+        if (ulPort == 0)
+        {
+            return false;
+        }
+        gxServerInfo.port = (uint16_t)ulPort;
+    }
+
+    // パスとクエリ文字列。省略されている場合はルートとする
+    if (*pcCursor == '/')
+    {
+        gpcPath = pcCursor;
+        guxPathLength = strlen(pcCursor);
+    }
+    else if (*pcCursor == '\0')
+    {
+        gpcPath = "/";
+        guxPathLength = 1U;
+    }
+    else
+    {
+        return false;
+    }
+
+    gxServerInfo.pHostName = gcHost;
+    gxServerInfo.hostNameLength = uxHostLength;
+    return true;
+}
+
+static bool bprvConnect(void)
+{
+    memset(&gxSecureSocketsTransportParams, 0x00, sizeof(gxSecureSocketsTransportParams));
+    gxNetworkContext.pParams = &gxSecureSocketsTransportParams;
+
+    // ルート証明書はMQTTと同じく、デフォルトの信頼済み証明書を使用する
+    gxSocketsConfig.pAlpnProtos = NULL;
+    gxSocketsConfig.maxFragmentLength = 0;
+    gxSocketsConfig.disableSni = false;
+    gxSocketsConfig.pRootCa = NULL;
+    gxSocketsConfig.rootCaSize = 0;
+    gxSocketsConfig.sendTimeoutMs = OTA_APP_HTTP_SEND_RECV_TIMEOUT_MS;
+    gxSocketsConfig.recvTimeoutMs = OTA_APP_HTTP_SEND_RECV_TIMEOUT_MS;
+
+    if (SecureSocketsTransport_Connect(&gxNetworkContext, &gxServerInfo, &gxSocketsConfig) != TRANSPORT_SOCKET_STATUS_SUCCESS)
+    {
+        return false;
+    }
+
+    gxTransportInterface.pNetworkContext = &gxNetworkContext;
+    gxTransportInterface.send = SecureSocketsTransport_Send;
+    gxTransportInterface.recv = SecureSocketsTransport_Recv;
+    gbIsConnected = true;
+    return true;
+}
+
+static void vprvDisconnect(void)
+{
+    if (gbIsConnected == false)
+    {
+        return;
+    }
+
+    if (SecureSocketsTransport_Disconnect(&gxNetworkContext) != TRANSPORT_SOCKET_STATUS_SUCCESS)
+    {
+        APP_PRINTFWarn("Failed to disconnect ota http data plane.");
+    }
+    gbIsConnected = false;
+}
+
+static HTTPStatus_t xprvSendRangeRequest(uint32_t ulRangeStart, uint32_t ulRangeEnd, HTTPResponse_t *pxResponse)
+{
+    if (gbIsConnected == false)
+    {
+        return HTTPNetworkError;
+    }
+
+    // 接続を維持して、次のRange GETでTLSのハンドシェイクを省略する
+    HTTPRequestInfo_t xRequestInfo = {
+        .pMethod = HTTP_METHOD_GET,
+        .methodLen = sizeof(HTTP_METHOD_GET) - 1U,
+        .pPath = gpcPath,
+        .pathLen = guxPathLength,
+        .pHost = gcHost,
+        .hostLen = strlen(gcHost),
+        .reqFlags = HTTP_REQUEST_KEEP_ALIVE_FLAG,
+    };
+    HTTPRequestHeaders_t xRequestHeaders = {
+        .pBuffer = gucRequestBuffer,
+        .bufferLen = sizeof(gucRequestBuffer),
+    };
+
+    HTTPStatus_t xHttpStatus = HTTPClient_InitializeRequestHeaders(&xRequestHeaders, &xRequestInfo);
+    if (xHttpStatus != HTTPSuccess)
+    {
+        return xHttpStatus;
+    }
+    xHttpStatus = HTTPClient_AddRangeHeader(&xRequestHeaders, (int32_t)ulRangeStart, (int32_t)ulRangeEnd);
+    if (xHttpStatus != HTTPSuccess)
+    {
+        return xHttpStatus;
+    }
+
+    memset(pxResponse, 0x00, sizeof(HTTPResponse_t));
+    pxResponse->pBuffer = gucResponseBuffer;
+    pxResponse->bufferLen = sizeof(gucResponseBuffer);
+
+    return HTTPClient_Send(&gxTransportInterface, &xRequestHeaders, NULL, 0, pxResponse, 0);
+}
+
+#endif /* end OTA_DATA_OVER_HTTP */
+
+// --------------------------------------------------
+// Unit Test用関数定義(関数のプロトタイプ宣言は「自身のファイル名+ "_test.h"」で宣言されていること)
+// --------------------------------------------------
+#if (BUILD_MODE_TEST == 1) /* BUILD_MODE_TESTが定義されているとき */
+#endif                     /* end  BUILD_MODE_TEST */
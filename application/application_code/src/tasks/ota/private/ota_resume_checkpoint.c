@@ -0,0 +1,502 @@
+/**
+ * @file ota_resume_checkpoint.c
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+
+// --------------------------------------------------
+// システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "definitions.h"
+
+#include "ota.h"
+#include "ota_config.h"
+#include "ota_appversion32.h"
+
+// --------------------------------------------------
+// ユーザ作成ヘッダの取り込み
+// --------------------------------------------------
+#include "common/include/application_define.h"
+#include "config/ota_app_config.h"
+
+#include "tasks/ota/private/include/ota_resume_checkpoint.h"
+#include "tasks/ota/private/include/ota_staging_writer.h"
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#defineマクロ
+// --------------------------------------------------
+
+/**
+ * @brief 記録のマジックナンバー
+ */
+#define OTA_RESUME_CHECKPOINT_MAGIC (0x4F525350U)
+
+/**
+ * @brief 1件の記録を書き込む領域のサイズ
+ *
+ * @details
+ * 1ページに複数の記録を追記し、ページが一杯になったときだけ消去することで、ページの消去回数を抑える
+ */
+#define OTA_RESUME_CHECKPOINT_SLOT_SIZE (256U)
+
+/**
+ * @brief 1ページに書き込める記録の数
+ */
+#define OTA_RESUME_CHECKPOINT_SLOT_NUM (NVM_FLASH_PAGESIZE / OTA_RESUME_CHECKPOINT_SLOT_SIZE)
+
+/**
+ * @brief 内部フラッシュに一度に書き込むサイズ(クアッドワード)
+ */
+#define OTA_RESUME_CHECKPOINT_WRITE_UNIT_SIZE (16U)
+
+/**
+ * @brief 記録がないことを示すスロットの番号
+ */
+#define OTA_RESUME_CHECKPOINT_NO_SLOT (UINT32_MAX)
+
+#if (OTA_MAX_BLOCK_BITMAP_SIZE + 48U) > OTA_RESUME_CHECKPOINT_SLOT_SIZE
+
+/**
+ * 記録はビットマップとヘッダ(最大48バイト)を1つのスロットに格納するため、ビットマップを大きくする場合はスロットも大きくする
+ */
+#    error "OTA_MAX_BLOCK_BITMAP_SIZE exceeds OTA_RESUME_CHECKPOINT_SLOT_SIZE"
+#endif
+
+#if (OTA_APP_RESUME_ENABLE == 1) && ((OTA_APP_STAGING_IMAGE_SIZE + NVM_FLASH_PAGESIZE) > OTA_APP_DELTA_BASE_IMAGE_SIZE)
+
+/**
+ * バンクを切り替えると受信したイメージが実行中のバンクになるため、記録のページにイメージを書き込まないようにする
+ */
+#    error "OTA_APP_STAGING_IMAGE_SIZE overlaps OTA_APP_RESUME_CHECKPOINT_ADDRESS"
+#endif
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#define関数マクロ
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するtypedef定義
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するenumタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するstruct/unionタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+/**
+ * @brief 内部フラッシュに書き込む記録
+ */
+typedef struct
+{
+    uint32_t ulMagic;                            /**< マジックナンバー */
+    uint32_t ulSequence;                         /**< 書き込んだ順番。最も大きいものが最新 */
+    uint32_t ulAppVersion;                       /**< 記録したときに実行していたFWのバージョン */
+    uint32_t ulFileSize;                         /**< ファイルのサイズ */
+    uint32_t ulFileId;                           /**< ファイルID */
+    uint32_t ulSignatureHash;                    /**< 署名のハッシュ値。同じイメージかの判定に使用する */
+    uint32_t ulReceivedBlockCount;               /**< 受信済みのデータブロック数 */
+    uint8_t ucBitmap[OTA_MAX_BLOCK_BITMAP_SIZE]; /**< 受信済みのデータブロックのビットマップ。OTAライブラリと同じく0が受信済み */
+    uint32_t ulChecksum;                         /**< ulChecksumより前のチェックサム */
+} OtaResumeCheckpointRecord_t;
+
+/**
+ * @brief 内部フラッシュに書き込む単位に揃えた記録
+ */
+typedef union
+{
+    OtaResumeCheckpointRecord_t xRecord;                                  /**< 記録 */
+    uint32_t ulWords[OTA_RESUME_CHECKPOINT_SLOT_SIZE / sizeof(uint32_t)]; /**< 書き込み用 */
+} OtaResumeCheckpointSlot_t;
+
+// --------------------------------------------------
+// ファイル内で共有するstatic変数宣言
+// --------------------------------------------------
+
+/**
+ * @brief 最新の記録
+ */
+static OtaResumeCheckpointSlot_t gxSlot;
+
+/**
+ * @brief gxSlotが有効な記録か
+ */
+static bool gbHasCheckpoint = false;
+
+/**
+ * @brief 次に書き込むスロットの番号
+ */
+static uint32_t gulNextSlot = 0;
+
+/**
+ * @brief ページに記録が書き込まれているか。消去が必要かの判定に使用する
+ */
+static bool gbIsPageDirty = false;
+
+/**
+ * @brief 記録の対象のファイルを受信中か
+ */
+static bool gbIsActive = false;
+
+/**
+ * @brief 前回記録してから書き込んだデータブロック数
+ */
+static uint32_t gulBlocksSinceCheckpoint = 0;
+
+// --------------------------------------------------
+// static関数プロトタイプ宣言
+// --------------------------------------------------
+
+/**
+ * @brief FNV-1aでハッシュ値を計算する
+ *
+ * @param[in] pucData  データ
+ * @param[in] uxLength データの長さ
+ *
+ * @return uint32_t ハッシュ値
+ */
+static uint32_t ulprvHash(const uint8_t *pucData, size_t uxLength);
+
+/**
+ * @brief 記録のチェックサムを計算する
+ *
+ * @param[in] pxRecord 記録
+ *
+ * @return uint32_t チェックサム
+ */
+static uint32_t ulprvChecksum(const OtaResumeCheckpointRecord_t *pxRecord);
+
+/**
+ * @brief ファイルの署名のハッシュ値を計算する
+ *
+ * @param[in] pxFileContext ファイルの情報
+ *
+ * @return uint32_t 署名のハッシュ値。署名がない場合は0
+ */
+static uint32_t ulprvSignatureHash(const OtaFileContext_t *const pxFileContext);
+
+/**
+ * @brief ファイルのデータブロック数を求める
+ *
+ * @param[in] ulFileSize ファイルのサイズ
+ *
+ * @return uint32_t データブロック数
+ */
+static uint32_t ulprvBlockCount(uint32_t ulFileSize);
+
+/**
+ * @brief 受信済みのデータブロックのビットマップを記録に反映し、内部フラッシュに書き込む
+ *
+ * @param[in] pxFileContext       受信するファイルの情報
+ * @param[in] ulWrittenBlockIndex ビットマップに反映されていない、書き込んだデータブロックの番号。ない場合はUINT32_MAX
+ */
+static void vprvWriteCheckpoint(const OtaFileContext_t *const pxFileContext, uint32_t ulWrittenBlockIndex);
+
+/**
+ * @brief 記録をページの次のスロットに書き込む。ページが一杯の場合は消去してから書き込む
+ *
+ * @retval true  成功
+ * @retval false 失敗
+ */
+static bool bprvWriteSlot(void);
+
+/**
+ * @brief 記録を書き込むページを消去する
+ *
+ * @retval true  成功
+ * @retval false 失敗
+ */
+static bool bprvErasePage(void);
+
+// --------------------------------------------------
+// 変数定義（staticを除く）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 関数定義（staticを除く）
+// --------------------------------------------------
+
+void vOtaResumeCheckpointInit(void)
+{
+    gbHasCheckpoint = false;
+    gbIsActive = false;
+    gbIsPageDirty = false;
+    gulNextSlot = 0;
+
+#if (OTA_APP_RESUME_ENABLE == 1)
+    const OtaResumeCheckpointSlot_t *pxSlots = (const OtaResumeCheckpointSlot_t *)OTA_APP_RESUME_CHECKPOINT_ADDRESS;
+    uint32_t ulLatestSlot = OTA_RESUME_CHECKPOINT_NO_SLOT;
+
+    // 追記した記録のうち、正しく書き込まれた最新のものを探す
+    for (uint32_t i = 0; i < OTA_RESUME_CHECKPOINT_SLOT_NUM; i++)
+    {
+        const OtaResumeCheckpointRecord_t *pxRecord = &pxSlots[i].xRecord;
+        if (pxRecord->ulMagic == UINT32_MAX)
+        {
+            // 消去されたままのスロット以降には書き込まれていない
+            break;
+        }
+        gbIsPageDirty = true;
+        gulNextSlot = i + 1;
+        if ((pxRecord->ulMagic != OTA_RESUME_CHECKPOINT_MAGIC) || (pxRecord->ulChecksum != ulprvChecksum(pxRecord)))
+        {
+            continue;
+        }
+        if ((ulLatestSlot == OTA_RESUME_CHECKPOINT_NO_SLOT) || (pxRecord->ulSequence > pxSlots[ulLatestSlot].xRecord.ulSequence))
+        {
+            ulLatestSlot = i;
+        }
+    }
+
+    if (ulLatestSlot == OTA_RESUME_CHECKPOINT_NO_SLOT)
+    {
+        vOtaResumeCheckpointClear();
+        return;
+    }
+
+    // バンクの配置やビットマップの形式は記録したときのFWでのみ有効
+    memcpy(&gxSlot, &pxSlots[ulLatestSlot], sizeof(gxSlot));
+    if (gxSlot.xRecord.ulAppVersion != appFirmwareVersion.u.unsignedVersion32)
+    {
+        APP_PRINTFInfo("OTA resume checkpoint discarded; recorded by another firmware version.");
+        vOtaResumeCheckpointClear();
+        return;
+    }
+
+    gbHasCheckpoint = true;
+    APP_PRINTFInfo("OTA resume checkpoint found: file size=%u, received blocks=%u.",
+                   gxSlot.xRecord.ulFileSize,
+                   gxSlot.xRecord.ulReceivedBlockCount);
+#endif
+}
+
+bool bOtaResumeCheckpointRestore(OtaFileContext_t *const pxFileContext)
+{
+    if ((gbHasCheckpoint == false) || (pxFileContext == NULL) || (pxFileContext->pRxBlockBitmap == NULL))
+    {
+        return false;
+    }
+
+    const OtaResumeCheckpointRecord_t *pxRecord = &gxSlot.xRecord;
+    const uint32_t ulBlockCount = ulprvBlockCount(pxFileContext->fileSize);
+    if ((pxRecord->ulFileSize != pxFileContext->fileSize) ||
+        (pxRecord->ulFileId != pxFileContext->serverFileID) ||
+        (pxRecord->ulSignatureHash != ulprvSignatureHash(pxFileContext)) ||
+        (pxRecord->ulReceivedBlockCount >= ulBlockCount))
+    {
+        APP_PRINTFInfo("OTA resume checkpoint discarded; job is for another image.");
+        vOtaResumeCheckpointClear();
+        return false;
+    }
+
+    memcpy(pxFileContext->pRxBlockBitmap, pxRecord->ucBitmap, (ulBlockCount + 7U) / 8U);
+    pxFileContext->blocksRemaining = ulBlockCount - pxRecord->ulReceivedBlockCount;
+
+    gbHasCheckpoint = false;
+    gbIsActive = true;
+    gulBlocksSinceCheckpoint = 0;
+    APP_PRINTFInfo("OTA download resumed: %u of %u blocks already received.", pxRecord->ulReceivedBlockCount, ulBlockCount);
+    return true;
+}
+
+void vOtaResumeCheckpointBegin(const OtaFileContext_t *const pxFileContext)
+{
+#if (OTA_APP_RESUME_ENABLE == 1)
+    if ((pxFileContext == NULL) || (ulprvBlockCount(pxFileContext->fileSize) > (OTA_MAX_BLOCK_BITMAP_SIZE * 8U)))
+    {
+        return;
+    }
+
+    // 別のイメージの記録は不要になる
+    vOtaResumeCheckpointClear();
+
+    OtaResumeCheckpointRecord_t *pxRecord = &gxSlot.xRecord;
+    memset(&gxSlot, 0xFF, sizeof(gxSlot));
+    pxRecord->ulMagic = OTA_RESUME_CHECKPOINT_MAGIC;
+    pxRecord->ulSequence = 0;
+    pxRecord->ulAppVersion = appFirmwareVersion.u.unsignedVersion32;
+    pxRecord->ulFileSize = pxFileContext->fileSize;
+    pxRecord->ulFileId = pxFileContext->serverFileID;
+    pxRecord->ulSignatureHash = ulprvSignatureHash(pxFileContext);
+
+    gbIsActive = true;
+    gulBlocksSinceCheckpoint = 0;
+#else
+    (void)pxFileContext;
+#endif
+}
+
+void vOtaResumeCheckpointRecordBlock(const OtaFileContext_t *const pxFileContext, uint32_t ulOffset)
+{
+    if ((gbIsActive == false) || (pxFileContext == NULL) || (pxFileContext->pRxBlockBitmap == NULL))
+    {
+        return;
+    }
+
+    gulBlocksSinceCheckpoint++;
+    if (gulBlocksSinceCheckpoint < OTA_APP_RESUME_CHECKPOINT_INTERVAL_BLOCKS)
+    {
+        return;
+    }
+    gulBlocksSinceCheckpoint = 0;
+
+    // OTAライブラリはwriteBlockが成功した後にビットマップを更新するため、書き込んだデータブロックはここで受信済みにする
+    vprvWriteCheckpoint(pxFileContext, ulOffset / otaconfigFILE_BLOCK_SIZE);
+}
+
+void vOtaResumeCheckpointFlush(const OtaFileContext_t *const pxFileContext)
+{
+    if ((gbIsActive == false) || (pxFileContext == NULL) || (pxFileContext->pRxBlockBitmap == NULL))
+    {
+        return;
+    }
+
+    gulBlocksSinceCheckpoint = 0;
+    vprvWriteCheckpoint(pxFileContext, UINT32_MAX);
+}
+
+void vOtaResumeCheckpointClear(void)
+{
+    gbHasCheckpoint = false;
+    gbIsActive = false;
+    gulBlocksSinceCheckpoint = 0;
+
+    // 消去の回数を抑えるため、記録が書き込まれている場合のみ消去する
+    if (gbIsPageDirty == true)
+    {
+        if (bprvErasePage() == false)
+        {
+            APP_PRINTFWarn("Failed to erase ota resume checkpoint.");
+        }
+    }
+}
+
+void vOtaResumeCheckpointAbort(void)
+{
+    // 受信用のファイルを作成する前に呼ばれた場合は、再起動前の記録を残す
+    if (gbIsActive == true)
+    {
+        vOtaResumeCheckpointClear();
+    }
+}
+
+// --------------------------------------------------
+// static関数定義
+// --------------------------------------------------
+
+static uint32_t ulprvHash(const uint8_t *pucData, size_t uxLength)
+{
+    uint32_t ulHash = 2166136261U;
+    for (size_t i = 0; i < uxLength; i++)
+    {
+        ulHash ^= pucData[i];
+        ulHash *= 16777619U;
+    }
+    return ulHash;
+}
+
+static uint32_t ulprvChecksum(const OtaResumeCheckpointRecord_t *pxRecord)
+{
+    return ulprvHash((const uint8_t *)pxRecord, offsetof(OtaResumeCheckpointRecord_t, ulChecksum));
+}
+
+static uint32_t ulprvSignatureHash(const OtaFileContext_t *const pxFileContext)
+{
+    if (pxFileContext->pSignature == NULL)
+    {
+        return 0;
+    }
+    return ulprvHash(pxFileContext->pSignature->data, pxFileContext->pSignature->size);
+}
+
+static uint32_t ulprvBlockCount(uint32_t ulFileSize)
+{
+    return (ulFileSize + (otaconfigFILE_BLOCK_SIZE - 1U)) / otaconfigFILE_BLOCK_SIZE;
+}
+
+static void vprvWriteCheckpoint(const OtaFileContext_t *const pxFileContext, uint32_t ulWrittenBlockIndex)
+{
+    OtaResumeCheckpointRecord_t *pxRecord = &gxSlot.xRecord;
+    const uint32_t ulBlockCount = ulprvBlockCount(pxFileContext->fileSize);
+    memcpy(pxRecord->ucBitmap, pxFileContext->pRxBlockBitmap, (ulBlockCount + 7U) / 8U);
+    if (ulWrittenBlockIndex < ulBlockCount)
+    {
+        pxRecord->ucBitmap[ulWrittenBlockIndex / 8U] &= (uint8_t)~(1U << (ulWrittenBlockIndex % 8U));
+    }
+
+    uint32_t ulReceivedBlockCount = 0;
+    for (uint32_t i = 0; i < ulBlockCount; i++)
+    {
+        if ((pxRecord->ucBitmap[i / 8U] & (uint8_t)(1U << (i % 8U))) == 0)
+        {
+            ulReceivedBlockCount++;
+        }
+    }
+    pxRecord->ulReceivedBlockCount = ulReceivedBlockCount;
+    pxRecord->ulSequence++;
+    pxRecord->ulChecksum = ulprvChecksum(pxRecord);
+
+    if (bprvWriteSlot() == false)
+    {
+        APP_PRINTFWarn("Failed to write ota resume checkpoint.");
+    }
+}
+
+static bool bprvWriteSlot(void)
+{
+    if (gulNextSlot >= OTA_RESUME_CHECKPOINT_SLOT_NUM)
+    {
+        if (bprvErasePage() == false)
+        {
+            return false;
+        }
+    }
+
+    const uint32_t ulAddress = OTA_APP_RESUME_CHECKPOINT_ADDRESS + (gulNextSlot * OTA_RESUME_CHECKPOINT_SLOT_SIZE);
+    gulNextSlot++;
+    gbIsPageDirty = true;
+
+    // 受信用のバンクの消去と同時にNVMを操作しないよう排他する
+    vOtaStagingWriterLockNvm();
+    bool bResult = true;
+    for (uint32_t i = 0; (i < OTA_RESUME_CHECKPOINT_SLOT_SIZE) && (bResult == true); i += OTA_RESUME_CHECKPOINT_WRITE_UNIT_SIZE)
+    {
+        if (NVM_QuadWordWrite(&gxSlot.ulWords[i / sizeof(uint32_t)], ulAddress + i) == false)
+        {
+            bResult = false;
+            break;
+        }
+        bResult = bOtaStagingWriterWaitNvm();
+    }
+    vOtaStagingWriterUnlockNvm();
+    return bResult;
+}
+
+static bool bprvErasePage(void)
+{
+    gulNextSlot = 0;
+    gbIsPageDirty = false;
+
+    vOtaStagingWriterLockNvm();
+    bool bResult = NVM_PageErase(OTA_APP_RESUME_CHECKPOINT_ADDRESS);
+    if (bResult == true)
+    {
+        bResult = bOtaStagingWriterWaitNvm();
+    }
+    vOtaStagingWriterUnlockNvm();
+    return bResult;
+}
+
+// --------------------------------------------------
+// Unit Test用関数定義(関数のプロトタイプ宣言は「自身のファイル名+ "_test.h"」で宣言されていること)
+// --------------------------------------------------
+#if (BUILD_MODE_TEST == 1) /* BUILD_MODE_TESTが定義されているとき */
+#endif                     /* end  BUILD_MODE_TEST */
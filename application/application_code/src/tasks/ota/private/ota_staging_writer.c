@@ -0,0 +1,719 @@
+/**
+ * @file ota_staging_writer.c
+ * @author Systemzeus Inc.
+ * @copyright Copyright © 2023 Systemzeus Inc. All rights reserved.
+ */
+
+// --------------------------------------------------
+// システムヘッダの取り込み
+// --------------------------------------------------
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "definitions.h"
+
+#include "ota_config.h"
+
+// --------------------------------------------------
+// ユーザ作成ヘッダの取り込み
+// --------------------------------------------------
+#include "common/include/application_define.h"
+#include "config/ota_app_config.h"
+#include "config/task_config.h"
+
+#include "tasks/ota/private/include/ota_staging_writer.h"
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#defineマクロ
+// --------------------------------------------------
+
+/**
+ * @brief 受信中のイメージを書き込むバンクのページ数
+ */
+#define OTA_STAGING_WRITER_PAGE_NUM (OTA_APP_STAGING_IMAGE_SIZE / NVM_FLASH_PAGESIZE)
+
+/**
+ * @brief 行の書き込み用のバッファのワード数
+ */
+#define OTA_STAGING_WRITER_ROW_WORD_NUM (NVM_FLASH_ROWSIZE / sizeof(uint32_t))
+
+/**
+ * @brief バッファに保持している行がないことを示すオフセット
+ */
+#define OTA_STAGING_WRITER_NO_ROW (UINT32_MAX)
+
+/**
+ * @brief NVMの完了割り込みを1回で待つ最大時間(ms)
+ *
+ * @details
+ * PALがNVMのコールバック関数を登録し直した場合も、この間隔でNVMのビジー状態を確認し直す
+ */
+#define OTA_STAGING_WRITER_NVM_WAIT_SLICE_MS (2U)
+
+/**
+ * @brief NVMの操作の完了を待つ最大時間(ms)。ページの消去時間の最大値より長くする
+ */
+#define OTA_STAGING_WRITER_NVM_TIMEOUT_MS (100U)
+
+#if (otaconfigFILE_BLOCK_SIZE % NVM_FLASH_ROWSIZE) != 0
+
+/**
+ * 行の途中から書き込む範囲はバッファに1行分しか保持できないため、データブロックは行の境界に揃える
+ */
+#    error "otaconfigFILE_BLOCK_SIZE is not a multiple of NVM_FLASH_ROWSIZE"
+#endif
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用する#define関数マクロ
+// --------------------------------------------------
+
+/**
+ * @brief ミリ秒をTickに変換する。1Tickに満たない場合は1Tickにする
+ */
+#define OTA_STAGING_WRITER_MS_TO_TICKS(ms) ((pdMS_TO_TICKS(ms) > 0) ? pdMS_TO_TICKS(ms) : 1)
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するtypedef定義
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するenumタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 自ファイル内でのみ使用するstruct/unionタグ定義（typedefを同時に行う）
+// --------------------------------------------------
+
+/**
+ * @brief 書き込みの統計情報
+ */
+typedef struct
+{
+    uint32_t ulWriteCount;      /**< bOtaStagingWriterWriteの呼び出し回数 */
+    uint32_t ulRowCount;        /**< 書き込んだ行数 */
+    TickType_t xTotalTicks;     /**< bOtaStagingWriterWriteにかかった時間の合計 */
+    TickType_t xMaxTicks;       /**< bOtaStagingWriterWriteにかかった時間の最大 */
+    uint32_t ulEraseWaitCount;  /**< ページの消去を待った回数 */
+    TickType_t xEraseWaitTicks; /**< ページの消去を待った時間の合計 */
+} OtaStagingWriterStats_t;
+
+// --------------------------------------------------
+// ファイル内で共有するstatic変数宣言
+// --------------------------------------------------
+
+/**
+ * @brief OTAStagingEraserTaskのハンドル
+ */
+static TaskHandle_t gxEraserTaskHandle = NULL;
+
+/**
+ * @brief NVMの操作を排他するミューテックス
+ */
+static SemaphoreHandle_t gxNvmMutex = NULL;
+
+/**
+ * @brief ページの消去が進んだことを書き込み側に通知するセマフォ
+ */
+static SemaphoreHandle_t gxEraseProgressSemaphore = NULL;
+
+/**
+ * @brief NVMの操作の完了を通知するセマフォ
+ */
+static SemaphoreHandle_t gxNvmDoneSemaphore = NULL;
+
+/**
+ * @brief 消去するページのビットマップ。1が消去する
+ */
+static uint8_t gucErasePlan[(OTA_STAGING_WRITER_PAGE_NUM + 7U) / 8U];
+
+/**
+ * @brief 消去の対象にするページ数。先頭からこのページ数の範囲のうち、gucErasePlanのページを消去する
+ */
+static volatile uint32_t gulPlannedPageNum = 0;
+
+/**
+ * @brief bOtaStagingWriterBeginで決めた、消去の対象にするページ数。vOtaStagingWriterStartEraseでgulPlannedPageNumに反映する
+ */
+static uint32_t gulBeginPageNum = 0;
+
+/**
+ * @brief 消去が済んだページ数。先頭からこのページ数の範囲は書き込める
+ */
+static volatile uint32_t gulErasedPageNum = 0;
+
+/**
+ * @brief ページの消去に失敗したか
+ */
+static volatile bool gbIsEraseFailed = false;
+
+/**
+ * @brief 書き込むイメージのサイズ
+ */
+static uint32_t gulImageSize = 0;
+
+/**
+ * @brief 行の全体が揃った部分を書き込むバッファ
+ *
+ * @details
+ * NVMはキャッシュを経由せずにRAMを読むため、キャッシュされない領域に配置する
+ */
+static uint32_t gulRowBuffer[OTA_STAGING_WRITER_ROW_WORD_NUM] __attribute__((coherent, aligned(16)));
+
+/**
+ * @brief 行の一部のみ揃った部分を保持するバッファ
+ */
+static uint32_t gulPendingRowBuffer[OTA_STAGING_WRITER_ROW_WORD_NUM] __attribute__((coherent, aligned(16)));
+
+/**
+ * @brief gulPendingRowBufferに保持している行のイメージ内のオフセット。保持していない場合は #OTA_STAGING_WRITER_NO_ROW
+ */
+static uint32_t gulPendingRowOffset = OTA_STAGING_WRITER_NO_ROW;
+
+/**
+ * @brief gulPendingRowBufferに保持しているバイト数
+ */
+static uint32_t gulPendingRowFilled = 0;
+
+/**
+ * @brief 書き込みの統計情報
+ */
+static OtaStagingWriterStats_t gxStats;
+
+// --------------------------------------------------
+// static関数プロトタイプ宣言
+// --------------------------------------------------
+
+/**
+ * @brief gucErasePlanに従ってページを消去するタスク
+ *
+ * @param[in] pvParam 未使用
+ */
+static void vprvOtaStagingEraserTask(void *pvParam);
+
+/**
+ * @brief NVMの操作が完了したときに割り込みから呼ばれるコールバック関数
+ *
+ * @param[in] xContext 使用しない
+ */
+static void vprvNvmCallback(uintptr_t xContext);
+
+/**
+ * @brief ページを消去する。消去が終わるまでタスクを待機させる
+ *
+ * @param[in] ulPageIndex 消去するページの番号
+ *
+ * @retval true  成功
+ * @retval false 失敗
+ */
+static bool bprvErasePage(uint32_t ulPageIndex);
+
+/**
+ * @brief 続きから受信する場合に消去するページを決め、消去するページの受信済みのデータブロックを受信していない状態に戻す
+ *
+ * @param[in]     ulImageSize イメージのサイズ
+ * @param[in,out] pucBitmap   受信済みのデータブロックのビットマップ(0が受信済み)
+ *
+ * @return uint32_t 受信していない状態に戻したデータブロック数
+ */
+static uint32_t ulprvPlanResume(uint32_t ulImageSize, uint8_t *pucBitmap);
+
+/**
+ * @brief フラッシュの範囲が消去されたままか確認する
+ *
+ * @param[in] ulOffset バンク内のオフセット。4バイト境界であること
+ * @param[in] ulLength 長さ。4の倍数であること
+ *
+ * @retval true  消去されたまま
+ * @retval false 書き込み済みのデータがある
+ */
+static bool bprvIsBlank(uint32_t ulOffset, uint32_t ulLength);
+
+/**
+ * @brief 書き込む範囲のページの消去が済むまで待つ
+ *
+ * @param[in] ulOffset 書き込むバンク内のオフセット
+ * @param[in] uxLength 書き込む長さ
+ *
+ * @retval true  消去が済んだ
+ * @retval false 消去が進まない、または消去の対象でない
+ */
+static bool bprvWaitErased(uint32_t ulOffset, size_t uxLength);
+
+/**
+ * @brief 行を書き込む。書き込み先のページの消去が済んでいない場合は待つ
+ *
+ * @param[in] ulRowOffset 行のバンク内のオフセット
+ * @param[in] pulData     書き込むデータ。キャッシュされない領域にあること
+ *
+ * @retval true  成功
+ * @retval false 消去が進まない、または書き込みに失敗した
+ */
+static bool bprvWriteRow(uint32_t ulRowOffset, const uint32_t *pulData);
+
+/**
+ * @brief gulPendingRowBufferに保持している行を書き込む。保持していない場合は何もしない
+ *
+ * @retval true  成功
+ * @retval false 書き込みに失敗した
+ */
+static bool bprvFlushPendingRow(void);
+
+// --------------------------------------------------
+// 変数定義（staticを除く）
+// --------------------------------------------------
+
+// --------------------------------------------------
+// 関数定義（staticを除く）
+// --------------------------------------------------
+
+bool bOtaStagingWriterInit(void)
+{
+    // 既に作成済み
+    if (gxEraserTaskHandle != NULL)
+    {
+        return true;
+    }
+
+    if (gxNvmMutex == NULL)
+    {
+        gxNvmMutex = xSemaphoreCreateMutex();
+    }
+    if (gxEraseProgressSemaphore == NULL)
+    {
+        gxEraseProgressSemaphore = xSemaphoreCreateBinary();
+    }
+    if (gxNvmDoneSemaphore == NULL)
+    {
+        gxNvmDoneSemaphore = xSemaphoreCreateBinary();
+    }
+    if ((gxNvmMutex == NULL) || (gxEraseProgressSemaphore == NULL) || (gxNvmDoneSemaphore == NULL))
+    {
+        APP_PRINTFError("Failed to create ota staging writer semaphore.");
+        return false;
+    }
+
+    if (xTaskCreate(&vprvOtaStagingEraserTask,
+                    "OTAStagingEraserTask",
+                    OTA_STAGING_ERASER_TASK_SIZE,
+                    NULL,
+                    OTA_STAGING_ERASER_TASK_PRIORITY,
+                    &gxEraserTaskHandle) == pdFAIL)
+    {
+        APP_PRINTFError("OTA staging eraser task create failed.");
+        gxEraserTaskHandle = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool bOtaStagingWriterBegin(uint32_t ulImageSize, uint8_t *pucResumeBitmap, uint32_t *pulReclaimedBlockNum)
+{
+    *pulReclaimedBlockNum = 0;
+    if ((gxEraserTaskHandle == NULL) || (ulImageSize > OTA_APP_STAGING_IMAGE_SIZE))
+    {
+        return false;
+    }
+
+    const uint32_t ulPageNum = (ulImageSize + (NVM_FLASH_PAGESIZE - 1U)) / NVM_FLASH_PAGESIZE;
+
+    // 前回の消去が残っていれば取りやめてから、消去するページを決め直す。消去はvOtaStagingWriterStartEraseまで始めない
+    vOtaStagingWriterLockNvm();
+    gulPlannedPageNum = 0;
+    gulErasedPageNum = 0;
+    gbIsEraseFailed = false;
+    if (pucResumeBitmap == NULL)
+    {
+        memset(gucErasePlan, 0xFF, sizeof(gucErasePlan));
+    }
+    else
+    {
+        *pulReclaimedBlockNum = ulprvPlanResume(ulImageSize, pucResumeBitmap);
+    }
+    vOtaStagingWriterUnlockNvm();
+    gulBeginPageNum = ulPageNum;
+
+    gulImageSize = ulImageSize;
+    gulPendingRowOffset = OTA_STAGING_WRITER_NO_ROW;
+    gulPendingRowFilled = 0;
+    memset(&gxStats, 0x00, sizeof(gxStats));
+    return true;
+}
+
+void vOtaStagingWriterStartErase(void)
+{
+    if (gxEraserTaskHandle == NULL)
+    {
+        return;
+    }
+
+    vOtaStagingWriterLockNvm();
+    gulPlannedPageNum = gulBeginPageNum;
+    vOtaStagingWriterUnlockNvm();
+    xTaskNotifyGive(gxEraserTaskHandle);
+}
+
+bool bOtaStagingWriterWrite(uint32_t ulOffset, const uint8_t *pucData, size_t uxLength)
+{
+    const TickType_t xStartTick = xTaskGetTickCount();
+    bool bResult = true;
+
+    while ((uxLength > 0) && (bResult == true))
+    {
+        const uint32_t ulRowOffset = ulOffset - (ulOffset % NVM_FLASH_ROWSIZE);
+        const uint32_t ulOffsetInRow = ulOffset - ulRowOffset;
+        size_t uxChunk = NVM_FLASH_ROWSIZE - ulOffsetInRow;
+        if (uxChunk > uxLength)
+        {
+            uxChunk = uxLength;
+        }
+
+        if (uxChunk == NVM_FLASH_ROWSIZE)
+        {
+            // 行の全体が揃っていればすぐに書き込む
+            memcpy(gulRowBuffer, pucData, NVM_FLASH_ROWSIZE);
+            bResult = bprvWriteRow(ulRowOffset, gulRowBuffer);
+        }
+        else if ((gulPendingRowOffset != OTA_STAGING_WRITER_NO_ROW) && (gulPendingRowOffset != ulRowOffset))
+        {
+            APP_PRINTFError("Failed to write ota staging image at %u; another partial row at %u is pending.", ulOffset, gulPendingRowOffset);
+            bResult = false;
+        }
+        else
+        {
+            // 行は消去後に1度しか書き込めないため、揃うまでバッファに保持する
+            if (gulPendingRowOffset == OTA_STAGING_WRITER_NO_ROW)
+            {
+                memset(gulPendingRowBuffer, 0xFF, sizeof(gulPendingRowBuffer));
+                gulPendingRowOffset = ulRowOffset;
+                gulPendingRowFilled = 0;
+            }
+            memcpy(&((uint8_t *)gulPendingRowBuffer)[ulOffsetInRow], pucData, uxChunk);
+            gulPendingRowFilled += (uint32_t)uxChunk;
+
+            if ((gulPendingRowFilled >= NVM_FLASH_ROWSIZE) || ((ulOffset + uxChunk) >= gulImageSize))
+            {
+                bResult = bprvFlushPendingRow();
+            }
+        }
+
+        ulOffset += (uint32_t)uxChunk;
+        pucData += uxChunk;
+        uxLength -= uxChunk;
+    }
+
+    const TickType_t xElapsedTicks = xTaskGetTickCount() - xStartTick;
+    gxStats.ulWriteCount++;
+    gxStats.xTotalTicks += xElapsedTicks;
+    if (xElapsedTicks > gxStats.xMaxTicks)
+    {
+        gxStats.xMaxTicks = xElapsedTicks;
+    }
+    return bResult;
+}
+
+bool bOtaStagingWriterEnd(void)
+{
+    bool bResult = bprvFlushPendingRow();
+
+    // イメージの書き込みが終わったため、残りのページは消去しない
+    vOtaStagingWriterLockNvm();
+    gulPlannedPageNum = 0;
+    vOtaStagingWriterUnlockNvm();
+
+    uint32_t ulAverageUs = (gxStats.ulWriteCount == 0)
+                               ? 0
+                               : (uint32_t)(((uint64_t)gxStats.xTotalTicks * portTICK_PERIOD_MS * 1000U) / gxStats.ulWriteCount);
+    APP_PRINTFInfo("OTA staging write: writes=%u, rows=%u, average=%u us, max=%u ms, erase waits=%u (%u ms)",
+                   gxStats.ulWriteCount,
+                   gxStats.ulRowCount,
+                   ulAverageUs,
+                   (uint32_t)gxStats.xMaxTicks * portTICK_PERIOD_MS,
+                   gxStats.ulEraseWaitCount,
+                   (uint32_t)gxStats.xEraseWaitTicks * portTICK_PERIOD_MS);
+    return bResult;
+}
+
+void vOtaStagingWriterAbort(void)
+{
+    if (gxNvmMutex == NULL)
+    {
+        return;
+    }
+
+    vOtaStagingWriterLockNvm();
+    gulPlannedPageNum = 0;
+    vOtaStagingWriterUnlockNvm();
+
+    gulPendingRowOffset = OTA_STAGING_WRITER_NO_ROW;
+    gulPendingRowFilled = 0;
+}
+
+void vOtaStagingWriterLockNvm(void)
+{
+    if (gxNvmMutex != NULL)
+    {
+        xSemaphoreTake(gxNvmMutex, portMAX_DELAY);
+
+        // otaPal_CreateFileForRxなどPALが別のコールバック関数を登録している場合があるため、NVMを操作する前に登録し直す
+        (void)xSemaphoreTake(gxNvmDoneSemaphore, 0);
+        NVM_CallbackRegister(vprvNvmCallback, (uintptr_t)NULL);
+    }
+}
+
+bool bOtaStagingWriterWaitNvm(void)
+{
+    // 完了割り込みで起床して確認し直す。CPUを占有しないため、他のタスクは待つ間も動作できる
+    const TickType_t xStartTick = xTaskGetTickCount();
+    while (NVM_IsBusy() == true)
+    {
+        if ((xTaskGetTickCount() - xStartTick) >= pdMS_TO_TICKS(OTA_STAGING_WRITER_NVM_TIMEOUT_MS))
+        {
+            APP_PRINTFError("NVM operation timed out.");
+            return false;
+        }
+        (void)xSemaphoreTake(gxNvmDoneSemaphore, OTA_STAGING_WRITER_MS_TO_TICKS(OTA_STAGING_WRITER_NVM_WAIT_SLICE_MS));
+    }
+    return (NVM_ErrorGet() == NVM_ERROR_NONE);
+}
+
+void vOtaStagingWriterUnlockNvm(void)
+{
+    if (gxNvmMutex != NULL)
+    {
+        xSemaphoreGive(gxNvmMutex);
+    }
+}
+
+// --------------------------------------------------
+// static関数定義
+// --------------------------------------------------
+
+static void vprvOtaStagingEraserTask(void *pvParam)
+{
+    (void)pvParam;
+
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        const TickType_t xStartTick = xTaskGetTickCount();
+        uint32_t ulErasedCount = 0;
+        bool bIsDone = false;
+        while (bIsDone == false)
+        {
+            // 1ページごとにミューテックスを解放し、その間に書き込みや消去の取りやめができるようにする
+            vOtaStagingWriterLockNvm();
+            const uint32_t ulPageIndex = gulErasedPageNum;
+            if ((gbIsEraseFailed == true) || (ulPageIndex >= gulPlannedPageNum))
+            {
+                bIsDone = true;
+            }
+            else if ((gucErasePlan[ulPageIndex / 8U] & (uint8_t)(1U << (ulPageIndex % 8U))) == 0)
+            {
+                gulErasedPageNum = ulPageIndex + 1U;
+            }
+            else if (bprvErasePage(ulPageIndex) == true)
+            {
+                gulErasedPageNum = ulPageIndex + 1U;
+                ulErasedCount++;
+            }
+            else
+            {
+                APP_PRINTFError("Failed to erase ota staging page %u.", ulPageIndex);
+                gbIsEraseFailed = true;
+                bIsDone = true;
+            }
+            vOtaStagingWriterUnlockNvm();
+            xSemaphoreGive(gxEraseProgressSemaphore);
+        }
+
+        if (ulErasedCount > 0)
+        {
+            APP_PRINTFDebug("OTA staging erase: %u pages in %u ms.",
+                            ulErasedCount,
+                            (uint32_t)(xTaskGetTickCount() - xStartTick) * portTICK_PERIOD_MS);
+        }
+    }
+}
+
+static void vprvNvmCallback(uintptr_t xContext)
+{
+    (void)xContext;
+
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    (void)xSemaphoreGiveFromISR(gxNvmDoneSemaphore, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+static bool bprvErasePage(uint32_t ulPageIndex)
+{
+    if (NVM_PageErase(OTA_APP_STAGING_IMAGE_ADDRESS + (ulPageIndex * NVM_FLASH_PAGESIZE)) == false)
+    {
+        return false;
+    }
+
+    // 実行中でないバンクの消去はCPUを止めないため、完了割り込みを待つ間は他のタスクに譲る
+    return bOtaStagingWriterWaitNvm();
+}
+
+static uint32_t ulprvPlanResume(uint32_t ulImageSize, uint8_t *pucBitmap)
+{
+    const uint32_t ulBlockNum = (ulImageSize + (otaconfigFILE_BLOCK_SIZE - 1U)) / otaconfigFILE_BLOCK_SIZE;
+    uint32_t ulReclaimedBlockNum = 0;
+    bool bIsChanged = true;
+
+    memset(gucErasePlan, 0x00, sizeof(gucErasePlan));
+
+    // 消去するページが増えると受信し直すデータブロックが増え、そのデータブロックが別のページにもまたがる場合があるため、変化がなくなるまで繰り返す
+    while (bIsChanged == true)
+    {
+        bIsChanged = false;
+        for (uint32_t i = 0; i < ulBlockNum; i++)
+        {
+            const uint32_t ulStart = i * otaconfigFILE_BLOCK_SIZE;
+            uint32_t ulEnd = ulStart + otaconfigFILE_BLOCK_SIZE;
+            if (ulEnd > ulImageSize)
+            {
+                // 最後のデータブロックは行の残りも含めて書き込んでいる
+                ulEnd = ((ulImageSize + (NVM_FLASH_ROWSIZE - 1U)) / NVM_FLASH_ROWSIZE) * NVM_FLASH_ROWSIZE;
+            }
+            const uint32_t ulFirstPage = ulStart / NVM_FLASH_PAGESIZE;
+            const uint32_t ulLastPage = (ulEnd - 1U) / NVM_FLASH_PAGESIZE;
+            const bool bIsMissing = ((pucBitmap[i / 8U] & (uint8_t)(1U << (i % 8U))) != 0);
+
+            // 受信済みのデータブロックが消去されたままの場合は、ファイルを開き直したときにPALが消去したため受信し直す
+            if ((bIsMissing == false) && (bprvIsBlank(ulStart, ulEnd - ulStart) == true))
+            {
+                pucBitmap[i / 8U] |= (uint8_t)(1U << (i % 8U));
+                ulReclaimedBlockNum++;
+                bIsChanged = true;
+                continue;
+            }
+
+            for (uint32_t ulPage = ulFirstPage; ulPage <= ulLastPage; ulPage++)
+            {
+                const bool bIsPlanned = ((gucErasePlan[ulPage / 8U] & (uint8_t)(1U << (ulPage % 8U))) != 0);
+                if ((bIsMissing == true) && (bIsPlanned == false))
+                {
+                    // 受信していないデータブロックの範囲に書き込み済みのデータがあれば、ページごと消去する
+                    const uint32_t ulPageStart = ulPage * NVM_FLASH_PAGESIZE;
+                    const uint32_t ulFrom = (ulStart > ulPageStart) ? ulStart : ulPageStart;
+                    const uint32_t ulTo = (ulEnd < (ulPageStart + NVM_FLASH_PAGESIZE)) ? ulEnd : (ulPageStart + NVM_FLASH_PAGESIZE);
+                    if (bprvIsBlank(ulFrom, ulTo - ulFrom) == false)
+                    {
+                        gucErasePlan[ulPage / 8U] |= (uint8_t)(1U << (ulPage % 8U));
+                        bIsChanged = true;
+                    }
+                }
+                else if ((bIsMissing == false) && (bIsPlanned == true))
+                {
+                    // 消去するページにかかる受信済みのデータブロックは受信し直す
+                    pucBitmap[i / 8U] |= (uint8_t)(1U << (i % 8U));
+                    ulReclaimedBlockNum++;
+                    bIsChanged = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (ulReclaimedBlockNum > 0)
+    {
+        APP_PRINTFInfo("OTA staging resume: %u received blocks are erased or overlap partially written pages and will be received again.", ulReclaimedBlockNum);
+    }
+    return ulReclaimedBlockNum;
+}
+
+static bool bprvIsBlank(uint32_t ulOffset, uint32_t ulLength)
+{
+    const uint32_t *pulWords = (const uint32_t *)(OTA_APP_STAGING_IMAGE_ADDRESS + ulOffset);
+    for (uint32_t i = 0; i < (ulLength / sizeof(uint32_t)); i++)
+    {
+        if (pulWords[i] != UINT32_MAX)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool bprvWaitErased(uint32_t ulOffset, size_t uxLength)
+{
+    if (uxLength == 0)
+    {
+        return true;
+    }
+
+    const uint32_t ulLastPageIndex = (ulOffset + (uint32_t)uxLength - 1U) / NVM_FLASH_PAGESIZE;
+    if (gulErasedPageNum > ulLastPageIndex)
+    {
+        return true;
+    }
+
+    const TickType_t xWaitStartTick = xTaskGetTickCount();
+    gxStats.ulEraseWaitCount++;
+    while (gulErasedPageNum <= ulLastPageIndex)
+    {
+        if ((gbIsEraseFailed == true) || (ulLastPageIndex >= gulPlannedPageNum))
+        {
+            APP_PRINTFError("Failed to write ota staging image at %u; page %u will not be erased.", ulOffset, ulLastPageIndex);
+            return false;
+        }
+        if (xSemaphoreTake(gxEraseProgressSemaphore, pdMS_TO_TICKS(OTA_APP_STAGING_ERASE_WAIT_TIMEOUT_MS)) != pdTRUE)
+        {
+            APP_PRINTFError("Failed to write ota staging image at %u; erase did not progress.", ulOffset);
+            return false;
+        }
+    }
+    gxStats.xEraseWaitTicks += xTaskGetTickCount() - xWaitStartTick;
+    return true;
+}
+
+static bool bprvWriteRow(uint32_t ulRowOffset, const uint32_t *pulData)
+{
+    // 書き込み先のページの消去が済むまで待つ
+    if (bprvWaitErased(ulRowOffset, NVM_FLASH_ROWSIZE) == false)
+    {
+        return false;
+    }
+
+    // OTAStagingEraserTaskが消去したページに直接書き込む。PALを経由しないため、同じページを消去し直すことはない
+    vOtaStagingWriterLockNvm();
+    bool bResult = NVM_RowWrite((uint32_t *)pulData, OTA_APP_STAGING_IMAGE_ADDRESS + ulRowOffset);
+    if (bResult == true)
+    {
+        bResult = bOtaStagingWriterWaitNvm();
+    }
+    vOtaStagingWriterUnlockNvm();
+
+    if (bResult == false)
+    {
+        APP_PRINTFError("Failed to write ota staging row at %u.", ulRowOffset);
+        return false;
+    }
+    gxStats.ulRowCount++;
+    return true;
+}
+
+static bool bprvFlushPendingRow(void)
+{
+    if (gulPendingRowOffset == OTA_STAGING_WRITER_NO_ROW)
+    {
+        return true;
+    }
+
+    const uint32_t ulRowOffset = gulPendingRowOffset;
+    gulPendingRowOffset = OTA_STAGING_WRITER_NO_ROW;
+    gulPendingRowFilled = 0;
+    return bprvWriteRow(ulRowOffset, gulPendingRowBuffer);
+}
+
+// --------------------------------------------------
+// Unit Test用関数定義(関数のプロトタイプ宣言は「自身のファイル名+ "_test.h"」で宣言されていること)
+// --------------------------------------------------
+#if (BUILD_MODE_TEST == 1) /* BUILD_MODE_TESTが定義されているとき */
+#endif                     /* end  BUILD_MODE_TEST */
@@ -178,19 +178,15 @@ DeviceRegisterResult_t eRunDeviceRegisterProcess(const LinkingOneTimeToken_t *px
     }
     APP_PRINTFDebug("Receive thing name is %s", xThingName.ucName);
 
-    // ThingNameをFlashに保存
-    if (eWriteFlashInfo(WRITE_FLASH_TYPE_USUAL_THING_NAME, &xThingName) != FLASH_TASK_RESULT_SUCCESS)
-    {
-        APP_PRINTFError("Write thing name to flash error.");
-        return DEVICE_REGISTER_RESULT_FAILED;
-    }
-
-    // プロビジョニングフラグを保存
+    // ThingNameとプロビジョニングフラグをFlashに保存。プロビジョニングフラグはThingNameより後に書き込まれる
     ProvisioningFlag_t xProvisioningFlag = true;
-    if (eWriteFlashInfo(WRITE_FLASH_TYPE_PROVISIONING_FLAG,
-                        &xProvisioningFlag) != FLASH_TASK_RESULT_SUCCESS)
+    const FlashWriteEntry_t xWriteEntries[] = {
+        {.eWriteFlashType = WRITE_FLASH_TYPE_USUAL_THING_NAME, .pvWriteData = &xThingName},
+        {.eWriteFlashType = WRITE_FLASH_TYPE_PROVISIONING_FLAG, .pvWriteData = &xProvisioningFlag},
+    };
+    if (eWriteFlashInfoBatch(xWriteEntries, sizeof(xWriteEntries) / sizeof(xWriteEntries[0])) != FLASH_TASK_RESULT_SUCCESS)
     {
-        APP_PRINTFError("Write provisioning flag to flash error.");
+        APP_PRINTFError("Write thing name and provisioning flag to flash error.");
         return DEVICE_REGISTER_RESULT_FAILED;
     }
 
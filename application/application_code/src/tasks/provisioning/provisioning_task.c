@@ -190,13 +190,14 @@ static void prvProvisioningTask(void *pvParameters)
             memset(&xEndpoint, 0x00, sizeof(xEndpoint));
             memcpy(xEndpoint.ucEndpoint, xReceiveQueueData.uxEndpoint, strlen((const char *)xReceiveQueueData.uxEndpoint));
 
-            if (eWriteFlashInfo(WRITE_FLASH_TYPE_WIFI_INFO, &xWiFiInfo) != FLASH_TASK_RESULT_SUCCESS)
+            // Wi-Fi情報とエンドポイントはまとめて書き込む
+            const FlashWriteEntry_t xWriteEntries[] = {
+                {.eWriteFlashType = WRITE_FLASH_TYPE_WIFI_INFO, .pvWriteData = &xWiFiInfo},
+                {.eWriteFlashType = WRITE_FLASH_TYPE_AWS_IOT_ENDPOINT, .pvWriteData = &xEndpoint},
+            };
+            if (eWriteFlashInfoBatch(xWriteEntries, sizeof(xWriteEntries) / sizeof(xWriteEntries[0])) != FLASH_TASK_RESULT_SUCCESS)
             {
-                APP_PRINTFError("Failed to write flash Wi-Fi info.");
-            }
-            if (eWriteFlashInfo(WRITE_FLASH_TYPE_AWS_IOT_ENDPOINT, &xEndpoint) != FLASH_TASK_RESULT_SUCCESS)
-            {
-                APP_PRINTFError("Failed to write flash iot endpoint.");
+                APP_PRINTFError("Failed to write flash Wi-Fi info and iot endpoint.");
             }
 
             // BLEのWi-Fi接続情報Characteristic初期化(適当な値に書き換える)
@@ -206,7 +207,13 @@ static void prvProvisioningTask(void *pvParameters)
 
             // OTT(ワンタイムトークン)作成
             uint8_t uxTmpOTT[OTT_SIZE] = {0};
-            xGetRandomBytes(uxTmpOTT, sizeof(uxTmpOTT));
+            if (xGetRandomBytes(uxTmpOTT, sizeof(uxTmpOTT)) != sizeof(uxTmpOTT))
+            {
+                // 乱数が揃っていないOTTは推測される恐れがあるため、リンキング情報を送らずに終了する
+                APP_PRINTFError("Failed to generate OTT; random bytes are short.");
+                gxAppData.eState = PROVISIONING_APP_STATE_DEINIT;
+                break;
+            }
 
             uint8_t uxOTTBase64[OTT_BASE64_SIZE + 1] = {0};
             memset(uxOTTBase64, 0x00, sizeof(uxOTTBase64));
@@ -31,6 +31,7 @@
 #include "tasks/flash/include/flash_task.h"
 #include "tasks/mqtt/include/mqtt_operation_task.h"
 #include "tasks/shadow/include/device_shadow_task.h"
+#include "tasks/ota/include/ota_agent_task.h"
 
 // --------------------------------------------------
 // 自ファイル内でのみ使用する#defineマクロ
@@ -626,6 +627,9 @@ static void vprvShadowTask(void *pvParameter)
 
                 APP_PRINTFDebug("Start processing update command");
 
+                // 応答を待つ間はOTAのデータブロックの要求を止める
+                vOTAAgentTaskBeginInteractiveOperation();
+
                 // ShadowのUpdate処理を行う
                 if (bprvUpdateShadowState(xReceiveCommand.u.xUpdateCommand.xUpdateShadowType,
                                           &(xReceiveCommand.u.xUpdateCommand.xShadowState)) == false)
@@ -633,6 +637,8 @@ static void vprvShadowTask(void *pvParameter)
                     APP_PRINTFError("Failed to update shadow status.");
                 }
 
+                vOTAAgentTaskEndInteractiveOperation();
+
                 // 待ち合わせのタスクがある場合は、タスクにUpdate終了を通知
                 if (xReceiveCommand.u.xUpdateCommand.xWaitingTaskHandle != NULL)
                 {
@@ -645,12 +651,17 @@ static void vprvShadowTask(void *pvParameter)
 
                 APP_PRINTFDebug("Start processing get command");
 
+                // 応答を待つ間はOTAのデータブロックの要求を止める
+                vOTAAgentTaskBeginInteractiveOperation();
+
                 // ShadowのGet処理を行う
                 if (bprvGetShadowState(xReceiveCommand.u.xGetCommand.pxShadowState) == false)
                 {
                     APP_PRINTFError("Failed to get shadow status.");
                 }
 
+                vOTAAgentTaskEndInteractiveOperation();
+
                 // 待ち合わせのタスクがある場合は、タスクにGet終了を通知
                 if (xReceiveCommand.u.xGetCommand.xWaitingTaskHandle != NULL)
                 {
@@ -759,10 +770,12 @@ static bool bprvSubscribeAndRegisterShadowStateChangeCallback(const ShadowChange
     static StaticMQTTCommandBuffer_t xSubscribeMQTTContextBuffer; // コンテキスト保存場所を永続化したいためStaticで宣言
     memset(&xSubscribeMQTTContextBuffer, 0x00, sizeof(xSubscribeMQTTContextBuffer));
 
-    MQTTOperationTaskResult_t eMQTTResult = eMQTTSubscribe(&gxDeltaSubscribeInfo,
-                                                           &vprvDeltaShadowIncomingPublishCallback,
-                                                           &gxDeltaIncomingContext,
-                                                           &xSubscribeMQTTContextBuffer);
+    // Deltaの解析はJSONの検証と検索を行うため、MQTT TaskではなくDispatch Taskで実行する
+    MQTTOperationTaskResult_t eMQTTResult = eMQTTSubscribeWithDispatchMode(&gxDeltaSubscribeInfo,
+                                                                           &vprvDeltaShadowIncomingPublishCallback,
+                                                                           &gxDeltaIncomingContext,
+                                                                           &xSubscribeMQTTContextBuffer,
+                                                                           MQTT_DISPATCH_MODE_WORKER);
     if (eMQTTResult != MQTT_OPERATION_TASK_RESULT_SUCCESS)
     {
         APP_PRINTFError("Subscribe error: %d", eMQTTResult);
@@ -1078,8 +1091,17 @@ static bool bprvMQTTRequestWithResponse(const MQTTRequest_t *pxRequest,
                                         MQTTResponse_t *pxResponse,
                                         const uint32_t xTimeoutMs)
 {
+    // MQTTが再接続中の場合は、接続が回復するまで待機する
+    if (bMQTTWaitForConnection(xTimeoutMs) == false)
+    {
+        APP_PRINTFError("MQTT is not connected.");
+        return false;
+    }
+
     // Responseをサブスクライブ
-    DeviceShadowMQTTIncomingContext_t xIncomingContext = {0x00};
+    // Unsubscribeが完了するまでSubscriptionManagerから参照されるため、Staticで宣言する
+    static DeviceShadowMQTTIncomingContext_t xIncomingContext;
+    memset(&xIncomingContext, 0x00, sizeof(xIncomingContext));
 
     // サブスクライブしたトピックに受信があった際に必要となるコンテキストを作成
     xIncomingContext.puxPayload = pxResponse->pucPayloadBuffer;
@@ -1106,61 +1128,73 @@ static bool bprvMQTTRequestWithResponse(const MQTTRequest_t *pxRequest,
     if (eMQTTResult != MQTT_OPERATION_TASK_RESULT_SUCCESS)
     {
         APP_PRINTFError("Subscribe error: %d", eMQTTResult);
+        memset(&xIncomingContext, 0x00, sizeof(xIncomingContext));
         return false;
     }
 
     APP_PRINTFDebug("Topic subscribe succeeded. Topic name: %s", pxResponse->pucTopicName);
 
+    // Subscribe以降はどの経路でもUnsubscribeするため、結果を保持して最後に判定する
+    bool bIsReceived = false;
+
     // Publishする情報を格納
     MQTTPublishInfo_t xMQTTPublishInfo = {
         .pTopicName = pxRequest->pucTopicName,
         .topicNameLength = pxRequest->uxTopicNameLength,
         .pPayload = pxRequest->pucPayload,
         .payloadLength = pxRequest->uxPayloadLength,
-        .qos = MQTTQoS0,
+        .qos = MQTTQoS1,
     };
 
     // Publishを行う
-    // Publishが実際に行われるまで待機する
+    // 鍵状態の報告を通信断で失わないようQoS1とし、PUBACKを受信するまで待機する
     static StaticMQTTCommandBuffer_t xPublishMQTTContextBuffer; // コンテキスト保存場所を永続化したいためStaticで宣言
     memset(&xPublishMQTTContextBuffer, 0x00, sizeof(xPublishMQTTContextBuffer));
     eMQTTResult = eMQTTpublish(&xMQTTPublishInfo, &xPublishMQTTContextBuffer);
     if (eMQTTResult != MQTT_OPERATION_TASK_RESULT_SUCCESS)
     {
         APP_PRINTFError("Publish failed. Reasons: %d", eMQTTResult);
-        return false;
     }
-
-    APP_PRINTFDebug("MQTT publish success. Topic %s", xMQTTPublishInfo.pTopicName);
-
-    // 登録結果を受信するまで待機
-    // PublishがあるとxIncomingContext.xNotifyTaskHandleに格納したタスクハンドルに対してxTaskNotifyGive()が起こる
-    if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(xTimeoutMs)) == pdFAIL)
+    else
     {
-        APP_PRINTFError("Subscribe time out");
-        return false;
-    }
+        APP_PRINTFDebug("MQTT publish success. Topic %s", xMQTTPublishInfo.pTopicName);
+
+        // 登録結果を受信するまで待機
+        // PublishがあるとxIncomingContext.xNotifyTaskHandleに格納したタスクハンドルに対してxTaskNotifyGive()が起こる
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(xTimeoutMs)) == pdFAIL)
+        {
+            APP_PRINTFError("Subscribe time out");
+        }
+        else
+        {
+            bIsReceived = true;
 
-    // 受信したペイロードを出力
-    APP_PRINTFDebug("Received MQTT length %d", xIncomingContext.uxPayloadLength);
+            // 受信したペイロードを出力
+            APP_PRINTFDebug("Received MQTT length %d", xIncomingContext.uxPayloadLength);
 
-    // ペイロードの終端をNULL文字にする
-    pxResponse->pucPayloadBuffer[xIncomingContext.uxPayloadLength] = '\0';
+            // ペイロードの終端をNULL文字にする
+            pxResponse->pucPayloadBuffer[xIncomingContext.uxPayloadLength] = '\0';
 
-    // 受信したペイロードサイズを格納
-    pxResponse->uxReceivePayloadLength = xIncomingContext.uxPayloadLength;
+            // 受信したペイロードサイズを格納
+            pxResponse->uxReceivePayloadLength = xIncomingContext.uxPayloadLength;
+        }
+    }
 
     // SubscribeしたMQTTトピックをUnsubscribe
     static StaticMQTTCommandBuffer_t xUnsubscribeMQTTContextBuffer; // コンテキスト保存場所を永続化したいためStaticで宣言
     memset(&xUnsubscribeMQTTContextBuffer, 0x00, sizeof(xUnsubscribeMQTTContextBuffer));
     eMQTTResult = eMQTTUnsubscribe(&xSubscribeInfo, &xUnsubscribeMQTTContextBuffer);
+
+    // Unsubscribeに失敗して振り分けが残っても、呼び出し元のバッファに書き込まれないようコンテキストを無効にする
+    memset(&xIncomingContext, 0x00, sizeof(xIncomingContext));
+
     if (eMQTTResult != MQTT_OPERATION_TASK_RESULT_SUCCESS)
     {
         APP_PRINTFError("Unsubscribe failed. Reasons: %d", eMQTTResult);
         return false;
     }
 
-    return true;
+    return bIsReceived;
 }
 
 static bool bprvIsMatchClientToken(uint8_t *pucPayload,
@@ -82,6 +82,14 @@ static void vprvWakeUpTask(void *pvParameters);
  */
 static void vprvCbReceiveBLE(void *pvValue);
 
+/**
+ * @brief 起動後に使用する情報の読み込みをFlashTaskに依頼する
+ *
+ * @details
+ * 完了は待たない。ネットワークなどの初期化と並行してセキュアエレメントから読み込み、キャッシュさせる
+ */
+static void vprvPrefetchFlashInfo(void);
+
 #if (CREATE_PRINT_REMAINING_HEAP_SIZE_TASK == 1)
 /**
  * @brief 残りのヒープサイズをプリントする（デバック用）
@@ -149,6 +157,9 @@ static void vprvWakeUpTask(void *pvParameters)
             break;
         }
 
+        // セキュアエレメントからの読み込みを、以降の初期化と並行して行う
+        vprvPrefetchFlashInfo();
+
         // IPタスクなどネットワーク通信を行うために必要なタスクを初期化
         // NOTE: この関数内ではWi-Fiルータへの接続は行わない
         NetworkOperationResult_t eNetworkResult = eNetworkInit();
@@ -261,6 +272,25 @@ static void vprvCbReceiveBLE(void *pvValue)
     }
 }
 
+static void vprvPrefetchFlashInfo(void)
+{
+    const ReadFlashType_t eReadFlashTypes[] = {
+        READ_FLASH_TYPE_PROVISIONING_FLAG,
+        READ_FLASH_TYPE_AWS_IOT_ENDPOINT,
+        READ_FLASH_TYPE_USUAL_THING_NAME,
+    };
+
+    for (uint8_t i = 0; i < sizeof(eReadFlashTypes) / sizeof(eReadFlashTypes[0]); i++)
+    {
+        // 読み込みに失敗した場合も、使用するときに改めて読み込む
+        FlashTaskResult_t eResult = eReadFlashInfoAsync(eReadFlashTypes[i], NULL);
+        if (eResult != FLASH_TASK_RESULT_SUCCESS)
+        {
+            APP_PRINTFWarn("Flash prefetch request failed. Type: 0x%X, Reason: %d", eReadFlashTypes[i], eResult);
+        }
+    }
+}
+
 #if (CREATE_PRINT_REMAINING_HEAP_SIZE_TASK == 1)
 static void vprvPrintRemainingHeapSize(void *pvParameters)
 {